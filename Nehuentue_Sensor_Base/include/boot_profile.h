@@ -0,0 +1,93 @@
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Perfil de arranque: duración de cada fase de setup() y de la conexión
+// (asociación WiFi, DHCP, broker), medida con esp_timer_get_time() y guardada
+// en RTC memory. Se publica una vez, en el primer mensaje de estado.
+#define BOOT_PROFILE_MAGIC          0x464F5242  // "BROF"
+
+/**
+ * @brief Fases medidas (el orden es el de los campos en RTC memory)
+ *
+ * Las de setup() se abren y cierran en secuencia; las de red las cierran los
+ * eventos WiFi/MQTT, en paralelo con el polling.
+ */
+enum BootPhase {
+  BOOT_PHASE_SYSTEM = 0,      // SysMgr
+  BOOT_PHASE_STORAGE,         // FlashStorage + imagen de configuración
+  BOOT_PHASE_LOCAL,           // Cola persistente, contadores, perfiles
+  BOOT_PHASE_MQTT_SETUP,      // Comandos + MqttMgr.begin + tarea (sin red)
+  BOOT_PHASE_MODBUS,          // ModbusMgr.begin
+  BOOT_PHASE_POLLING,         // beginPolling
+  BOOT_PHASE_WIFI_START,      // WifiMgr.begin + connectSTA + TimeMgr
+  BOOT_PHASE_WIFI_ASSOC,      // connectSTA -> STA_CONNECTED
+  BOOT_PHASE_WIFI_DHCP,       // STA_CONNECTED -> GOT_IP
+  BOOT_PHASE_MQTT_CONNECT,    // GOT_IP -> conectado al broker
+  BOOT_PHASE_COUNT
+};
+
+/**
+ * @brief Registro en RTC memory (sobrevive a reinicios por software, watchdog
+ *        y panic; no a un corte de alimentación)
+ *
+ * Tiempos en us desde el arranque de la aplicación (esp_timer). Un arranque
+ * que se reinicia antes de publicar deja su registro para el siguiente.
+ */
+struct BootProfileRecord {
+  uint32_t magic;
+  char firmware[12];                        // FIRMWARE_VERSION que lo midió
+  uint8_t resetReason;                      // esp_reset_reason_t de ese arranque
+  uint8_t published;
+  uint16_t reserved;
+  uint32_t phaseStartUs[BOOT_PHASE_COUNT];  // 0 = no empezó
+  uint32_t phaseUs[BOOT_PHASE_COUNT];       // 0 = no terminó
+  uint32_t setupUs;                         // Fin de setup()
+  uint32_t readyUs;                         // Primera conexión al broker
+  uint32_t crc;                             // CRC32 de todo lo anterior
+};
+
+/**
+ * @brief Abre el perfil de este arranque (primera línea de setup())
+ *
+ * Si el registro de RTC memory es válido y no se publicó (el arranque anterior
+ * se reinició antes de conectar) se conserva como "prev" para el reporte.
+ */
+void bootProfileBegin();
+
+/**
+ * @brief Marca el inicio/fin de una fase; sólo cuenta la primera vez
+ *        (las reconexiones posteriores no pisan el arranque)
+ * @note Se puede llamar desde cualquier tarea o callback de eventos
+ */
+void bootPhaseBegin(BootPhase phase);
+void bootPhaseEnd(BootPhase phase);
+
+/**
+ * @brief Fin de setup() (la red puede seguir conectando)
+ */
+void bootProfileSetupDone();
+
+/**
+ * @brief true hasta que el perfil sale en un mensaje de estado
+ */
+bool bootProfilePending();
+
+/**
+ * @brief Agrega el perfil (y el del arranque anterior sin publicar) al objeto
+ */
+void bootProfileToJson(JsonObject boot);
+
+/**
+ * @brief Marca el perfil como publicado (ya no sale en los próximos estados)
+ */
+void bootProfileMarkPublished();
+
+/**
+ * @brief Imprime el desglose por Serial
+ */
+void bootProfilePrint();
+
+#endif // BOOT_PROFILE_H
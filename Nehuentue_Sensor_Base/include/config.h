@@ -13,48 +13,46 @@
 
 #include <Arduino.h>
 
-// Versión de configuración (para migración)
-#define CONFIG_VERSION 1
+// Versión del firmware (mensaje de estado y perfil de arranque, boot_profile.h)
+#define FIRMWARE_VERSION "v2.1"
+
+// Versión de la imagen de configuración (para migración, ver config_image.h)
+// 1: claves sueltas en NVS (wifi_ssid, mqtt_server, ...) + blob sensor_config
+// 2: una sola imagen "cfg_image" con CRC32
+#define CONFIG_VERSION 2
 
 // ============================================================================
 // Sensor Configuration (única estructura no definida en managers)
 // ============================================================================
+// Ordenada de mayor a menor alineación: sin relleno dentro de la imagen
 struct SensorConfig {
   char name[32];              // Nombre del sensor
   char type[32];              // Tipo de sensor
   char unit[16];              // Unidad de medida
   
-  bool enabled;
-  uint8_t slaveId;            // = modbusAddress (compatibilidad)
-  uint8_t modbusAddress;      // Alias para slaveId
-  uint8_t modbusFunction;     // Función Modbus (0x03, 0x04, etc.)
-  uint16_t startAddress;
-  uint16_t registerStart;     // Alias para startAddress
-  uint16_t quantity;
-  uint16_t registerCount;     // Alias para quantity
   uint32_t pollInterval;
-  int rxPin;
-  int txPin;
   uint32_t baudrate;
+  int32_t rxPin;
+  int32_t txPin;
   
   // Campos para conversión de datos
   float multiplier;
   float offset;
-  uint8_t decimals;
   
-  uint8_t version;
+  uint16_t startAddress;
+  uint16_t quantity;
+  uint8_t slaveId;
+  uint8_t modbusFunction;     // Función Modbus (0x03, 0x04, etc.)
+  uint8_t decimals;
+  bool enabled;
   
   SensorConfig() {
     memset(this, 0, sizeof(SensorConfig));
-    version = CONFIG_VERSION;
     enabled = true;
     slaveId = 1;
-    modbusAddress = 1;
     modbusFunction = 0x03;  // Read Holding Registers por defecto
     startAddress = 0;
-    registerStart = 0;
     quantity = 10;
-    registerCount = 10;
     multiplier = 1.0f;
     offset = 0.0f;
     decimals = 2;
@@ -66,6 +64,18 @@ struct SensorConfig {
   }
 };
 
+// ============================================================================
+// NTP Configuration (el resto de la configuración de red vive en los managers)
+// ============================================================================
+struct NtpConfig {
+  char server[64];
+  uint16_t port;
+  
+  NtpConfig() {
+    memset(this, 0, sizeof(NtpConfig));
+  }
+};
+
 // ============================================================================
 // System Statistics
 // ============================================================================
@@ -95,6 +105,7 @@ struct SystemStats {
 #define DEFAULT_WIFI_SSID         "Amanda 2.4G"
 #define DEFAULT_WIFI_PASSWORD     "Gomezriquelmegomez12"
 #define DEFAULT_HOSTNAME          "Nehuentue-Sensor"
+#define WIFI_CONNECT_TIMEOUT_MS   15000   // Sin IP en este tiempo = ERR_WIFI_CONNECTION_FAILED (no bloquea el arranque)
 
 // MQTT Broker
 #define DEFAULT_MQTT_SERVER       "192.168.1.25"  // Raspberry Pi con Mosquitto
@@ -105,14 +116,50 @@ struct SystemStats {
 
 // Tópicos MQTT
 #define MQTT_TOPIC_BASE           "nehuentue"
-#define MQTT_TOPIC_TELEMETRY      "telemetry"
+#define MQTT_TOPIC_TELEMETRY      "telemetry"       // Agregados por ventana
+#define MQTT_TOPIC_TELEMETRY_RAW  "telemetry/raw"   // Muestras crudas (puntos con raw)
 #define MQTT_TOPIC_STATUS         "status"
 #define MQTT_TOPIC_CMD            "cmd"
 #define MQTT_TOPIC_RESPONSE       "response"
+#define MQTT_TOPIC_RAW_REQ        "raw/req"       // + /<token>, payload binario
+#define MQTT_TOPIC_RAW_RESP       "raw/resp"      // + /<token>, payload binario
 
 // Intervalos (milisegundos)
 #define DEFAULT_TELEMETRY_INTERVAL  60000   // 60 segundos
 #define DEFAULT_STATUS_INTERVAL     300000  // 5 minutos
+#define DEFAULT_AGGREGATION_WINDOW_MS 60000 // Ventana de agregación por defecto
+#define AGGREGATION_CLOSE_CHECK_MS  1000    // Cierre por timer de ventanas sin lecturas nuevas
+
+// Hora UTC (TimeSyncManager; el servidor se cambia con set_ntp)
+#define DEFAULT_NTP_SERVER          "pool.ntp.org"
+#define NTP_SYNC_INTERVAL_MS        300000  // 5 minutos entre rondas
+
+// Commits de configuración a NVS (ConfigCommitManager, get_nvs_stats)
+#define CONFIG_COMMIT_DEBOUNCE_MS   2000    // Ventana sin cambios antes de escribir
+#define CONFIG_COMMIT_CHECK_MS      250     // Período del trabajo "cfg_commit"
+#define FLASH_CACHE_BUDGET_BYTES    2048    // Caché de lectura de FlashStorage (cfg_image entra)
+
+// Historial comprimido en RAM (get_history)
+#define HISTORY_RAM_BUDGET          32768   // ~10 h de 1 punto a 1 Hz con valores estables
+#define HISTORY_QUERY_DEFAULT_LIMIT 300
+#define HISTORY_QUERY_MAX_LIMIT     500
+#define HISTORY_REPLY_MAX_BYTES     (MQTT_MANAGER_QUEUE_BYTES / 2)  // JSON por página: más = "next"
+
+// Biblioteca de perfiles de equipos (list_profiles)
+#define PROFILE_LIST_DEFAULT_LIMIT  20
+#define PROFILE_LIST_MAX_LIMIT      50
+
+// Contadores persistentes (partición "statslog", CounterLogManager)
+#define STATS_CHECKPOINT_INTERVAL_MS 10000  // 64 KB = 1024 registros: una vuelta cada ~3 h
+#define STATS_LOG_SCHEMA            1       // Versión de PersistedCounters (main.cpp)
+
+// Cola persistente de publicaciones (partición "mqttlog", ver partitions.csv)
+#define MQTT_OFFLINE_MAX_AGE_S      (7UL * 24 * 3600)  // Retención: 7 días (0 = sin límite)
+#define MQTT_OFFLINE_MAX_SEGMENTS   0                  // Segmentos de 4 KB (0 = toda la partición)
+
+// Entrega de publicaciones
+#define MQTT_PUBLISH_QOS            1       // 0 = sin confirmación, 1 = PUBACK + reenvío
+#define MQTT_INFLIGHT_WINDOW        8       // Mensajes QoS 1 en vuelo (1-32)
 
 // ============================================================================
 // SISTEMA DE CÓDIGOS DE ERROR
@@ -0,0 +1,71 @@
+#ifndef CONFIG_IMAGE_H
+#define CONFIG_IMAGE_H
+
+#include <Arduino.h>
+#include <WiFiManager.h>
+#include <MQTTManager.h>
+#include <ConfigCommitManager.h>
+#include "config.h"
+
+// Imagen de configuración persistente: toda la configuración del dispositivo
+// en un solo blob de NVS, leído y validado con una lectura en el arranque
+#define CONFIG_IMAGE_KEY            "cfg_image"
+#define CONFIG_IMAGE_MAGIC          0x4746434E  // "NCFG"
+
+/**
+ * @brief Encabezado de la imagen (no cambia entre versiones)
+ */
+struct ConfigImageHeader {
+  uint32_t magic;
+  uint16_t version;           // CONFIG_VERSION con que se escribió
+  uint16_t size;              // Bytes de la imagen completa
+  uint32_t crc;               // CRC32 de todo lo que sigue al encabezado
+};
+
+/**
+ * @brief Imagen CONFIG_VERSION 2
+ *
+ * Cambiar el tamaño o el orden de un campo (también de SensorConfig, WiFiConfig
+ * o MQTTConfig) exige subir CONFIG_VERSION y migrar en config_image.cpp.
+ */
+struct ConfigImage {
+  ConfigImageHeader header;
+  SensorConfig sensor;
+  char wifiSsid[sizeof(WiFiConfig::ssid)];
+  char wifiPassword[sizeof(WiFiConfig::password)];
+  char mqttServer[sizeof(MQTTConfig::server)];
+  char mqttUser[sizeof(MQTTConfig::user)];
+  char mqttPassword[sizeof(MQTTConfig::password)];
+  char ntpServer[sizeof(NtpConfig::server)];
+  uint16_t mqttPort;
+  uint16_t ntpPort;
+};
+
+/**
+ * @brief Origen de la configuración en el arranque
+ */
+enum ConfigImageResult {
+  CONFIG_IMAGE_LOADED = 0,    // Imagen válida
+  CONFIG_IMAGE_MIGRATED,      // Claves de la versión 1 pasadas a una imagen nueva
+  CONFIG_IMAGE_CREATED,       // Sin configuración guardada: imagen con valores por defecto
+  CONFIG_IMAGE_INVALID        // Imagen corrupta o de otra versión: valores por defecto
+};
+
+/**
+ * @brief Carga la configuración en wifiConfig, mqttConfig, ntpConfig y sensorConfig
+ *
+ * Con imagen: una lectura de NVS y CRC32. Sin imagen: migra las claves de la
+ * versión 1 que existan, escribe la imagen y borra las claves viejas.
+ *
+ * @note Los globales deben tener ya los valores por defecto; una imagen
+ *       inválida los deja como están y no se sobrescribe.
+ */
+ConfigImageResult loadConfigImage();
+
+/**
+ * @brief Arma la imagen con la configuración en RAM y la deja en ConfigMgr
+ *        (commit diferido; una imagen idéntica no se escribe)
+ */
+ConfigStageResult saveConfigImage();
+
+#endif // CONFIG_IMAGE_H
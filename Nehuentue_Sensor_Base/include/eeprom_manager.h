@@ -5,6 +5,8 @@
 #include "driver/i2c.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
 
 // ============================================================================
 // CONFIGURACIÓN EEPROM 24LCXX (Compatible con 24LC64, 24LC128, 24LC256, etc.)
@@ -18,7 +20,26 @@
 #define EEPROM_SIZE 16384           // 128 Kbit = 16 KBytes (24LC128)
 
 #define EEPROM_PAGE_SIZE 32         // Tamaño de página para escritura (igual en todos)
-#define EEPROM_WRITE_CYCLE_TIME_MS 5 // Tiempo de escritura típico
+#define EEPROM_WRITE_CYCLE_MAX_MS 10  // Tope del ciclo interno (tWC = 5 ms + margen)
+
+// ============================================================================
+// ESCRITURA DIFERIDA (write-behind)
+// ============================================================================
+// Con enableWriteBehind() las escrituras se encolan y una tarea las graba:
+// writeBytes() vuelve sin esperar los ciclos de grabación
+#define EEPROM_WRITE_QUEUE_DEPTH 16          // Ítems de hasta una página
+#define EEPROM_WRITE_QUEUE_WAIT_MS 1000      // Espera por lugar en cola llena
+#define EEPROM_FLUSH_TIMEOUT_MS 2000
+#define EEPROM_WRITER_TASK_STACK_SIZE 3072
+#define EEPROM_WRITER_TASK_PRIORITY 1
+
+// ============================================================================
+// COPIA EN RAM (shadow)
+// ============================================================================
+// Con enableShadow() una región (o toda la EEPROM) se carga a RAM en begin:
+// las lecturas salen de RAM y las escrituras sólo marcan páginas sucias, que
+// se graban con flush()
+#define EEPROM_SHADOW_LOAD_CHUNK 1024        // Bytes por lectura secuencial al cargar
 
 // ============================================================================
 // CONFIGURACIÓN I2C ESP32
@@ -46,6 +67,35 @@ enum EEPROMStatus {
     EEPROM_ERROR_NULL_POINTER
 };
 
+// Estadísticas de escritura (ver getWriteStats())
+struct EEPROMWriteStats {
+    uint32_t pagesWritten;       // Transacciones de página enviadas
+    uint32_t bytesWritten;
+    uint32_t requestsQueued;     // Ítems aceptados por la cola
+    uint32_t requestsCoalesced;  // Ítems fusionados con otro de la misma página
+    uint32_t queueFullWaits;     // Escrituras que esperaron lugar en la cola
+    uint32_t writeErrors;
+    uint32_t ackPolls;           // Sondeos sin ACK (EEPROM grabando)
+    uint32_t lastCycleUs;        // Ciclo de grabación medido por ACK polling
+    uint32_t maxCycleUs;
+    uint32_t lastLatencyUs;      // Encolado -> página grabada
+    uint32_t avgLatencyUs;       // Promedio móvil (1/8)
+    uint32_t maxLatencyUs;
+    uint16_t queueDepth;         // Ítems en cola al consultar
+    uint16_t queueHighWater;
+};
+
+// Estado de la copia en RAM (ver getShadowStats())
+struct EEPROMShadowStats {
+    uint16_t start;              // Región copiada (alineada a página)
+    uint16_t length;
+    uint16_t dirtyPages;         // Páginas a grabar en el próximo flush()
+    uint32_t hits;               // Lecturas servidas desde RAM
+    uint32_t misses;             // Lecturas que fueron a la EEPROM
+    uint32_t pagesWrittenBack;
+    uint32_t loadUs;             // Duración de la carga inicial
+};
+
 // ============================================================================
 // CLASE EEPROM MANAGER (ULTRA GENÉRICA)
 // ============================================================================
@@ -59,11 +109,66 @@ private:
     uint32_t frequency;
     uint16_t eepromSize;  // Tamaño configurable de la EEPROM
     
+    // Ciclo de grabación en curso: la próxima transacción hace ACK polling
+    bool writeCyclePending;
+    unsigned long writeCycleStartUs;
+    
+    // Escritura diferida
+    enum WriteItemType : uint8_t {
+        WRITE_ITEM_DATA,
+        WRITE_ITEM_FLUSH,   // Barrera: graba lo anterior y marca barrierSeq
+        WRITE_ITEM_STOP
+    };
+    
+    // Nunca cruza un límite de página (writeBytes() parte las escrituras)
+    struct WriteItem {
+        WriteItemType type;
+        uint8_t length;
+        uint16_t address;
+        unsigned long queuedUs;
+        uint32_t barrierSeq;          // Número de barrera (FLUSH/STOP)
+        uint8_t data[EEPROM_PAGE_SIZE];
+    };
+    
+    QueueHandle_t writeQueue;
+    TaskHandle_t writerHandle;
+    volatile uint32_t pendingItems;   // Encolados y todavía sin grabar
+    volatile bool writeFailed;        // Error desde el último flush()
+    EEPROMWriteStats stats;
+    portMUX_TYPE statsMux;
+    
+    // Barreras: semáforo propio (no la notificación de la tarea que espera)
+    // y número de secuencia para ignorar avisos de barreras ya vencidas
+    SemaphoreHandle_t barrierMutex;   // Una barrera en espera a la vez
+    SemaphoreHandle_t barrierDone;    // Binario: la tarea grabó hasta una barrera
+    uint32_t barrierSeq;              // Última barrera encolada
+    volatile uint32_t barrierDoneSeq; // Última barrera alcanzada por la tarea
+    
+    // Copia en RAM: shadow es la versión vigente de la región
+    uint8_t* shadow;
+    uint32_t* dirtyPages;             // Un bit por página de la región
+    uint16_t shadowStart;
+    uint16_t shadowLength;
+    SemaphoreHandle_t shadowMutex;
+    EEPROMShadowStats shadowStats;
+    
     // Funciones privadas de bajo nivel
     esp_err_t writeRaw(uint16_t address, const uint8_t* data, size_t length);
     esp_err_t readRaw(uint16_t address, uint8_t* buffer, size_t length);
+    esp_err_t waitWriteCycle();
     bool verifyDevice();
     
+    EEPROMStatus enqueueWrite(uint16_t address, const uint8_t* data, size_t length);
+    bool waitPending(uint32_t timeoutMs);
+    bool waitBarrier(WriteItemType type, uint32_t timeoutMs);
+    bool mergeWrite(WriteItem& burst, const WriteItem& item);
+    void writeBurst(WriteItem& burst, uint32_t items);
+    static void writerTask(void* parameter);
+    
+    EEPROMStatus writeDevice(uint16_t address, const uint8_t* data, size_t length);
+    void writeShadow(uint16_t address, const uint8_t* data, size_t length);
+    EEPROMStatus writeBackShadow();
+    
 public:
     // ========================================================================
     // CONSTRUCTOR Y DESTRUCTOR
@@ -88,6 +193,41 @@ public:
     EEPROMStatus readByte(uint16_t address, uint8_t* data);
     EEPROMStatus readBytes(uint16_t address, uint8_t* buffer, size_t length);
     
+    // ========================================================================
+    // ESCRITURA DIFERIDA
+    // ========================================================================
+    
+    /**
+     * Arranca la tarea de escritura: desde acá writeBytes() (y save, fill,
+     * saveString...) encola y vuelve. Las escrituras contiguas de una misma
+     * página que se juntan en la cola salen en una sola transacción. Las
+     * lecturas esperan a que se grabe lo pendiente.
+     */
+    EEPROMStatus enableWriteBehind(uint8_t queueDepth = EEPROM_WRITE_QUEUE_DEPTH);
+    void disableWriteBehind();  // Graba lo pendiente y detiene la tarea
+    bool isWriteBehindEnabled() const { return writeQueue != NULL; }
+    
+    // Graba las páginas sucias de la copia en RAM y espera a que se grabe todo
+    // lo encolado hasta ahora.
+    // EEPROM_ERROR_WRITE_FAILED si alguna escritura diferida falló desde el último flush
+    EEPROMStatus flush(uint32_t timeoutMs = EEPROM_FLUSH_TIMEOUT_MS);
+    
+    // ========================================================================
+    // COPIA EN RAM
+    // ========================================================================
+    
+    /**
+     * Carga [start, start + length) a RAM en lecturas secuenciales (length 0 =
+     * hasta el final). La región se extiende a páginas completas. Desde acá
+     * readBytes()/writeBytes() sobre la región no usan el bus: las escrituras
+     * marcan páginas sucias (sólo si el contenido cambia) y flush() las graba.
+     * Para cargar más rápido, begin() a 400 kHz (24LC) o 1 MHz (24FC).
+     */
+    EEPROMStatus enableShadow(uint16_t start = 0, uint16_t length = 0);
+    EEPROMStatus disableShadow();  // Graba las páginas sucias y libera la RAM
+    bool isShadowEnabled() const { return shadow != NULL; }
+    EEPROMShadowStats getShadowStats();
+    
     // ========================================================================
     // OPERACIONES GENÉRICAS CON TEMPLATES (Ultra flexible)
     // ========================================================================
@@ -195,6 +335,9 @@ public:
     uint16_t getPageSize() const { return EEPROM_PAGE_SIZE; }
     uint8_t getDeviceAddress() const { return deviceAddress; }
     uint16_t getFreeSpace(uint16_t fromAddress = 0);
+    EEPROMWriteStats getWriteStats();
+    uint16_t getQueueDepth();
+    void resetWriteStats();
     void printStatus();
     void printMemoryMap(uint16_t startAddress = 0, uint16_t length = 256);
     void dumpMemory(uint16_t startAddress, uint16_t length);
@@ -0,0 +1,31 @@
+#ifndef MODBUS_COMMANDS_H
+#define MODBUS_COMMANDS_H
+
+#include <Arduino.h>
+
+// Comandos MQTT de acceso directo al bus Modbus (modbus_batch, passthrough binario)
+#define MODBUS_BATCH_MAX_VALUES     128     // Valores de escritura por lote (total)
+
+/**
+ * @brief Registra los comandos Modbus en CmdDispatcher (llamar en setup)
+ */
+void registerModbusCommands();
+
+/**
+ * @brief Prepara el passthrough binario (raw/req/<token> -> raw/resp/<token>)
+ * @param clientId Client ID MQTT usado en los tópicos
+ */
+void beginRawModbus(const char* clientId);
+
+/**
+ * @brief Suscribe el tópico raw/req/+ (llamar en cada conexión MQTT)
+ */
+void subscribeRawModbus();
+
+/**
+ * @brief Atiende un mensaje del passthrough binario
+ * @return false si el tópico no es de raw/req (el mensaje sigue su curso)
+ */
+bool handleRawModbusMessage(const char* topic, const uint8_t* payload, size_t length);
+
+#endif // MODBUS_COMMANDS_H
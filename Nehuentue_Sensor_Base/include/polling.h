@@ -0,0 +1,44 @@
+#ifndef POLLING_H
+#define POLLING_H
+
+#include <Arduino.h>
+#include <CommandDispatcher.h>
+#include <PollingManager.h>
+
+// Plan de polling = sensor principal (SensorConfig) + puntos extra (set_points)
+#define POLL_EXTRA_POINTS       (POLLING_MGR_MAX_POINTS - 1)
+
+/**
+ * @brief Puntos extra persistidos en flash ("poll_points")
+ */
+struct PollPointList {
+  uint8_t count;
+  PollPoint points[POLL_EXTRA_POINTS];
+
+  PollPointList() {
+    memset(this, 0, sizeof(PollPointList));
+  }
+};
+
+/**
+ * @brief Carga los puntos extra, arma el plan e inicia PollMgr
+ * @param clientId Client ID MQTT (tópico de telemetría)
+ * @note Llamar después de ModbusMgr.begin()
+ */
+bool beginPolling(const char* clientId);
+
+/**
+ * @brief Rearma el plan desde la configuración actual y lo aplica en caliente
+ *
+ * Responde en ctx el resultado ({"status":"ok","generation",...} o el error
+ * de validación).
+ */
+bool applyPollingConfig(CommandContext& ctx);
+
+/**
+ * @brief Registra set_points, get_points, list_profiles, get_profile,
+ *        apply_profile, set_aggregation, get_aggregation y get_history
+ */
+void registerPollingCommands();
+
+#endif // POLLING_H
@@ -91,7 +91,7 @@ extern QueueHandle_t eepromQueue;
 void modbusTask(void *pvParameters);
 void decoderTask(void *pvParameters);
 void mqttTask(void *pvParameters);      // Nueva tarea dedicada a MQTT
-// void eepromTask(void *pvParameters);  // DESHABILITADA - sin hardware
+// void eepromTask(void *pvParameters);  // DESHABILITADA - sin hardware (ver EEPROMManager::enableWriteBehind)
 
 // Funciones auxiliares
 void initTasks();
@@ -0,0 +1,379 @@
+/**
+ * @file AggregationManager.cpp
+ * @brief Implementación del AggregationManager
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "AggregationManager.h"
+#include <math.h>
+
+// Instancia global
+AggregationManager AggMgr;
+
+// ============================================================================
+// WELFORD
+// ============================================================================
+
+void RunningStats::reset() {
+    count = 0;
+    mean = 0.0;
+    m2 = 0.0;
+    min = 0.0f;
+    max = 0.0f;
+}
+
+void RunningStats::add(float value) {
+    count++;
+    if (count == 1) {
+        min = max = value;
+    } else {
+        if (value < min) min = value;
+        if (value > max) max = value;
+    }
+
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+}
+
+float RunningStats::variance() const {
+    return (count > 1) ? (float)(m2 / (count - 1)) : 0.0f;
+}
+
+float RunningStats::stddev() const {
+    return sqrtf(variance());
+}
+
+// ============================================================================
+// CONSTRUCTOR
+// ============================================================================
+
+AggregationManager::AggregationManager() {
+    memset(series, 0, sizeof(series));
+    memset(used, 0, sizeof(used));
+    memset(lastSeen, 0, sizeof(lastSeen));
+    memset(&stats, 0, sizeof(AggregationStats));
+    mutex = NULL;
+    windowCallback = nullptr;
+}
+
+bool AggregationManager::begin() {
+    if (mutex != NULL) return true;
+
+    mutex = xSemaphoreCreateMutex();
+    if (mutex == NULL) {
+        Serial.println("[AGG MGR] ERROR: No se pudo crear mutex");
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// AGREGACIÓN
+// ============================================================================
+
+uint8_t AggregationManager::add(const char* point, const float* values, uint8_t count, uint32_t now,
+                                AggregateWindow& closed) {
+    lock();
+
+    const AggregationRule* rule = findRule(point);
+    uint32_t windowMs = (rule != nullptr) ? rule->windowMs : config.defaultWindowMs;
+    uint8_t result = (rule != nullptr && rule->raw) ? AGG_EMIT_RAW : 0;
+
+    // Sin ventana: el punto se publica crudo
+    if (windowMs == 0) {
+        unlock();
+        return result | AGG_EMIT_RAW;
+    }
+
+    AggregateWindow* window = findSeries(point, now);
+
+    // Un now anterior al inicio (el timer abrió la ventana siguiente con un
+    // millis() posterior al de esta lectura) cuenta en la ventana actual
+    if (window->windowMs != windowMs) {
+        openWindow(*window, windowMs, now);
+    } else if ((int32_t)(now - window->start) >= (int32_t)windowMs) {
+        if (takeWindow(window - series, closed)) {
+            result |= AGG_WINDOW_CLOSED;
+        }
+        openWindow(*window, windowMs, now);
+    }
+
+    if (values != nullptr) {
+        uint8_t channels = (count < AGGREGATION_MGR_MAX_CHANNELS) ? count : AGGREGATION_MGR_MAX_CHANNELS;
+        if (channels > window->channels) {
+            window->channels = channels;
+        }
+        for (uint8_t i = 0; i < channels; i++) {
+            window->stats[i].add(values[i]);
+        }
+        window->samples++;
+        stats.samples++;
+    } else {
+        window->missed++;
+    }
+
+    unlock();
+    return result;
+}
+
+void AggregationManager::onWindowClosed(AggregateWindowCallback callback) {
+    lock();
+    windowCallback = callback;
+    unlock();
+}
+
+void AggregationManager::closeExpired() {
+    AggregateWindow closed;
+
+    // De a una serie: el callback corre sin el mutex y add() no espera
+    for (uint8_t i = 0; i < AGGREGATION_MGR_MAX_SERIES; i++) {
+        lock();
+        bool emit = false;
+        uint32_t now = millis();
+        if (used[i] && series[i].windowMs > 0 && now - series[i].start >= series[i].windowMs) {
+            emit = takeWindow(i, closed);
+            openWindow(series[i], series[i].windowMs, now);
+        }
+        AggregateWindowCallback callback = windowCallback;
+        unlock();
+
+        if (emit && callback != nullptr) {
+            callback(closed);
+        }
+    }
+}
+
+void AggregationManager::closeSeries(const char* point) {
+    if (point == nullptr) return;
+
+    AggregateWindow closed;
+    bool emit = false;
+
+    lock();
+    for (uint8_t i = 0; i < AGGREGATION_MGR_MAX_SERIES; i++) {
+        if (used[i] && strcmp(series[i].name, point) == 0) {
+            emit = takeWindow(i, closed);
+            used[i] = false;
+            break;
+        }
+    }
+    AggregateWindowCallback callback = windowCallback;
+    unlock();
+
+    if (emit && callback != nullptr) {
+        callback(closed);
+    }
+}
+
+// ============================================================================
+// CONFIGURACIÓN
+// ============================================================================
+
+bool AggregationManager::setDefaultWindow(uint32_t windowMs) {
+    if (!validWindow(windowMs)) return false;
+
+    lock();
+    config.defaultWindowMs = windowMs;
+    unlock();
+    closeChanged();
+    return true;
+}
+
+bool AggregationManager::setRule(const char* point, uint32_t windowMs, bool raw) {
+    if (point == nullptr || !validWindow(windowMs)) return false;
+
+    size_t nameLength = strlen(point);
+    if (nameLength == 0 || nameLength > AGGREGATION_MGR_MAX_NAME) return false;
+
+    lock();
+    AggregationRule* rule = (AggregationRule*)findRule(point);
+    if (rule == nullptr) {
+        if (config.count >= AGGREGATION_MGR_MAX_RULES) {
+            unlock();
+            return false;
+        }
+        rule = &config.rules[config.count++];
+        memset(rule, 0, sizeof(AggregationRule));
+        strncpy(rule->name, point, AGGREGATION_MGR_MAX_NAME);
+    }
+    rule->windowMs = windowMs;
+    rule->raw = raw;
+    unlock();
+    closeChanged();
+    return true;
+}
+
+bool AggregationManager::removeRule(const char* point) {
+    lock();
+    const AggregationRule* rule = findRule(point);
+    if (rule == nullptr) {
+        unlock();
+        return false;
+    }
+
+    // Compactar: la última regla ocupa el hueco
+    uint8_t index = rule - config.rules;
+    config.rules[index] = config.rules[--config.count];
+    unlock();
+    closeChanged();
+    return true;
+}
+
+bool AggregationManager::setConfig(const AggregationConfig& newConfig) {
+    if (newConfig.count > AGGREGATION_MGR_MAX_RULES || !validWindow(newConfig.defaultWindowMs)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < newConfig.count; i++) {
+        if (!validWindow(newConfig.rules[i].windowMs)) return false;
+    }
+
+    lock();
+    config = newConfig;
+    unlock();
+    closeChanged();
+    return true;
+}
+
+void AggregationManager::getConfig(AggregationConfig& out) {
+    lock();
+    out = config;
+    unlock();
+}
+
+uint32_t AggregationManager::windowFor(const char* point) {
+    lock();
+    const AggregationRule* rule = findRule(point);
+    uint32_t windowMs = (rule != nullptr) ? rule->windowMs : config.defaultWindowMs;
+    unlock();
+    return windowMs;
+}
+
+// ============================================================================
+// INFORMACIÓN
+// ============================================================================
+
+void AggregationManager::printStatus() {
+    AggregationConfig current;
+    getConfig(current);
+
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   Aggregation Manager - Estado         ║");
+    Serial.println("╚════════════════════════════════════════╝");
+    Serial.printf("  Ventana por defecto: %lu ms\n", current.defaultWindowMs);
+    Serial.printf("  Muestras: %lu, ventanas cerradas: %lu, desalojos: %lu\n",
+                  stats.samples, stats.windowsClosed, stats.evictions);
+    for (uint8_t i = 0; i < current.count; i++) {
+        Serial.printf("  %-16s ventana %lu ms%s\n", current.rules[i].name,
+                      current.rules[i].windowMs, current.rules[i].raw ? " + crudo" : "");
+    }
+    Serial.println("════════════════════════════════════════\n");
+}
+
+// ============================================================================
+// MÉTODOS PRIVADOS
+// ============================================================================
+
+void AggregationManager::lock() {
+    if (mutex != NULL) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+    }
+}
+
+void AggregationManager::unlock() {
+    if (mutex != NULL) {
+        xSemaphoreGive(mutex);
+    }
+}
+
+const AggregationRule* AggregationManager::findRule(const char* point) const {
+    for (uint8_t i = 0; i < config.count; i++) {
+        if (strcmp(config.rules[i].name, point) == 0) {
+            return &config.rules[i];
+        }
+    }
+    return nullptr;
+}
+
+AggregateWindow* AggregationManager::findSeries(const char* point, uint32_t now) {
+    int8_t freeSlot = -1;
+    int8_t oldest = 0;
+
+    for (uint8_t i = 0; i < AGGREGATION_MGR_MAX_SERIES; i++) {
+        if (!used[i]) {
+            if (freeSlot < 0) freeSlot = i;
+            continue;
+        }
+        if (strcmp(series[i].name, point) == 0) {
+            lastSeen[i] = now;
+            return &series[i];
+        }
+        if (now - lastSeen[i] > now - lastSeen[oldest]) {
+            oldest = i;
+        }
+    }
+
+    // Punto nuevo: hueco libre o la serie sin muestras hace más tiempo
+    // (p. ej. un punto que salió del plan)
+    uint8_t slot = (freeSlot >= 0) ? freeSlot : oldest;
+    if (freeSlot < 0) {
+        stats.evictions++;
+    }
+
+    memset(&series[slot], 0, sizeof(AggregateWindow));
+    strncpy(series[slot].name, point, AGGREGATION_MGR_MAX_NAME);
+    used[slot] = true;
+    lastSeen[slot] = now;
+    return &series[slot];
+}
+
+// Copia la ventana de la serie si tiene algo que publicar
+bool AggregationManager::takeWindow(uint8_t slot, AggregateWindow& closed) {
+    AggregateWindow& window = series[slot];
+    if (window.samples == 0 && window.missed == 0) return false;
+
+    closed = window;
+    stats.windowsClosed++;
+    return true;
+}
+
+// Cierra las ventanas cuya duración efectiva ya no es la de su regla: lo
+// acumulado se entrega y la próxima lectura abre la ventana nueva
+void AggregationManager::closeChanged() {
+    AggregateWindow closed;
+
+    for (uint8_t i = 0; i < AGGREGATION_MGR_MAX_SERIES; i++) {
+        lock();
+        bool emit = false;
+        if (used[i]) {
+            const AggregationRule* rule = findRule(series[i].name);
+            uint32_t windowMs = (rule != nullptr) ? rule->windowMs : config.defaultWindowMs;
+            if (windowMs != series[i].windowMs) {
+                emit = takeWindow(i, closed);
+                used[i] = false;
+            }
+        }
+        AggregateWindowCallback callback = windowCallback;
+        unlock();
+
+        if (emit && callback != nullptr) {
+            callback(closed);
+        }
+    }
+}
+
+void AggregationManager::openWindow(AggregateWindow& window, uint32_t windowMs, uint32_t now) {
+    window.windowMs = windowMs;
+    window.start = now - (now % windowMs);
+    window.samples = 0;
+    window.missed = 0;
+    window.channels = 0;
+    for (uint8_t i = 0; i < AGGREGATION_MGR_MAX_CHANNELS; i++) {
+        window.stats[i].reset();
+    }
+}
+
+bool AggregationManager::validWindow(uint32_t windowMs) {
+    return windowMs == 0 || windowMs >= AGGREGATION_MGR_MIN_WINDOW_MS;
+}
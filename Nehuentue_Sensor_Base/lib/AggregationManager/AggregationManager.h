@@ -0,0 +1,207 @@
+/**
+ * @file AggregationManager.h
+ * @brief Agregación por ventanas (min/max/media/desvío/cantidad) en el dispositivo
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @details
+ * En lugar de publicar cada muestra, cada punto acumula sus valores en una
+ * ventana de tiempo y sólo se publica el resumen al cerrarla. La media y
+ * la varianza se calculan con el algoritmo de Welford (una pasada, estable
+ * numéricamente, sin guardar las muestras).
+ *
+ * Las ventanas se alinean a múltiplos de su duración y se cierran con la
+ * primera muestra (o lectura fallida) que cae fuera de ellas, o con
+ * closeExpired() (timer) si el punto deja de leerse. Un cambio de regla o
+ * de punto cierra la ventana abierta en lugar de descartarla.
+ *
+ * Reglas por punto (por nombre):
+ * - windowMs: duración de la ventana (0 = sin agregación)
+ * - raw: además publicar cada muestra cruda
+ * Los puntos sin regla usan la ventana por defecto y no publican crudo.
+ *
+ * Uso:
+ * @code
+ * AggMgr.begin();
+ * AggMgr.setDefaultWindow(60000);
+ * AggMgr.setRule("presion", 10000, true);
+ *
+ * // Por cada lectura:
+ * AggregateWindow closed;
+ * uint8_t result = AggMgr.add("presion", values, count, millis(), closed);
+ * if (result & AGG_EMIT_RAW) { ...publicar muestra... }
+ * if (result & AGG_WINDOW_CLOSED) { ...publicar closed... }
+ *
+ * // Ventanas cerradas fuera de add() (timer, cambios de configuración)
+ * AggMgr.onWindowClosed(publicarVentana);
+ * AggMgr.closeExpired();   // Periódicamente
+ * @endcode
+ */
+
+#ifndef AGGREGATION_MANAGER_H
+#define AGGREGATION_MANAGER_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// ============================================================================
+// CONSTANTES Y CONFIGURACIÓN
+// ============================================================================
+
+#define AGGREGATION_MGR_VERSION "1.0.0"
+#define AGGREGATION_MGR_MAX_SERIES 16         // Puntos agregados a la vez
+#define AGGREGATION_MGR_MAX_CHANNELS 8        // Valores agregados por punto
+#define AGGREGATION_MGR_MAX_RULES 16
+#define AGGREGATION_MGR_MAX_NAME 23
+#define AGGREGATION_MGR_MIN_WINDOW_MS 1000
+
+// Resultado de add()
+#define AGG_EMIT_RAW 0x01                     // Publicar la muestra cruda
+#define AGG_WINDOW_CLOSED 0x02                // Ventana cerrada copiada en closed
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+/**
+ * @brief Estadística incremental de Welford
+ */
+struct RunningStats {
+    uint32_t count;
+    double mean;
+    double m2;                  ///< Suma de cuadrados de las desviaciones
+    float min;
+    float max;
+
+    void reset();
+    void add(float value);
+    float variance() const;     ///< Varianza muestral (n - 1)
+    float stddev() const;
+};
+
+/**
+ * @brief Ventana de un punto
+ */
+struct AggregateWindow {
+    char name[AGGREGATION_MGR_MAX_NAME + 1];
+    uint32_t windowMs;
+    uint32_t start;             ///< millis() del inicio (alineado a windowMs)
+    uint32_t samples;           ///< Lecturas exitosas
+    uint32_t missed;            ///< Lecturas fallidas
+    uint8_t channels;
+    RunningStats stats[AGGREGATION_MGR_MAX_CHANNELS];
+};
+
+/**
+ * @brief Regla de agregación de un punto
+ */
+struct AggregationRule {
+    char name[AGGREGATION_MGR_MAX_NAME + 1];
+    uint32_t windowMs;          ///< 0 = sin agregación
+    bool raw;                   ///< Publicar también cada muestra
+};
+
+/**
+ * @brief Configuración completa (persistible como blob)
+ */
+struct AggregationConfig {
+    uint32_t defaultWindowMs;
+    uint8_t count;
+    AggregationRule rules[AGGREGATION_MGR_MAX_RULES];
+
+    AggregationConfig() {
+        memset(this, 0, sizeof(AggregationConfig));
+    }
+};
+
+/**
+ * @brief Ventana cerrada fuera de add() (timer, reglas o punto cambiados)
+ * @note Se llama sin el mutex tomado, desde la tarea que provocó el cierre
+ */
+typedef void (*AggregateWindowCallback)(const AggregateWindow& window);
+
+struct AggregationStats {
+    uint32_t samples;
+    uint32_t windowsClosed;
+    uint32_t evictions;         ///< Series descartadas por falta de lugar
+};
+
+// ============================================================================
+// CLASE PRINCIPAL
+// ============================================================================
+
+class AggregationManager {
+public:
+    AggregationManager();
+
+    bool begin();
+
+    /**
+     * @brief Agrega una lectura del punto
+     * @param values Valores escalados, nullptr si la lectura falló
+     * @param count Cantidad de valores (se agregan los primeros
+     *        AGGREGATION_MGR_MAX_CHANNELS)
+     * @param closed Recibe la ventana cerrada si el resultado trae AGG_WINDOW_CLOSED
+     * @return Combinación de AGG_EMIT_RAW / AGG_WINDOW_CLOSED
+     */
+    uint8_t add(const char* point, const float* values, uint8_t count, uint32_t now, AggregateWindow& closed);
+
+    /**
+     * @brief Destino de las ventanas cerradas fuera de add()
+     */
+    void onWindowClosed(AggregateWindowCallback callback);
+
+    /**
+     * @brief Cierra las ventanas vencidas aunque su punto no tenga lecturas
+     *        nuevas (llamar periódicamente, p. ej. cada segundo)
+     */
+    void closeExpired();
+
+    /**
+     * @brief Cierra la ventana abierta del punto y libera su serie
+     *        (punto quitado del plan o reconfigurado)
+     */
+    void closeSeries(const char* point);
+
+    // Configuración (se aplica en caliente; una ventana cuya duración
+    // cambia se cierra, se entrega con onWindowClosed y empieza de nuevo)
+    bool setDefaultWindow(uint32_t windowMs);
+    bool setRule(const char* point, uint32_t windowMs, bool raw);
+    bool removeRule(const char* point);
+    bool setConfig(const AggregationConfig& config);
+    void getConfig(AggregationConfig& config);
+
+    /**
+     * @brief Ventana efectiva de un punto (regla o default)
+     */
+    uint32_t windowFor(const char* point);
+
+    AggregationStats getStats() const { return stats; }
+    void printStatus();
+
+private:
+    AggregationConfig config;
+    AggregateWindow series[AGGREGATION_MGR_MAX_SERIES];
+    bool used[AGGREGATION_MGR_MAX_SERIES];
+    uint32_t lastSeen[AGGREGATION_MGR_MAX_SERIES];
+    AggregationStats stats;
+    SemaphoreHandle_t mutex;
+    AggregateWindowCallback windowCallback;
+
+    void lock();
+    void unlock();
+    const AggregationRule* findRule(const char* point) const;
+    AggregateWindow* findSeries(const char* point, uint32_t now);
+    bool takeWindow(uint8_t slot, AggregateWindow& closed);
+    void closeChanged();
+    static void openWindow(AggregateWindow& window, uint32_t windowMs, uint32_t now);
+    static bool validWindow(uint32_t windowMs);
+};
+
+// ============================================================================
+// INSTANCIA GLOBAL
+// ============================================================================
+extern AggregationManager AggMgr;
+
+#endif // AGGREGATION_MANAGER_H
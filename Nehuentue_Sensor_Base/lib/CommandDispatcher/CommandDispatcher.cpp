@@ -0,0 +1,350 @@
+/**
+ * @file CommandDispatcher.cpp
+ * @brief Implementación del CommandDispatcher
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "CommandDispatcher.h"
+#include <MQTTManager.h>
+
+// Instancia global
+CommandDispatcher CmdDispatcher;
+
+// ============================================================================
+// CONTEXTO
+// ============================================================================
+
+bool CommandContext::reply(const JsonDocument& response) {
+    return MqttMgr.publishJSON(replyTopic, response);
+}
+
+bool CommandContext::reply(const char* json) {
+    return MqttMgr.publish(replyTopic, json);
+}
+
+bool CommandContext::replyError(const char* code, const char* param) {
+    StaticJsonDocument<192> response;
+    response["cmd"] = spec.name;
+    response["error"] = code;
+    if (param != nullptr) {
+        response["param"] = param;
+    }
+    return reply(response);
+}
+
+// ============================================================================
+// CONSTRUCTOR
+// ============================================================================
+
+CommandDispatcher::CommandDispatcher() {
+    commandCount = 0;
+    memset(commands, 0, sizeof(commands));
+    memset(table, -1, sizeof(table));
+    memset(&stats, 0, sizeof(CommandDispatcherStats));
+    jobQueue = NULL;
+    freeSlots = NULL;
+    workerHandle = NULL;
+}
+
+// ============================================================================
+// REGISTRO Y BÚSQUEDA
+// ============================================================================
+
+bool CommandDispatcher::registerCommand(const CommandSpec& spec) {
+    if (spec.name == nullptr || spec.handler == nullptr) return false;
+
+    size_t nameLength = strlen(spec.name);
+    if (nameLength == 0 || nameLength > COMMAND_DISPATCHER_MAX_NAME_LENGTH) {
+        Serial.printf("[CMD DISP] Nombre inválido: '%s'\n", spec.name);
+        return false;
+    }
+
+    if (commandCount >= COMMAND_DISPATCHER_MAX_COMMANDS) {
+        Serial.printf("[CMD DISP] ERROR: Tabla llena, no se registra '%s'\n", spec.name);
+        return false;
+    }
+
+    // Sondeo lineal hasta un hueco libre
+    uint32_t mask = COMMAND_DISPATCHER_TABLE_SIZE - 1;
+    uint32_t slot = hash(spec.name) & mask;
+    while (table[slot] >= 0) {
+        if (strcmp(commands[table[slot]]->name, spec.name) == 0) {
+            Serial.printf("[CMD DISP] ERROR: Comando duplicado '%s'\n", spec.name);
+            return false;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    commands[commandCount] = &spec;
+    table[slot] = (int8_t)commandCount;
+    commandCount++;
+    return true;
+}
+
+const CommandSpec* CommandDispatcher::find(const char* name) const {
+    if (name == nullptr) return nullptr;
+
+    uint32_t mask = COMMAND_DISPATCHER_TABLE_SIZE - 1;
+    uint32_t slot = hash(name) & mask;
+    while (table[slot] >= 0) {
+        const CommandSpec* spec = commands[table[slot]];
+        if (strcmp(spec->name, name) == 0) {
+            return spec;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return nullptr;
+}
+
+const CommandSpec* CommandDispatcher::at(size_t index) const {
+    return (index < commandCount) ? commands[index] : nullptr;
+}
+
+// ============================================================================
+// DESPACHO
+// ============================================================================
+
+CommandDispatchStatus CommandDispatcher::dispatch(JsonDocument& request, const char* replyTopic) {
+    const char* name = request["cmd"];
+    if (name == nullptr) {
+        MqttMgr.publish(replyTopic, "{\"error\":\"missing_cmd\"}");
+        return CMD_DISPATCH_MISSING_CMD;
+    }
+
+    const CommandSpec* spec = find(name);
+    if (spec == nullptr) {
+        Serial.printf("[CMD] Comando desconocido: %s\n", name);
+        MqttMgr.publish(replyTopic, "{\"error\":\"unknown_command\"}");
+        stats.unknown++;
+        return CMD_DISPATCH_UNKNOWN;
+    }
+
+    CommandContext ctx(*spec, request, replyTopic);
+
+    const char* badParam = nullptr;
+    bool missing = false;
+    if (!validate(*spec, request, badParam, missing)) {
+        Serial.printf("[CMD] %s: parámetro '%s' %s\n", spec->name, badParam,
+                      missing ? "faltante" : "con tipo inválido");
+        ctx.replyError(missing ? "missing_param" : "invalid_param", badParam);
+        stats.invalid++;
+        return CMD_DISPATCH_INVALID_PARAMS;
+    }
+
+    if ((spec->flags & CMD_FLAG_ASYNC) && workerHandle != NULL) {
+        return enqueue(*spec, request, replyTopic);
+    }
+
+    Serial.printf("[CMD] Ejecutando: %s\n", spec->name);
+    stats.dispatched++;
+    spec->handler(ctx);
+    return CMD_DISPATCH_OK;
+}
+
+// ============================================================================
+// TAREA WORKER
+// ============================================================================
+
+bool CommandDispatcher::startWorker() {
+    if (workerHandle != NULL) return true;
+
+    if (jobQueue == NULL) {
+        jobQueue = xQueueCreate(COMMAND_DISPATCHER_QUEUE_DEPTH, sizeof(CommandJob));
+        if (jobQueue == NULL) {
+            Serial.println("[CMD DISP] ERROR: No se pudo crear cola de trabajos");
+            return false;
+        }
+    }
+
+    if (freeSlots == NULL) {
+        freeSlots = xQueueCreate(COMMAND_DISPATCHER_PAYLOAD_SLOTS, sizeof(uint8_t));
+        if (freeSlots == NULL) {
+            Serial.println("[CMD DISP] ERROR: No se pudo crear pool de buffers");
+            return false;
+        }
+        for (uint8_t i = 0; i < COMMAND_DISPATCHER_PAYLOAD_SLOTS; i++) {
+            xQueueSend(freeSlots, &i, 0);
+        }
+    }
+
+    BaseType_t result = xTaskCreate(workerTask, "cmd_worker", COMMAND_DISPATCHER_TASK_STACK_SIZE,
+                                    this, COMMAND_DISPATCHER_TASK_PRIORITY, &workerHandle);
+    if (result != pdPASS) {
+        workerHandle = NULL;
+        Serial.println("[CMD DISP] ERROR: No se pudo crear tarea worker");
+        return false;
+    }
+
+    Serial.println("[CMD DISP] ✓ Tarea worker iniciada");
+    return true;
+}
+
+void CommandDispatcher::stopWorker() {
+    if (workerHandle == NULL) return;
+
+    vTaskDelete(workerHandle);
+    workerHandle = NULL;
+
+    // Devolver al pool todos los buffers: los de trabajos que no llegaron a
+    // correr y el del que pudo quedar a medias en el worker
+    xQueueReset(jobQueue);
+    xQueueReset(freeSlots);
+    for (uint8_t i = 0; i < COMMAND_DISPATCHER_PAYLOAD_SLOTS; i++) {
+        xQueueSend(freeSlots, &i, 0);
+    }
+
+    Serial.println("[CMD DISP] Tarea worker detenida");
+}
+
+size_t CommandDispatcher::pendingJobs() const {
+    return (jobQueue != NULL) ? uxQueueMessagesWaiting(jobQueue) : 0;
+}
+
+CommandDispatchStatus CommandDispatcher::enqueue(const CommandSpec& spec, JsonDocument& request, const char* replyTopic) {
+    CommandContext ctx(spec, request, replyTopic);
+
+    size_t length = measureJson(request);
+    if (length >= COMMAND_DISPATCHER_MAX_PAYLOAD) {
+        ctx.replyError("payload_too_large");
+        stats.invalid++;
+        return CMD_DISPATCH_INVALID_PARAMS;
+    }
+
+    CommandJob job;
+    job.spec = &spec;
+    strncpy(job.replyTopic, replyTopic, sizeof(job.replyTopic) - 1);
+    job.replyTopic[sizeof(job.replyTopic) - 1] = '\0';
+
+    // Sin espera: el callback MQTT nunca se bloquea por un worker ocupado
+    if (xQueueReceive(freeSlots, &job.slot, 0) != pdTRUE) {
+        Serial.printf("[CMD] %s rechazado: sin buffer libre\n", spec.name);
+        ctx.replyError("no_memory");
+        stats.noMemory++;
+        return CMD_DISPATCH_NO_MEMORY;
+    }
+    job.length = serializeJson(request, payloadPool[job.slot], COMMAND_DISPATCHER_MAX_PAYLOAD);
+
+    if (xQueueSend(jobQueue, &job, 0) != pdTRUE) {
+        xQueueSend(freeSlots, &job.slot, 0);
+        Serial.printf("[CMD] %s rechazado: worker ocupado\n", spec.name);
+        ctx.replyError("busy");
+        stats.rejected++;
+        return CMD_DISPATCH_BUSY;
+    }
+
+    Serial.printf("[CMD] Encolado: %s\n", spec.name);
+    stats.queued++;
+
+    StaticJsonDocument<128> response;
+    response["cmd"] = spec.name;
+    response["status"] = "accepted";
+    ctx.reply(response);
+    return CMD_DISPATCH_QUEUED;
+}
+
+void CommandDispatcher::workerTask(void* parameter) {
+    CommandDispatcher* dispatcher = (CommandDispatcher*)parameter;
+    CommandJob job;
+
+    while (true) {
+        if (xQueueReceive(dispatcher->jobQueue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        // Parseo in-place sobre la copia del trabajo (ya validada): los
+        // strings del documento apuntan al buffer hasta que termina el handler
+        char* payload = dispatcher->payloadPool[job.slot];
+        StaticJsonDocument<COMMAND_DISPATCHER_DOC_SIZE> request;
+        if (deserializeJson(request, payload, job.length)) {
+            xQueueSend(dispatcher->freeSlots, &job.slot, 0);
+            continue;
+        }
+
+        Serial.printf("[CMD] Ejecutando (worker): %s\n", job.spec->name);
+        CommandContext ctx(*job.spec, request, job.replyTopic);
+        dispatcher->stats.dispatched++;
+        job.spec->handler(ctx);
+        xQueueSend(dispatcher->freeSlots, &job.slot, 0);
+    }
+}
+
+bool CommandDispatcher::validate(const CommandSpec& spec, JsonDocument& request,
+                                 const char*& badParam, bool& missing) const {
+    for (uint8_t i = 0; i < spec.paramCount; i++) {
+        const CommandParam& param = spec.params[i];
+        JsonVariant value = request[param.name];
+
+        if (value.isNull()) {
+            if (param.required) {
+                badParam = param.name;
+                missing = true;
+                return false;
+            }
+            continue;
+        }
+
+        bool ok = false;
+        switch (param.type) {
+            case CMD_PARAM_STRING: ok = value.is<const char*>(); break;
+            case CMD_PARAM_INT:    ok = value.is<long>(); break;
+            case CMD_PARAM_FLOAT:  ok = value.is<float>(); break;
+            case CMD_PARAM_BOOL:   ok = value.is<bool>(); break;
+            case CMD_PARAM_OBJECT: ok = value.is<JsonObject>(); break;
+            case CMD_PARAM_ARRAY:  ok = value.is<JsonArray>(); break;
+        }
+
+        if (!ok) {
+            badParam = param.name;
+            missing = false;
+            return false;
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// INFORMACIÓN
+// ============================================================================
+
+void CommandDispatcher::printCommands() {
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   Comandos MQTT registrados            ║");
+    Serial.println("╚════════════════════════════════════════╝");
+    for (size_t i = 0; i < commandCount; i++) {
+        const CommandSpec* spec = commands[i];
+        Serial.printf("  %-16s %s\n", spec->name, spec->description ? spec->description : "");
+        for (uint8_t p = 0; p < spec->paramCount; p++) {
+            Serial.printf("      %s%s: %s\n", spec->params[p].name,
+                          spec->params[p].required ? "" : "?",
+                          paramTypeName(spec->params[p].type));
+        }
+    }
+    Serial.println("════════════════════════════════════════\n");
+}
+
+const char* CommandDispatcher::paramTypeName(CommandParamType type) {
+    switch (type) {
+        case CMD_PARAM_STRING: return "string";
+        case CMD_PARAM_INT: return "int";
+        case CMD_PARAM_FLOAT: return "float";
+        case CMD_PARAM_BOOL: return "bool";
+        case CMD_PARAM_OBJECT: return "object";
+        case CMD_PARAM_ARRAY: return "array";
+        default: return "unknown";
+    }
+}
+
+// ============================================================================
+// MÉTODOS PRIVADOS
+// ============================================================================
+
+uint32_t CommandDispatcher::hash(const char* name) {
+    // FNV-1a 32 bits
+    uint32_t h = 2166136261UL;
+    while (*name) {
+        h ^= (uint8_t)*name++;
+        h *= 16777619UL;
+    }
+    return h;
+}
@@ -0,0 +1,247 @@
+/**
+ * @file CommandDispatcher.h
+ * @brief Despachador de comandos MQTT basado en tabla de registro
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @details
+ * Reemplaza la cadena if/else strcmp de onMqttMessage. Cada subsistema
+ * registra sus comandos (nombre, handler y esquema de parámetros) y el
+ * despachador los busca en una tabla hash de direccionamiento abierto
+ * (FNV-1a), con búsqueda O(1) independiente de la cantidad de comandos.
+ *
+ * Antes de llamar al handler se valida el esquema: parámetros requeridos
+ * y tipo de cada parámetro presente. Los errores se responden de forma
+ * uniforme ({"cmd":...,"error":"missing_param","param":...}).
+ *
+ * Uso:
+ * @code
+ * static const CommandParam setWifiParams[] = {
+ *     {"ssid", CMD_PARAM_STRING, true},
+ *     {"password", CMD_PARAM_STRING, true},
+ * };
+ *
+ * static void cmdSetWifi(CommandContext& ctx) {
+ *     const char* ssid = ctx.request["ssid"];
+ *     ...
+ *     ctx.reply("{\"status\":\"ok\"}");
+ * }
+ *
+ * CmdDispatcher.registerCommand({"set_wifi", cmdSetWifi, CMD_PARAMS(setWifiParams), CMD_FLAG_NONE,
+ *                                "Configura credenciales WiFi"});
+ * @endcode
+ *
+ * Los comandos deben registrarse en setup(), antes de que la tarea MQTT
+ * empiece a despachar (la tabla no se protege con mutex).
+ *
+ * Comandos largos (CMD_FLAG_ASYNC): el callback MQTT sólo los valida y los
+ * encola; una tarea worker los ejecuta y publica la respuesta al terminar.
+ * La cola es acotada: si está llena el comando se rechaza con "busy".
+ */
+
+#ifndef COMMAND_DISPATCHER_H
+#define COMMAND_DISPATCHER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+// ============================================================================
+// CONSTANTES Y CONFIGURACIÓN
+// ============================================================================
+
+#define COMMAND_DISPATCHER_VERSION "1.0.0"
+#define COMMAND_DISPATCHER_MAX_COMMANDS 32
+#define COMMAND_DISPATCHER_TABLE_SIZE 64      // Potencia de 2, >= 2x comandos
+#define COMMAND_DISPATCHER_MAX_NAME_LENGTH 31
+#define COMMAND_DISPATCHER_QUEUE_DEPTH 4          // Comandos async en espera
+// JSON máximo de un trabajo async: lo más grande que entrega PubSubClient
+// (tamaño de cada buffer del pool de copias)
+#ifdef MQTT_MAX_PACKET_SIZE
+#define COMMAND_DISPATCHER_MAX_PAYLOAD MQTT_MAX_PACKET_SIZE
+#else
+#define COMMAND_DISPATCHER_MAX_PAYLOAD 1024
+#endif
+// Buffers de copia: uno por posición de la cola más el que ejecuta el worker
+#define COMMAND_DISPATCHER_PAYLOAD_SLOTS (COMMAND_DISPATCHER_QUEUE_DEPTH + 1)
+#define COMMAND_DISPATCHER_DOC_SIZE 1536          // Documento de un comando parseado
+#define COMMAND_DISPATCHER_MAX_TOPIC 96
+#define COMMAND_DISPATCHER_TASK_STACK_SIZE 8192
+#define COMMAND_DISPATCHER_TASK_PRIORITY 2        // Debajo de la tarea MQTT
+
+// ============================================================================
+// ESQUEMA DE PARÁMETROS
+// ============================================================================
+
+enum CommandParamType {
+    CMD_PARAM_STRING = 0,
+    CMD_PARAM_INT,
+    CMD_PARAM_FLOAT,        ///< Acepta también enteros
+    CMD_PARAM_BOOL,
+    CMD_PARAM_OBJECT,
+    CMD_PARAM_ARRAY
+};
+
+struct CommandParam {
+    const char* name;
+    CommandParamType type;
+    bool required;
+};
+
+#define CMD_PARAMS(array) array, (uint8_t)(sizeof(array) / sizeof(array[0]))
+#define CMD_NO_PARAMS nullptr, 0
+
+// Flags de comando
+#define CMD_FLAG_NONE 0x00
+#define CMD_FLAG_ASYNC 0x01     ///< Se ejecuta en la tarea worker
+
+// ============================================================================
+// CONTEXTO DE EJECUCIÓN
+// ============================================================================
+
+struct CommandSpec;
+
+/**
+ * @brief Contexto que recibe cada handler
+ */
+class CommandContext {
+public:
+    CommandContext(const CommandSpec& spec, JsonDocument& request, const char* replyTopic)
+        : spec(spec), request(request), replyTopic(replyTopic) {}
+
+    const CommandSpec& spec;
+    JsonDocument& request;      ///< Documento ya validado contra el esquema
+    const char* replyTopic;
+
+    /**
+     * @brief Publica la respuesta (serializada directo en la cola MQTT)
+     */
+    bool reply(const JsonDocument& response);
+    bool reply(const char* json);
+
+    /**
+     * @brief Publica {"cmd":..., "error":code[, "param":param]}
+     */
+    bool replyError(const char* code, const char* param = nullptr);
+};
+
+typedef void (*CommandHandler)(CommandContext& ctx);
+
+/**
+ * @brief Definición de un comando (debe tener duración estática)
+ */
+struct CommandSpec {
+    const char* name;
+    CommandHandler handler;
+    const CommandParam* params;
+    uint8_t paramCount;
+    uint8_t flags;              ///< CMD_FLAG_*
+    const char* description;
+};
+
+/**
+ * @brief Resultado de dispatch()
+ */
+enum CommandDispatchStatus {
+    CMD_DISPATCH_OK = 0,
+    CMD_DISPATCH_MISSING_CMD,
+    CMD_DISPATCH_UNKNOWN,
+    CMD_DISPATCH_INVALID_PARAMS,
+    CMD_DISPATCH_QUEUED,        ///< Encolado para la tarea worker
+    CMD_DISPATCH_BUSY,          ///< Cola de trabajos llena, rechazado
+    CMD_DISPATCH_NO_MEMORY      ///< Sin buffer libre para la copia, rechazado
+};
+
+/**
+ * @brief Trabajo encolado para la tarea worker
+ *
+ * El documento original apunta al buffer de PubSubClient (parseo
+ * zero-copy), que deja de ser válido al volver del callback: el trabajo
+ * lleva su propia copia serializada en un buffer del pool fijo.
+ */
+struct CommandJob {
+    const CommandSpec* spec;
+    char replyTopic[COMMAND_DISPATCHER_MAX_TOPIC];
+    uint16_t length;
+    uint8_t slot;               ///< Buffer del pool; lo devuelve el worker
+};
+
+struct CommandDispatcherStats {
+    uint32_t dispatched;
+    uint32_t unknown;
+    uint32_t invalid;
+    uint32_t queued;            ///< Comandos async aceptados
+    uint32_t rejected;          ///< Comandos async rechazados (busy)
+    uint32_t noMemory;          ///< Comandos async sin buffer para la copia
+};
+
+// ============================================================================
+// CLASE PRINCIPAL
+// ============================================================================
+
+class CommandDispatcher {
+public:
+    CommandDispatcher();
+
+    /**
+     * @brief Registra un comando
+     * @return false si el nombre ya existe, es inválido o la tabla está llena
+     */
+    bool registerCommand(const CommandSpec& spec);
+
+    /**
+     * @brief Busca un comando por nombre (O(1))
+     */
+    const CommandSpec* find(const char* name) const;
+
+    /**
+     * @brief Valida y ejecuta el comando indicado en request["cmd"]
+     *
+     * Responde por sí mismo los errores de despacho (missing_cmd,
+     * unknown_command, missing_param, invalid_param).
+     */
+    CommandDispatchStatus dispatch(JsonDocument& request, const char* replyTopic);
+
+    /**
+     * @brief Inicia la tarea worker para comandos CMD_FLAG_ASYNC
+     *
+     * Sin worker, los comandos async se ejecutan en línea (como antes).
+     */
+    bool startWorker();
+    void stopWorker();
+    bool isWorkerRunning() const { return workerHandle != NULL; }
+    size_t pendingJobs() const;
+
+    // Información
+    size_t count() const { return commandCount; }
+    const CommandSpec* at(size_t index) const;
+    CommandDispatcherStats getStats() const { return stats; }
+    void printCommands();
+
+    static const char* paramTypeName(CommandParamType type);
+
+private:
+    const CommandSpec* commands[COMMAND_DISPATCHER_MAX_COMMANDS];
+    int8_t table[COMMAND_DISPATCHER_TABLE_SIZE];  // Índice en commands, -1 = libre
+    size_t commandCount;
+    CommandDispatcherStats stats;
+
+    QueueHandle_t jobQueue;
+    QueueHandle_t freeSlots;    // Índices libres de payloadPool
+    TaskHandle_t workerHandle;
+    char payloadPool[COMMAND_DISPATCHER_PAYLOAD_SLOTS][COMMAND_DISPATCHER_MAX_PAYLOAD];
+
+    static void workerTask(void* parameter);
+    CommandDispatchStatus enqueue(const CommandSpec& spec, JsonDocument& request, const char* replyTopic);
+    static uint32_t hash(const char* name);
+    bool validate(const CommandSpec& spec, JsonDocument& request, const char*& badParam, bool& missing) const;
+};
+
+// ============================================================================
+// INSTANCIA GLOBAL
+// ============================================================================
+extern CommandDispatcher CmdDispatcher;
+
+#endif // COMMAND_DISPATCHER_H
@@ -0,0 +1,467 @@
+/**
+ * @file ConfigCommitManager.cpp
+ * @brief Implementación del ConfigCommitManager
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "ConfigCommitManager.h"
+#include <esp_crc.h>
+#include <esp_partition.h>
+
+// Instancia global
+ConfigCommitManager ConfigMgr;
+
+// ============================================================================
+// CONSTRUCTOR Y DESTRUCTOR
+// ============================================================================
+
+ConfigCommitManager::ConfigCommitManager() {
+    storage = nullptr;
+    memset(entries, 0, sizeof(entries));
+    keyCount = 0;
+    debounceMs = CONFIG_COMMIT_DEFAULT_DEBOUNCE_MS;
+    firstChange = 0;
+    lastChange = 0;
+    memset(&totals, 0, sizeof(totals));
+    mutex = NULL;
+}
+
+ConfigCommitManager::~ConfigCommitManager() {
+    for (uint8_t i = 0; i < keyCount; i++) {
+        clearPending(entries[i]);
+    }
+    if (mutex != NULL) {
+        vSemaphoreDelete(mutex);
+        mutex = NULL;
+    }
+}
+
+// ============================================================================
+// INICIALIZACIÓN
+// ============================================================================
+
+bool ConfigCommitManager::begin(FlashStorageManager& flash, uint32_t debounce) {
+    if (mutex == NULL) {
+        mutex = xSemaphoreCreateMutex();
+        if (mutex == NULL) {
+            Serial.println("[CONFIG] ERROR: No se pudo crear mutex");
+            return false;
+        }
+    }
+
+    storage = &flash;
+    debounceMs = debounce;
+
+    Serial.printf("[CONFIG] Commits diferidos: ventana %lu ms (máx. %lu ms)\n",
+                  debounceMs, (unsigned long)CONFIG_COMMIT_MAX_DELAY_MS);
+    return true;
+}
+
+// ============================================================================
+// ESCENIFICACIÓN
+// ============================================================================
+
+ConfigStageResult ConfigCommitManager::stageString(const char* key, const char* value) {
+    if (value == nullptr) return CONFIG_STAGE_ERROR;
+    if (strlen(value) > FLASH_STORAGE_MAX_STRING_LENGTH) return CONFIG_STAGE_ERROR;
+    return stageValue(key, CONFIG_VALUE_STRING, value, strlen(value) + 1);
+}
+
+ConfigStageResult ConfigCommitManager::stageInt(const char* key, int32_t value) {
+    return stageValue(key, CONFIG_VALUE_INT, &value, sizeof(value));
+}
+
+ConfigStageResult ConfigCommitManager::stageBlob(const char* key, const void* data, size_t size) {
+    if (size + sizeof(FlashStorageHeader) > FLASH_STORAGE_MAX_BLOB_SIZE) return CONFIG_STAGE_ERROR;
+    return stageValue(key, CONFIG_VALUE_BLOB, data, size);
+}
+
+ConfigStageResult ConfigCommitManager::stageRaw(const char* key, const void* data, size_t size) {
+    if (size == 0 || size > FLASH_STORAGE_MAX_BLOB_SIZE) return CONFIG_STAGE_ERROR;
+    return stageValue(key, CONFIG_VALUE_RAW, data, size);
+}
+
+ConfigStageResult ConfigCommitManager::stageValue(const char* key, ConfigValueType type,
+                                                  const void* data, size_t size) {
+    if (storage == nullptr || mutex == NULL) return CONFIG_STAGE_ERROR;
+    if (key == nullptr || data == nullptr) return CONFIG_STAGE_ERROR;
+    if (strlen(key) == 0 || strlen(key) > FLASH_STORAGE_MAX_KEY_LENGTH) return CONFIG_STAGE_ERROR;
+
+    lock();
+
+    Entry* entry = findEntry(key, true);
+    if (entry == nullptr) {
+        unlock();
+        Serial.printf("[CONFIG] ERROR: Sin lugar para la clave '%s'\n", key);
+        return CONFIG_STAGE_ERROR;
+    }
+    entry->type = type;
+
+    // Primera vez que se toca la clave: sembrar el hash con lo que hay en NVS
+    if (!entry->hashKnown) {
+        seedHash(*entry, size);
+    }
+
+    uint32_t hash = hashValue(type, data, size);
+    bool matchesFlash = entry->hashKnown && hash == entry->committedHash;
+    ConfigStageResult result;
+
+    // Antes de pisar un pendiente: reemplazarlo no reinicia el plazo máximo
+    bool anyPending = totals.pending > 0;
+
+    if (entry->stats.pending && hash == entry->pendingHash) {
+        // Mismo valor que ya espera commit
+        entry->stats.skipped++;
+        totals.skipped++;
+        unlock();
+        return CONFIG_STAGE_PENDING;
+    }
+
+    if (entry->stats.pending) {
+        // El valor pendiente se pisa sin llegar a escribirse
+        entry->stats.coalesced++;
+        totals.coalesced++;
+        clearPending(*entry);
+        totals.pending--;
+    }
+
+    if (matchesFlash) {
+        entry->stats.skipped++;
+        totals.skipped++;
+        result = CONFIG_STAGE_UNCHANGED;
+    } else {
+        entry->pendingData = (uint8_t*)malloc(size);
+        if (entry->pendingData == nullptr) {
+            unlock();
+            Serial.printf("[CONFIG] ERROR: Sin memoria para '%s'\n", key);
+            return CONFIG_STAGE_ERROR;
+        }
+        memcpy(entry->pendingData, data, size);
+        entry->pendingSize = size;
+        entry->pendingHash = hash;
+        entry->stats.pending = true;
+
+        unsigned long now = millis();
+        if (!anyPending) {
+            firstChange = now;
+        }
+        lastChange = now;
+        totals.pending++;
+        result = CONFIG_STAGE_PENDING;
+    }
+
+    unlock();
+    return result;
+}
+
+// ============================================================================
+// COMMIT
+// ============================================================================
+
+bool ConfigCommitManager::loop() {
+    if (mutex == NULL) return false;
+
+    lock();
+
+    if (totals.pending == 0) {
+        unlock();
+        return false;
+    }
+
+    // Debounce: esperar una ventana sin cambios, pero no más que el máximo
+    unsigned long now = millis();
+    bool quiet = (now - lastChange) >= debounceMs;
+    bool overdue = (now - firstChange) >= CONFIG_COMMIT_MAX_DELAY_MS;
+    if (!quiet && !overdue) {
+        unlock();
+        return false;
+    }
+
+    commitLocked();
+    unlock();
+    return true;
+}
+
+bool ConfigCommitManager::flush() {
+    if (mutex == NULL) return true;
+
+    lock();
+    bool ok = (totals.pending == 0) || commitLocked();
+    unlock();
+    return ok;
+}
+
+void ConfigCommitManager::discard() {
+    if (mutex == NULL) return;
+
+    lock();
+    for (uint8_t i = 0; i < keyCount; i++) {
+        clearPending(entries[i]);
+    }
+    if (totals.pending > 0) {
+        Serial.printf("[CONFIG] %u clave(s) pendientes descartadas\n", totals.pending);
+    }
+    totals.pending = 0;
+    unlock();
+}
+
+bool ConfigCommitManager::hasPending() {
+    lock();
+    bool pending = totals.pending > 0;
+    unlock();
+    return pending;
+}
+
+bool ConfigCommitManager::commitLocked() {
+    // Todas las claves pendientes en un lote: se escriben todas o ninguna
+    FlashStorageBatch batch;
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < keyCount; i++) {
+        Entry& entry = entries[i];
+        if (!entry.stats.pending) continue;
+
+        FlashStorageStatus staged = addToBatch(batch, entry);
+        if (staged != FLASH_STORAGE_OK) {
+            Serial.printf("[CONFIG] ERROR: No se pudo preparar '%s' (%d)\n", entry.stats.key, staged);
+            break;
+        }
+        count++;
+    }
+
+    FlashStorageStatus status = (count == totals.pending)
+        ? storage->commitBatch(batch)
+        : FLASH_STORAGE_ERROR_SIZE_TOO_LARGE;
+
+    totals.commits++;
+    totals.lastCommit = millis();
+
+    if (status != FLASH_STORAGE_OK) {
+        for (uint8_t i = 0; i < keyCount; i++) {
+            if (!entries[i].stats.pending) continue;
+            entries[i].stats.failures++;
+            totals.failures++;
+        }
+        // Reintentar después de otra ventana completa
+        firstChange = lastChange = totals.lastCommit;
+        Serial.printf("[CONFIG] ERROR: Commit de %u clave(s) revertido (%d)\n", totals.pending, status);
+        return false;
+    }
+
+    for (uint8_t i = 0; i < keyCount; i++) {
+        Entry& entry = entries[i];
+        if (!entry.stats.pending) continue;
+
+        uint32_t cost = entryCost(entry.type, entry.pendingSize);
+        entry.stats.writes++;
+        entry.stats.entries += cost;
+        totals.writes++;
+        totals.entries += cost;
+
+        entry.committedHash = entry.pendingHash;
+        entry.hashKnown = true;
+        clearPending(entry);
+    }
+    totals.pending = 0;
+
+    Serial.printf("[CONFIG] Commit: %u clave(s) escrita(s)\n", count);
+    return true;
+}
+
+FlashStorageStatus ConfigCommitManager::addToBatch(FlashStorageBatch& batch, const Entry& entry) {
+    switch (entry.type) {
+        case CONFIG_VALUE_STRING:
+            return batch.putString(entry.stats.key, (const char*)entry.pendingData);
+        case CONFIG_VALUE_INT: {
+            int32_t value;
+            memcpy(&value, entry.pendingData, sizeof(value));
+            return batch.putInt(entry.stats.key, value);
+        }
+        case CONFIG_VALUE_RAW:
+            return batch.putBytes(entry.stats.key, entry.pendingData, entry.pendingSize, false);
+        default:
+            return batch.putBytes(entry.stats.key, entry.pendingData, entry.pendingSize);
+    }
+}
+
+// ============================================================================
+// ESTADÍSTICAS Y DESGASTE
+// ============================================================================
+
+bool ConfigCommitManager::getKey(uint8_t index, ConfigKeyStats& out) {
+    if (index >= keyCount) return false;
+
+    lock();
+    out = entries[index].stats;
+    unlock();
+    return true;
+}
+
+ConfigCommitStats ConfigCommitManager::getStats() {
+    lock();
+    ConfigCommitStats copy = totals;
+    unlock();
+    return copy;
+}
+
+float ConfigCommitManager::getEntriesPerDay() {
+    uint32_t uptimeS = millis() / 1000;
+    if (uptimeS < CONFIG_COMMIT_MIN_FORECAST_S) return -1.0f;
+
+    return (float)getStats().entries * 86400.0f / uptimeS;
+}
+
+float ConfigCommitManager::getForecastYears() {
+    float perDay = getEntriesPerDay();
+    if (perDay <= 0.0f) return -1.0f;
+
+    const esp_partition_t* nvs = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                          (esp_partition_subtype_t)ESP_PARTITION_SUBTYPE_DATA_NVS,
+                                                          NULL);
+    if (nvs == NULL) return -1.0f;
+
+    // NVS escribe en forma circular y deja siempre una página libre: cada
+    // vuelta completa borra cada sector una vez
+    uint32_t pages = nvs->size / SPI_FLASH_SEC_SIZE;
+    if (pages < 2) return -1.0f;
+    float entriesPerCycle = (float)(pages - 1) * CONFIG_COMMIT_NVS_PAGE_ENTRIES;
+
+    float cyclesPerDay = perDay / entriesPerCycle;
+    return (float)CONFIG_COMMIT_FLASH_CYCLES / cyclesPerDay / 365.0f;
+}
+
+void ConfigCommitManager::printStatus() {
+    ConfigCommitStats stats = getStats();
+
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   Config Commit - Estado               ║");
+    Serial.println("╚════════════════════════════════════════╝");
+    Serial.printf("  Ventana: %lu ms\n", debounceMs);
+    Serial.printf("  Commits: %lu (pendientes: %u)\n", stats.commits, stats.pending);
+    Serial.printf("  Escrituras: %lu, descartadas: %lu, agrupadas: %lu, errores: %lu\n",
+                  stats.writes, stats.skipped, stats.coalesced, stats.failures);
+    Serial.printf("  Entradas NVS: %lu\n", stats.entries);
+
+    float years = getForecastYears();
+    if (years >= 0.0f) {
+        Serial.printf("  Vida útil estimada NVS: %.1f años\n", years);
+    } else {
+        Serial.println("  Vida útil estimada NVS: sin datos suficientes");
+    }
+
+    Serial.println("  Clave            Escrit.  Descart.  Agrup.  Entradas");
+    for (uint8_t i = 0; i < keyCount; i++) {
+        ConfigKeyStats key;
+        getKey(i, key);
+        Serial.printf("  %-15s %c %7lu  %8lu  %6lu  %8lu\n",
+                      key.key, key.pending ? '*' : ' ', key.writes, key.skipped,
+                      key.coalesced, key.entries);
+    }
+    Serial.println("════════════════════════════════════════\n");
+}
+
+// ============================================================================
+// MÉTODOS PRIVADOS
+// ============================================================================
+
+ConfigCommitManager::Entry* ConfigCommitManager::findEntry(const char* key, bool create) {
+    for (uint8_t i = 0; i < keyCount; i++) {
+        if (strcmp(entries[i].stats.key, key) == 0) {
+            return &entries[i];
+        }
+    }
+
+    if (!create || keyCount >= CONFIG_COMMIT_MAX_KEYS) return nullptr;
+
+    Entry* entry = &entries[keyCount++];
+    memset(entry, 0, sizeof(Entry));
+    strncpy(entry->stats.key, key, FLASH_STORAGE_MAX_KEY_LENGTH);
+    return entry;
+}
+
+void ConfigCommitManager::seedHash(Entry& entry, size_t size) {
+    // Si la clave no existe (o no se puede leer) el hash queda desconocido y
+    // el primer valor se escribe siempre
+    switch (entry.type) {
+        case CONFIG_VALUE_STRING: {
+            String value;
+            if (storage->loadString(entry.stats.key, value) == FLASH_STORAGE_OK) {
+                entry.committedHash = hashValue(entry.type, value.c_str(), value.length() + 1);
+                entry.hashKnown = true;
+            }
+            break;
+        }
+        case CONFIG_VALUE_INT: {
+            if (storage->exists(entry.stats.key)) {
+                int32_t value = storage->loadInt(entry.stats.key, (int32_t)0);
+                entry.committedHash = hashValue(entry.type, &value, sizeof(value));
+                entry.hashKnown = true;
+            }
+            break;
+        }
+        default: {
+            uint8_t* buffer = (uint8_t*)malloc(size);
+            if (buffer == nullptr) return;
+            FlashStorageStatus status;
+            if (entry.type == CONFIG_VALUE_RAW) {
+                // Un blob de otro largo es otro valor: el hash queda desconocido
+                size_t length;
+                status = storage->loadRawBytes(entry.stats.key, buffer, size, length);
+                if (status == FLASH_STORAGE_OK && length != size) status = FLASH_STORAGE_ERROR_READ_FAILED;
+            } else {
+                status = storage->loadBytes(entry.stats.key, buffer, size);
+            }
+            if (status == FLASH_STORAGE_OK) {
+                entry.committedHash = hashValue(entry.type, buffer, size);
+                entry.hashKnown = true;
+            }
+            free(buffer);
+            break;
+        }
+    }
+}
+
+void ConfigCommitManager::clearPending(Entry& entry) {
+    if (entry.pendingData != nullptr) {
+        free(entry.pendingData);
+        entry.pendingData = nullptr;
+    }
+    entry.pendingSize = 0;
+    entry.stats.pending = false;
+}
+
+uint32_t ConfigCommitManager::hashValue(ConfigValueType type, const void* data, size_t size) {
+    // El tipo entra en el hash: "1" como string y 1 como int no son iguales
+    uint8_t tag = (uint8_t)type;
+    uint32_t crc = esp_crc32_le(0, &tag, 1);
+    return esp_crc32_le(crc, (const uint8_t*)data, size);
+}
+
+uint32_t ConfigCommitManager::entryCost(ConfigValueType type, size_t size) {
+    // Entradas de 32 bytes: los enteros caben en una; strings llevan una
+    // de cabecera y los blobs dos (índice + fragmento de datos)
+    switch (type) {
+        case CONFIG_VALUE_INT:
+            return 1;
+        case CONFIG_VALUE_STRING:
+            return 1 + (size + CONFIG_COMMIT_NVS_ENTRY_SIZE - 1) / CONFIG_COMMIT_NVS_ENTRY_SIZE;
+        case CONFIG_VALUE_RAW:
+            return 2 + (size + CONFIG_COMMIT_NVS_ENTRY_SIZE - 1) / CONFIG_COMMIT_NVS_ENTRY_SIZE;
+        default:
+            size += sizeof(FlashStorageHeader);
+            return 2 + (size + CONFIG_COMMIT_NVS_ENTRY_SIZE - 1) / CONFIG_COMMIT_NVS_ENTRY_SIZE;
+    }
+}
+
+void ConfigCommitManager::lock() {
+    if (mutex != NULL) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+    }
+}
+
+void ConfigCommitManager::unlock() {
+    if (mutex != NULL) {
+        xSemaphoreGive(mutex);
+    }
+}
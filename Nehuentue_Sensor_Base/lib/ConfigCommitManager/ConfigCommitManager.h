@@ -0,0 +1,226 @@
+/**
+ * @file ConfigCommitManager.h
+ * @brief Commits diferidos de configuración a NVS: sin escrituras repetidas y agrupados
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @details
+ * Los comandos de configuración (set_wifi, set_mqtt, set_sensor, ...) no
+ * escriben la flash: "escenifican" cada clave aquí y siguen. El manager:
+ *
+ * - Compara el hash (CRC32) del valor con el del último valor escrito y
+ *   descarta las escrituras idénticas. El hash de cada clave se siembra
+ *   leyendo NVS la primera vez que se escenifica.
+ * - Agrupa los cambios: se escriben juntos cuando pasa la ventana de
+ *   debounce sin cambios nuevos (o a lo sumo CONFIG_COMMIT_MAX_DELAY_MS
+ *   después del primero). Un valor reescrito dentro de la ventana cuesta
+ *   una sola escritura; uno que vuelve al valor guardado, ninguna.
+ * - Cuenta por clave escrituras, descartes y entradas NVS consumidas, y con
+ *   eso estima la vida útil de la partición NVS al ritmo actual.
+ *
+ * Cada commit es un FlashStorageBatch: las claves pendientes se escriben
+ * todas o ninguna, con el mismo formato que saveString/saveInt/save<T>, así
+ * que la carga en el arranque no cambia.
+ *
+ * Uso:
+ * @code
+ * ConfigMgr.begin(FlashStorage, 2000);
+ *
+ * ConfigMgr.stageString("mqtt_server", server);
+ * ConfigMgr.stageInt("mqtt_port", port);
+ * ConfigMgr.stage("agg_config", aggregation);
+ *
+ * void loop() { ConfigMgr.loop(); }     // escribe cuando vence la ventana
+ * ConfigMgr.flush();                     // antes de reiniciar
+ * @endcode
+ */
+
+#ifndef CONFIG_COMMIT_MANAGER_H
+#define CONFIG_COMMIT_MANAGER_H
+
+#include <Arduino.h>
+#include <FlashStorageManager.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// ============================================================================
+// CONSTANTES Y CONFIGURACIÓN
+// ============================================================================
+
+#define CONFIG_COMMIT_VERSION "1.0.0"
+#define CONFIG_COMMIT_MAX_KEYS 16
+#define CONFIG_COMMIT_DEFAULT_DEBOUNCE_MS 2000
+#define CONFIG_COMMIT_MAX_DELAY_MS 10000      // Cambios continuos no postergan el commit para siempre
+
+// Modelo de desgaste de NVS (entradas de 32 bytes, 126 por página de 4 KB)
+#define CONFIG_COMMIT_NVS_ENTRY_SIZE 32
+#define CONFIG_COMMIT_NVS_PAGE_ENTRIES 126
+#define CONFIG_COMMIT_FLASH_CYCLES 100000     // Ciclos de borrado garantizados por sector
+#define CONFIG_COMMIT_MIN_FORECAST_S 3600     // Ritmo medido en menos tiempo no es representativo
+
+// ============================================================================
+// ENUMERACIONES
+// ============================================================================
+
+/**
+ * @brief Resultado de escenificar un valor
+ */
+enum ConfigStageResult {
+    CONFIG_STAGE_UNCHANGED = 0,     ///< Igual a lo guardado: no se escribirá
+    CONFIG_STAGE_PENDING,           ///< Se escribirá en el próximo commit
+    CONFIG_STAGE_ERROR              ///< Clave inválida, sin lugar o sin memoria
+};
+
+enum ConfigValueType {
+    CONFIG_VALUE_STRING = 0,
+    CONFIG_VALUE_INT,
+    CONFIG_VALUE_BLOB,              ///< Con header de FlashStorageManager (save<T>)
+    CONFIG_VALUE_RAW                ///< Sin header: el formato trae su propia versión y CRC
+};
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+/**
+ * @brief Contadores de una clave (desde el arranque)
+ */
+struct ConfigKeyStats {
+    char key[FLASH_STORAGE_MAX_KEY_LENGTH + 1];
+    uint32_t writes;            ///< Escrituras efectivas a NVS
+    uint32_t skipped;           ///< Escenificaciones idénticas a lo guardado
+    uint32_t coalesced;         ///< Valores pisados antes de escribirse
+    uint32_t failures;
+    uint32_t entries;           ///< Entradas NVS escritas (estimadas)
+    bool pending;
+};
+
+/**
+ * @brief Totales del manager
+ */
+struct ConfigCommitStats {
+    uint32_t commits;           ///< Pasadas de escritura
+    uint32_t writes;
+    uint32_t skipped;
+    uint32_t coalesced;
+    uint32_t failures;
+    uint32_t entries;
+    uint8_t pending;            ///< Claves esperando commit
+    unsigned long lastCommit;   ///< millis() del último commit (0 = ninguno)
+};
+
+// ============================================================================
+// CLASE PRINCIPAL
+// ============================================================================
+
+class ConfigCommitManager {
+public:
+    ConfigCommitManager();
+    ~ConfigCommitManager();
+
+    /**
+     * @param storage Almacenamiento ya inicializado
+     * @param debounceMs Ventana sin cambios antes de escribir
+     */
+    bool begin(FlashStorageManager& storage, uint32_t debounceMs = CONFIG_COMMIT_DEFAULT_DEBOUNCE_MS);
+
+    // ========================================================================
+    // ESCENIFICACIÓN
+    // ========================================================================
+
+    ConfigStageResult stageString(const char* key, const char* value);
+    ConfigStageResult stageInt(const char* key, int32_t value);
+    ConfigStageResult stageBlob(const char* key, const void* data, size_t size);
+    ConfigStageResult stageRaw(const char* key, const void* data, size_t size);
+
+    template<typename T>
+    ConfigStageResult stage(const char* key, const T& data) {
+        return stageBlob(key, &data, sizeof(T));
+    }
+
+    // ========================================================================
+    // COMMIT
+    // ========================================================================
+
+    /**
+     * @brief Escribe si venció la ventana (llamar periódicamente)
+     * @return true si hubo commit
+     */
+    bool loop();
+
+    /**
+     * @brief Escribe ya todo lo pendiente
+     * @return false si el lote falló (todo queda pendiente)
+     */
+    bool flush();
+
+    /**
+     * @brief Descarta lo pendiente sin escribir
+     */
+    void discard();
+
+    bool hasPending();
+
+    // ========================================================================
+    // ESTADÍSTICAS Y DESGASTE
+    // ========================================================================
+
+    uint8_t getKeyCount() const { return keyCount; }
+    bool getKey(uint8_t index, ConfigKeyStats& out);
+    ConfigCommitStats getStats();
+
+    /**
+     * @brief Entradas NVS escritas por día al ritmo medido desde el arranque
+     * @return < 0 si todavía no hay suficiente tiempo medido
+     */
+    float getEntriesPerDay();
+
+    /**
+     * @brief Años hasta agotar los ciclos de borrado de la partición NVS
+     * @return < 0 si no hay ritmo medido o no hay escrituras
+     */
+    float getForecastYears();
+
+    uint32_t getDebounceMs() const { return debounceMs; }
+    void printStatus();
+
+private:
+    struct Entry {
+        ConfigKeyStats stats;
+        ConfigValueType type;
+        bool hashKnown;         // committedHash refleja lo que hay en NVS
+        uint32_t committedHash;
+        uint32_t pendingHash;
+        uint8_t* pendingData;   // Copia del valor pendiente (heap)
+        size_t pendingSize;
+    };
+
+    FlashStorageManager* storage;
+    Entry entries[CONFIG_COMMIT_MAX_KEYS];
+    uint8_t keyCount;
+    uint32_t debounceMs;
+    unsigned long firstChange;  // Cambio pendiente más antiguo
+    unsigned long lastChange;
+    ConfigCommitStats totals;
+    SemaphoreHandle_t mutex;
+
+    ConfigStageResult stageValue(const char* key, ConfigValueType type, const void* data, size_t size);
+    Entry* findEntry(const char* key, bool create);
+    void seedHash(Entry& entry, size_t size);
+    FlashStorageStatus addToBatch(FlashStorageBatch& batch, const Entry& entry);
+    bool commitLocked();
+    void clearPending(Entry& entry);
+
+    static uint32_t hashValue(ConfigValueType type, const void* data, size_t size);
+    static uint32_t entryCost(ConfigValueType type, size_t size);
+
+    void lock();
+    void unlock();
+};
+
+// ============================================================================
+// INSTANCIA GLOBAL
+// ============================================================================
+extern ConfigCommitManager ConfigMgr;
+
+#endif // CONFIG_COMMIT_MANAGER_H
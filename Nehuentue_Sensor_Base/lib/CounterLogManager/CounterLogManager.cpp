@@ -0,0 +1,322 @@
+/**
+ * @file CounterLogManager.cpp
+ * @brief Implementación del CounterLogManager
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "CounterLogManager.h"
+#include <esp_crc.h>
+
+// Instancia global
+CounterLogManager CounterLog;
+
+#define RECORD_HEADER_SIZE ((uint16_t)sizeof(CounterLogRecordHeader))
+
+// ============================================================================
+// CONSTRUCTOR Y DESTRUCTOR
+// ============================================================================
+
+CounterLogManager::CounterLogManager() {
+    partition = NULL;
+    mutex = NULL;
+    initialized = false;
+    sectorCount = 0;
+    slotsPerSector = COUNTER_LOG_SECTOR_SIZE / COUNTER_LOG_SLOT_SIZE;
+    writeSector = 0;
+    writeSlot = 0;
+    hasLatest = false;
+    latestSchema = 0;
+    latestLength = 0;
+    memset(latest, 0, sizeof(latest));
+    memset(&stats, 0, sizeof(CounterLogStats));
+}
+
+CounterLogManager::~CounterLogManager() {
+    end();
+}
+
+// ============================================================================
+// INICIALIZACIÓN
+// ============================================================================
+
+bool CounterLogManager::begin(const char* label) {
+    if (initialized) {
+        Serial.println("[COUNTER LOG] Ya inicializado");
+        return true;
+    }
+
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   Counter Log Manager v1.0             ║");
+    Serial.println("╚════════════════════════════════════════╝");
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                         (esp_partition_subtype_t)COUNTER_LOG_PARTITION_SUBTYPE,
+                                         label);
+    if (partition == NULL) {
+        Serial.printf("[COUNTER LOG] ERROR: Partición '%s' no encontrada (revisa partitions.csv)\n", label);
+        return false;
+    }
+
+    // Con un solo sector, abrir el siguiente borraría el último registro
+    sectorCount = partition->size / COUNTER_LOG_SECTOR_SIZE;
+    if (sectorCount < 2) {
+        Serial.println("[COUNTER LOG] ERROR: Se necesitan al menos 2 sectores");
+        partition = NULL;
+        return false;
+    }
+
+    mutex = xSemaphoreCreateMutex();
+    if (mutex == NULL) {
+        Serial.println("[COUNTER LOG] ERROR: No se pudo crear mutex");
+        partition = NULL;
+        return false;
+    }
+
+    unsigned long start = micros();
+    if (!recover()) {
+        Serial.println("[COUNTER LOG] ERROR: No se pudo recuperar el log");
+        vSemaphoreDelete(mutex);
+        mutex = NULL;
+        partition = NULL;
+        return false;
+    }
+    stats.recoveryUs = micros() - start;
+
+    initialized = true;
+
+    Serial.printf("  Partición: %s (0x%06lX, %lu KB)\n", partition->label,
+                  (unsigned long)partition->address, (unsigned long)(partition->size / 1024));
+    Serial.printf("  Registros: %u sectores x %u (%u bytes c/u)\n",
+                  sectorCount, slotsPerSector, COUNTER_LOG_SLOT_SIZE);
+    if (hasLatest) {
+        Serial.printf("  Último registro: #%lu (sector %u), recuperado en %lu us\n",
+                      stats.sequence, writeSector, stats.recoveryUs);
+    } else {
+        Serial.println("  Log vacío");
+    }
+    if (stats.corrupted > 0) {
+        Serial.printf("  Registros inválidos ignorados: %lu\n", stats.corrupted);
+    }
+    Serial.println("════════════════════════════════════════\n");
+
+    return true;
+}
+
+void CounterLogManager::end() {
+    if (initialized) {
+        initialized = false;
+        Serial.println("[COUNTER LOG] Finalizado");
+    }
+
+    if (mutex != NULL) {
+        vSemaphoreDelete(mutex);
+        mutex = NULL;
+    }
+
+    partition = NULL;
+}
+
+// ============================================================================
+// OPERACIONES
+// ============================================================================
+
+bool CounterLogManager::load(void* data, size_t length, uint8_t schema) {
+    if (!initialized || data == NULL) return false;
+    if (!lock()) return false;
+
+    bool ok = hasLatest && latestSchema == schema && latestLength == length;
+    if (ok) {
+        memcpy(data, latest, length);
+    } else if (hasLatest) {
+        Serial.printf("[COUNTER LOG] Registro #%lu de otro esquema (v%u, %u bytes), se ignora\n",
+                      stats.sequence, latestSchema, latestLength);
+    }
+
+    unlock();
+    return ok;
+}
+
+bool CounterLogManager::append(const void* data, size_t length, uint8_t schema) {
+    if (!initialized || data == NULL || length == 0 || length > COUNTER_LOG_MAX_DATA) return false;
+    if (!lock()) return false;
+
+    // Sin cambios desde el último checkpoint: no se gasta un registro
+    if (hasLatest && latestSchema == schema && latestLength == length && memcmp(latest, data, length) == 0) {
+        stats.skipped++;
+        unlock();
+        return true;
+    }
+
+    if (writeSlot >= slotsPerSector && !openNextSector()) {
+        stats.writeErrors++;
+        unlock();
+        return false;
+    }
+
+    uint8_t slot[COUNTER_LOG_SLOT_SIZE];
+    memset(slot, 0xFF, sizeof(slot));
+
+    CounterLogRecordHeader header;
+    header.magic = COUNTER_LOG_RECORD_MAGIC;
+    header.schema = schema;
+    header.length = (uint8_t)length;
+    header.sequence = stats.sequence + 1;
+    header.crc = recordCrc(header, (const uint8_t*)data);
+
+    memcpy(slot, &header, RECORD_HEADER_SIZE);
+    memcpy(slot + RECORD_HEADER_SIZE, data, length);
+
+    // Una sola escritura por registro; un corte deja un CRC que no coincide
+    size_t address = (size_t)writeSector * COUNTER_LOG_SECTOR_SIZE + (size_t)writeSlot * COUNTER_LOG_SLOT_SIZE;
+    size_t size = (RECORD_HEADER_SIZE + length + 3) & ~(size_t)3;
+    bool ok = esp_partition_write(partition, address, slot, size) == ESP_OK;
+
+    // Aunque falle, el lugar ya no está borrado: avanzar igual
+    writeSlot++;
+
+    if (ok) {
+        stats.appended++;
+        stats.sequence = header.sequence;
+        hasLatest = true;
+        latestSchema = schema;
+        latestLength = (uint8_t)length;
+        memcpy(latest, data, length);
+    } else {
+        stats.writeErrors++;
+        Serial.println("[COUNTER LOG] ERROR: Escritura en flash fallida");
+    }
+
+    unlock();
+    return ok;
+}
+
+// ============================================================================
+// INFORMACIÓN
+// ============================================================================
+
+void CounterLogManager::printStats() {
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   Counter Log - Estadísticas           ║");
+    Serial.println("╚════════════════════════════════════════╝");
+    Serial.printf("  Estado: %s\n", initialized ? "✓ Activo" : "✗ Inactivo");
+    if (initialized) {
+        Serial.printf("  Último registro: #%lu (sector %u, lugar %u de %u)\n",
+                      stats.sequence, writeSector, writeSlot, slotsPerSector);
+        Serial.printf("  Capacidad: %lu registros por vuelta\n", getCapacity());
+    }
+    Serial.printf("  Escritos: %lu (sin cambios: %lu)\n", stats.appended, stats.skipped);
+    Serial.printf("  Borrados de sector: %lu\n", stats.erases);
+    Serial.printf("  Errores de escritura: %lu\n", stats.writeErrors);
+    Serial.printf("  Inválidos al recuperar: %lu\n", stats.corrupted);
+    Serial.println("════════════════════════════════════════\n");
+}
+
+// ============================================================================
+// PRIVADOS
+// ============================================================================
+
+bool CounterLogManager::lock() {
+    return xSemaphoreTake(mutex, pdMS_TO_TICKS(COUNTER_LOG_TIMEOUT_MS)) == pdTRUE;
+}
+
+void CounterLogManager::unlock() {
+    xSemaphoreGive(mutex);
+}
+
+bool CounterLogManager::recover() {
+    CounterLogRecordHeader header;
+    uint8_t data[COUNTER_LOG_MAX_DATA];
+
+    // 1. Sector más nuevo: el de mayor secuencia en su primer registro válido
+    //    (los sectores se llenan en orden, así que basta con uno por sector)
+    int32_t newestSector = -1;
+    uint32_t newestSequence = 0;
+    for (uint16_t sector = 0; sector < sectorCount; sector++) {
+        for (uint16_t slot = 0; slot < slotsPerSector; slot++) {
+            int result = readSlot(sector, slot, header, data);
+            if (result == 0) break;         // Libre: el resto del sector también
+            if (result < 0) continue;       // Cortado: probar el siguiente
+            if (newestSector < 0 || header.sequence > newestSequence) {
+                newestSector = sector;
+                newestSequence = header.sequence;
+            }
+            break;
+        }
+    }
+
+    if (newestSector < 0) {
+        // Log vacío: el primer append borra y abre el sector 0
+        writeSector = sectorCount - 1;
+        writeSlot = slotsPerSector;
+        hasLatest = false;
+        stats.sequence = 0;
+        return true;
+    }
+
+    // 2. Dentro de ese sector: el último registro válido y el primer lugar
+    //    después del último usado (válido o no: sólo se escribe sobre 0xFF)
+    uint16_t used = 0;
+    for (uint16_t slot = 0; slot < slotsPerSector; slot++) {
+        int result = readSlot(newestSector, slot, header, data);
+        if (result == 0) continue;
+        used = slot + 1;
+        if (result < 0) {
+            stats.corrupted++;
+            continue;
+        }
+        if (!hasLatest || header.sequence > stats.sequence) {
+            hasLatest = true;
+            stats.sequence = header.sequence;
+            latestSchema = header.schema;
+            latestLength = header.length;
+            memcpy(latest, data, header.length);
+        }
+    }
+
+    writeSector = newestSector;
+    writeSlot = used;
+    return true;
+}
+
+bool CounterLogManager::openNextSector() {
+    uint16_t next = (writeSector + 1) % sectorCount;
+    size_t address = (size_t)next * COUNTER_LOG_SECTOR_SIZE;
+
+    if (esp_partition_erase_range(partition, address, COUNTER_LOG_SECTOR_SIZE) != ESP_OK) {
+        Serial.printf("[COUNTER LOG] ERROR: No se pudo borrar el sector %u\n", next);
+        return false;
+    }
+
+    stats.erases++;
+    writeSector = next;
+    writeSlot = 0;
+    return true;
+}
+
+int CounterLogManager::readSlot(uint16_t sector, uint16_t slot, CounterLogRecordHeader& header, uint8_t* data) {
+    uint8_t buffer[COUNTER_LOG_SLOT_SIZE];
+    size_t address = (size_t)sector * COUNTER_LOG_SECTOR_SIZE + (size_t)slot * COUNTER_LOG_SLOT_SIZE;
+    if (esp_partition_read(partition, address, buffer, sizeof(buffer)) != ESP_OK) {
+        return -1;
+    }
+
+    bool blank = true;
+    for (size_t i = 0; i < sizeof(buffer) && blank; i++) {
+        blank = (buffer[i] == 0xFF);
+    }
+    if (blank) return 0;
+
+    memcpy(&header, buffer, RECORD_HEADER_SIZE);
+    if (header.magic != COUNTER_LOG_RECORD_MAGIC || header.length == 0 || header.length > COUNTER_LOG_MAX_DATA) {
+        return -1;
+    }
+
+    memcpy(data, buffer + RECORD_HEADER_SIZE, header.length);
+    return recordCrc(header, data) == header.crc ? 1 : -1;
+}
+
+uint32_t CounterLogManager::recordCrc(const CounterLogRecordHeader& header, const uint8_t* data) {
+    uint32_t crc = esp_crc32_le(0, (const uint8_t*)&header, offsetof(CounterLogRecordHeader, crc));
+    return esp_crc32_le(crc, data, header.length);
+}
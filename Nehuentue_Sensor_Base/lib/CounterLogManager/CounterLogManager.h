@@ -0,0 +1,199 @@
+/**
+ * @file CounterLogManager.h
+ * @brief Log circular de contadores con nivelación de desgaste en partición flash
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @details
+ * Guarda "checkpoints" de contadores (estadísticas de sistema, Modbus, ...)
+ * para que sobrevivan a los reinicios. Cada checkpoint es un registro nuevo
+ * al final de un log append-only que recorre toda la partición: nunca se
+ * reescribe la misma dirección, y cada sector se borra una vez por vuelta.
+ *
+ * Características:
+ * - Registros de tamaño fijo (COUNTER_LOG_SLOT_SIZE) con número de secuencia
+ *   y CRC32; un registro cortado a mitad de escritura se ignora
+ * - Rotación circular por sectores de 4 KB: desgaste uniforme
+ * - Recuperación en begin(): primer registro de cada sector para ubicar el
+ *   más nuevo y recorrido sólo de ese sector
+ * - Checkpoint sin cambios = sin escritura (se compara con el último)
+ * - Versión de esquema por registro: un struct de otra versión no se carga
+ * - Thread-safe con mutex FreeRTOS
+ *
+ * Formato (cada sector):
+ *
+ *   [registro 0][registro 1] ... [registro N-1]    (0xFF = libre)
+ *   registro = [CounterLogRecordHeader][datos][0xFF hasta COUNTER_LOG_SLOT_SIZE]
+ *
+ * Uso:
+ * @code
+ * struct Counters { uint32_t boots; uint32_t errors; } counters = {};
+ *
+ * CounterLog.begin();
+ * CounterLog.load(counters, 1);        // Último checkpoint (si hay)
+ * counters.boots++;
+ * CounterLog.append(counters, 1);      // Cada pocos segundos
+ * @endcode
+ */
+
+#ifndef COUNTER_LOG_MANAGER_H
+#define COUNTER_LOG_MANAGER_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// ============================================================================
+// CONSTANTES Y CONFIGURACIÓN
+// ============================================================================
+
+#define COUNTER_LOG_VERSION "1.0.0"
+#define COUNTER_LOG_PARTITION_LABEL "statslog"    // Ver partitions.csv
+#define COUNTER_LOG_PARTITION_SUBTYPE 0x42        // Subtipo de datos custom
+#define COUNTER_LOG_SECTOR_SIZE 4096              // Un sector flash
+#define COUNTER_LOG_SLOT_SIZE 64                  // 64 registros por sector
+#define COUNTER_LOG_TIMEOUT_MS 1000               // Timeout para mutex
+
+// ============================================================================
+// FORMATO EN FLASH
+// ============================================================================
+
+/**
+ * @brief Cabecera de registro (12 bytes)
+ */
+struct CounterLogRecordHeader {
+    uint16_t magic;             ///< COUNTER_LOG_RECORD_MAGIC
+    uint8_t schema;             ///< Versión del struct guardado (la define quien llama)
+    uint8_t length;             ///< Bytes de datos
+    uint32_t sequence;          ///< Creciente en toda la partición
+    uint32_t crc;               ///< CRC32 de los 8 bytes anteriores + datos
+};
+
+#define COUNTER_LOG_RECORD_MAGIC 0x4C43           // "CL"
+#define COUNTER_LOG_MAX_DATA (COUNTER_LOG_SLOT_SIZE - sizeof(CounterLogRecordHeader))
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+/**
+ * @brief Estadísticas del log
+ */
+struct CounterLogStats {
+    uint32_t appended;          ///< Registros escritos en este arranque
+    uint32_t skipped;           ///< Checkpoints sin cambios (no escritos)
+    uint32_t erases;            ///< Borrados de sector en este arranque
+    uint32_t writeErrors;
+    uint32_t corrupted;         ///< Registros inválidos vistos al recuperar
+    uint32_t sequence;          ///< Secuencia del último registro (0 = log vacío)
+    uint32_t recoveryUs;        ///< Duración del escaneo en begin()
+};
+
+// ============================================================================
+// CLASE PRINCIPAL
+// ============================================================================
+
+class CounterLogManager {
+public:
+    CounterLogManager();
+    ~CounterLogManager();
+
+    // ========================================================================
+    // INICIALIZACIÓN
+    // ========================================================================
+
+    /**
+     * @brief Abre la partición y recupera el último registro válido
+     * @return true si la partición existe (con o sin registros)
+     */
+    bool begin(const char* label = COUNTER_LOG_PARTITION_LABEL);
+
+    /**
+     * @brief Libera recursos (el log se mantiene en flash)
+     */
+    void end();
+
+    bool isReady() const { return initialized; }
+
+    // ========================================================================
+    // OPERACIONES
+    // ========================================================================
+
+    /**
+     * @brief Copia el último registro válido
+     * @return false si el log está vacío o el registro es de otro esquema/tamaño
+     */
+    bool load(void* data, size_t length, uint8_t schema);
+
+    /**
+     * @brief Agrega un registro (checkpoint)
+     *
+     * Si los datos son iguales al último registro no escribe nada. Al entrar
+     * a un sector nuevo lo borra primero (~45 ms).
+     * @return true si el registro quedó escrito (o no hacía falta)
+     */
+    bool append(const void* data, size_t length, uint8_t schema);
+
+    template<typename T>
+    bool load(T& data, uint8_t schema) {
+        static_assert(sizeof(T) <= COUNTER_LOG_MAX_DATA, "Struct demasiado grande para un registro");
+        return load(&data, sizeof(T), schema);
+    }
+
+    template<typename T>
+    bool append(const T& data, uint8_t schema) {
+        static_assert(sizeof(T) <= COUNTER_LOG_MAX_DATA, "Struct demasiado grande para un registro");
+        return append(&data, sizeof(T), schema);
+    }
+
+    // ========================================================================
+    // INFORMACIÓN
+    // ========================================================================
+
+    uint32_t getSequence() const { return stats.sequence; }
+    uint32_t getCapacity() const { return (uint32_t)sectorCount * slotsPerSector; }
+    CounterLogStats getStats() const { return stats; }
+    void printStats();
+
+private:
+    const esp_partition_t* partition;
+    SemaphoreHandle_t mutex;
+    bool initialized;
+
+    uint16_t sectorCount;
+    uint16_t slotsPerSector;
+
+    // Próximo registro: slotsPerSector = sector lleno, abrir el siguiente
+    uint16_t writeSector;
+    uint16_t writeSlot;
+
+    // Último registro válido (en RAM para load() y para saltear repetidos)
+    bool hasLatest;
+    uint8_t latestSchema;
+    uint8_t latestLength;
+    uint8_t latest[COUNTER_LOG_MAX_DATA];
+
+    CounterLogStats stats;
+
+    bool lock();
+    void unlock();
+
+    bool recover();
+    bool openNextSector();
+
+    /**
+     * @brief Lee un registro
+     * @return 1 válido, 0 libre (todo 0xFF), -1 inválido o cortado
+     */
+    int readSlot(uint16_t sector, uint16_t slot, CounterLogRecordHeader& header, uint8_t* data);
+
+    static uint32_t recordCrc(const CounterLogRecordHeader& header, const uint8_t* data);
+};
+
+// ============================================================================
+// INSTANCIA GLOBAL
+// ============================================================================
+extern CounterLogManager CounterLog;
+
+#endif // COUNTER_LOG_MANAGER_H
@@ -0,0 +1,270 @@
+/**
+ * @file DeviceProfileManager.cpp
+ * @brief Implementación del DeviceProfileManager
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "DeviceProfileManager.h"
+#include <esp_crc.h>
+
+// Instancia global
+DeviceProfileManager ProfileMgr;
+
+// ============================================================================
+// CONSTRUCTOR Y DESTRUCTOR
+// ============================================================================
+
+DeviceProfileManager::DeviceProfileManager() {
+    partition = nullptr;
+    mapHandle = 0;
+    base = nullptr;
+    header = nullptr;
+    profiles = nullptr;
+    points = nullptr;
+    strings = nullptr;
+    stringsSize = 0;
+}
+
+DeviceProfileManager::~DeviceProfileManager() {
+    end();
+}
+
+// ============================================================================
+// INICIALIZACIÓN
+// ============================================================================
+
+bool DeviceProfileManager::begin(const char* label) {
+    if (header != nullptr) {
+        Serial.println("[PROFILES] Ya inicializado");
+        return true;
+    }
+
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   Device Profile Manager v1.0          ║");
+    Serial.println("╚════════════════════════════════════════╝");
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                         (esp_partition_subtype_t)DEVICE_PROFILE_PARTITION_SUBTYPE,
+                                         label);
+    if (partition == nullptr) {
+        Serial.printf("[PROFILES] ERROR: Partición '%s' no encontrada (revisa partitions.csv)\n", label);
+        return false;
+    }
+
+    // La cabecera se lee aparte para mapear sólo lo que ocupa la imagen
+    ProfileImageHeader image;
+    if (esp_partition_read(partition, 0, &image, sizeof(image)) != ESP_OK) {
+        Serial.println("[PROFILES] ERROR: No se pudo leer la cabecera");
+        partition = nullptr;
+        return false;
+    }
+
+    if (image.magic != DEVICE_PROFILE_MAGIC) {
+        Serial.println("[PROFILES] Partición vacía (grabar con tools/build_profiles.py)");
+        partition = nullptr;
+        return false;
+    }
+
+    if (image.imageSize < sizeof(ProfileImageHeader) || image.imageSize > partition->size) {
+        Serial.printf("[PROFILES] ERROR: Tamaño de imagen inválido (%lu)\n", (unsigned long)image.imageSize);
+        partition = nullptr;
+        return false;
+    }
+
+    const void* mapped = nullptr;
+    if (esp_partition_mmap(partition, 0, image.imageSize, SPI_FLASH_MMAP_DATA, &mapped, &mapHandle) != ESP_OK) {
+        Serial.println("[PROFILES] ERROR: No se pudo mapear la partición");
+        partition = nullptr;
+        return false;
+    }
+    base = (const uint8_t*)mapped;
+
+    unsigned long start = micros();
+    const char* reason = validate(*(const ProfileImageHeader*)base, image.imageSize);
+    if (reason != nullptr) {
+        Serial.printf("[PROFILES] ERROR: Imagen descartada (%s)\n", reason);
+        end();
+        return false;
+    }
+
+    header = (const ProfileImageHeader*)base;
+    profiles = (const ProfileRecord*)(base + header->profilesOffset);
+    points = (const ProfilePointRecord*)(base + header->pointsOffset);
+    strings = (const char*)(base + header->stringsOffset);
+    stringsSize = header->imageSize - header->stringsOffset;
+
+    Serial.printf("  Partición: %s (0x%06lX, %lu KB)\n", partition->label,
+                  (unsigned long)partition->address, (unsigned long)(partition->size / 1024));
+    Serial.printf("  Imagen: v%u, %lu bytes, CRC %08lX (verificado en %lu us)\n",
+                  header->version, (unsigned long)header->imageSize,
+                  (unsigned long)header->crc, micros() - start);
+    Serial.printf("  Perfiles: %u (%lu registros)\n", header->profileCount, (unsigned long)header->pointCount);
+    Serial.println("════════════════════════════════════════\n");
+
+    return true;
+}
+
+void DeviceProfileManager::end() {
+    if (base != nullptr) {
+        spi_flash_munmap(mapHandle);
+        if (header != nullptr) {
+            Serial.println("[PROFILES] Finalizado");
+        }
+    }
+
+    partition = nullptr;
+    mapHandle = 0;
+    base = nullptr;
+    header = nullptr;
+    profiles = nullptr;
+    points = nullptr;
+    strings = nullptr;
+    stringsSize = 0;
+}
+
+/**
+ * @return nullptr si la imagen es válida, o el motivo
+ */
+const char* DeviceProfileManager::validate(const ProfileImageHeader& image, uint32_t mappedSize) const {
+    if (image.version != DEVICE_PROFILE_FORMAT_VERSION) {
+        return "versión no soportada";
+    }
+
+    // Tablas alineadas a 4 (se leen como structs en el lugar) y dentro de la imagen
+    uint64_t profilesEnd = (uint64_t)image.profilesOffset + (uint64_t)image.profileCount * sizeof(ProfileRecord);
+    uint64_t pointsEnd = (uint64_t)image.pointsOffset + (uint64_t)image.pointCount * sizeof(ProfilePointRecord);
+    if ((image.profilesOffset | image.pointsOffset | image.stringsOffset) & 0x3) {
+        return "tablas desalineadas";
+    }
+    if (image.profilesOffset < sizeof(ProfileImageHeader) || profilesEnd > image.pointsOffset ||
+        pointsEnd > image.stringsOffset || image.stringsOffset >= mappedSize) {
+        return "tablas fuera de la imagen";
+    }
+
+    uint32_t crc = esp_crc32_le(0, base + sizeof(ProfileImageHeader), mappedSize - sizeof(ProfileImageHeader));
+    if (crc != image.crc) {
+        return "CRC no coincide";
+    }
+
+    // Con la tabla de strings terminada en '\0', todo offset válido es un string terminado
+    const char* table = (const char*)(base + image.stringsOffset);
+    uint32_t tableSize = mappedSize - image.stringsOffset;
+    if (table[tableSize - 1] != '\0') {
+        return "strings sin terminar";
+    }
+
+    const ProfileRecord* index = (const ProfileRecord*)(base + image.profilesOffset);
+    for (uint16_t i = 0; i < image.profileCount; i++) {
+        const ProfileRecord& profile = index[i];
+        if (profile.nameOffset >= tableSize || profile.vendorOffset >= tableSize ||
+            (uint64_t)profile.firstPoint + profile.pointCount > image.pointCount) {
+            return "perfil con referencias inválidas";
+        }
+        // find() hace búsqueda binaria: el builder ordena por hash
+        if (i > 0 && profile.nameHash < index[i - 1].nameHash) {
+            return "índice desordenado";
+        }
+    }
+
+    const ProfilePointRecord* pointTable = (const ProfilePointRecord*)(base + image.pointsOffset);
+    for (uint32_t i = 0; i < image.pointCount; i++) {
+        if (pointTable[i].nameOffset >= tableSize || pointTable[i].unitOffset >= tableSize) {
+            return "registro con referencias inválidas";
+        }
+    }
+
+    return nullptr;
+}
+
+// ============================================================================
+// CONSULTA
+// ============================================================================
+
+uint16_t DeviceProfileManager::getProfileCount() const {
+    return header != nullptr ? header->profileCount : 0;
+}
+
+const ProfileRecord* DeviceProfileManager::find(const char* model) const {
+    if (header == nullptr || model == nullptr) return nullptr;
+
+    uint32_t hash = hashName(model);
+
+    // Primer registro con nameHash >= hash
+    uint16_t low = 0;
+    uint16_t high = header->profileCount;
+    while (low < high) {
+        uint16_t middle = low + (high - low) / 2;
+        if (profiles[middle].nameHash < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    // Colisiones de hash: recorrer los del mismo hash
+    for (uint16_t i = low; i < header->profileCount && profiles[i].nameHash == hash; i++) {
+        if (strcmp(strings + profiles[i].nameOffset, model) == 0) {
+            return &profiles[i];
+        }
+    }
+    return nullptr;
+}
+
+const ProfileRecord* DeviceProfileManager::getProfile(uint16_t index) const {
+    if (header == nullptr || index >= header->profileCount) return nullptr;
+    return &profiles[index];
+}
+
+const ProfilePointRecord* DeviceProfileManager::getPoints(const ProfileRecord& profile) const {
+    if (header == nullptr) return nullptr;
+    return &points[profile.firstPoint];
+}
+
+const char* DeviceProfileManager::getString(uint32_t offset) const {
+    if (strings == nullptr || offset >= stringsSize) return "";
+    return strings + offset;
+}
+
+uint32_t DeviceProfileManager::hashName(const char* name) {
+    // FNV-1a (el mismo en tools/build_profiles.py)
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// ============================================================================
+// DIAGNÓSTICO
+// ============================================================================
+
+uint32_t DeviceProfileManager::getImageSize() const {
+    return header != nullptr ? header->imageSize : 0;
+}
+
+uint32_t DeviceProfileManager::getImageCrc() const {
+    return header != nullptr ? header->crc : 0;
+}
+
+void DeviceProfileManager::printStatus() {
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   Device Profiles - Estado             ║");
+    Serial.println("╚════════════════════════════════════════╝");
+
+    if (header == nullptr) {
+        Serial.println("  Sin imagen de perfiles");
+        Serial.println("════════════════════════════════════════\n");
+        return;
+    }
+
+    Serial.printf("  Imagen: %lu de %lu bytes, CRC %08lX\n", (unsigned long)header->imageSize,
+                  (unsigned long)partition->size, (unsigned long)header->crc);
+    Serial.printf("  Perfiles: %u (%lu registros)\n", header->profileCount, (unsigned long)header->pointCount);
+    for (uint16_t i = 0; i < header->profileCount; i++) {
+        Serial.printf("    %-20s %-16s %2u registros\n", getName(profiles[i]),
+                      getVendor(profiles[i]), profiles[i].pointCount);
+    }
+    Serial.println("════════════════════════════════════════\n");
+}
@@ -0,0 +1,179 @@
+/**
+ * @file DeviceProfileManager.h
+ * @brief Biblioteca de perfiles de equipos (mapas de registros) en partición mapeada
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @details
+ * Los perfiles de medidores y equipos (modelo, velocidad, esclavo por defecto
+ * y sus registros Modbus) viajan con el firmware en una partición de datos de
+ * sólo lectura ("profiles"). La imagen la arma tools/build_profiles.py en la
+ * PC y se graba con esptool; el firmware nunca la escribe.
+ *
+ * Características:
+ * - Partición mapeada con esp_partition_mmap(): los perfiles se leen en el
+ *   lugar, sin copias a RAM (nombres y registros son punteros a flash)
+ * - Formato indexado: tabla de perfiles ordenada por hash FNV-1a del modelo,
+ *   búsqueda binaria + strcmp
+ * - Sin el límite de 4 KB de los blobs NVS (la partición entera es la imagen)
+ * - CRC32 de la imagen verificado una vez en begin()
+ * - Sin mutex: la imagen es inmutable mientras está mapeada
+ *
+ * Formato (little-endian, todo alineado a 4):
+ *
+ *   [ProfileImageHeader][ProfileRecord × N][ProfilePointRecord × M][strings]
+ *
+ * Uso:
+ * @code
+ * ProfileMgr.begin();
+ *
+ * const ProfileRecord* profile = ProfileMgr.find("SDM120");
+ * if (profile != nullptr) {
+ *     const ProfilePointRecord* points = ProfileMgr.getPoints(*profile);
+ *     for (uint16_t i = 0; i < profile->pointCount; i++) {
+ *         Serial.println(ProfileMgr.getString(points[i].nameOffset));
+ *     }
+ * }
+ * @endcode
+ */
+
+#ifndef DEVICE_PROFILE_MANAGER_H
+#define DEVICE_PROFILE_MANAGER_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+
+// ============================================================================
+// CONSTANTES Y CONFIGURACIÓN
+// ============================================================================
+
+#define DEVICE_PROFILE_VERSION "1.0.0"
+#define DEVICE_PROFILE_PARTITION_LABEL "profiles"   // Ver partitions.csv
+#define DEVICE_PROFILE_PARTITION_SUBTYPE 0x41       // Subtipo de datos custom
+
+#define DEVICE_PROFILE_MAGIC 0x4652504EUL           // "NPRF"
+#define DEVICE_PROFILE_FORMAT_VERSION 1
+
+// ============================================================================
+// FORMATO EN FLASH (lo escribe tools/build_profiles.py)
+// ============================================================================
+
+/**
+ * @brief Cabecera de la imagen (32 bytes, al inicio de la partición)
+ */
+struct ProfileImageHeader {
+    uint32_t magic;             ///< DEVICE_PROFILE_MAGIC
+    uint16_t version;           ///< DEVICE_PROFILE_FORMAT_VERSION
+    uint16_t profileCount;
+    uint32_t imageSize;         ///< Bytes desde el inicio de la cabecera
+    uint32_t crc;               ///< CRC32 de todo lo que sigue a la cabecera
+    uint32_t profilesOffset;    ///< Tabla de ProfileRecord
+    uint32_t pointsOffset;      ///< Tabla de ProfilePointRecord
+    uint32_t stringsOffset;     ///< Strings terminadas en '\0'
+    uint32_t pointCount;
+};
+
+/**
+ * @brief Entrada del índice (24 bytes), ordenada por nameHash y luego nombre
+ */
+struct ProfileRecord {
+    uint32_t nameHash;          ///< FNV-1a del modelo
+    uint32_t nameOffset;        ///< Modelo (offset en la tabla de strings)
+    uint32_t vendorOffset;      ///< Fabricante
+    uint32_t firstPoint;        ///< Índice en la tabla de puntos
+    uint16_t pointCount;
+    uint8_t defaultSlave;
+    uint8_t reserved;
+    uint32_t baudrate;          ///< Velocidad de fábrica del equipo
+};
+
+/**
+ * @brief Registro de un perfil (24 bytes), mismos campos que un PollPoint
+ */
+struct ProfilePointRecord {
+    uint32_t nameOffset;
+    uint32_t unitOffset;        ///< "" si no tiene
+    uint16_t address;
+    uint16_t quantity;
+    uint8_t functionCode;       ///< 0x01-0x04
+    uint8_t reserved[3];
+    float multiplier;
+    float offset;
+};
+
+// ============================================================================
+// CLASE PRINCIPAL
+// ============================================================================
+
+class DeviceProfileManager {
+public:
+    DeviceProfileManager();
+    ~DeviceProfileManager();
+
+    /**
+     * @brief Mapea la partición y valida la imagen
+     * @return false si no hay partición o la imagen no es válida
+     *         (el firmware sigue andando sin perfiles)
+     */
+    bool begin(const char* label = DEVICE_PROFILE_PARTITION_LABEL);
+
+    /**
+     * @brief Desmapea la partición (los punteros devueltos dejan de valer)
+     */
+    void end();
+
+    bool isReady() const { return header != nullptr; }
+
+    // ========================================================================
+    // CONSULTA (punteros a flash mapeada, válidos hasta end())
+    // ========================================================================
+
+    uint16_t getProfileCount() const;
+
+    /**
+     * @brief Busca un perfil por modelo (distingue mayúsculas)
+     * @return nullptr si no existe
+     */
+    const ProfileRecord* find(const char* model) const;
+
+    /**
+     * @brief Perfil por posición en el índice (orden de hash, no alfabético)
+     */
+    const ProfileRecord* getProfile(uint16_t index) const;
+
+    const ProfilePointRecord* getPoints(const ProfileRecord& profile) const;
+    const char* getString(uint32_t offset) const;
+
+    const char* getName(const ProfileRecord& profile) const { return getString(profile.nameOffset); }
+    const char* getVendor(const ProfileRecord& profile) const { return getString(profile.vendorOffset); }
+
+    // ========================================================================
+    // DIAGNÓSTICO
+    // ========================================================================
+
+    uint32_t getImageSize() const;
+    uint32_t getPartitionSize() const { return partition != nullptr ? partition->size : 0; }
+    uint32_t getImageCrc() const;
+    void printStatus();
+
+    static uint32_t hashName(const char* name);
+
+private:
+    const esp_partition_t* partition;
+    spi_flash_mmap_handle_t mapHandle;
+    const uint8_t* base;                ///< Inicio del mapeo
+    const ProfileImageHeader* header;   ///< nullptr si no hay imagen válida
+    const ProfileRecord* profiles;
+    const ProfilePointRecord* points;
+    const char* strings;
+    uint32_t stringsSize;
+
+    const char* validate(const ProfileImageHeader& image, uint32_t mappedSize) const;
+};
+
+// ============================================================================
+// INSTANCIA GLOBAL
+// ============================================================================
+extern DeviceProfileManager ProfileMgr;
+
+#endif // DEVICE_PROFILE_MANAGER_H
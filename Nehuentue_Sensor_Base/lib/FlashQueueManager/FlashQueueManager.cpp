@@ -0,0 +1,667 @@
+/**
+ * @file FlashQueueManager.cpp
+ * @brief Implementación del FlashQueueManager
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "FlashQueueManager.h"
+#include <time.h>
+
+// Instancia global
+FlashQueueManager FlashQueue;
+
+#define SEGMENT_HEADER_SIZE ((uint16_t)sizeof(FlashQueueSegmentHeader))
+#define RECORD_HEADER_SIZE ((uint16_t)sizeof(FlashQueueRecordHeader))
+
+// ============================================================================
+// CONSTRUCTOR Y DESTRUCTOR
+// ============================================================================
+
+FlashQueueManager::FlashQueueManager() {
+    partition = NULL;
+    mutex = NULL;
+    initialized = false;
+    segmentCount = 0;
+    activeSegments = 0;
+    maxSegments = 0;
+    maxAgeSeconds = 0;
+    headSegment = 0;
+    headSequence = 0;
+    writeOffset = 0;
+    tailSegment = 0;
+    tailOffset = 0;
+    memset(&stats, 0, sizeof(FlashQueueStats));
+}
+
+FlashQueueManager::~FlashQueueManager() {
+    end();
+}
+
+// ============================================================================
+// INICIALIZACIÓN
+// ============================================================================
+
+bool FlashQueueManager::begin(const char* label) {
+    if (initialized) {
+        Serial.println("[FLASH QUEUE] Ya inicializado");
+        return true;
+    }
+
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   Flash Queue Manager v1.0             ║");
+    Serial.println("╚════════════════════════════════════════╝");
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                         (esp_partition_subtype_t)FLASH_QUEUE_PARTITION_SUBTYPE,
+                                         label);
+    if (partition == NULL) {
+        Serial.printf("[FLASH QUEUE] ERROR: Partición '%s' no encontrada (revisa partitions.csv)\n", label);
+        return false;
+    }
+
+    segmentCount = partition->size / FLASH_QUEUE_SEGMENT_SIZE;
+    activeSegments = segmentCount;
+    if (maxSegments > 0 && maxSegments < segmentCount) {
+        activeSegments = maxSegments;
+    }
+
+    if (activeSegments < 2) {
+        Serial.println("[FLASH QUEUE] ERROR: Se necesitan al menos 2 segmentos");
+        partition = NULL;
+        return false;
+    }
+
+    mutex = xSemaphoreCreateMutex();
+    if (mutex == NULL) {
+        Serial.println("[FLASH QUEUE] ERROR: No se pudo crear mutex");
+        partition = NULL;
+        return false;
+    }
+
+    if (!recover()) {
+        Serial.println("[FLASH QUEUE] ERROR: No se pudo recuperar el log");
+        vSemaphoreDelete(mutex);
+        mutex = NULL;
+        partition = NULL;
+        return false;
+    }
+
+    initialized = true;
+
+    Serial.printf("  Partición: %s (0x%06lX, %lu KB)\n", partition->label,
+                  (unsigned long)partition->address, (unsigned long)(partition->size / 1024));
+    Serial.printf("  Segmentos: %u de %u (%lu KB)\n", activeSegments, segmentCount,
+                  (unsigned long)(getCapacity() / 1024));
+    Serial.printf("  Retención: %s\n", maxAgeSeconds > 0 ? "por antigüedad" : "sin límite de edad");
+    Serial.printf("  Backlog: %lu mensajes (%lu bytes)\n", stats.pendingRecords, stats.pendingBytes);
+    Serial.printf("  Máx. borrados por sector: %lu\n", stats.maxEraseCount);
+    Serial.println("════════════════════════════════════════\n");
+
+    return true;
+}
+
+void FlashQueueManager::end() {
+    if (initialized) {
+        initialized = false;
+        Serial.println("[FLASH QUEUE] Finalizado");
+    }
+
+    if (mutex != NULL) {
+        vSemaphoreDelete(mutex);
+        mutex = NULL;
+    }
+
+    partition = NULL;
+}
+
+void FlashQueueManager::setRetention(uint32_t maxAge, uint16_t segments) {
+    maxAgeSeconds = maxAge;
+    if (!initialized) {
+        maxSegments = segments;
+    }
+}
+
+// ============================================================================
+// OPERACIONES
+// ============================================================================
+
+bool FlashQueueManager::append(const char* topic, const uint8_t* payload, size_t length, bool retained, uint8_t qos) {
+    const uint8_t* parts[1] = { payload };
+    size_t lengths[1] = { length };
+    return append(topic, parts, lengths, 1, retained, qos);
+}
+
+bool FlashQueueManager::append(const char* topic, const uint8_t* const parts[], const size_t lengths[], size_t count, bool retained, uint8_t qos) {
+    if (!initialized || topic == NULL) return false;
+
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (parts[i] == NULL && lengths[i] > 0) return false;
+        length += lengths[i];
+    }
+
+    size_t topicLength = strlen(topic);
+    if (topicLength == 0 || topicLength > FLASH_QUEUE_MAX_TOPIC_LENGTH) return false;
+
+    uint32_t size = recordSize(topicLength, 0) + length;
+    if (length > 0xFFFF || SEGMENT_HEADER_SIZE + size > FLASH_QUEUE_SEGMENT_SIZE) {
+        Serial.printf("[FLASH QUEUE] Mensaje demasiado grande (%u bytes)\n", (unsigned)length);
+        return false;
+    }
+    size = recordSize(topicLength, length);
+
+    if (!lock()) return false;
+
+    if (writeOffset + size > FLASH_QUEUE_SEGMENT_SIZE) {
+        if (!openNextSegment()) {
+            unlock();
+            return false;
+        }
+    }
+
+    FlashQueueRecordHeader header;
+    header.state = FLASH_QUEUE_STATE_WRITING;
+    header.flags = (retained ? FLASH_QUEUE_FLAG_RETAINED : 0) | (qos > 0 ? FLASH_QUEUE_FLAG_QOS1 : 0);
+    header.magic = FLASH_QUEUE_RECORD_MAGIC;
+    header.topicLength = topicLength;
+    header.payloadLength = length;
+    header.timestamp = (uint32_t)time(NULL);
+    header.crc = calculateCRC16((const uint8_t*)topic, topicLength);
+    for (size_t i = 0; i < count; i++) {
+        header.crc = calculateCRC16(parts[i], lengths[i], header.crc);
+    }
+    header.reserved = 0xFFFF;
+
+    size_t address = (size_t)headSegment * FLASH_QUEUE_SEGMENT_SIZE + writeOffset;
+
+    // 1. Cabecera (estado ESCRIBIENDO)  2. Datos  3. Estado VÁLIDO
+    // Un corte de energía entre pasos deja un registro que se salta al drenar.
+    bool ok = esp_partition_write(partition, address, &header, RECORD_HEADER_SIZE) == ESP_OK;
+    ok = ok && esp_partition_write(partition, address + RECORD_HEADER_SIZE, topic, topicLength) == ESP_OK;
+    size_t dataAddress = address + RECORD_HEADER_SIZE + topicLength;
+    for (size_t i = 0; ok && i < count; i++) {
+        if (lengths[i] == 0) continue;
+        ok = esp_partition_write(partition, dataAddress, parts[i], lengths[i]) == ESP_OK;
+        dataAddress += lengths[i];
+    }
+    ok = ok && writeRecordState(headSegment, writeOffset, FLASH_QUEUE_STATE_VALID);
+
+    // Aunque falle, el espacio ya no está borrado: avanzar igual
+    writeOffset += size;
+
+    if (ok) {
+        stats.appended++;
+        stats.pendingRecords++;
+        stats.pendingBytes += topicLength + length;
+    } else {
+        Serial.println("[FLASH QUEUE] ERROR: Escritura en flash fallida");
+    }
+
+    unlock();
+    return ok;
+}
+
+bool FlashQueueManager::peek(FlashQueueRecord& record) {
+    if (!initialized) return false;
+    if (!lock()) return false;
+
+    // Desde la cola: lo consumido o descartado también la hace avanzar
+    bool found = scan(tailSegment, tailOffset, record);
+
+    unlock();
+    return found;
+}
+
+bool FlashQueueManager::peekNext(const FlashQueueRecord& after, FlashQueueRecord& record) {
+    if (!initialized) return false;
+    if (!lock()) return false;
+
+    uint16_t segment = after.segment;
+    uint16_t offset = after.offset + recordSize(after.topicLength, after.payloadLength);
+    bool found = scan(segment, offset, record);
+
+    unlock();
+    return found;
+}
+
+bool FlashQueueManager::peekAt(uint16_t segment, uint16_t offset, FlashQueueRecord& record) {
+    if (!initialized) return false;
+    if (!lock()) return false;
+
+    // Sin descartes: sólo confirma que el registro sigue pendiente
+    FlashQueueRecordHeader header;
+    bool found = segment < activeSegments &&
+                 offset + RECORD_HEADER_SIZE <= FLASH_QUEUE_SEGMENT_SIZE &&
+                 readRecordHeader(segment, offset, header) &&
+                 header.state == FLASH_QUEUE_STATE_VALID &&
+                 header.topicLength <= FLASH_QUEUE_MAX_TOPIC_LENGTH &&
+                 loadRecord(segment, offset, header, record);
+
+    unlock();
+    return found;
+}
+
+bool FlashQueueManager::scan(uint16_t& segment, uint16_t& offset, FlashQueueRecord& record) {
+    // Llamar con el mutex tomado
+    bool found = false;
+
+    while (!found) {
+        if (segment == headSegment && offset >= writeOffset) {
+            break;  // Backlog vacío
+        }
+
+        FlashQueueRecordHeader header;
+        if (offset + RECORD_HEADER_SIZE > FLASH_QUEUE_SEGMENT_SIZE ||
+            !readRecordHeader(segment, offset, header)) {
+            // Fin de segmento (espacio borrado o cabecera inválida)
+            if (!advanceCursor(segment, offset)) break;
+            continue;
+        }
+
+        uint16_t size = recordSize(header.topicLength, header.payloadLength);
+
+        if (header.state != FLASH_QUEUE_STATE_VALID) {
+            // Consumido o incompleto (corte durante la escritura)
+            offset += size;
+            continue;
+        }
+
+        bool discard = false;
+
+        // Retención por antigüedad (sólo con reloj sincronizado)
+        uint32_t now = (uint32_t)time(NULL);
+        if (maxAgeSeconds > 0 && now >= FLASH_QUEUE_MIN_VALID_EPOCH &&
+            header.timestamp >= FLASH_QUEUE_MIN_VALID_EPOCH &&
+            now - header.timestamp > maxAgeSeconds) {
+            stats.expired++;
+            discard = true;
+        } else if (header.topicLength > FLASH_QUEUE_MAX_TOPIC_LENGTH ||
+                   !verifyRecord(segment, offset, header)) {
+            stats.corrupted++;
+            discard = true;
+        }
+
+        if (discard) {
+            writeRecordState(segment, offset, FLASH_QUEUE_STATE_CONSUMED);
+            if (stats.pendingRecords > 0) stats.pendingRecords--;
+            uint32_t bytes = header.topicLength + header.payloadLength;
+            stats.pendingBytes = (stats.pendingBytes > bytes) ? stats.pendingBytes - bytes : 0;
+            offset += size;
+            continue;
+        }
+
+        if (!loadRecord(segment, offset, header, record)) {
+            break;
+        }
+        found = true;
+    }
+
+    return found;
+}
+
+bool FlashQueueManager::loadRecord(uint16_t segment, uint16_t offset, const FlashQueueRecordHeader& header,
+                                   FlashQueueRecord& record) {
+    size_t address = (size_t)segment * FLASH_QUEUE_SEGMENT_SIZE + offset + RECORD_HEADER_SIZE;
+    if (esp_partition_read(partition, address, record.topic, header.topicLength) != ESP_OK) {
+        return false;
+    }
+    record.topic[header.topicLength] = '\0';
+    record.segment = segment;
+    record.offset = offset;
+    record.topicLength = header.topicLength;
+    record.payloadLength = header.payloadLength;
+    record.retained = (header.flags & FLASH_QUEUE_FLAG_RETAINED) != 0;
+    record.qos = (header.flags & FLASH_QUEUE_FLAG_QOS1) ? 1 : 0;
+    record.timestamp = header.timestamp;
+    return true;
+}
+
+bool FlashQueueManager::readPayload(const FlashQueueRecord& record, size_t offset, uint8_t* buffer, size_t length) {
+    if (!initialized || buffer == NULL) return false;
+    if (offset + length > record.payloadLength) return false;
+    if (!lock()) return false;
+
+    size_t address = (size_t)record.segment * FLASH_QUEUE_SEGMENT_SIZE + record.offset +
+                     RECORD_HEADER_SIZE + record.topicLength + offset;
+    bool ok = esp_partition_read(partition, address, buffer, length) == ESP_OK;
+
+    unlock();
+    return ok;
+}
+
+bool FlashQueueManager::pop(const FlashQueueRecord& record) {
+    if (!initialized) return false;
+    if (!lock()) return false;
+
+    // Registros ya consumidos entre la cola y éste (descartados por
+    // peekNext() mientras había varios en vuelo) no cuentan para el orden
+    while (record.segment != tailSegment || record.offset != tailOffset) {
+        if (tailSegment == headSegment && tailOffset >= writeOffset) break;
+
+        FlashQueueRecordHeader header;
+        if (tailOffset + RECORD_HEADER_SIZE > FLASH_QUEUE_SEGMENT_SIZE ||
+            !readRecordHeader(tailSegment, tailOffset, header)) {
+            if (!advanceTail()) break;
+            continue;
+        }
+        if (header.state == FLASH_QUEUE_STATE_VALID) break;
+        tailOffset += recordSize(header.topicLength, header.payloadLength);
+    }
+
+    // Sólo se consume el registro de la cola (orden estricto)
+    if (record.segment != tailSegment || record.offset != tailOffset) {
+        unlock();
+        return false;
+    }
+
+    bool ok = writeRecordState(record.segment, record.offset, FLASH_QUEUE_STATE_CONSUMED);
+    tailOffset += recordSize(record.topicLength, record.payloadLength);
+
+    stats.drained++;
+    if (stats.pendingRecords > 0) stats.pendingRecords--;
+    uint32_t bytes = record.topicLength + record.payloadLength;
+    stats.pendingBytes = (stats.pendingBytes > bytes) ? stats.pendingBytes - bytes : 0;
+
+    unlock();
+    return ok;
+}
+
+bool FlashQueueManager::clear() {
+    if (!initialized) return false;
+    if (!lock()) return false;
+
+    // Se abre un segmento nuevo con un salto de secuencia: al recuperar,
+    // la cadena de segmentos se corta ahí y el contenido anterior se ignora.
+    uint16_t next = (headSegment + 1) % activeSegments;
+    bool ok = formatSegment(next, headSequence + 2);
+    if (ok) {
+        headSegment = next;
+        headSequence += 2;
+        writeOffset = SEGMENT_HEADER_SIZE;
+        tailSegment = next;
+        tailOffset = SEGMENT_HEADER_SIZE;
+        stats.pendingRecords = 0;
+        stats.pendingBytes = 0;
+        Serial.println("[FLASH QUEUE] Backlog descartado");
+    }
+
+    unlock();
+    return ok;
+}
+
+// ============================================================================
+// INFORMACIÓN
+// ============================================================================
+
+void FlashQueueManager::printStats() {
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   Flash Queue - Estadísticas           ║");
+    Serial.println("╚════════════════════════════════════════╝");
+    Serial.printf("  Backlog: %lu mensajes (%lu bytes)\n", stats.pendingRecords, stats.pendingBytes);
+    Serial.printf("  Agregados: %lu\n", stats.appended);
+    Serial.printf("  Drenados: %lu\n", stats.drained);
+    Serial.printf("  Descartados (espacio): %lu\n", stats.dropped);
+    Serial.printf("  Descartados (antigüedad): %lu\n", stats.expired);
+    Serial.printf("  Descartados (corruptos): %lu\n", stats.corrupted);
+    Serial.printf("  Borrados de sector: %lu\n", stats.erases);
+    Serial.printf("  Máx. borrados por sector: %lu\n", stats.maxEraseCount);
+    Serial.printf("  Segmento cabeza/cola: %u / %u\n", headSegment, tailSegment);
+    Serial.println("════════════════════════════════════════\n");
+}
+
+// ============================================================================
+// MÉTODOS PRIVADOS
+// ============================================================================
+
+bool FlashQueueManager::lock() {
+    if (mutex == NULL) return false;
+    return xSemaphoreTake(mutex, pdMS_TO_TICKS(FLASH_QUEUE_TIMEOUT_MS)) == pdTRUE;
+}
+
+void FlashQueueManager::unlock() {
+    if (mutex != NULL) {
+        xSemaphoreGive(mutex);
+    }
+}
+
+bool FlashQueueManager::recover() {
+    uint32_t* sequences = new uint32_t[activeSegments];
+    bool anyValid = false;
+    uint32_t bestSequence = 0;
+    uint16_t bestSegment = 0;
+
+    // 1. Leer cabeceras de todos los segmentos del anillo
+    for (uint16_t i = 0; i < activeSegments; i++) {
+        FlashQueueSegmentHeader header;
+        sequences[i] = 0;
+
+        if (esp_partition_read(partition, (size_t)i * FLASH_QUEUE_SEGMENT_SIZE,
+                               &header, SEGMENT_HEADER_SIZE) != ESP_OK) {
+            continue;
+        }
+        if (header.magic != FLASH_QUEUE_SEGMENT_MAGIC ||
+            header.version != FLASH_QUEUE_FORMAT_VERSION ||
+            header.crc != calculateCRC16((const uint8_t*)&header, SEGMENT_HEADER_SIZE - 2)) {
+            continue;
+        }
+
+        sequences[i] = header.sequence;
+        if (header.eraseCount > stats.maxEraseCount) {
+            stats.maxEraseCount = header.eraseCount;
+        }
+        if (!anyValid || header.sequence > bestSequence) {
+            bestSequence = header.sequence;
+            bestSegment = i;
+            anyValid = true;
+        }
+    }
+
+    if (!anyValid) {
+        delete[] sequences;
+        Serial.println("[FLASH QUEUE] Partición vacía, formateando...");
+        if (!formatSegment(0, 1)) return false;
+        headSegment = tailSegment = 0;
+        headSequence = 1;
+        writeOffset = tailOffset = SEGMENT_HEADER_SIZE;
+        return true;
+    }
+
+    // 2. Cola: retroceder mientras las secuencias sean consecutivas
+    headSegment = bestSegment;
+    headSequence = bestSequence;
+    uint16_t segment = headSegment;
+    for (uint16_t n = 1; n < activeSegments; n++) {
+        uint16_t prev = (segment + activeSegments - 1) % activeSegments;
+        if (sequences[prev] == 0 || sequences[prev] != sequences[segment] - 1) break;
+        segment = prev;
+    }
+    delete[] sequences;
+
+    tailSegment = segment;
+    tailOffset = SEGMENT_HEADER_SIZE;
+
+    // 3. Recorrer registros de cola a cabeza: backlog y punto de escritura
+    stats.pendingRecords = 0;
+    stats.pendingBytes = 0;
+    segment = tailSegment;
+    while (true) {
+        uint16_t offset = SEGMENT_HEADER_SIZE;
+        bool clean = true;
+
+        while (offset + RECORD_HEADER_SIZE <= FLASH_QUEUE_SEGMENT_SIZE) {
+            FlashQueueRecordHeader header;
+            if (!readRecordHeader(segment, offset, header)) {
+                // ¿Espacio borrado o basura? Sólo lo borrado es escribible
+                uint8_t raw[RECORD_HEADER_SIZE];
+                esp_partition_read(partition, (size_t)segment * FLASH_QUEUE_SEGMENT_SIZE + offset,
+                                   raw, RECORD_HEADER_SIZE);
+                for (uint16_t i = 0; i < RECORD_HEADER_SIZE; i++) {
+                    if (raw[i] != 0xFF) { clean = false; break; }
+                }
+                break;
+            }
+            if (header.state == FLASH_QUEUE_STATE_VALID) {
+                stats.pendingRecords++;
+                stats.pendingBytes += header.topicLength + header.payloadLength;
+            }
+            offset += recordSize(header.topicLength, header.payloadLength);
+        }
+
+        if (segment == headSegment) {
+            writeOffset = clean ? offset : FLASH_QUEUE_SEGMENT_SIZE;
+            break;
+        }
+        segment = (segment + 1) % activeSegments;
+    }
+
+    return true;
+}
+
+bool FlashQueueManager::formatSegment(uint16_t segment, uint32_t sequence) {
+    size_t address = (size_t)segment * FLASH_QUEUE_SEGMENT_SIZE;
+
+    // Conservar el contador de borrados del sector
+    FlashQueueSegmentHeader header;
+    uint32_t eraseCount = 0;
+    if (esp_partition_read(partition, address, &header, SEGMENT_HEADER_SIZE) == ESP_OK &&
+        header.magic == FLASH_QUEUE_SEGMENT_MAGIC) {
+        eraseCount = header.eraseCount;
+    }
+
+    if (esp_partition_erase_range(partition, address, FLASH_QUEUE_SEGMENT_SIZE) != ESP_OK) {
+        Serial.printf("[FLASH QUEUE] ERROR: No se pudo borrar segmento %u\n", segment);
+        return false;
+    }
+
+    stats.erases++;
+    eraseCount++;
+    if (eraseCount > stats.maxEraseCount) {
+        stats.maxEraseCount = eraseCount;
+    }
+
+    header.magic = FLASH_QUEUE_SEGMENT_MAGIC;
+    header.sequence = sequence;
+    header.eraseCount = eraseCount;
+    header.version = FLASH_QUEUE_FORMAT_VERSION;
+    header.crc = calculateCRC16((const uint8_t*)&header, SEGMENT_HEADER_SIZE - 2);
+
+    return esp_partition_write(partition, address, &header, SEGMENT_HEADER_SIZE) == ESP_OK;
+}
+
+bool FlashQueueManager::openNextSegment() {
+    uint16_t next = (headSegment + 1) % activeSegments;
+
+    // Log lleno: la cabeza alcanza a la cola, se descarta el segmento más antiguo
+    if (next == tailSegment) {
+        dropSegment(tailSegment);
+        tailSegment = (tailSegment + 1) % activeSegments;
+        tailOffset = SEGMENT_HEADER_SIZE;
+    }
+
+    if (!formatSegment(next, headSequence + 1)) {
+        return false;
+    }
+
+    headSegment = next;
+    headSequence++;
+    writeOffset = SEGMENT_HEADER_SIZE;
+    return true;
+}
+
+void FlashQueueManager::dropSegment(uint16_t segment) {
+    uint16_t offset = (segment == tailSegment) ? tailOffset : SEGMENT_HEADER_SIZE;
+    uint32_t lost = 0;
+
+    while (offset + RECORD_HEADER_SIZE <= FLASH_QUEUE_SEGMENT_SIZE) {
+        FlashQueueRecordHeader header;
+        if (!readRecordHeader(segment, offset, header)) break;
+        if (header.state == FLASH_QUEUE_STATE_VALID) {
+            lost++;
+            uint32_t bytes = header.topicLength + header.payloadLength;
+            stats.pendingBytes = (stats.pendingBytes > bytes) ? stats.pendingBytes - bytes : 0;
+        }
+        offset += recordSize(header.topicLength, header.payloadLength);
+    }
+
+    stats.dropped += lost;
+    stats.pendingRecords = (stats.pendingRecords > lost) ? stats.pendingRecords - lost : 0;
+
+    if (lost > 0) {
+        Serial.printf("[FLASH QUEUE] Log lleno: %lu mensajes antiguos descartados\n", lost);
+    }
+}
+
+bool FlashQueueManager::advanceTail() {
+    return advanceCursor(tailSegment, tailOffset);
+}
+
+bool FlashQueueManager::advanceCursor(uint16_t& segment, uint16_t& offset) {
+    if (segment == headSegment) {
+        return false;
+    }
+    segment = (segment + 1) % activeSegments;
+    offset = SEGMENT_HEADER_SIZE;
+    return true;
+}
+
+bool FlashQueueManager::readRecordHeader(uint16_t segment, uint16_t offset, FlashQueueRecordHeader& header) {
+    size_t address = (size_t)segment * FLASH_QUEUE_SEGMENT_SIZE + offset;
+    if (esp_partition_read(partition, address, &header, RECORD_HEADER_SIZE) != ESP_OK) {
+        return false;
+    }
+    if (header.magic != FLASH_QUEUE_RECORD_MAGIC) {
+        return false;
+    }
+    // Longitudes absurdas = cabecera escrita a medias
+    return (uint32_t)offset + recordSize(header.topicLength, header.payloadLength) <= FLASH_QUEUE_SEGMENT_SIZE;
+}
+
+bool FlashQueueManager::writeRecordState(uint16_t segment, uint16_t offset, uint8_t state) {
+    // Se reescribe la primera palabra (estado, flags, magic): sólo bajan bits
+    size_t address = (size_t)segment * FLASH_QUEUE_SEGMENT_SIZE + offset;
+    uint8_t word[4];
+    if (esp_partition_read(partition, address, word, sizeof(word)) != ESP_OK) {
+        return false;
+    }
+    word[0] &= state;
+    return esp_partition_write(partition, address, word, sizeof(word)) == ESP_OK;
+}
+
+bool FlashQueueManager::verifyRecord(uint16_t segment, uint16_t offset, const FlashQueueRecordHeader& header) {
+    size_t address = (size_t)segment * FLASH_QUEUE_SEGMENT_SIZE + offset + RECORD_HEADER_SIZE;
+    size_t remaining = header.topicLength + header.payloadLength;
+    uint16_t crc = 0xFFFF;
+    uint8_t chunk[64];
+
+    while (remaining > 0) {
+        size_t n = (remaining < sizeof(chunk)) ? remaining : sizeof(chunk);
+        if (esp_partition_read(partition, address, chunk, n) != ESP_OK) {
+            return false;
+        }
+        crc = calculateCRC16(chunk, n, crc);
+        address += n;
+        remaining -= n;
+    }
+
+    return crc == header.crc;
+}
+
+uint16_t FlashQueueManager::recordSize(uint16_t topicLength, uint16_t payloadLength) {
+    uint32_t size = RECORD_HEADER_SIZE + topicLength + payloadLength;
+    return (uint16_t)((size + 3) & ~3UL);  // Alineado a 4 bytes
+}
+
+uint16_t FlashQueueManager::calculateCRC16(const uint8_t* data, size_t length, uint16_t crc) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i];
+        for (int j = 0; j < 8; j++) {
+            if (crc & 0x0001) {
+                crc = (crc >> 1) ^ 0xA001;
+            } else {
+                crc = crc >> 1;
+            }
+        }
+    }
+    return crc;
+}
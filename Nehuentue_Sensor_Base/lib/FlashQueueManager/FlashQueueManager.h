@@ -0,0 +1,286 @@
+/**
+ * @file FlashQueueManager.h
+ * @brief Cola persistente store-and-forward en partición flash dedicada
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @details
+ * Log append-only de mensajes MQTT guardado en una partición de datos propia
+ * (no NVS). Se usa para no perder publicaciones durante caídas de WiFi o del
+ * broker: mientras no hay conexión los mensajes se agregan al log y al
+ * reconectar se drenan en orden de llegada.
+ *
+ * Características:
+ * - Partición dividida en segmentos de 4 KB (un sector flash cada uno)
+ * - Rotación circular de segmentos: cada sector se borra una vez por vuelta,
+ *   por lo que el desgaste queda repartido de forma uniforme
+ * - Contador de borrados por segmento (guardado en la cabecera)
+ * - Estados de registro escritos sólo bajando bits (como NVS), sin borrar
+ * - Recuperación tras reinicio escaneando cabeceras de segmento
+ * - Retención configurable por antigüedad y por cantidad de segmentos
+ * - Thread-safe con mutex FreeRTOS
+ *
+ * Uso:
+ * @code
+ * FlashQueue.begin();
+ * FlashQueue.append("nehuentue/dev/telemetry", payload, len, false);
+ *
+ * FlashQueueRecord rec;
+ * while (FlashQueue.peek(rec)) {
+ *     // enviar rec.topic + payload (readPayload) ...
+ *     FlashQueue.pop(rec);
+ * }
+ * @endcode
+ */
+
+#ifndef FLASH_QUEUE_MANAGER_H
+#define FLASH_QUEUE_MANAGER_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// ============================================================================
+// CONSTANTES Y CONFIGURACIÓN
+// ============================================================================
+
+#define FLASH_QUEUE_VERSION "1.0.0"
+#define FLASH_QUEUE_PARTITION_LABEL "mqttlog"     // Ver partitions.csv
+#define FLASH_QUEUE_PARTITION_SUBTYPE 0x40        // Subtipo de datos custom
+#define FLASH_QUEUE_SEGMENT_SIZE 4096             // Un sector flash
+#define FLASH_QUEUE_MAX_TOPIC_LENGTH 128
+#define FLASH_QUEUE_TIMEOUT_MS 1000               // Timeout para mutex
+#define FLASH_QUEUE_MIN_VALID_EPOCH 1609459200UL  // 2021-01-01: reloj válido
+
+// ============================================================================
+// FORMATO EN FLASH
+// ============================================================================
+
+/**
+ * @brief Cabecera de segmento (primeros 16 bytes de cada sector)
+ */
+struct FlashQueueSegmentHeader {
+    uint32_t magic;             ///< FLASH_QUEUE_SEGMENT_MAGIC
+    uint32_t sequence;          ///< Secuencia creciente de apertura
+    uint32_t eraseCount;        ///< Veces que se borró este sector
+    uint16_t version;           ///< Versión del formato
+    uint16_t crc;               ///< CRC16 de los 14 bytes anteriores
+};
+
+/**
+ * @brief Cabecera de registro (16 bytes, alineada a 4)
+ *
+ * El byte de estado sólo pasa de 1 a 0 bits: ESCRIBIENDO (0xFF) ->
+ * VÁLIDO (0xFE) -> CONSUMIDO (0xFC). Así se actualiza sin borrar el sector.
+ */
+struct FlashQueueRecordHeader {
+    uint8_t state;
+    uint8_t flags;              ///< FLASH_QUEUE_FLAG_*
+    uint16_t magic;             ///< FLASH_QUEUE_RECORD_MAGIC
+    uint16_t topicLength;
+    uint16_t payloadLength;
+    uint32_t timestamp;
+    uint16_t crc;               ///< CRC16 de topic + payload
+    uint16_t reserved;
+};
+
+#define FLASH_QUEUE_SEGMENT_MAGIC 0x4751534EUL    // "NSQG"
+#define FLASH_QUEUE_RECORD_MAGIC 0x5152           // "RQ"
+#define FLASH_QUEUE_FORMAT_VERSION 1
+
+#define FLASH_QUEUE_STATE_WRITING 0xFF
+#define FLASH_QUEUE_STATE_VALID 0xFE
+#define FLASH_QUEUE_STATE_CONSUMED 0xFC
+
+#define FLASH_QUEUE_FLAG_RETAINED 0x01
+#define FLASH_QUEUE_FLAG_QOS1 0x02
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+/**
+ * @brief Registro pendiente devuelto por peek()
+ *
+ * El payload no se copia a RAM: se lee por tramos con readPayload().
+ */
+struct FlashQueueRecord {
+    uint16_t segment;           ///< Índice de segmento
+    uint16_t offset;            ///< Offset del registro dentro del segmento
+    uint16_t topicLength;
+    uint16_t payloadLength;
+    bool retained;
+    uint8_t qos;                ///< QoS con que se debe reenviar
+    uint32_t timestamp;         ///< time() al encolar (epoch si hay NTP)
+    char topic[FLASH_QUEUE_MAX_TOPIC_LENGTH + 1];
+};
+
+/**
+ * @brief Estadísticas de la cola persistente
+ */
+struct FlashQueueStats {
+    uint32_t appended;          ///< Registros agregados
+    uint32_t drained;           ///< Registros entregados (pop)
+    uint32_t dropped;           ///< Descartados por falta de espacio
+    uint32_t expired;           ///< Descartados por antigüedad
+    uint32_t corrupted;         ///< Descartados por CRC/cabecera inválida
+    uint32_t erases;            ///< Borrados de sector en este arranque
+    uint32_t maxEraseCount;     ///< Mayor contador de borrados visto
+    uint32_t pendingRecords;    ///< Backlog actual (registros)
+    uint32_t pendingBytes;      ///< Backlog actual (bytes topic+payload)
+};
+
+// ============================================================================
+// CLASE PRINCIPAL
+// ============================================================================
+
+class FlashQueueManager {
+public:
+    FlashQueueManager();
+    ~FlashQueueManager();
+
+    // ========================================================================
+    // INICIALIZACIÓN
+    // ========================================================================
+
+    /**
+     * @brief Abre la partición y recupera el estado del log
+     * @param label Etiqueta de la partición (ver partitions.csv)
+     * @return true si la partición existe y el log quedó operativo
+     */
+    bool begin(const char* label = FLASH_QUEUE_PARTITION_LABEL);
+
+    /**
+     * @brief Libera recursos (el contenido del log se mantiene en flash)
+     */
+    void end();
+
+    bool isReady() const { return initialized; }
+
+    // ========================================================================
+    // RETENCIÓN
+    // ========================================================================
+
+    /**
+     * @brief Configura la retención del log
+     * @param maxAgeSeconds Antigüedad máxima de un registro (0 = sin límite).
+     *        Sólo se aplica cuando el reloj está sincronizado.
+     * @param maxSegments Segmentos a usar (0 = toda la partición). Debe
+     *        llamarse antes de begin(); cambiarlo entre arranques descarta
+     *        los segmentos que quedan fuera del anillo.
+     */
+    void setRetention(uint32_t maxAgeSeconds, uint16_t maxSegments = 0);
+
+    // ========================================================================
+    // OPERACIONES
+    // ========================================================================
+
+    /**
+     * @brief Agrega un mensaje al final del log
+     *
+     * Si el log está lleno se descarta el segmento más antiguo.
+     * @return true si el registro quedó escrito
+     */
+    bool append(const char* topic, const uint8_t* payload, size_t length, bool retained, uint8_t qos = 0);
+
+    /**
+     * @brief Agrega un mensaje cuyo payload está repartido en varios tramos
+     *        (p. ej. un registro de la cola RAM que dio la vuelta al buffer)
+     */
+    bool append(const char* topic, const uint8_t* const parts[], const size_t lengths[], size_t count, bool retained, uint8_t qos = 0);
+
+    /**
+     * @brief Obtiene el registro pendiente más antiguo sin consumirlo
+     * @return false si no hay backlog
+     */
+    bool peek(FlashQueueRecord& record);
+
+    /**
+     * @brief Obtiene el registro pendiente siguiente a `after`, sin consumir
+     *        nada (para tener varios registros en vuelo a la vez)
+     * @return false si `after` es el último
+     */
+    bool peekNext(const FlashQueueRecord& after, FlashQueueRecord& record);
+
+    /**
+     * @brief Vuelve a leer el registro de esa posición (p. ej. para reenviarlo)
+     * @return false si ya no está pendiente (consumido, descartado o pisado)
+     */
+    bool peekAt(uint16_t segment, uint16_t offset, FlashQueueRecord& record);
+
+    /**
+     * @brief Lee un tramo del payload de un registro obtenido con peek()
+     * @return true si la lectura fue correcta
+     */
+    bool readPayload(const FlashQueueRecord& record, size_t offset, uint8_t* buffer, size_t length);
+
+    /**
+     * @brief Marca como entregado el registro más antiguo pendiente
+     *
+     * Con varios en vuelo se consumen en el mismo orden en que se obtuvieron.
+     * @return false si `record` no es el más antiguo (o ya no está)
+     */
+    bool pop(const FlashQueueRecord& record);
+
+    /**
+     * @brief Descarta todo el backlog (abre un segmento nuevo, sin borrar toda la partición)
+     */
+    bool clear();
+
+    // ========================================================================
+    // INFORMACIÓN
+    // ========================================================================
+
+    uint32_t pendingCount() const { return stats.pendingRecords; }
+    uint32_t pendingBytes() const { return stats.pendingBytes; }
+    uint32_t getCapacity() const { return (uint32_t)activeSegments * FLASH_QUEUE_SEGMENT_SIZE; }
+    FlashQueueStats getStats() const { return stats; }
+    void printStats();
+
+private:
+    const esp_partition_t* partition;
+    SemaphoreHandle_t mutex;
+    bool initialized;
+
+    uint16_t segmentCount;      // Segmentos disponibles en la partición
+    uint16_t activeSegments;    // Segmentos usados por el anillo
+    uint16_t maxSegments;       // Límite configurado (0 = todos)
+    uint32_t maxAgeSeconds;
+
+    // Cabeza (escritura)
+    uint16_t headSegment;
+    uint32_t headSequence;
+    uint16_t writeOffset;
+
+    // Cola (lectura)
+    uint16_t tailSegment;
+    uint16_t tailOffset;
+
+    FlashQueueStats stats;
+
+    bool lock();
+    void unlock();
+
+    bool recover();
+    bool formatSegment(uint16_t segment, uint32_t sequence);
+    bool openNextSegment();
+    void dropSegment(uint16_t segment);
+    bool advanceTail();
+    bool advanceCursor(uint16_t& segment, uint16_t& offset);
+    bool scan(uint16_t& segment, uint16_t& offset, FlashQueueRecord& record);
+    bool loadRecord(uint16_t segment, uint16_t offset, const FlashQueueRecordHeader& header, FlashQueueRecord& record);
+    bool readRecordHeader(uint16_t segment, uint16_t offset, FlashQueueRecordHeader& header);
+    bool writeRecordState(uint16_t segment, uint16_t offset, uint8_t state);
+    bool verifyRecord(uint16_t segment, uint16_t offset, const FlashQueueRecordHeader& header);
+
+    static uint16_t recordSize(uint16_t topicLength, uint16_t payloadLength);
+    static uint16_t calculateCRC16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF);
+};
+
+// ============================================================================
+// INSTANCIA GLOBAL
+// ============================================================================
+extern FlashQueueManager FlashQueue;
+
+#endif // FLASH_QUEUE_MANAGER_H
@@ -18,6 +18,11 @@ FlashStorageManager::FlashStorageManager() {
     initialized = false;
     readOnly = false;
     mutex = NULL;
+    cache = nullptr;
+    cacheBudget = 0;
+    cacheBytes = 0;
+    cacheCount = 0;
+    cacheClock = 0;
     memset(namespaceName, 0, sizeof(namespaceName));
     memset(&stats, 0, sizeof(FlashStorageStats));
 }
@@ -67,6 +72,11 @@ FlashStorageStatus FlashStorageManager::begin(const char* ns, bool ro) {
     
     initialized = true;
     
+    // Un lote cortado a mitad (p. ej. por un reset) vuelve a su estado previo
+    if (!readOnly) {
+        recoverBatch();
+    }
+    
     Serial.println("\n╔════════════════════════════════════════╗");
     Serial.println("║   Flash Storage Manager v1.0           ║");
     Serial.println("╚════════════════════════════════════════╝");
@@ -75,12 +85,15 @@ FlashStorageStatus FlashStorageManager::begin(const char* ns, bool ro) {
     Serial.printf("  Thread-safe: ✓\n");
     Serial.printf("  CRC16: ✓\n");
     Serial.printf("  Versioning: ✓\n");
+    Serial.printf("  Lotes atómicos: ✓\n");
     Serial.println("════════════════════════════════════════\n");
     
     return FLASH_STORAGE_OK;
 }
 
 void FlashStorageManager::end() {
+    disableCache();
+    
     if (initialized) {
         preferences.end();
         initialized = false;
@@ -93,23 +106,227 @@ void FlashStorageManager::end() {
     }
 }
 
+// ============================================================================
+// OPERACIONES CON BLOBS (base de save<T>/load<T>)
+// ============================================================================
+
+FlashStorageStatus FlashStorageManager::saveBytes(const char* key, const void* data, size_t size, bool useHeader) {
+    if (!initialized) return FLASH_STORAGE_ERROR_NOT_INITIALIZED;
+    if (data == nullptr) return FLASH_STORAGE_ERROR_NULL_POINTER;
+    if (strlen(key) > FLASH_STORAGE_MAX_KEY_LENGTH) return FLASH_STORAGE_ERROR_KEY_TOO_LONG;
+    
+    // Tomar mutex
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(FLASH_STORAGE_TIMEOUT_MS)) != pdTRUE) {
+        return FLASH_STORAGE_ERROR_TIMEOUT;
+    }
+    
+    FlashStorageStatus status = FLASH_STORAGE_OK;
+    
+    if (useHeader) {
+        // Crear header con CRC
+        FlashStorageHeader header;
+        header.crc = calculateCRC16((const uint8_t*)data, size);
+        header.version = FLASH_STORAGE_VERSION;
+        header.size = size;
+        header.timestamp = millis() / 1000;
+        
+        // Combinar header + data en un buffer
+        size_t totalSize = sizeof(FlashStorageHeader) + size;
+        uint8_t* buffer = new uint8_t[totalSize];
+        memcpy(buffer, &header, sizeof(FlashStorageHeader));
+        memcpy(buffer + sizeof(FlashStorageHeader), data, size);
+        
+        // Guardar blob completo
+        size_t written = preferences.putBytes(key, buffer, totalSize);
+        
+        if (written != totalSize) {
+            cacheInvalidate(key);
+            status = FLASH_STORAGE_ERROR_WRITE_FAILED;
+        } else {
+            cachePut(key, FLASH_VALUE_BLOB, buffer, totalSize);
+            stats.totalWrites++;
+            stats.lastWriteTime = millis();
+        }
+        delete[] buffer;
+    } else {
+        // Guardar directamente sin header
+        size_t written = preferences.putBytes(key, data, size);
+        if (written != size) {
+            cacheInvalidate(key);
+            status = FLASH_STORAGE_ERROR_WRITE_FAILED;
+        } else {
+            cachePut(key, FLASH_VALUE_BLOB, data, size);
+            stats.totalWrites++;
+            stats.lastWriteTime = millis();
+        }
+    }
+    
+    xSemaphoreGive(mutex);
+    return status;
+}
+
+FlashStorageStatus FlashStorageManager::loadBytes(const char* key, void* data, size_t size, bool useHeader) {
+    if (!initialized) return FLASH_STORAGE_ERROR_NOT_INITIALIZED;
+    if (data == nullptr) return FLASH_STORAGE_ERROR_NULL_POINTER;
+    if (strlen(key) > FLASH_STORAGE_MAX_KEY_LENGTH) return FLASH_STORAGE_ERROR_KEY_TOO_LONG;
+    
+    // Tomar mutex
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(FLASH_STORAGE_TIMEOUT_MS)) != pdTRUE) {
+        return FLASH_STORAGE_ERROR_TIMEOUT;
+    }
+    
+    FlashStorageStatus status = FLASH_STORAGE_OK;
+    
+    if (useHeader) {
+        size_t totalSize = sizeof(FlashStorageHeader) + size;
+        uint8_t* buffer = nullptr;
+        const uint8_t* blob;
+        
+        CacheSlot* slot = cacheFind(key, FLASH_VALUE_BLOB, totalSize);
+        if (slot != nullptr) {
+            blob = slot->data;
+        } else {
+            // Verificar que la key existe
+            if (!preferences.isKey(key)) {
+                xSemaphoreGive(mutex);
+                return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
+            }
+            
+            // Leer blob completo
+            buffer = new uint8_t[totalSize];
+            size_t read = preferences.getBytes(key, buffer, totalSize);
+            
+            if (read != totalSize) {
+                delete[] buffer;
+                xSemaphoreGive(mutex);
+                return FLASH_STORAGE_ERROR_READ_FAILED;
+            }
+            blob = buffer;
+        }
+        
+        // Extraer header
+        FlashStorageHeader header;
+        memcpy(&header, blob, sizeof(FlashStorageHeader));
+        
+        // Verificar versión
+        if (header.version != FLASH_STORAGE_VERSION) {
+            delete[] buffer;
+            xSemaphoreGive(mutex);
+            stats.versionMismatches++;
+            return FLASH_STORAGE_ERROR_VERSION_MISMATCH;
+        }
+        
+        // Extraer datos
+        memcpy(data, blob + sizeof(FlashStorageHeader), size);
+        
+        // Verificar CRC (lo que está en caché ya se verificó al entrar)
+        if (slot == nullptr) {
+            uint16_t calculatedCRC = calculateCRC16((const uint8_t*)data, size);
+            if (calculatedCRC != header.crc) {
+                delete[] buffer;
+                xSemaphoreGive(mutex);
+                stats.crcErrors++;
+                return FLASH_STORAGE_ERROR_CRC_MISMATCH;
+            }
+            cachePut(key, FLASH_VALUE_BLOB, buffer, totalSize);
+            delete[] buffer;
+        }
+        
+        stats.totalReads++;
+        stats.lastReadTime = millis();
+        
+    } else if (!cacheRead(key, FLASH_VALUE_BLOB, data, size)) {
+        if (!preferences.isKey(key)) {
+            xSemaphoreGive(mutex);
+            return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
+        }
+        
+        // Leer directamente sin header
+        size_t read = preferences.getBytes(key, data, size);
+        if (read != size) {
+            status = FLASH_STORAGE_ERROR_READ_FAILED;
+        } else {
+            cachePut(key, FLASH_VALUE_BLOB, data, size);
+            stats.totalReads++;
+            stats.lastReadTime = millis();
+        }
+    } else {
+        stats.totalReads++;
+        stats.lastReadTime = millis();
+    }
+    
+    xSemaphoreGive(mutex);
+    return status;
+}
+
+FlashStorageStatus FlashStorageManager::loadRawBytes(const char* key, void* buffer, size_t maxSize, size_t& length) {
+    length = 0;
+    if (!initialized) return FLASH_STORAGE_ERROR_NOT_INITIALIZED;
+    if (buffer == nullptr) return FLASH_STORAGE_ERROR_NULL_POINTER;
+    if (strlen(key) > FLASH_STORAGE_MAX_KEY_LENGTH) return FLASH_STORAGE_ERROR_KEY_TOO_LONG;
+    
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(FLASH_STORAGE_TIMEOUT_MS)) != pdTRUE) {
+        return FLASH_STORAGE_ERROR_TIMEOUT;
+    }
+    
+    CacheSlot* slot = cacheFind(key, FLASH_VALUE_BLOB, 0);
+    if (slot != nullptr) {
+        // Mismo criterio que getBytes(): si no entra, nada
+        if (slot->size <= maxSize) {
+            memcpy(buffer, slot->data, slot->size);
+            length = slot->size;
+        }
+    } else {
+        if (!preferences.isKey(key)) {
+            xSemaphoreGive(mutex);
+            return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
+        }
+        
+        // getBytes() devuelve 0 si el blob no entra en maxSize
+        length = preferences.getBytes(key, buffer, maxSize);
+        if (length > 0) {
+            cachePut(key, FLASH_VALUE_BLOB, buffer, length);
+        }
+    }
+    xSemaphoreGive(mutex);
+    
+    if (length == 0) {
+        return FLASH_STORAGE_ERROR_SIZE_TOO_LARGE;
+    }
+    
+    stats.totalReads++;
+    stats.lastReadTime = millis();
+    return FLASH_STORAGE_OK;
+}
+
 // ============================================================================
 // OPERACIONES CON STRINGS
 // ============================================================================
 
 FlashStorageStatus FlashStorageManager::saveString(const char* key, const String& value) {
+    return saveString(key, value.c_str());
+}
+
+FlashStorageStatus FlashStorageManager::saveString(const char* key, const char* value) {
     if (!initialized) return FLASH_STORAGE_ERROR_NOT_INITIALIZED;
+    if (value == nullptr) return FLASH_STORAGE_ERROR_NULL_POINTER;
     if (strlen(key) > FLASH_STORAGE_MAX_KEY_LENGTH) return FLASH_STORAGE_ERROR_KEY_TOO_LONG;
-    if (value.length() > FLASH_STORAGE_MAX_STRING_LENGTH) return FLASH_STORAGE_ERROR_SIZE_TOO_LARGE;
+    if (strlen(value) > FLASH_STORAGE_MAX_STRING_LENGTH) return FLASH_STORAGE_ERROR_SIZE_TOO_LARGE;
     
     if (xSemaphoreTake(mutex, pdMS_TO_TICKS(FLASH_STORAGE_TIMEOUT_MS)) != pdTRUE) {
         return FLASH_STORAGE_ERROR_TIMEOUT;
     }
     
-    size_t written = preferences.putString(key, value);
+    // putString() devuelve strlen: 0 también es un "" escrito (p. ej. WiFi abierta)
+    bool ok = preferences.putString(key, value) > 0 || value[0] == '\0';
+    if (ok) {
+        cachePut(key, FLASH_VALUE_STRING, value, strlen(value) + 1);
+    } else {
+        cacheInvalidate(key);
+    }
     xSemaphoreGive(mutex);
     
-    if (written == 0) {
+    if (!ok) {
         return FLASH_STORAGE_ERROR_WRITE_FAILED;
     }
     
@@ -126,12 +343,17 @@ FlashStorageStatus FlashStorageManager::loadString(const char* key, String& valu
         return FLASH_STORAGE_ERROR_TIMEOUT;
     }
     
-    if (!preferences.isKey(key)) {
-        xSemaphoreGive(mutex);
-        return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
+    CacheSlot* slot = cacheFind(key, FLASH_VALUE_STRING, 0);
+    if (slot != nullptr) {
+        value = (const char*)slot->data;
+    } else {
+        if (!preferences.isKey(key)) {
+            xSemaphoreGive(mutex);
+            return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
+        }
+        value = preferences.getString(key, "");
+        cacheFill(key, FLASH_VALUE_STRING, value.c_str(), value.length() + 1, value.length() > 0);
     }
-    
-    value = preferences.getString(key, "");
     xSemaphoreGive(mutex);
     
     stats.totalReads++;
@@ -147,7 +369,14 @@ String FlashStorageManager::loadString(const char* key, const String& defaultVal
         return defaultValue;
     }
     
-    String value = preferences.getString(key, defaultValue);
+    String value;
+    CacheSlot* slot = cacheFind(key, FLASH_VALUE_STRING, 0);
+    if (slot != nullptr) {
+        value = (const char*)slot->data;
+    } else {
+        value = preferences.getString(key, defaultValue);
+        cacheFill(key, FLASH_VALUE_STRING, value.c_str(), value.length() + 1, value != defaultValue);
+    }
     xSemaphoreGive(mutex);
     
     stats.totalReads++;
@@ -168,6 +397,11 @@ FlashStorageStatus FlashStorageManager::saveInt(const char* key, int32_t value)
     }
     
     size_t written = preferences.putInt(key, value);
+    if (written == 0) {
+        cacheInvalidate(key);
+    } else {
+        cachePut(key, FLASH_VALUE_I32, &value, sizeof(value));
+    }
     xSemaphoreGive(mutex);
     
     if (written == 0) {
@@ -187,12 +421,14 @@ FlashStorageStatus FlashStorageManager::loadInt(const char* key, int32_t& value)
         return FLASH_STORAGE_ERROR_TIMEOUT;
     }
     
-    if (!preferences.isKey(key)) {
-        xSemaphoreGive(mutex);
-        return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
+    if (!cacheRead(key, FLASH_VALUE_I32, &value, sizeof(value))) {
+        if (!preferences.isKey(key)) {
+            xSemaphoreGive(mutex);
+            return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
+        }
+        value = preferences.getInt(key, 0);
+        cacheFill(key, FLASH_VALUE_I32, &value, sizeof(value), value != 0);
     }
-    
-    value = preferences.getInt(key, 0);
     xSemaphoreGive(mutex);
     
     stats.totalReads++;
@@ -208,7 +444,11 @@ int32_t FlashStorageManager::loadInt(const char* key, int32_t defaultValue) {
         return defaultValue;
     }
     
-    int32_t value = preferences.getInt(key, defaultValue);
+    int32_t value;
+    if (!cacheRead(key, FLASH_VALUE_I32, &value, sizeof(value))) {
+        value = preferences.getInt(key, defaultValue);
+        cacheFill(key, FLASH_VALUE_I32, &value, sizeof(value), value != defaultValue);
+    }
     xSemaphoreGive(mutex);
     
     stats.totalReads++;
@@ -225,6 +465,11 @@ FlashStorageStatus FlashStorageManager::saveUInt(const char* key, uint32_t value
     }
     
     size_t written = preferences.putUInt(key, value);
+    if (written == 0) {
+        cacheInvalidate(key);
+    } else {
+        cachePut(key, FLASH_VALUE_U32, &value, sizeof(value));
+    }
     xSemaphoreGive(mutex);
     
     if (written == 0) {
@@ -244,12 +489,14 @@ FlashStorageStatus FlashStorageManager::loadUInt(const char* key, uint32_t& valu
         return FLASH_STORAGE_ERROR_TIMEOUT;
     }
     
-    if (!preferences.isKey(key)) {
-        xSemaphoreGive(mutex);
-        return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
+    if (!cacheRead(key, FLASH_VALUE_U32, &value, sizeof(value))) {
+        if (!preferences.isKey(key)) {
+            xSemaphoreGive(mutex);
+            return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
+        }
+        value = preferences.getUInt(key, 0);
+        cacheFill(key, FLASH_VALUE_U32, &value, sizeof(value), value != 0);
     }
-    
-    value = preferences.getUInt(key, 0);
     xSemaphoreGive(mutex);
     
     stats.totalReads++;
@@ -265,7 +512,11 @@ uint32_t FlashStorageManager::loadUInt(const char* key, uint32_t defaultValue) {
         return defaultValue;
     }
     
-    uint32_t value = preferences.getUInt(key, defaultValue);
+    uint32_t value;
+    if (!cacheRead(key, FLASH_VALUE_U32, &value, sizeof(value))) {
+        value = preferences.getUInt(key, defaultValue);
+        cacheFill(key, FLASH_VALUE_U32, &value, sizeof(value), value != defaultValue);
+    }
     xSemaphoreGive(mutex);
     
     stats.totalReads++;
@@ -282,6 +533,12 @@ FlashStorageStatus FlashStorageManager::saveBool(const char* key, bool value) {
     }
     
     size_t written = preferences.putBool(key, value);
+    if (written == 0) {
+        cacheInvalidate(key);
+    } else {
+        uint8_t raw = value ? 1 : 0;
+        cachePut(key, FLASH_VALUE_U8, &raw, sizeof(raw));
+    }
     xSemaphoreGive(mutex);
     
     if (written == 0) {
@@ -301,12 +558,18 @@ FlashStorageStatus FlashStorageManager::loadBool(const char* key, bool& value) {
         return FLASH_STORAGE_ERROR_TIMEOUT;
     }
     
-    if (!preferences.isKey(key)) {
-        xSemaphoreGive(mutex);
-        return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
+    uint8_t raw;
+    if (cacheRead(key, FLASH_VALUE_U8, &raw, sizeof(raw))) {
+        value = raw != 0;
+    } else {
+        if (!preferences.isKey(key)) {
+            xSemaphoreGive(mutex);
+            return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
+        }
+        value = preferences.getBool(key, false);
+        raw = value ? 1 : 0;
+        cacheFill(key, FLASH_VALUE_U8, &raw, sizeof(raw), value);
     }
-    
-    value = preferences.getBool(key, false);
     xSemaphoreGive(mutex);
     
     stats.totalReads++;
@@ -322,7 +585,15 @@ bool FlashStorageManager::loadBool(const char* key, bool defaultValue) {
         return defaultValue;
     }
     
-    bool value = preferences.getBool(key, defaultValue);
+    bool value;
+    uint8_t raw;
+    if (cacheRead(key, FLASH_VALUE_U8, &raw, sizeof(raw))) {
+        value = raw != 0;
+    } else {
+        value = preferences.getBool(key, defaultValue);
+        raw = value ? 1 : 0;
+        cacheFill(key, FLASH_VALUE_U8, &raw, sizeof(raw), value != defaultValue);
+    }
     xSemaphoreGive(mutex);
     
     stats.totalReads++;
@@ -339,6 +610,11 @@ FlashStorageStatus FlashStorageManager::saveFloat(const char* key, float value)
     }
     
     size_t written = preferences.putFloat(key, value);
+    if (written == 0) {
+        cacheInvalidate(key);
+    } else {
+        cachePut(key, FLASH_VALUE_BLOB, &value, sizeof(value));
+    }
     xSemaphoreGive(mutex);
     
     if (written == 0) {
@@ -358,12 +634,16 @@ FlashStorageStatus FlashStorageManager::loadFloat(const char* key, float& value)
         return FLASH_STORAGE_ERROR_TIMEOUT;
     }
     
-    if (!preferences.isKey(key)) {
-        xSemaphoreGive(mutex);
-        return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
+    if (!cacheRead(key, FLASH_VALUE_BLOB, &value, sizeof(value))) {
+        if (!preferences.isKey(key)) {
+            xSemaphoreGive(mutex);
+            return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
+        }
+        value = preferences.getFloat(key, 0.0f);
+        if (preferences.getBytesLength(key) == sizeof(value)) {
+            cachePut(key, FLASH_VALUE_BLOB, &value, sizeof(value));
+        }
     }
-    
-    value = preferences.getFloat(key, 0.0f);
     xSemaphoreGive(mutex);
     
     stats.totalReads++;
@@ -379,7 +659,13 @@ float FlashStorageManager::loadFloat(const char* key, float defaultValue) {
         return defaultValue;
     }
     
-    float value = preferences.getFloat(key, defaultValue);
+    float value;
+    if (!cacheRead(key, FLASH_VALUE_BLOB, &value, sizeof(value))) {
+        value = preferences.getFloat(key, defaultValue);
+        if (cache != nullptr && preferences.getBytesLength(key) == sizeof(value)) {
+            cachePut(key, FLASH_VALUE_BLOB, &value, sizeof(value));
+        }
+    }
     xSemaphoreGive(mutex);
     
     stats.totalReads++;
@@ -413,6 +699,7 @@ FlashStorageStatus FlashStorageManager::remove(const char* key) {
         return FLASH_STORAGE_ERROR_TIMEOUT;
     }
     
+    cacheInvalidate(key);
     bool result = preferences.remove(key);
     xSemaphoreGive(mutex);
     
@@ -426,6 +713,7 @@ FlashStorageStatus FlashStorageManager::clear() {
         return FLASH_STORAGE_ERROR_TIMEOUT;
     }
     
+    cacheFlush();
     bool result = preferences.clear();
     xSemaphoreGive(mutex);
     
@@ -447,6 +735,536 @@ size_t FlashStorageManager::getFreeEntries() {
     return free;
 }
 
+// ============================================================================
+// CACHÉ DE LECTURA
+// ============================================================================
+
+#define CACHE_MASK (FLASH_STORAGE_CACHE_SLOTS - 1)
+
+bool FlashStorageManager::enableCache(size_t budgetBytes) {
+    if (!initialized) return false;
+    
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(FLASH_STORAGE_TIMEOUT_MS)) != pdTRUE) {
+        return false;
+    }
+    
+    if (cache == nullptr) {
+        cache = (CacheSlot*)calloc(FLASH_STORAGE_CACHE_SLOTS, sizeof(CacheSlot));
+    } else {
+        cacheFlush();
+    }
+    cacheBudget = (cache != nullptr) ? budgetBytes : 0;
+    xSemaphoreGive(mutex);
+    
+    if (cache == nullptr) {
+        Serial.println("[FLASH STORAGE] ERROR: Sin memoria para la caché");
+        return false;
+    }
+    
+    Serial.printf("[FLASH STORAGE] ✓ Caché de lectura: %zu bytes\n", budgetBytes);
+    return true;
+}
+
+void FlashStorageManager::disableCache() {
+    if (cache == nullptr) return;
+    
+    // Desde end() el mutex puede no existir todavía
+    bool locked = (mutex != NULL) && xSemaphoreTake(mutex, pdMS_TO_TICKS(FLASH_STORAGE_TIMEOUT_MS)) == pdTRUE;
+    cacheFlush();
+    free(cache);
+    cache = nullptr;
+    cacheBudget = 0;
+    if (locked) xSemaphoreGive(mutex);
+}
+
+FlashStorageManager::CacheSlot* FlashStorageManager::cacheFind(const char* key, FlashStorageValueType type, size_t size) {
+    if (cache == nullptr) return nullptr;
+    
+    // La tabla nunca se llena (CACHE_MAX_ENTRIES < SLOTS): el sondeo termina
+    uint32_t hash = cacheHash(key);
+    for (size_t i = hash & CACHE_MASK; cache[i].hash != 0; i = (i + 1) & CACHE_MASK) {
+        if (cache[i].hash != hash || strcmp(cache[i].key, key) != 0) continue;
+        
+        // Otro tipo u otro tamaño: que responda NVS, como sin caché
+        if (cache[i].type != type || (size != 0 && cache[i].size != size)) break;
+        
+        cache[i].lastUse = ++cacheClock;
+        stats.cacheHits++;
+        return &cache[i];
+    }
+    
+    stats.cacheMisses++;
+    return nullptr;
+}
+
+bool FlashStorageManager::cacheRead(const char* key, FlashStorageValueType type, void* value, size_t size) {
+    CacheSlot* slot = cacheFind(key, type, size);
+    if (slot == nullptr) return false;
+    
+    memcpy(value, slot->data, size);
+    return true;
+}
+
+void FlashStorageManager::cachePut(const char* key, FlashStorageValueType type, const void* data, size_t size) {
+    if (cache == nullptr) return;
+    
+    cacheInvalidate(key);
+    
+    // Un valor que se come más de un cuarto del presupuesto vaciaría la caché
+    if (size > cacheBudget / 4) return;
+    
+    // Descartar los menos usados hasta que entre
+    while (cacheCount >= FLASH_STORAGE_CACHE_MAX_ENTRIES || cacheBytes + size > cacheBudget) {
+        size_t oldest = FLASH_STORAGE_CACHE_SLOTS;
+        for (size_t i = 0; i < FLASH_STORAGE_CACHE_SLOTS; i++) {
+            if (cache[i].hash == 0) continue;
+            if (oldest == FLASH_STORAGE_CACHE_SLOTS || cache[i].lastUse < cache[oldest].lastUse) {
+                oldest = i;
+            }
+        }
+        if (oldest == FLASH_STORAGE_CACHE_SLOTS) break;
+        cacheErase(oldest);
+    }
+    
+    uint8_t* copy = (uint8_t*)malloc(size > 0 ? size : 1);
+    if (copy == nullptr) return;
+    memcpy(copy, data, size);
+    
+    uint32_t hash = cacheHash(key);
+    size_t i = hash & CACHE_MASK;
+    while (cache[i].hash != 0) {
+        i = (i + 1) & CACHE_MASK;
+    }
+    
+    strncpy(cache[i].key, key, FLASH_STORAGE_MAX_KEY_LENGTH);
+    cache[i].key[FLASH_STORAGE_MAX_KEY_LENGTH] = '\0';
+    cache[i].hash = hash;
+    cache[i].lastUse = ++cacheClock;
+    cache[i].type = type;
+    cache[i].data = copy;
+    cache[i].size = size;
+    cacheBytes += size;
+    cacheCount++;
+}
+
+// Tipo de Preferences que corresponde a cada FlashStorageValueType
+static PreferenceType preferenceType(FlashStorageValueType type) {
+    switch (type) {
+        case FLASH_VALUE_U8:     return PT_U8;
+        case FLASH_VALUE_I32:    return PT_I32;
+        case FLASH_VALUE_U32:    return PT_U32;
+        case FLASH_VALUE_STRING: return PT_STR;
+        case FLASH_VALUE_BLOB:   return PT_BLOB;
+        default:                 return PT_INVALID;
+    }
+}
+
+void FlashStorageManager::cacheFill(const char* key, FlashStorageValueType type, const void* data, size_t size, bool confirmed) {
+    if (cache == nullptr) return;
+    
+    // Los get*() de Preferences devuelven el default si la clave falta o es
+    // de otro tipo: un valor igual al default hay que confirmarlo
+    if (!confirmed && (!preferences.isKey(key) || preferences.getType(key) != preferenceType(type))) {
+        return;
+    }
+    cachePut(key, type, data, size);
+}
+
+void FlashStorageManager::cacheInvalidate(const char* key) {
+    if (cache == nullptr) return;
+    
+    uint32_t hash = cacheHash(key);
+    for (size_t i = hash & CACHE_MASK; cache[i].hash != 0; i = (i + 1) & CACHE_MASK) {
+        if (cache[i].hash == hash && strcmp(cache[i].key, key) == 0) {
+            cacheErase(i);
+            return;
+        }
+    }
+}
+
+void FlashStorageManager::cacheErase(size_t index) {
+    free(cache[index].data);
+    cacheBytes -= cache[index].size;
+    cacheCount--;
+    
+    // Borrado con corrimiento hacia atrás: sin lápidas, los sondeos siguen cortos
+    size_t hole = index;
+    size_t next = index;
+    for (;;) {
+        cache[hole].hash = 0;
+        cache[hole].data = nullptr;
+        
+        size_t home;
+        do {
+            next = (next + 1) & CACHE_MASK;
+            if (cache[next].hash == 0) return;
+            home = cache[next].hash & CACHE_MASK;
+        } while (hole <= next ? (hole < home && home <= next) : (hole < home || home <= next));
+        
+        cache[hole] = cache[next];
+        hole = next;
+    }
+}
+
+void FlashStorageManager::cacheFlush() {
+    if (cache == nullptr) return;
+    
+    for (size_t i = 0; i < FLASH_STORAGE_CACHE_SLOTS; i++) {
+        free(cache[i].data);
+    }
+    memset(cache, 0, FLASH_STORAGE_CACHE_SLOTS * sizeof(CacheSlot));
+    cacheBytes = 0;
+    cacheCount = 0;
+}
+
+uint32_t FlashStorageManager::cacheHash(const char* key) {
+    // FNV-1a; 0 marca slot libre
+    uint32_t hash = 2166136261u;
+    while (*key) {
+        hash ^= (uint8_t)*key++;
+        hash *= 16777619u;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+// ============================================================================
+// LOTES
+// ============================================================================
+
+// Registro de deshacer: [crc16][cantidad] y por clave [key 16][tipo][largo 2][valor previo]
+#define UNDO_HEADER_SIZE 3
+#define UNDO_RECORD_HEADER_SIZE (FLASH_STORAGE_MAX_KEY_LENGTH + 1 + 1 + 2)
+
+FlashStorageStatus FlashStorageManager::commitBatch(const FlashStorageBatch& batch) {
+    if (!initialized) return FLASH_STORAGE_ERROR_NOT_INITIALIZED;
+    if (readOnly) return FLASH_STORAGE_ERROR_WRITE_FAILED;
+    if (batch.itemCount == 0) return FLASH_STORAGE_OK;
+    
+    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(FLASH_STORAGE_TIMEOUT_MS)) != pdTRUE) {
+        return FLASH_STORAGE_ERROR_TIMEOUT;
+    }
+    
+    // Handle propio sobre el mismo namespace: Preferences hace commit en cada put
+    nvs_handle_t handle;
+    if (nvs_open(namespaceName, NVS_READWRITE, &handle) != ESP_OK) {
+        xSemaphoreGive(mutex);
+        return FLASH_STORAGE_ERROR_WRITE_FAILED;
+    }
+    
+    FlashStorageStatus status = FLASH_STORAGE_OK;
+    
+    // Una sola clave ya es atómica en NVS: sólo los lotes de varias se registran
+    bool journaled = batch.itemCount > 1;
+    uint8_t* undo = nullptr;
+    size_t undoLength = UNDO_HEADER_SIZE;
+    
+    if (journaled) {
+        undo = new uint8_t[FLASH_STORAGE_MAX_BLOB_SIZE];
+        for (uint8_t i = 0; i < batch.itemCount; i++) {
+            if (!appendUndo(handle, batch.items[i].key, undo, undoLength)) {
+                status = FLASH_STORAGE_ERROR_SIZE_TOO_LARGE;
+                break;
+            }
+        }
+        
+        if (status == FLASH_STORAGE_OK) {
+            undo[2] = batch.itemCount;
+            uint16_t crc = calculateCRC16(undo + 2, undoLength - 2);
+            memcpy(undo, &crc, sizeof(crc));
+            if (nvs_set_blob(handle, FLASH_STORAGE_UNDO_KEY, undo, undoLength) != ESP_OK ||
+                nvs_commit(handle) != ESP_OK) {
+                status = FLASH_STORAGE_ERROR_WRITE_FAILED;
+            }
+        }
+    }
+    
+    bool clean = true;  // false: el registro queda para que begin() reintente
+    if (status == FLASH_STORAGE_OK) {
+        for (uint8_t i = 0; i < batch.itemCount; i++) {
+            const FlashStorageBatch::Item& item = batch.items[i];
+            if (writeValue(handle, item.key, item.type, item.data, item.size) != ESP_OK) {
+                Serial.printf("[FLASH STORAGE] ERROR: Lote falló en '%s'\n", item.key);
+                status = FLASH_STORAGE_ERROR_WRITE_FAILED;
+                break;
+            }
+        }
+        
+        // Un solo commit para todas las claves del lote
+        if (status == FLASH_STORAGE_OK && nvs_commit(handle) != ESP_OK) {
+            status = FLASH_STORAGE_ERROR_WRITE_FAILED;
+        }
+        
+        if (status != FLASH_STORAGE_OK && journaled) {
+            clean = applyUndo(handle, undo, undoLength);
+            nvs_commit(handle);
+            stats.batchRollbacks++;
+            Serial.printf("[FLASH STORAGE] Lote revertido (%u claves)%s\n", batch.itemCount,
+                          clean ? "" : " - se reintentará al iniciar");
+        }
+    }
+    
+    if (journaled && clean) {
+        nvs_erase_key(handle, FLASH_STORAGE_UNDO_KEY);
+        nvs_commit(handle);
+    }
+    
+    nvs_close(handle);
+    delete[] undo;
+    
+    // Escrito por fuera de Preferences: lo que hubiera en caché ya no vale
+    for (uint8_t i = 0; i < batch.itemCount; i++) {
+        cacheInvalidate(batch.items[i].key);
+    }
+    xSemaphoreGive(mutex);
+    
+    if (status == FLASH_STORAGE_OK) {
+        stats.totalWrites += batch.itemCount;
+        stats.batchCommits++;
+        stats.lastWriteTime = millis();
+    }
+    return status;
+}
+
+bool FlashStorageManager::appendUndo(nvs_handle_t handle, const char* key, uint8_t* log, size_t& length) {
+    if (length + UNDO_RECORD_HEADER_SIZE > FLASH_STORAGE_MAX_BLOB_SIZE) return false;
+    
+    uint8_t* record = log + length;
+    uint8_t* value = record + UNDO_RECORD_HEADER_SIZE;
+    size_t room = FLASH_STORAGE_MAX_BLOB_SIZE - length - UNDO_RECORD_HEADER_SIZE;
+    
+    // Mismo sondeo de tipos que Preferences::getType()
+    FlashStorageValueType type = FLASH_VALUE_NONE;
+    size_t size = 0;
+    uint8_t u8;
+    int32_t i32;
+    uint32_t u32;
+    
+    if (nvs_get_u8(handle, key, &u8) == ESP_OK) {
+        type = FLASH_VALUE_U8;
+        size = sizeof(u8);
+        if (size > room) return false;
+        memcpy(value, &u8, size);
+    } else if (nvs_get_i32(handle, key, &i32) == ESP_OK) {
+        type = FLASH_VALUE_I32;
+        size = sizeof(i32);
+        if (size > room) return false;
+        memcpy(value, &i32, size);
+    } else if (nvs_get_u32(handle, key, &u32) == ESP_OK) {
+        type = FLASH_VALUE_U32;
+        size = sizeof(u32);
+        if (size > room) return false;
+        memcpy(value, &u32, size);
+    } else if (nvs_get_str(handle, key, NULL, &size) == ESP_OK) {
+        type = FLASH_VALUE_STRING;
+        if (size > room || nvs_get_str(handle, key, (char*)value, &size) != ESP_OK) return false;
+    } else if (nvs_get_blob(handle, key, NULL, &size) == ESP_OK) {
+        type = FLASH_VALUE_BLOB;
+        if (size > room || nvs_get_blob(handle, key, value, &size) != ESP_OK) return false;
+    }
+    
+    memset(record, 0, FLASH_STORAGE_MAX_KEY_LENGTH + 1);
+    strncpy((char*)record, key, FLASH_STORAGE_MAX_KEY_LENGTH);
+    record[FLASH_STORAGE_MAX_KEY_LENGTH + 1] = type;
+    record[FLASH_STORAGE_MAX_KEY_LENGTH + 2] = size & 0xFF;
+    record[FLASH_STORAGE_MAX_KEY_LENGTH + 3] = (size >> 8) & 0xFF;
+    
+    length += UNDO_RECORD_HEADER_SIZE + size;
+    return true;
+}
+
+bool FlashStorageManager::applyUndo(nvs_handle_t handle, const uint8_t* log, size_t length) {
+    if (log == nullptr || length < UNDO_HEADER_SIZE) return false;
+    
+    uint16_t crc;
+    memcpy(&crc, log, sizeof(crc));
+    if (crc != calculateCRC16(log + 2, length - 2)) return false;
+    
+    bool ok = true;
+    uint8_t count = log[2];
+    size_t offset = UNDO_HEADER_SIZE;
+    
+    for (uint8_t i = 0; i < count; i++) {
+        if (offset + UNDO_RECORD_HEADER_SIZE > length) return false;
+        
+        const uint8_t* record = log + offset;
+        char key[FLASH_STORAGE_MAX_KEY_LENGTH + 1];
+        memcpy(key, record, sizeof(key));
+        key[FLASH_STORAGE_MAX_KEY_LENGTH] = '\0';
+        FlashStorageValueType type = (FlashStorageValueType)record[FLASH_STORAGE_MAX_KEY_LENGTH + 1];
+        size_t size = record[FLASH_STORAGE_MAX_KEY_LENGTH + 2] | (record[FLASH_STORAGE_MAX_KEY_LENGTH + 3] << 8);
+        
+        offset += UNDO_RECORD_HEADER_SIZE;
+        if (offset + size > length) return false;
+        
+        // Seguir aunque una falle: restaurar todo lo posible
+        if (writeValue(handle, key, type, log + offset, size) != ESP_OK) {
+            ok = false;
+        }
+        offset += size;
+    }
+    
+    return ok;
+}
+
+void FlashStorageManager::recoverBatch() {
+    nvs_handle_t handle;
+    if (nvs_open(namespaceName, NVS_READWRITE, &handle) != ESP_OK) return;
+    
+    size_t length = 0;
+    if (nvs_get_blob(handle, FLASH_STORAGE_UNDO_KEY, NULL, &length) == ESP_OK) {
+        uint8_t* log = new uint8_t[length];
+        bool restored = nvs_get_blob(handle, FLASH_STORAGE_UNDO_KEY, log, &length) == ESP_OK &&
+                        applyUndo(handle, log, length);
+        
+        if (restored) {
+            stats.batchRollbacks++;
+            Serial.printf("[FLASH STORAGE] ⚠️  Lote interrumpido: %u claves restauradas\n", log[2]);
+        } else {
+            Serial.println("[FLASH STORAGE] ERROR: Registro de lote ilegible, descartado");
+        }
+        delete[] log;
+        
+        nvs_erase_key(handle, FLASH_STORAGE_UNDO_KEY);
+        nvs_commit(handle);
+    }
+    
+    nvs_close(handle);
+}
+
+esp_err_t FlashStorageManager::writeValue(nvs_handle_t handle, const char* key, FlashStorageValueType type,
+                                          const uint8_t* data, size_t size) {
+    switch (type) {
+        case FLASH_VALUE_U8: {
+            uint8_t value;
+            memcpy(&value, data, sizeof(value));
+            return nvs_set_u8(handle, key, value);
+        }
+        case FLASH_VALUE_I32: {
+            int32_t value;
+            memcpy(&value, data, sizeof(value));
+            return nvs_set_i32(handle, key, value);
+        }
+        case FLASH_VALUE_U32: {
+            uint32_t value;
+            memcpy(&value, data, sizeof(value));
+            return nvs_set_u32(handle, key, value);
+        }
+        case FLASH_VALUE_STRING:
+            return nvs_set_str(handle, key, (const char*)data);
+        case FLASH_VALUE_BLOB:
+            return nvs_set_blob(handle, key, data, size);
+        default: {
+            // Ausente: borrar (ya ausente también es éxito)
+            esp_err_t err = nvs_erase_key(handle, key);
+            return (err == ESP_ERR_NVS_NOT_FOUND) ? ESP_OK : err;
+        }
+    }
+}
+
+// ============================================================================
+// FLASH STORAGE BATCH
+// ============================================================================
+
+FlashStorageBatch::FlashStorageBatch() {
+    memset(items, 0, sizeof(items));
+    itemCount = 0;
+}
+
+FlashStorageBatch::~FlashStorageBatch() {
+    clear();
+}
+
+void FlashStorageBatch::clear() {
+    for (uint8_t i = 0; i < itemCount; i++) {
+        free(items[i].data);
+        items[i].data = nullptr;
+    }
+    itemCount = 0;
+}
+
+FlashStorageStatus FlashStorageBatch::putString(const char* key, const char* value) {
+    if (value == nullptr) return FLASH_STORAGE_ERROR_NULL_POINTER;
+    if (strlen(value) > FLASH_STORAGE_MAX_STRING_LENGTH) return FLASH_STORAGE_ERROR_SIZE_TOO_LARGE;
+    return add(key, FLASH_VALUE_STRING, value, strlen(value) + 1);
+}
+
+FlashStorageStatus FlashStorageBatch::putInt(const char* key, int32_t value) {
+    return add(key, FLASH_VALUE_I32, &value, sizeof(value));
+}
+
+FlashStorageStatus FlashStorageBatch::putUInt(const char* key, uint32_t value) {
+    return add(key, FLASH_VALUE_U32, &value, sizeof(value));
+}
+
+FlashStorageStatus FlashStorageBatch::putBool(const char* key, bool value) {
+    uint8_t raw = value ? 1 : 0;
+    return add(key, FLASH_VALUE_U8, &raw, sizeof(raw));
+}
+
+FlashStorageStatus FlashStorageBatch::putFloat(const char* key, float value) {
+    return add(key, FLASH_VALUE_BLOB, &value, sizeof(value));
+}
+
+FlashStorageStatus FlashStorageBatch::putBytes(const char* key, const void* data, size_t size, bool useHeader) {
+    if (data == nullptr) return FLASH_STORAGE_ERROR_NULL_POINTER;
+    if (!useHeader) {
+        return add(key, FLASH_VALUE_BLOB, data, size);
+    }
+    
+    // Mismo formato que save<T>()
+    FlashStorageHeader header;
+    header.crc = FlashStorageManager::calculateCRC16((const uint8_t*)data, size);
+    header.version = FLASH_STORAGE_VERSION;
+    header.size = size;
+    header.timestamp = millis() / 1000;
+    return add(key, FLASH_VALUE_BLOB, &header, sizeof(header), data, size);
+}
+
+FlashStorageStatus FlashStorageBatch::remove(const char* key) {
+    return add(key, FLASH_VALUE_NONE, nullptr, 0);
+}
+
+FlashStorageStatus FlashStorageBatch::add(const char* key, FlashStorageValueType type,
+                                          const void* first, size_t firstSize,
+                                          const void* second, size_t secondSize) {
+    if (key == nullptr) return FLASH_STORAGE_ERROR_NULL_POINTER;
+    if (strlen(key) == 0 || strlen(key) > FLASH_STORAGE_MAX_KEY_LENGTH) return FLASH_STORAGE_ERROR_KEY_TOO_LONG;
+    
+    size_t size = firstSize + secondSize;
+    if (size > FLASH_STORAGE_MAX_BLOB_SIZE) return FLASH_STORAGE_ERROR_SIZE_TOO_LARGE;
+    
+    Item* item = nullptr;
+    for (uint8_t i = 0; i < itemCount; i++) {
+        if (strcmp(items[i].key, key) == 0) {
+            item = &items[i];
+            break;
+        }
+    }
+    if (item == nullptr && itemCount >= FLASH_STORAGE_BATCH_MAX_ITEMS) {
+        return FLASH_STORAGE_ERROR_SIZE_TOO_LARGE;
+    }
+    
+    uint8_t* data = nullptr;
+    if (size > 0) {
+        data = (uint8_t*)malloc(size);
+        if (data == nullptr) return FLASH_STORAGE_ERROR_SIZE_TOO_LARGE;
+        memcpy(data, first, firstSize);
+        if (secondSize > 0) memcpy(data + firstSize, second, secondSize);
+    }
+    
+    if (item == nullptr) {
+        item = &items[itemCount++];
+        strncpy(item->key, key, FLASH_STORAGE_MAX_KEY_LENGTH);
+        item->key[FLASH_STORAGE_MAX_KEY_LENGTH] = '\0';
+    } else {
+        free(item->data);
+    }
+    item->type = type;
+    item->data = data;
+    item->size = size;
+    return FLASH_STORAGE_OK;
+}
+
 // ============================================================================
 // ESTADÍSTICAS Y DIAGNÓSTICO
 // ============================================================================
@@ -467,6 +1285,13 @@ void FlashStorageManager::printStats() {
     Serial.printf("  Errores de versión: %lu\n", stats.versionMismatches);
     Serial.printf("  Última escritura: %lu ms\n", stats.lastWriteTime);
     Serial.printf("  Última lectura: %lu ms\n", stats.lastReadTime);
+    Serial.printf("  Lotes: %lu (revertidos: %lu)\n", stats.batchCommits, stats.batchRollbacks);
+    if (cache != nullptr) {
+        Serial.printf("  Caché: %u claves, %zu/%zu bytes, %lu aciertos, %lu fallos\n",
+                      cacheCount, cacheBytes, cacheBudget, stats.cacheHits, stats.cacheMisses);
+    } else {
+        Serial.println("  Caché: desactivada");
+    }
     Serial.printf("  Entradas libres: %zu\n", getFreeEntries());
     Serial.println("════════════════════════════════════════\n");
 }
@@ -15,6 +15,8 @@
  * - Soporte para estructuras, strings y tipos primitivos
  * - API simple tipo template (genérico)
  * - Límites de escritura para proteger flash (10,000 ciclos típicos)
+ * - Lotes de varias claves con commit único y rollback (FlashStorageBatch)
+ * - Caché de lectura opcional en RAM con presupuesto de bytes (enableCache)
  * 
  * Uso:
  * @code
@@ -36,6 +38,7 @@
 
 #include <Arduino.h>
 #include <Preferences.h>
+#include <nvs.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
@@ -48,6 +51,11 @@
 #define FLASH_STORAGE_MAX_STRING_LENGTH 512    // Máximo para strings
 #define FLASH_STORAGE_MAX_BLOB_SIZE 4000       // Máximo para blobs (4KB)
 #define FLASH_STORAGE_TIMEOUT_MS 1000          // Timeout para mutex
+#define FLASH_STORAGE_BATCH_MAX_ITEMS 16       // Claves por lote
+#define FLASH_STORAGE_UNDO_KEY "_fs_undo"      // Valores previos de un lote en curso
+#define FLASH_STORAGE_CACHE_SLOTS 32           // Tabla hash de la caché (potencia de 2)
+#define FLASH_STORAGE_CACHE_MAX_ENTRIES 24     // 3/4 de los slots: sondeos cortos
+#define FLASH_STORAGE_CACHE_DEFAULT_BUDGET 2048  // Bytes de valores en caché
 
 // ============================================================================
 // ENUMERACIONES
@@ -70,6 +78,18 @@ enum FlashStorageStatus {
     FLASH_STORAGE_ERROR_NULL_POINTER
 };
 
+/**
+ * @brief Tipo NVS de un valor (como lo escribe Preferences)
+ */
+enum FlashStorageValueType : uint8_t {
+    FLASH_VALUE_NONE = 0,       // Clave ausente (en un lote: borrarla)
+    FLASH_VALUE_U8,             // putBool
+    FLASH_VALUE_I32,            // putInt
+    FLASH_VALUE_U32,            // putUInt
+    FLASH_VALUE_STRING,         // putString
+    FLASH_VALUE_BLOB            // putBytes, putFloat, save<T>
+};
+
 // ============================================================================
 // ESTRUCTURAS
 // ============================================================================
@@ -94,6 +114,75 @@ struct FlashStorageStats {
     uint32_t versionMismatches;
     unsigned long lastWriteTime;
     unsigned long lastReadTime;
+    uint32_t batchCommits;      // Lotes escritos completos
+    uint32_t batchRollbacks;    // Lotes revertidos (error o corte de energía)
+    uint32_t cacheHits;         // Lecturas servidas desde RAM
+    uint32_t cacheMisses;       // Lecturas que fueron a NVS con la caché activa
+};
+
+// ============================================================================
+// LOTE DE ESCRITURAS
+// ============================================================================
+
+/**
+ * @brief Escrituras de varias claves que se aplican todas o ninguna
+ * 
+ * El lote se arma en RAM (copia los valores) sin tocar la flash; 
+ * FlashStorageManager::commitBatch() lo aplica con un solo nvs_commit.
+ * Antes de escribir guarda los valores previos en FLASH_STORAGE_UNDO_KEY:
+ * si una escritura falla se restauran en el momento, y si se corta la
+ * energía a mitad, begin() los restaura en el próximo arranque.
+ * 
+ * @code
+ * FlashStorageBatch batch;
+ * batch.putString("mqtt_server", server);
+ * batch.putInt("mqtt_port", port);
+ * batch.put("sensor", sensorConfig);
+ * if (FlashStorage.commitBatch(batch) != FLASH_STORAGE_OK) { ... }
+ * @endcode
+ */
+class FlashStorageBatch {
+public:
+    FlashStorageBatch();
+    ~FlashStorageBatch();
+    
+    // Una clave repetida reemplaza el valor anterior del lote
+    FlashStorageStatus putString(const char* key, const char* value);
+    FlashStorageStatus putInt(const char* key, int32_t value);
+    FlashStorageStatus putUInt(const char* key, uint32_t value);
+    FlashStorageStatus putBool(const char* key, bool value);
+    FlashStorageStatus putFloat(const char* key, float value);
+    FlashStorageStatus putBytes(const char* key, const void* data, size_t size, bool useHeader = true);
+    FlashStorageStatus remove(const char* key);
+    
+    template<typename T>
+    FlashStorageStatus put(const char* key, const T& data, bool useHeader = true) {
+        return putBytes(key, &data, sizeof(T), useHeader);
+    }
+    
+    void clear();
+    uint8_t count() const { return itemCount; }
+
+private:
+    friend class FlashStorageManager;
+    
+    struct Item {
+        char key[FLASH_STORAGE_MAX_KEY_LENGTH + 1];
+        FlashStorageValueType type;
+        uint8_t* data;
+        size_t size;
+    };
+    
+    Item items[FLASH_STORAGE_BATCH_MAX_ITEMS];
+    uint8_t itemCount;
+    
+    FlashStorageStatus add(const char* key, FlashStorageValueType type,
+                           const void* first, size_t firstSize,
+                           const void* second = nullptr, size_t secondSize = 0);
+    
+    // Sin copia ni asignación: los items son dueños de su memoria
+    FlashStorageBatch(const FlashStorageBatch&);
+    FlashStorageBatch& operator=(const FlashStorageBatch&);
 };
 
 // ============================================================================
@@ -152,53 +241,7 @@ public:
      */
     template<typename T>
     FlashStorageStatus save(const char* key, const T& data, bool useHeader = true) {
-        if (!initialized) return FLASH_STORAGE_ERROR_NOT_INITIALIZED;
-        if (strlen(key) > FLASH_STORAGE_MAX_KEY_LENGTH) return FLASH_STORAGE_ERROR_KEY_TOO_LONG;
-        
-        // Tomar mutex
-        if (xSemaphoreTake(mutex, pdMS_TO_TICKS(FLASH_STORAGE_TIMEOUT_MS)) != pdTRUE) {
-            return FLASH_STORAGE_ERROR_TIMEOUT;
-        }
-        
-        FlashStorageStatus status = FLASH_STORAGE_OK;
-        
-        if (useHeader) {
-            // Crear header con CRC
-            FlashStorageHeader header;
-            header.crc = calculateCRC16((const uint8_t*)&data, sizeof(T));
-            header.version = FLASH_STORAGE_VERSION;
-            header.size = sizeof(T);
-            header.timestamp = millis() / 1000;
-            
-            // Combinar header + data en un buffer
-            size_t totalSize = sizeof(FlashStorageHeader) + sizeof(T);
-            uint8_t* buffer = new uint8_t[totalSize];
-            memcpy(buffer, &header, sizeof(FlashStorageHeader));
-            memcpy(buffer + sizeof(FlashStorageHeader), &data, sizeof(T));
-            
-            // Guardar blob completo
-            size_t written = preferences.putBytes(key, buffer, totalSize);
-            delete[] buffer;
-            
-            if (written != totalSize) {
-                status = FLASH_STORAGE_ERROR_WRITE_FAILED;
-            } else {
-                stats.totalWrites++;
-                stats.lastWriteTime = millis();
-            }
-        } else {
-            // Guardar directamente sin header
-            size_t written = preferences.putBytes(key, (const void*)&data, sizeof(T));
-            if (written != sizeof(T)) {
-                status = FLASH_STORAGE_ERROR_WRITE_FAILED;
-            } else {
-                stats.totalWrites++;
-                stats.lastWriteTime = millis();
-            }
-        }
-        
-        xSemaphoreGive(mutex);
-        return status;
+        return saveBytes(key, &data, sizeof(T), useHeader);
     }
     
     /**
@@ -211,89 +254,35 @@ public:
      */
     template<typename T>
     FlashStorageStatus load(const char* key, T& data, bool useHeader = true) {
-        if (!initialized) return FLASH_STORAGE_ERROR_NOT_INITIALIZED;
-        if (strlen(key) > FLASH_STORAGE_MAX_KEY_LENGTH) return FLASH_STORAGE_ERROR_KEY_TOO_LONG;
-        
-        // Tomar mutex
-        if (xSemaphoreTake(mutex, pdMS_TO_TICKS(FLASH_STORAGE_TIMEOUT_MS)) != pdTRUE) {
-            return FLASH_STORAGE_ERROR_TIMEOUT;
-        }
-        
-        FlashStorageStatus status = FLASH_STORAGE_OK;
-        
-        if (useHeader) {
-            // Calcular tamaño total
-            size_t totalSize = sizeof(FlashStorageHeader) + sizeof(T);
-            
-            // Verificar que la key existe
-            if (!preferences.isKey(key)) {
-                xSemaphoreGive(mutex);
-                return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
-            }
-            
-            // Leer blob completo
-            uint8_t* buffer = new uint8_t[totalSize];
-            size_t read = preferences.getBytes(key, buffer, totalSize);
-            
-            if (read != totalSize) {
-                delete[] buffer;
-                xSemaphoreGive(mutex);
-                return FLASH_STORAGE_ERROR_READ_FAILED;
-            }
-            
-            // Extraer header
-            FlashStorageHeader header;
-            memcpy(&header, buffer, sizeof(FlashStorageHeader));
-            
-            // Verificar versión
-            if (header.version != FLASH_STORAGE_VERSION) {
-                delete[] buffer;
-                xSemaphoreGive(mutex);
-                stats.versionMismatches++;
-                return FLASH_STORAGE_ERROR_VERSION_MISMATCH;
-            }
-            
-            // Extraer datos
-            memcpy(&data, buffer + sizeof(FlashStorageHeader), sizeof(T));
-            
-            // Verificar CRC
-            uint16_t calculatedCRC = calculateCRC16((const uint8_t*)&data, sizeof(T));
-            if (calculatedCRC != header.crc) {
-                delete[] buffer;
-                xSemaphoreGive(mutex);
-                stats.crcErrors++;
-                return FLASH_STORAGE_ERROR_CRC_MISMATCH;
-            }
-            
-            delete[] buffer;
-            stats.totalReads++;
-            stats.lastReadTime = millis();
-            
-        } else {
-            // Leer directamente sin header
-            if (!preferences.isKey(key)) {
-                xSemaphoreGive(mutex);
-                return FLASH_STORAGE_ERROR_KEY_NOT_FOUND;
-            }
-            
-            size_t read = preferences.getBytes(key, (void*)&data, sizeof(T));
-            if (read != sizeof(T)) {
-                status = FLASH_STORAGE_ERROR_READ_FAILED;
-            } else {
-                stats.totalReads++;
-                stats.lastReadTime = millis();
-            }
-        }
-        
-        xSemaphoreGive(mutex);
-        return status;
+        return loadBytes(key, &data, sizeof(T), useHeader);
     }
     
+    /**
+     * @brief Versión sin tipo de save(): guarda size bytes
+     * @details Para quien guarda datos cuyo tipo no conoce (p. ej. ConfigCommitManager);
+     *          el blob resultante es idéntico al de save<T>() con sizeof(T) == size.
+     */
+    FlashStorageStatus saveBytes(const char* key, const void* data, size_t size, bool useHeader = true);
+    
+    /**
+     * @brief Versión sin tipo de load(): exige exactamente size bytes
+     */
+    FlashStorageStatus loadBytes(const char* key, void* data, size_t size, bool useHeader = true);
+    
+    /**
+     * @brief Lee un blob sin header de largo variable (hasta maxSize)
+     * @param length Bytes leídos
+     * @details Para formatos con su propio encabezado y versión, que pueden
+     *          crecer entre versiones de firmware.
+     */
+    FlashStorageStatus loadRawBytes(const char* key, void* buffer, size_t maxSize, size_t& length);
+    
     // ========================================================================
     // OPERACIONES CON STRINGS
     // ========================================================================
     
     FlashStorageStatus saveString(const char* key, const String& value);
+    FlashStorageStatus saveString(const char* key, const char* value);  // Sin String intermedio
     FlashStorageStatus loadString(const char* key, String& value);
     String loadString(const char* key, const String& defaultValue = "");
     
@@ -323,9 +312,36 @@ public:
     
     bool exists(const char* key);
     FlashStorageStatus remove(const char* key);
+    
+    /**
+     * @brief Aplica un lote: todas sus claves o ninguna, con un solo commit
+     * @return FLASH_STORAGE_OK, o el error tras revertir lo escrito
+     */
+    FlashStorageStatus commitBatch(const FlashStorageBatch& batch);
+    
     FlashStorageStatus clear();
     size_t getFreeEntries();
     
+    // ========================================================================
+    // CACHÉ DE LECTURA
+    // ========================================================================
+    
+    /**
+     * @brief Activa la caché en RAM de los valores leídos y escritos
+     * @param budgetBytes Bytes de valores a retener (se descarta el menos usado)
+     * @details Las lecturas repetidas de una clave cuestan un sondeo en una
+     *          tabla hash en vez de una búsqueda en las páginas de NVS.
+     *          save*() actualiza la caché; remove(), clear() y commitBatch()
+     *          invalidan. Sólo ve lo que pasa por este manager.
+     * @return false si no hay memoria para la tabla
+     */
+    bool enableCache(size_t budgetBytes = FLASH_STORAGE_CACHE_DEFAULT_BUDGET);
+    void disableCache();
+    bool isCacheEnabled() const { return cache != nullptr; }
+    size_t getCacheBudget() const { return cacheBudget; }
+    size_t getCacheBytes() const { return cacheBytes; }
+    uint8_t getCacheEntries() const { return cacheCount; }
+    
     // ========================================================================
     // ESTADÍSTICAS Y DIAGNÓSTICO
     // ========================================================================
@@ -339,7 +355,7 @@ public:
     // CRC Y VALIDACIÓN
     // ========================================================================
     
-    uint16_t calculateCRC16(const uint8_t* data, size_t length);
+    static uint16_t calculateCRC16(const uint8_t* data, size_t length);
     
     template<typename T>
     uint16_t calculateCRC16(const T& data) {
@@ -353,6 +369,39 @@ private:
     bool readOnly;
     char namespaceName[16];
     FlashStorageStats stats;
+    
+    // Caché de lectura: direccionamiento abierto con sondeo lineal
+    struct CacheSlot {
+        char key[FLASH_STORAGE_MAX_KEY_LENGTH + 1];
+        uint32_t hash;              // 0 = slot libre
+        uint32_t lastUse;
+        FlashStorageValueType type;
+        uint8_t* data;              // Valor tal como está en NVS (heap)
+        size_t size;
+    };
+    
+    CacheSlot* cache;
+    size_t cacheBudget;
+    size_t cacheBytes;
+    uint8_t cacheCount;
+    uint32_t cacheClock;
+    
+    // Llamar con el mutex tomado
+    CacheSlot* cacheFind(const char* key, FlashStorageValueType type, size_t size);  // size 0: cualquiera
+    bool cacheRead(const char* key, FlashStorageValueType type, void* value, size_t size);
+    void cachePut(const char* key, FlashStorageValueType type, const void* data, size_t size);
+    void cacheFill(const char* key, FlashStorageValueType type, const void* data, size_t size, bool confirmed);
+    void cacheInvalidate(const char* key);
+    void cacheErase(size_t index);
+    void cacheFlush();
+    static uint32_t cacheHash(const char* key);
+    
+    // Lotes (acceso directo a NVS con un handle propio; llamar con el mutex tomado)
+    bool appendUndo(nvs_handle_t handle, const char* key, uint8_t* log, size_t& length);
+    bool applyUndo(nvs_handle_t handle, const uint8_t* log, size_t length);
+    void recoverBatch();
+    static esp_err_t writeValue(nvs_handle_t handle, const char* key, FlashStorageValueType type,
+                                const uint8_t* data, size_t size);
 };
 
 // ============================================================================
@@ -0,0 +1,446 @@
+/**
+ * @file HistoryManager.cpp
+ * @brief Implementación del HistoryManager
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "HistoryManager.h"
+
+// Instancia global
+HistoryManager HistoryMgr;
+
+// Peor caso por muestra: tiempo (4 + 32 bits) + valor (2 + 5 + 5 + 32 bits)
+#define HISTORY_WORST_TIME_BITS 36
+#define HISTORY_WORST_VALUE_BITS 44
+#define HISTORY_BLOCK_BITS (HISTORY_MGR_BLOCK_SIZE * 8)
+
+// ============================================================================
+// CONSTRUCTOR
+// ============================================================================
+
+HistoryManager::HistoryManager() {
+    headers = nullptr;
+    data = nullptr;
+    blockCount = 0;
+    nextBlock = 0;
+    memset(series, 0, sizeof(series));
+    memset(&stats, 0, sizeof(HistoryStats));
+    mutex = NULL;
+}
+
+HistoryManager::~HistoryManager() {
+    end();
+}
+
+// ============================================================================
+// INICIALIZACIÓN
+// ============================================================================
+
+bool HistoryManager::begin(size_t budgetBytes) {
+    if (data != nullptr) return true;
+
+    size_t blocks = budgetBytes / (HISTORY_MGR_BLOCK_SIZE + sizeof(BlockHeader));
+    if (blocks < HISTORY_MGR_MIN_BLOCKS) blocks = HISTORY_MGR_MIN_BLOCKS;
+    if (blocks > INT16_MAX) blocks = INT16_MAX;
+
+    if (mutex == NULL) {
+        mutex = xSemaphoreCreateMutex();
+        if (mutex == NULL) {
+            Serial.println("[HISTORY] ERROR: No se pudo crear mutex");
+            return false;
+        }
+    }
+
+    headers = (BlockHeader*)calloc(blocks, sizeof(BlockHeader));
+    data = (uint8_t*)calloc(blocks, HISTORY_MGR_BLOCK_SIZE);
+    if (headers == nullptr || data == nullptr) {
+        Serial.println("[HISTORY] ERROR: Sin memoria para el historial");
+        end();
+        return false;
+    }
+
+    blockCount = blocks;
+    nextBlock = 0;
+    for (uint16_t i = 0; i < blockCount; i++) {
+        headers[i].series = 0xFF;
+        headers[i].next = -1;
+    }
+    memset(series, 0, sizeof(series));
+    memset(&stats, 0, sizeof(HistoryStats));
+    stats.blocksTotal = blockCount;
+
+    Serial.printf("[HISTORY] ✓ %u bloques de %u bytes (%u KB)\n", blockCount, HISTORY_MGR_BLOCK_SIZE,
+                  (unsigned)((blockCount * (HISTORY_MGR_BLOCK_SIZE + sizeof(BlockHeader))) / 1024));
+    return true;
+}
+
+void HistoryManager::end() {
+    if (headers != nullptr) {
+        free(headers);
+        headers = nullptr;
+    }
+    if (data != nullptr) {
+        free(data);
+        data = nullptr;
+    }
+    blockCount = 0;
+}
+
+// ============================================================================
+// ESCRITURA
+// ============================================================================
+
+bool HistoryManager::append(const char* point, uint32_t timestamp, const float* values, uint8_t count) {
+    if (data == nullptr || point == nullptr || values == nullptr || count == 0) return false;
+
+    uint8_t channels = (count < HISTORY_MGR_MAX_CHANNELS) ? count : HISTORY_MGR_MAX_CHANNELS;
+    uint32_t bits[HISTORY_MGR_MAX_CHANNELS];
+    memcpy(bits, values, channels * sizeof(uint32_t));
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    Series* s = findSeries(point, true);
+    if (s == nullptr) {
+        stats.rejected++;
+        xSemaphoreGive(mutex);
+        return false;
+    }
+    uint8_t seriesIndex = s - series;
+
+    uint16_t worst = HISTORY_WORST_TIME_BITS + HISTORY_WORST_VALUE_BITS * channels;
+    BlockHeader* header = (s->newest >= 0) ? &headers[s->newest] : nullptr;
+
+    if (header == nullptr || header->channels != channels || header->count == UINT16_MAX ||
+        header->bitLength + worst > HISTORY_BLOCK_BITS) {
+        startBlock(*s, seriesIndex, timestamp, bits, channels);
+    } else {
+        uint8_t* buffer = data + s->newest * HISTORY_MGR_BLOCK_SIZE;
+        encodeTime(*header, buffer, *s, timestamp);
+        for (uint8_t i = 0; i < channels; i++) {
+            encodeValue(*header, buffer, *s, i, bits[i]);
+        }
+        header->count++;
+        header->lastTime = timestamp;
+    }
+
+    s->samples++;
+    stats.samples++;
+    stats.appended++;
+
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+void HistoryManager::startBlock(Series& s, uint8_t seriesIndex, uint32_t timestamp, const uint32_t* bits, uint8_t channels) {
+    // Puede desalojar bloques de esta misma serie (siempre el más viejo)
+    int16_t block = allocateBlock(seriesIndex);
+    BlockHeader& header = headers[block];
+    uint8_t* buffer = data + block * HISTORY_MGR_BLOCK_SIZE;
+
+    // Primera muestra sin comprimir: el bloque se decodifica solo
+    header.channels = channels;
+    header.count = 1;
+    header.firstTime = timestamp;
+    header.lastTime = timestamp;
+    for (uint8_t i = 0; i < channels; i++) {
+        writeBits(buffer, header.bitLength, bits[i], 32);
+        s.prevValue[i] = bits[i];
+        s.prevLeading[i] = 0;
+        s.prevTrailing[i] = 0xFF;
+    }
+
+    if (s.newest >= 0) {
+        headers[s.newest].next = block;
+    } else {
+        s.oldest = block;
+    }
+    s.newest = block;
+    s.channels = channels;
+    s.prevTime = timestamp;
+    s.prevDelta = 0;
+}
+
+void HistoryManager::encodeTime(BlockHeader& header, uint8_t* buffer, Series& s, uint32_t timestamp) {
+    int32_t delta = (int32_t)(timestamp - s.prevTime);
+    int32_t dod = delta - s.prevDelta;
+    uint16_t& position = header.bitLength;
+
+    if (dod == 0) {
+        writeBits(buffer, position, 0x0, 1);
+    } else if (dod >= -63 && dod <= 64) {
+        writeBits(buffer, position, 0x2, 2);
+        writeBits(buffer, position, dod + 63, 7);
+    } else if (dod >= -255 && dod <= 256) {
+        writeBits(buffer, position, 0x6, 3);
+        writeBits(buffer, position, dod + 255, 9);
+    } else if (dod >= -2047 && dod <= 2048) {
+        writeBits(buffer, position, 0xE, 4);
+        writeBits(buffer, position, dod + 2047, 12);
+    } else {
+        writeBits(buffer, position, 0xF, 4);
+        writeBits(buffer, position, (uint32_t)dod, 32);
+    }
+
+    s.prevTime = timestamp;
+    s.prevDelta = delta;
+}
+
+void HistoryManager::encodeValue(BlockHeader& header, uint8_t* buffer, Series& s, uint8_t channel, uint32_t bits) {
+    uint32_t x = bits ^ s.prevValue[channel];
+    uint16_t& position = header.bitLength;
+    s.prevValue[channel] = bits;
+
+    if (x == 0) {
+        writeBits(buffer, position, 0x0, 1);
+        return;
+    }
+
+    uint8_t leading = __builtin_clz(x);
+    uint8_t trailing = __builtin_ctz(x);
+    uint8_t prevLeading = s.prevLeading[channel];
+    uint8_t prevTrailing = s.prevTrailing[channel];
+
+    if (prevTrailing != 0xFF && leading >= prevLeading && trailing >= prevTrailing) {
+        // Cabe en la ventana de bits significativos anterior
+        writeBits(buffer, position, 0x2, 2);
+        writeBits(buffer, position, x >> prevTrailing, 32 - prevLeading - prevTrailing);
+    } else {
+        uint8_t length = 32 - leading - trailing;
+        writeBits(buffer, position, 0x3, 2);
+        writeBits(buffer, position, leading, 5);
+        writeBits(buffer, position, length - 1, 5);
+        writeBits(buffer, position, x >> trailing, length);
+        s.prevLeading[channel] = leading;
+        s.prevTrailing[channel] = trailing;
+    }
+}
+
+// ============================================================================
+// CONSULTA
+// ============================================================================
+
+HistoryQueryResult HistoryManager::query(const char* point, uint32_t from, uint32_t to, size_t limit,
+                                         HistorySampleCallback callback, void* context) {
+    HistoryQueryResult result;
+    memset(&result, 0, sizeof(HistoryQueryResult));
+    if (data == nullptr || point == nullptr) return result;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    Series* s = findSeries(point, false);
+    if (s != nullptr) {
+        result.channels = s->channels;
+
+        for (int16_t block = s->oldest; block >= 0; block = headers[block].next) {
+            const BlockHeader& header = headers[block];
+
+            // Rango por bloque: se saltan sin decodificar
+            if (header.lastTime < from) continue;
+            if (header.firstTime > to) break;
+
+            Decoder decoder;
+            decodeFirst(decoder, header, block);
+
+            for (uint16_t i = 0; i < header.count; i++) {
+                if (i > 0) decodeNext(decoder, header.channels);
+                if (decoder.time < from) continue;
+                if (decoder.time > to) goto done;
+
+                if (result.count >= limit) {
+                    result.truncated = true;
+                    result.nextTime = decoder.time;
+                    goto done;
+                }
+
+                float values[HISTORY_MGR_MAX_CHANNELS];
+                memcpy(values, decoder.value, header.channels * sizeof(float));
+                if (!callback(decoder.time, values, header.channels, context)) {
+                    result.truncated = true;
+                    result.nextTime = decoder.time;
+                    goto done;
+                }
+                result.count++;
+            }
+        }
+    }
+
+done:
+    xSemaphoreGive(mutex);
+    return result;
+}
+
+void HistoryManager::decodeFirst(Decoder& decoder, const BlockHeader& header, int16_t block) {
+    decoder.data = data + block * HISTORY_MGR_BLOCK_SIZE;
+    decoder.position = 0;
+    decoder.time = header.firstTime;
+    decoder.delta = 0;
+    for (uint8_t i = 0; i < header.channels; i++) {
+        decoder.value[i] = readBits(decoder.data, decoder.position, 32);
+        decoder.leading[i] = 0;
+        decoder.trailing[i] = 0;
+    }
+}
+
+void HistoryManager::decodeNext(Decoder& decoder, uint8_t channels) {
+    int32_t dod;
+    if (readBits(decoder.data, decoder.position, 1) == 0) {
+        dod = 0;
+    } else if (readBits(decoder.data, decoder.position, 1) == 0) {
+        dod = (int32_t)readBits(decoder.data, decoder.position, 7) - 63;
+    } else if (readBits(decoder.data, decoder.position, 1) == 0) {
+        dod = (int32_t)readBits(decoder.data, decoder.position, 9) - 255;
+    } else if (readBits(decoder.data, decoder.position, 1) == 0) {
+        dod = (int32_t)readBits(decoder.data, decoder.position, 12) - 2047;
+    } else {
+        dod = (int32_t)readBits(decoder.data, decoder.position, 32);
+    }
+    decoder.delta += dod;
+    decoder.time += decoder.delta;
+
+    for (uint8_t i = 0; i < channels; i++) {
+        if (readBits(decoder.data, decoder.position, 1) == 0) continue;
+
+        if (readBits(decoder.data, decoder.position, 1) == 1) {
+            decoder.leading[i] = readBits(decoder.data, decoder.position, 5);
+            uint8_t length = readBits(decoder.data, decoder.position, 5) + 1;
+            decoder.trailing[i] = 32 - decoder.leading[i] - length;
+        }
+        uint8_t length = 32 - decoder.leading[i] - decoder.trailing[i];
+        decoder.value[i] ^= readBits(decoder.data, decoder.position, length) << decoder.trailing[i];
+    }
+}
+
+// ============================================================================
+// INFORMACIÓN
+// ============================================================================
+
+bool HistoryManager::getSeriesInfo(const char* point, HistorySeriesInfo& info) {
+    memset(&info, 0, sizeof(HistorySeriesInfo));
+    if (data == nullptr) return false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    Series* s = findSeries(point, false);
+    bool found = (s != nullptr && s->oldest >= 0);
+    if (found) {
+        info.samples = s->samples;
+        info.channels = s->channels;
+        info.oldest = headers[s->oldest].firstTime;
+        info.newest = headers[s->newest].lastTime;
+        for (int16_t block = s->oldest; block >= 0; block = headers[block].next) {
+            info.bytes += (headers[block].bitLength + 7) / 8;
+            info.blocks++;
+        }
+    }
+    xSemaphoreGive(mutex);
+    return found;
+}
+
+HistoryStats HistoryManager::getStats() {
+    if (data == nullptr) return stats;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    stats.blocksUsed = 0;
+    stats.bytesUsed = 0;
+    for (uint16_t i = 0; i < blockCount; i++) {
+        if (headers[i].series != 0xFF) {
+            stats.blocksUsed++;
+            stats.bytesUsed += (headers[i].bitLength + 7) / 8;
+        }
+    }
+    HistoryStats snapshot = stats;
+    xSemaphoreGive(mutex);
+    return snapshot;
+}
+
+void HistoryManager::printStatus() {
+    HistoryStats current = getStats();
+
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   History Manager - Estado             ║");
+    Serial.println("╚════════════════════════════════════════╝");
+    Serial.printf("  Bloques: %u/%u, bytes: %lu\n", current.blocksUsed, current.blocksTotal, current.bytesUsed);
+    Serial.printf("  Muestras: %lu (agregadas: %lu, bloques desalojados: %lu)\n",
+                  current.samples, current.appended, current.evictedBlocks);
+    if (current.bytesUsed > 0) {
+        Serial.printf("  Bytes por muestra: %.2f\n", (float)current.bytesUsed / current.samples);
+    }
+    Serial.println("════════════════════════════════════════\n");
+}
+
+// ============================================================================
+// MÉTODOS PRIVADOS
+// ============================================================================
+
+HistoryManager::Series* HistoryManager::findSeries(const char* point, bool create) {
+    Series* reusable = nullptr;
+
+    for (uint8_t i = 0; i < HISTORY_MGR_MAX_SERIES; i++) {
+        Series& s = series[i];
+        if (s.used && strcmp(s.name, point) == 0) {
+            return &s;
+        }
+        // Libre, o sin bloques (p. ej. un punto que salió del plan)
+        if (reusable == nullptr && (!s.used || s.oldest < 0)) {
+            reusable = &s;
+        }
+    }
+
+    if (!create || reusable == nullptr) return nullptr;
+
+    memset(reusable, 0, sizeof(Series));
+    strncpy(reusable->name, point, HISTORY_MGR_MAX_NAME);
+    reusable->used = true;
+    reusable->oldest = -1;
+    reusable->newest = -1;
+    return reusable;
+}
+
+int16_t HistoryManager::allocateBlock(uint8_t seriesIndex) {
+    int16_t block = nextBlock;
+    nextBlock = (nextBlock + 1) % blockCount;
+
+    if (headers[block].series != 0xFF) {
+        releaseBlock(block);
+        stats.evictedBlocks++;
+    }
+
+    memset(&headers[block], 0, sizeof(BlockHeader));
+    memset(data + block * HISTORY_MGR_BLOCK_SIZE, 0, HISTORY_MGR_BLOCK_SIZE);
+    headers[block].series = seriesIndex;
+    headers[block].next = -1;
+    return block;
+}
+
+void HistoryManager::releaseBlock(int16_t block) {
+    // Asignación circular: el bloque reutilizado es el más viejo de su serie
+    BlockHeader& header = headers[block];
+    Series& owner = series[header.series];
+
+    owner.oldest = header.next;
+    if (owner.newest == block) {
+        owner.newest = -1;
+    }
+    owner.samples -= header.count;
+    stats.samples -= header.count;
+    header.series = 0xFF;
+}
+
+void HistoryManager::writeBits(uint8_t* buffer, uint16_t& position, uint32_t value, uint8_t count) {
+    // MSB primero; el bloque se pone a cero al asignarlo
+    for (int8_t i = count - 1; i >= 0; i--) {
+        if ((value >> i) & 0x01) {
+            buffer[position >> 3] |= 0x80 >> (position & 0x07);
+        }
+        position++;
+    }
+}
+
+uint32_t HistoryManager::readBits(const uint8_t* buffer, uint16_t& position, uint8_t count) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        value = (value << 1) | ((buffer[position >> 3] >> (7 - (position & 0x07))) & 0x01);
+        position++;
+    }
+    return value;
+}
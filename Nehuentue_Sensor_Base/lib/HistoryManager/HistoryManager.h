@@ -0,0 +1,190 @@
+/**
+ * @file HistoryManager.h
+ * @brief Historial comprimido de series de tiempo en RAM (estilo Gorilla)
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @details
+ * Guarda las muestras de cada punto en bloques de bits comprimidos para
+ * poder rellenar huecos del backend después de un corte:
+ *
+ * - Tiempos: delta-of-delta. Con período regular cada tiempo ocupa 1 bit.
+ * - Valores (float32): XOR con el valor anterior. Un valor repetido ocupa
+ *   1 bit; uno parecido, sólo sus bits significativos.
+ *
+ * Los bloques salen de un pool dimensionado por presupuesto de RAM y se
+ * asignan en orden circular: al llenarse, el bloque reutilizado es siempre
+ * el más viejo de todo el historial (y, por lo tanto, el más viejo de su
+ * serie). Cada bloque es autocontenido (tiempo y valores iniciales sin
+ * comprimir) y guarda su rango de tiempo, así una consulta salta bloques
+ * enteros sin decodificarlos.
+ *
+ * Uso:
+ * @code
+ * HistoryMgr.begin(32768);
+ * HistoryMgr.append("presion", millis(), values, 2);
+ *
+ * HistoryQueryResult result = HistoryMgr.query("presion", from, to, 300, onSample, ctx);
+ * if (result.truncated) { ...pedir desde result.nextTime... }
+ * @endcode
+ */
+
+#ifndef HISTORY_MANAGER_H
+#define HISTORY_MANAGER_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// ============================================================================
+// CONSTANTES Y CONFIGURACIÓN
+// ============================================================================
+
+#define HISTORY_MGR_VERSION "1.0.0"
+#define HISTORY_MGR_BLOCK_SIZE 256            // Bytes de datos por bloque
+#define HISTORY_MGR_MIN_BLOCKS 8
+#define HISTORY_MGR_MAX_SERIES 16
+#define HISTORY_MGR_MAX_CHANNELS 4            // Valores guardados por muestra
+#define HISTORY_MGR_MAX_NAME 23
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+/**
+ * @brief Callback de consulta (una muestra por llamada, en orden de tiempo)
+ * @return false para cortar la consulta: la muestra no cuenta como entregada
+ *         y queda como nextTime (p. ej. la respuesta ya no entra en un mensaje)
+ */
+typedef bool (*HistorySampleCallback)(uint32_t timestamp, const float* values, uint8_t channels, void* context);
+
+struct HistoryQueryResult {
+    size_t count;               ///< Muestras entregadas
+    uint8_t channels;
+    bool truncated;             ///< Quedaron muestras en el rango (límite o callback)
+    uint32_t nextTime;          ///< Tiempo de la primera muestra no entregada
+};
+
+/**
+ * @brief Resumen de una serie
+ */
+struct HistorySeriesInfo {
+    uint32_t samples;
+    uint32_t oldest;
+    uint32_t newest;
+    uint32_t bytes;             ///< Bytes comprimidos
+    uint8_t blocks;
+    uint8_t channels;
+};
+
+struct HistoryStats {
+    uint32_t appended;
+    uint32_t evictedBlocks;
+    uint32_t rejected;          ///< Sin lugar para una serie nueva
+    uint16_t blocksTotal;
+    uint16_t blocksUsed;
+    uint32_t bytesUsed;
+    uint32_t samples;           ///< Muestras vivas en el historial
+};
+
+// ============================================================================
+// CLASE PRINCIPAL
+// ============================================================================
+
+class HistoryManager {
+public:
+    HistoryManager();
+    ~HistoryManager();
+
+    /**
+     * @brief Reserva el pool de bloques
+     * @param budgetBytes RAM total (datos + cabeceras)
+     */
+    bool begin(size_t budgetBytes);
+    void end();
+
+    /**
+     * @brief Agrega una muestra (tiempos no decrecientes por serie)
+     * @param count Se guardan los primeros HISTORY_MGR_MAX_CHANNELS valores
+     */
+    bool append(const char* point, uint32_t timestamp, const float* values, uint8_t count);
+
+    /**
+     * @brief Recorre las muestras con timestamp en [from, to]
+     * @param limit Máximo de muestras a entregar
+     * @note El callback puede cortar antes devolviendo false
+     */
+    HistoryQueryResult query(const char* point, uint32_t from, uint32_t to, size_t limit,
+                             HistorySampleCallback callback, void* context);
+
+    bool getSeriesInfo(const char* point, HistorySeriesInfo& info);
+    HistoryStats getStats();
+    void printStatus();
+
+private:
+    struct BlockHeader {
+        uint8_t series;         // 0xFF = libre
+        uint8_t channels;
+        uint16_t count;
+        uint16_t bitLength;
+        int16_t next;           // Siguiente bloque (más nuevo) de la serie
+        uint32_t firstTime;
+        uint32_t lastTime;
+    };
+
+    struct Series {
+        char name[HISTORY_MGR_MAX_NAME + 1];
+        bool used;
+        uint8_t channels;
+        int16_t oldest;
+        int16_t newest;
+        uint32_t samples;
+        // Estado del codificador (bloque newest)
+        uint32_t prevTime;
+        int32_t prevDelta;
+        uint32_t prevValue[HISTORY_MGR_MAX_CHANNELS];
+        uint8_t prevLeading[HISTORY_MGR_MAX_CHANNELS];
+        uint8_t prevTrailing[HISTORY_MGR_MAX_CHANNELS];  // 0xFF = sin ventana previa
+    };
+
+    /**
+     * @brief Estado de decodificación de un bloque
+     */
+    struct Decoder {
+        const uint8_t* data;
+        uint16_t position;
+        uint32_t time;
+        int32_t delta;
+        uint32_t value[HISTORY_MGR_MAX_CHANNELS];
+        uint8_t leading[HISTORY_MGR_MAX_CHANNELS];
+        uint8_t trailing[HISTORY_MGR_MAX_CHANNELS];
+    };
+
+    BlockHeader* headers;
+    uint8_t* data;
+    uint16_t blockCount;
+    uint16_t nextBlock;         // Asignación circular = FIFO global
+    Series series[HISTORY_MGR_MAX_SERIES];
+    HistoryStats stats;
+    SemaphoreHandle_t mutex;
+
+    Series* findSeries(const char* point, bool create);
+    int16_t allocateBlock(uint8_t seriesIndex);
+    void releaseBlock(int16_t block);
+    void startBlock(Series& s, uint8_t seriesIndex, uint32_t timestamp, const uint32_t* bits, uint8_t channels);
+    void encodeTime(BlockHeader& header, uint8_t* buffer, Series& s, uint32_t timestamp);
+    void encodeValue(BlockHeader& header, uint8_t* buffer, Series& s, uint8_t channel, uint32_t bits);
+
+    void decodeFirst(Decoder& decoder, const BlockHeader& header, int16_t block);
+    void decodeNext(Decoder& decoder, uint8_t channels);
+
+    static void writeBits(uint8_t* buffer, uint16_t& position, uint32_t value, uint8_t count);
+    static uint32_t readBits(const uint8_t* buffer, uint16_t& position, uint8_t count);
+};
+
+// ============================================================================
+// INSTANCIA GLOBAL
+// ============================================================================
+extern HistoryManager HistoryMgr;
+
+#endif // HISTORY_MANAGER_H
@@ -7,6 +7,8 @@
 
 #include "MQTTManager.h"
 #include <WiFi.h>
+#include <FlashQueueManager.h>
+#include <lwip/sockets.h>
 
 // Instancia global
 MQTTManager MqttMgr;
@@ -16,18 +18,39 @@ MQTTManager* MQTTManager::instance = nullptr;
 // CONSTRUCTOR Y DESTRUCTOR
 // ============================================================================
 
-MQTTManager::MQTTManager() : mqttClient(wifiClient) {
+MQTTManager::MQTTManager() : wireTap(wifiClient), mqttClient(wireTap) {
     initialized = false;
     mqttTaskHandle = NULL;
+    rxTaskHandle = NULL;
+    socketFd = -1;
     mutex = NULL;
-    publishQueue = NULL;
+    queueBudget = MQTT_MANAGER_QUEUE_BYTES;
     autoReconnectEnabled = true;
     lastReconnectAttempt = 0;
+    reconnectNow = true;        // Nunca se intentó: el primero no espera el intervalo
+    loopJob = -1;
+    reconnectJob = -1;
     messageCallback = nullptr;
     connectionCallback = nullptr;
+    offlineStore = nullptr;
+    
+    publishQoS = 0;
+    inflightWindow = MQTT_MANAGER_DEFAULT_INFLIGHT;
+    inflightHead = 0;
+    inflightCount = 0;
+    sendIndex = 0;
+    nextPacketId = 1;
+    resendPending = false;
     
     memset(&config, 0, sizeof(MQTTConfig));
     memset(&stats, 0, sizeof(MQTTStats));
+    memset(&qosStats, 0, sizeof(MQTTQoSStats));
+    periodStart = 0;
+    periodMessages = 0;
+    periodBytes = 0;
+    periodLatencySum = 0;
+    periodLatencyMax = 0;
+    periodAcks = 0;
     
     instance = this;
 }
@@ -50,18 +73,18 @@ bool MQTTManager::begin(const char* server, uint16_t port, const char* user, con
     Serial.println("║   MQTT Manager v1.0                    ║");
     Serial.println("╚════════════════════════════════════════╝");
     
-    // Crear mutex
-    mutex = xSemaphoreCreateMutex();
+    // Crear mutex (recursivo: los callbacks pueden suscribirse desde la tarea)
+    mutex = xSemaphoreCreateRecursiveMutex();
     if (mutex == NULL) {
         Serial.println("[MQTT MGR] ERROR: No se pudo crear mutex");
         return false;
     }
     
-    // Crear cola de publicación
-    publishQueue = xQueueCreate(MQTT_MANAGER_QUEUE_SIZE, sizeof(MQTTMessage));
-    if (publishQueue == NULL) {
+    // Crear cola de publicación (arena de bytes)
+    if (!publishQueue.begin(queueBudget)) {
         Serial.println("[MQTT MGR] ERROR: No se pudo crear cola");
         vSemaphoreDelete(mutex);
+        mutex = NULL;
         return false;
     }
     
@@ -97,12 +120,16 @@ bool MQTTManager::begin(const char* server, uint16_t port, const char* user, con
     Serial.printf("  User: %s\n", user);
     Serial.printf("  Keep Alive: %d s\n", config.keepAlive);
     Serial.printf("  Max Packet: %d bytes\n", config.maxPacketSize);
+    Serial.printf("  Cola RAM: %u bytes\n", (unsigned)publishQueue.capacity());
+    Serial.printf("  QoS publicación: %d (ventana %d)\n", publishQoS, inflightWindow);
     Serial.println("════════════════════════════════════════\n");
     
     return true;
 }
 
 void MQTTManager::end() {
+    stopTask();
+    
     if (initialized) {
         disconnect();
         initialized = false;
@@ -114,10 +141,7 @@ void MQTTManager::end() {
         mutex = NULL;
     }
     
-    if (publishQueue != NULL) {
-        vQueueDelete(publishQueue);
-        publishQueue = NULL;
-    }
+    publishQueue.end();
 }
 
 // ============================================================================
@@ -146,6 +170,11 @@ bool MQTTManager::connect() {
         Serial.println("[MQTT MGR] ✓ MQTT conectado");
         stats.reconnects++;
         
+        // Mensajes QoS 1 sin PUBACK de la sesión anterior: reenviar con DUP
+        if (inflightCount > 0) {
+            resendPending = true;
+        }
+        
         if (connectionCallback != nullptr) {
             connectionCallback(true);
         }
@@ -177,75 +206,142 @@ bool MQTTManager::reconnect() {
     }
     
     unsigned long now = millis();
-    if (now - lastReconnectAttempt > MQTT_MANAGER_RECONNECT_INTERVAL) {
+    if (reconnectNow || now - lastReconnectAttempt > MQTT_MANAGER_RECONNECT_INTERVAL) {
+        reconnectNow = false;
         lastReconnectAttempt = now;
         Serial.println("[MQTT MGR] Intentando reconectar...");
-        return connect();
+        JobMgr.start(reconnectJob);
+        bool connected = connect();
+        JobMgr.finish(reconnectJob);
+        return connected;
     }
     
     return false;
 }
 
 // ============================================================================
-// PUBLISH
+// TAREA
 // ============================================================================
 
-bool MQTTManager::publish(const char* topic, const char* payload, bool retained) {
-    if (!initialized) return false;
-    
-    // Si está conectado, publicar directamente
-    if (isConnected()) {
-        lock();
-        bool result = mqttClient.publish(topic, payload, retained);
-        unlock();
-        
-        if (result) {
-            stats.totalPublished++;
-            stats.lastPublishTime = millis();
-        } else {
-            stats.failedPublish++;
-        }
-        
-        return result;
+bool MQTTManager::startTask() {
+    if (!initialized) {
+        Serial.println("[MQTT MGR] ERROR: No inicializado");
+        return false;
     }
+    if (mqttTaskHandle != NULL) return true;
     
-    // Si no está conectado, encolar mensaje
-    MQTTMessage msg;
-    strncpy(msg.topic, topic, sizeof(msg.topic) - 1);
-    strncpy(msg.payload, payload, sizeof(msg.payload) - 1);
-    msg.retained = retained;
+    // La vuelta corre por eventos, no por período: sólo duración y plazo
+    loopJob = JobMgr.registerJob("mqtt_loop", MQTT_MANAGER_LOOP_DEADLINE_MS, MQTT_MANAGER_LOOP_DEADLINE_MS,
+                                 nullptr, JOB_FLAG_ON_DEMAND);
+    reconnectJob = JobMgr.registerJob("mqtt_reconnect", MQTT_MANAGER_RECONNECT_INTERVAL,
+                                      MQTT_MANAGER_RECONNECT_INTERVAL, nullptr, JOB_FLAG_ON_DEMAND);
     
-    if (xQueueSend(publishQueue, &msg, 0) == pdTRUE) {
-        Serial.println("[MQTT MGR] Mensaje encolado");
-        return true;
-    } else {
-        Serial.println("[MQTT MGR] Cola llena, mensaje descartado");
-        stats.failedPublish++;
+    BaseType_t result = xTaskCreate(mqttTask, "mqtt_task", MQTT_MANAGER_TASK_STACK_SIZE,
+                                    this, MQTT_MANAGER_TASK_PRIORITY, &mqttTaskHandle);
+    if (result != pdPASS) {
+        mqttTaskHandle = NULL;
+        Serial.println("[MQTT MGR] ERROR: No se pudo crear tarea");
         return false;
     }
+    wireTap.setNotifyTask(mqttTaskHandle);
+    
+    result = xTaskCreate(rxTask, "mqtt_rx", MQTT_MANAGER_RX_TASK_STACK_SIZE,
+                         this, MQTT_MANAGER_TASK_PRIORITY, &rxTaskHandle);
+    if (result != pdPASS) {
+        // Sin vigilante los entrantes esperan a la próxima vuelta por tiempo
+        rxTaskHandle = NULL;
+        Serial.println("[MQTT MGR] ADVERTENCIA: No se pudo crear tarea de recepción");
+    }
+    
+    Serial.println("[MQTT MGR] ✓ Tarea MQTT iniciada");
+    return true;
 }
 
-bool MQTTManager::publish(const char* topic, const uint8_t* payload, size_t length, bool retained) {
-    if (!initialized || !isConnected()) return false;
+void MQTTManager::stopTask() {
+    if (mqttTaskHandle == NULL) return;
     
+    // Esperar a que la tarea no esté dentro de loop()
     lock();
-    bool result = mqttClient.publish(topic, payload, length, retained);
+    wireTap.setNotifyTask(NULL);
+    if (rxTaskHandle != NULL) {
+        vTaskDelete(rxTaskHandle);
+        rxTaskHandle = NULL;
+    }
+    vTaskDelete(mqttTaskHandle);
+    mqttTaskHandle = NULL;
+    socketFd = -1;
     unlock();
     
-    if (result) {
-        stats.totalPublished++;
-        stats.lastPublishTime = millis();
-    } else {
-        stats.failedPublish++;
+    Serial.println("[MQTT MGR] Tarea MQTT detenida");
+}
+
+// ============================================================================
+// PUBLISH
+// ============================================================================
+
+bool MQTTManager::publish(const char* topic, const char* payload, bool retained) {
+    return publish(topic, (const uint8_t*)payload, strlen(payload), retained);
+}
+
+bool MQTTManager::publish(const char* topic, const uint8_t* payload, size_t length, bool retained) {
+    if (!initialized) return false;
+    
+    // Sin mutex ni socket: reservar en la arena y avisar a la tarea MQTT
+    if (!publishQueue.push(topic, payload, length, retained, publishQoS)) {
+        Serial.printf("[MQTT MGR] Cola llena, mensaje descartado (%u bytes)\n", (unsigned)length);
+        __atomic_fetch_add(&stats.failedPublish, 1, __ATOMIC_RELAXED);
+        return false;
     }
     
-    return result;
+    notifyTask();
+    return true;
 }
 
 bool MQTTManager::publishJSON(const char* topic, const char* json, bool retained) {
     return publish(topic, json, retained);
 }
 
+bool MQTTManager::publishJSON(const char* topic, const JsonDocument& doc, bool retained) {
+    if (!initialized) return false;
+    
+    size_t length = measureJson(doc);
+    
+    MQTTRingReservation reservation;
+    if (!publishQueue.reserve(topic, length, retained, publishQoS, reservation)) {
+        Serial.printf("[MQTT MGR] Cola llena, mensaje descartado (%u bytes)\n", (unsigned)length);
+        __atomic_fetch_add(&stats.failedPublish, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    
+    MQTTRingWriter writer(publishQueue, reservation);
+    serializeJson(doc, writer);
+    publishQueue.commit(reservation);
+    
+    notifyTask();
+    return true;
+}
+
+bool MQTTManager::flush(uint32_t timeoutMs) {
+    if (!initialized) return false;
+    
+    unsigned long start = millis();
+    while (publishQueue.count() > 0 && millis() - start < timeoutMs) {
+        lock();
+        if (isConnected()) {
+            // Con QoS 1 la cola sólo se vacía al recibir los PUBACK
+            mqttClient.loop();
+            processAcks();
+            processPublishQueue();
+        }
+        unlock();
+        if (publishQueue.count() > 0) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+    
+    return publishQueue.count() == 0;
+}
+
 // ============================================================================
 // SUBSCRIBE
 // ============================================================================
@@ -320,13 +416,64 @@ void MQTTManager::setAutoReconnect(bool enable) {
     unlock();
 }
 
+void MQTTManager::setPublishQoS(uint8_t qos) {
+    if (qos > 1) {
+        Serial.println("[MQTT MGR] QoS 2 no soportado, se usa QoS 1");
+        qos = 1;
+    }
+    lock();
+    publishQoS = qos;
+    unlock();
+}
+
+void MQTTManager::setInflightWindow(uint8_t window) {
+    if (window == 0) window = 1;
+    if (window > MQTT_MANAGER_MAX_INFLIGHT) window = MQTT_MANAGER_MAX_INFLIGHT;
+    lock();
+    inflightWindow = window;
+    unlock();
+}
+
+void MQTTManager::setOfflineStore(FlashQueueManager* store) {
+    lock();
+    offlineStore = store;
+    unlock();
+}
+
+void MQTTManager::setQueueBudget(size_t bytes) {
+    if (initialized) {
+        Serial.println("[MQTT MGR] El presupuesto de cola se aplica antes de begin()");
+        return;
+    }
+    queueBudget = bytes;
+}
+
+uint32_t MQTTManager::getBacklog() const {
+    uint32_t backlog = publishQueue.count();
+    if (offlineStore != nullptr && offlineStore->isReady()) {
+        backlog += offlineStore->pendingCount();
+    }
+    return backlog;
+}
+
 // ============================================================================
 // INFORMACIÓN
 // ============================================================================
 
+MQTTQoSStats MQTTManager::getQoSStats() {
+    lock();
+    MQTTQoSStats result = qosStats;
+    result.qos = publishQoS;
+    result.window = inflightWindow;
+    result.inflight = inflightCount;
+    unlock();
+    return result;
+}
+
 void MQTTManager::resetStats() {
     lock();
     memset(&stats, 0, sizeof(MQTTStats));
+    memset(&qosStats, 0, sizeof(MQTTQoSStats));
     unlock();
 }
 
@@ -340,6 +487,16 @@ void MQTTManager::printStats() {
     Serial.printf("  Mensajes recibidos: %lu\n", stats.totalReceived);
     Serial.printf("  Publicaciones fallidas: %lu\n", stats.failedPublish);
     Serial.printf("  Reconexiones: %lu\n", stats.reconnects);
+    Serial.printf("  Backlog pendiente: %lu\n", getBacklog());
+    Serial.printf("  Cola RAM: %u / %u bytes (máx %lu, rechazados %lu)\n",
+                  (unsigned)publishQueue.used(), (unsigned)publishQueue.capacity(),
+                  publishQueue.getStats().highWater, publishQueue.getStats().rejected);
+    Serial.printf("  QoS %d: ventana %d, en vuelo %d, PUBACK %lu, reenvíos %lu, timeouts %lu\n",
+                  publishQoS, inflightWindow, inflightCount,
+                  qosStats.acked, qosStats.retransmits, qosStats.ackTimeouts);
+    Serial.printf("  Throughput: %.1f msg/s, %.0f B/s (latencia PUBACK media %lu us, máx %lu us)\n",
+                  qosStats.messagesPerSecond, qosStats.bytesPerSecond,
+                  qosStats.ackLatencyAvgUs, qosStats.ackLatencyMaxUs);
     Serial.printf("  Última publicación: %lu ms\n", stats.lastPublishTime);
     Serial.printf("  Última recepción: %lu ms\n", stats.lastReceiveTime);
     Serial.println("════════════════════════════════════════\n");
@@ -367,18 +524,46 @@ void MQTTManager::printInfo() {
 void MQTTManager::loop() {
     if (!initialized) return;
     
-    // Mantener conexión
+    lock();
+    
+    // Mantener conexión (keepalive y mensajes entrantes, incluidos PUBACK)
     mqttClient.loop();
+    processAcks();
     
-    // Auto-reconnect si está habilitado
-    if (autoReconnectEnabled && !isConnected()) {
+    // Auto-reconnect si está habilitado (sólo con red disponible)
+    if (autoReconnectEnabled && !isConnected() && WiFi.status() == WL_CONNECTED) {
         reconnect();
     }
     
-    // Procesar cola de publicación
     if (isConnected()) {
-        processPublishQueue();
+        if (resendPending) {
+            resendInflight();
+        }
+        checkAckTimeout();
     }
+    
+    if (isConnected()) {
+        // Drenar backlog: primero flash (lo más antiguo), luego cola RAM
+        processOfflineStore();
+        
+        // Si el drenado de flash no alcanza, no dejar que se llene la RAM
+        if (offlineStoreReady() && offlineStore->pendingCount() > 0) {
+            if (publishQueue.used() > publishQueue.capacity() / 2) {
+                spillToOfflineStore(false);
+            }
+        } else {
+            processPublishQueue();
+        }
+    } else if (offlineStoreReady()) {
+        // Sin conexión: persistir lo encolado
+        spillToOfflineStore(true);
+    }
+    
+    updateMetrics();
+    
+    socketFd = isConnected() ? wifiClient.fd() : -1;
+    
+    unlock();
 }
 
 // ============================================================================
@@ -387,13 +572,24 @@ void MQTTManager::loop() {
 
 void MQTTManager::lock() {
     if (mutex != NULL) {
-        xSemaphoreTake(mutex, portMAX_DELAY);
+        xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
     }
 }
 
 void MQTTManager::unlock() {
     if (mutex != NULL) {
-        xSemaphoreGive(mutex);
+        xSemaphoreGiveRecursive(mutex);
+    }
+}
+
+void MQTTManager::requestReconnect() {
+    reconnectNow = true;
+    notifyTask();
+}
+
+void MQTTManager::notifyTask() {
+    if (mqttTaskHandle != NULL) {
+        xTaskNotifyGive(mqttTaskHandle);
     }
 }
 
@@ -408,16 +604,372 @@ void MQTTManager::handleReconnect() {
 }
 
 void MQTTManager::processPublishQueue() {
-    MQTTMessage msg;
+    MQTTRingRecord record;
+    unsigned long start = millis();
     
-    // Procesar hasta 5 mensajes por iteración
-    for (int i = 0; i < 5; i++) {
-        if (xQueueReceive(publishQueue, &msg, 0) == pdTRUE) {
-            publish(msg.topic, msg.payload, msg.retained);
-        } else {
-            break;  // Cola vacía
+    // La ventana todavía espera PUBACK del backlog en flash
+    if (windowFromFlash()) return;
+    
+    if (inflightCount == 0) {
+        sendIndex = publishQueue.readIndex();
+    }
+    
+    // Enviar mientras haya lugar en la ventana; los registros siguen en la
+    // cola hasta su PUBACK (QoS 0 se libera apenas se escribe)
+    while (millis() - start < MQTT_MANAGER_DRAIN_BUDGET_MS && inflightCount < inflightWindow &&
+           publishQueue.peekAt(sendIndex, record)) {
+        uint16_t packetId = (record.qos > 0) ? allocatePacketId() : 0;
+        if (!writeRecord(record, packetId, false)) {
+            stats.failedPublish++;
+            break;  // Se reintenta en la próxima vuelta
+        }
+        
+        InflightEntry& entry = inflight[(inflightHead + inflightCount) % MQTT_MANAGER_MAX_INFLIGHT];
+        entry.packetId = packetId;
+        entry.acked = (packetId == 0);
+        entry.fromFlash = false;
+        entry.sentAt = micros();
+        entry.bytes = record.payloadLength;
+        inflightCount++;
+        sendIndex = record.next;
+        
+        releaseAcked();
+    }
+}
+
+bool MQTTManager::writeRecord(const MQTTRingRecord& record, uint16_t packetId, bool dup) {
+    // Escritura por tramos directo desde la arena: no depende del buffer
+    // interno de PubSubClient, así los mensajes mayores que
+    // MQTT_MAX_PACKET_SIZE también salen
+    bool ok = (packetId == 0)
+        ? mqttClient.beginPublish(record.topic, record.payloadLength, record.retained)
+        : writePublishHeader(record.topic, record.payloadLength, record.retained, packetId, dup);
+    if (!ok) {
+        return false;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (record.length[i] > 0 && mqttClient.write(record.payload[i], record.length[i]) != record.length[i]) {
+            mqttClient.disconnect();  // Paquete a medias: forzar reconexión
+            return false;
+        }
+    }
+    return (packetId == 0) ? mqttClient.endPublish() : true;
+}
+
+bool MQTTManager::writePublishHeader(const char* topic, size_t payloadLength, bool retained, uint16_t packetId, bool dup) {
+    // PubSubClient sólo arma PUBLISH QoS 0: la cabecera QoS 1 se arma acá
+    // y se escribe por el mismo cliente (mantiene el keepalive al día)
+    size_t topicLength = strlen(topic);
+    if (topicLength > MQTT_RING_MAX_TOPIC_LENGTH) return false;
+    
+    uint8_t header[5 + 2 + MQTT_RING_MAX_TOPIC_LENGTH + 2];
+    size_t pos = 0;
+    
+    header[pos++] = 0x32 | (dup ? 0x08 : 0) | (retained ? 0x01 : 0);  // PUBLISH, QoS 1
+    uint32_t remaining = 2 + topicLength + 2 + payloadLength;
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        if (remaining > 0) digit |= 0x80;
+        header[pos++] = digit;
+    } while (remaining > 0);
+    
+    header[pos++] = topicLength >> 8;
+    header[pos++] = topicLength & 0xFF;
+    memcpy(header + pos, topic, topicLength);
+    pos += topicLength;
+    header[pos++] = packetId >> 8;
+    header[pos++] = packetId & 0xFF;
+    
+    if (mqttClient.write(header, pos) != pos) {
+        mqttClient.disconnect();
+        return false;
+    }
+    return true;
+}
+
+void MQTTManager::processAcks() {
+    uint16_t packetId;
+    
+    while (wireTap.popAck(packetId)) {
+        for (uint8_t i = 0; i < inflightCount; i++) {
+            InflightEntry& entry = inflight[(inflightHead + i) % MQTT_MANAGER_MAX_INFLIGHT];
+            if (!entry.acked && entry.packetId == packetId) {
+                entry.acked = true;
+                recordAck(entry.sentAt);
+                break;
+            }
+        }
+    }
+    
+    releaseAcked();
+}
+
+void MQTTManager::releaseAcked() {
+    // Liberar en orden: un PUBACK fuera de orden espera a los anteriores
+    while (inflightCount > 0 && inflight[inflightHead].acked) {
+        InflightEntry& entry = inflight[inflightHead];
+        countDelivered(entry.bytes);
+        
+        if (!entry.fromFlash) {
+            publishQueue.pop();
+        } else if (offlineStoreReady()) {
+            // pop() sólo usa la posición y los largos del registro
+            FlashQueueRecord record;
+            record.segment = entry.segment;
+            record.offset = entry.offset;
+            record.topicLength = entry.topicLength;
+            record.payloadLength = entry.bytes;
+            offlineStore->pop(record);
+            if (offlineStore->pendingCount() == 0) {
+                Serial.println("[MQTT MGR] ✓ Backlog drenado");
+            }
+        }
+        
+        inflightHead = (inflightHead + 1) % MQTT_MANAGER_MAX_INFLIGHT;
+        inflightCount--;
+    }
+}
+
+void MQTTManager::resendInflight() {
+    MQTTRingRecord record;
+    FlashQueueRecord stored;
+    uint32_t index = publishQueue.readIndex();
+    uint32_t resent = 0;
+    
+    resendPending = false;
+    
+    for (uint8_t i = 0; i < inflightCount; i++) {
+        InflightEntry& entry = inflight[(inflightHead + i) % MQTT_MANAGER_MAX_INFLIGHT];
+        
+        if (entry.fromFlash) {
+            if (entry.acked) continue;
+            if (!offlineStoreReady() || !offlineStore->peekAt(entry.segment, entry.offset, stored)) {
+                // La rotación del log ya lo descartó: no queda qué reenviar
+                entry.acked = true;
+                continue;
+            }
+            if (!writeFlashRecord(stored, entry.packetId, true)) {
+                resendPending = true;
+                return;
+            }
+            entry.sentAt = micros();
+            resent++;
+            continue;
+        }
+        
+        if (!publishQueue.peekAt(index, record)) break;
+        
+        if (!entry.acked) {
+            if (!writeRecord(record, entry.packetId, true)) {
+                resendPending = true;
+                return;
+            }
+            entry.sentAt = micros();
+            resent++;
+        }
+        index = record.next;
+    }
+    
+    releaseAcked();
+    
+    if (resent > 0) {
+        qosStats.retransmits += resent;
+        Serial.printf("[MQTT MGR] %lu mensajes QoS 1 reenviados (DUP)\n", resent);
+    }
+}
+
+void MQTTManager::resetInflight() {
+    inflightHead = 0;
+    inflightCount = 0;
+    sendIndex = publishQueue.readIndex();
+}
+
+bool MQTTManager::checkAckTimeout() {
+    uint32_t now = micros();
+    uint32_t timeoutUs = MQTT_MANAGER_ACK_TIMEOUT_MS * 1000UL;
+    bool expired = false;
+    
+    for (uint8_t i = 0; i < inflightCount && !expired; i++) {
+        InflightEntry& entry = inflight[(inflightHead + i) % MQTT_MANAGER_MAX_INFLIGHT];
+        if (!entry.acked) {
+            expired = now - entry.sentAt > timeoutUs;
+            break;  // El más antiguo sin PUBACK decide
         }
     }
+    
+    if (!expired) return false;
+    
+    // Sin PUBACK por demasiado tiempo: el TCP está colgado aunque el socket
+    // siga abierto. Cortar para reconectar y reenviar la ventana
+    qosStats.ackTimeouts++;
+    Serial.println("[MQTT MGR] ✗ PUBACK vencido, reconectando...");
+    mqttClient.disconnect();
+    return true;
+}
+
+void MQTTManager::recordAck(uint32_t sentAt) {
+    uint32_t latency = micros() - sentAt;
+    qosStats.acked++;
+    periodAcks++;
+    periodLatencySum += latency;
+    if (latency > periodLatencyMax) {
+        periodLatencyMax = latency;
+    }
+}
+
+void MQTTManager::countDelivered(uint32_t bytes) {
+    stats.totalPublished++;
+    stats.lastPublishTime = millis();
+    periodMessages++;
+    periodBytes += bytes;
+}
+
+void MQTTManager::updateMetrics() {
+    unsigned long now = millis();
+    unsigned long elapsed = now - periodStart;
+    if (elapsed < MQTT_MANAGER_METRICS_PERIOD_MS) return;
+    
+    float seconds = elapsed / 1000.0f;
+    qosStats.messagesPerSecond = periodMessages / seconds;
+    qosStats.bytesPerSecond = periodBytes / seconds;
+    qosStats.ackLatencyAvgUs = (periodAcks > 0) ? (uint32_t)(periodLatencySum / periodAcks) : 0;
+    qosStats.ackLatencyMaxUs = periodLatencyMax;
+    
+    periodStart = now;
+    periodMessages = 0;
+    periodBytes = 0;
+    periodLatencySum = 0;
+    periodLatencyMax = 0;
+    periodAcks = 0;
+}
+
+uint16_t MQTTManager::allocatePacketId() {
+    uint16_t packetId = nextPacketId++;
+    if (nextPacketId == 0) {
+        nextPacketId = 1;  // 0 no es un packet ID válido
+    }
+    return packetId;
+}
+
+bool MQTTManager::offlineStoreReady() const {
+    return offlineStore != nullptr && offlineStore->isReady();
+}
+
+void MQTTManager::spillToOfflineStore(bool all) {
+    MQTTRingRecord record;
+    uint32_t moved = 0;
+    
+    // El frente de la cola son los registros de la ventana (en el mismo
+    // orden) y después los que todavía no se enviaron
+    while (publishQueue.peek(record)) {
+        if (!all && publishQueue.used() <= publishQueue.capacity() / 2) break;
+        
+        // Con la ventana ocupada por el backlog de flash, la cola RAM entera
+        // está sin enviar
+        bool inWindow = inflightCount > 0 && !windowFromFlash();
+        if (inWindow) {
+            InflightEntry& entry = inflight[inflightHead];
+            if (entry.acked) {
+                // QoS 0 ya escrito o QoS 1 con PUBACK detrás de uno pendiente:
+                // está entregado, pasarlo a flash lo publicaría de nuevo
+                countDelivered(entry.bytes);
+                publishQueue.pop();
+                inflightHead = (inflightHead + 1) % MQTT_MANAGER_MAX_INFLIGHT;
+                inflightCount--;
+                continue;
+            }
+            // QoS 1 sin PUBACK: con la sesión activa el PUBACK todavía puede
+            // llegar, así que se queda en la ventana
+            if (isConnected()) break;
+        }
+        
+        const uint8_t* parts[2] = { record.payload[0], record.payload[1] };
+        if (!offlineStore->append(record.topic, parts, record.length, 2, record.retained, record.qos)) {
+            break;  // Queda en RAM, se reintenta
+        }
+        // Un QoS 1 en vuelo sin sesión pasa a flash y se reenvía desde ahí
+        if (inWindow) {
+            inflightHead = (inflightHead + 1) % MQTT_MANAGER_MAX_INFLIGHT;
+            inflightCount--;
+        }
+        publishQueue.pop();
+        moved++;
+    }
+    
+    if (inflightCount == 0) {
+        resetInflight();
+    }
+    
+    if (moved > 0) {
+        Serial.printf("[MQTT MGR] %lu mensajes guardados en flash (%s)\n", moved,
+                      isConnected() ? "cola RAM llena" : "sin conexión");
+    }
+}
+
+void MQTTManager::processOfflineStore() {
+    if (!offlineStoreReady() || offlineStore->pendingCount() == 0) return;
+    
+    // Mensajes de la cola RAM en vuelo (de antes de la caída): se espera su
+    // PUBACK para no mezclar las dos fuentes en la ventana
+    if (inflightCount > 0 && !windowFromFlash()) return;
+    
+    FlashQueueRecord record;
+    unsigned long start = millis();
+    
+    // Drenar dentro del presupuesto de tiempo, transmitiendo el payload por
+    // tramos directamente desde flash. Los QoS 1 comparten la ventana en
+    // vuelo con la cola RAM y se consumen en orden al llegar su PUBACK
+    while (millis() - start < MQTT_MANAGER_DRAIN_BUDGET_MS && isConnected() && inflightCount < inflightWindow) {
+        bool found = (inflightCount == 0) ? offlineStore->peek(record)
+                                          : offlineStore->peekNext(flashRecord, record);
+        if (!found) break;
+        
+        uint16_t packetId = (record.qos > 0) ? allocatePacketId() : 0;
+        if (!writeFlashRecord(record, packetId, false)) {
+            stats.failedPublish++;
+            Serial.println("[MQTT MGR] ✗ Error drenando backlog, se reintentará");
+            break;
+        }
+        flashRecord = record;
+        
+        InflightEntry& entry = inflight[(inflightHead + inflightCount) % MQTT_MANAGER_MAX_INFLIGHT];
+        entry.packetId = packetId;
+        entry.acked = (packetId == 0);
+        entry.fromFlash = true;
+        entry.segment = record.segment;
+        entry.offset = record.offset;
+        entry.topicLength = record.topicLength;
+        entry.sentAt = micros();
+        entry.bytes = record.payloadLength;
+        inflightCount++;
+        
+        releaseAcked();
+    }
+}
+
+bool MQTTManager::writeFlashRecord(const FlashQueueRecord& record, uint16_t packetId, bool dup) {
+    uint8_t chunk[MQTT_MANAGER_DRAIN_CHUNK_SIZE];
+    
+    bool ok = (packetId == 0)
+        ? mqttClient.beginPublish(record.topic, record.payloadLength, record.retained)
+        : writePublishHeader(record.topic, record.payloadLength, record.retained, packetId, dup);
+    size_t offset = 0;
+    while (ok && offset < record.payloadLength) {
+        size_t n = record.payloadLength - offset;
+        if (n > sizeof(chunk)) n = sizeof(chunk);
+        ok = offlineStore->readPayload(record, offset, chunk, n) &&
+             mqttClient.write(chunk, n) == n;
+        offset += n;
+    }
+    if (ok && packetId == 0) {
+        ok = mqttClient.endPublish();
+    }
+    if (!ok) {
+        // Paquete a medias: cerrar la sesión, se reintenta al reconectar
+        mqttClient.disconnect();
+    }
+    return ok;
 }
 
 void MQTTManager::mqttCallback(char* topic, byte* payload, unsigned int length) {
@@ -431,11 +983,85 @@ void MQTTManager::mqttCallback(char* topic, byte* payload, unsigned int length)
     }
 }
 
+TickType_t MQTTManager::idleWait() {
+    // Corre en la tarea MQTT, la única que modifica este estado
+    if (resendPending || reconnectNow) return 0;
+    if (!isConnected()) return pdMS_TO_TICKS(MQTT_MANAGER_RECONNECT_INTERVAL);
+    
+    // Paquetes ya leídos del socket al buffer del cliente: select() no los ve
+    // y PubSubClient procesa uno por vuelta
+    if (wifiClient.available() > 0) return 0;
+    
+    // Quedó algo por enviar (presupuesto de tiempo agotado): un tick de
+    // respiro y otra vuelta
+    if (inflightCount < inflightWindow) {
+        bool flashBacklog = offlineStoreReady() && offlineStore->pendingCount() > 0;
+        if (flashBacklog && (inflightCount == 0 || windowFromFlash()) &&
+            offlineStore->pendingCount() > inflightCount) {
+            return 1;
+        }
+        if (!flashBacklog && !windowFromFlash() && publishQueue.count() > inflightCount) {
+            return 1;
+        }
+    }
+    
+    // Sin eventos: cada cuarto de keepalive, así el PINGREQ sale bastante
+    // antes de que el broker corte (1.5 x keepalive sin paquetes), y con
+    // mensajes en vuelo el PUBACK vencido se detecta a tiempo
+    uint32_t waitMs = (config.keepAlive > 0) ? config.keepAlive * 1000UL / 4 : MQTT_MANAGER_RECONNECT_INTERVAL;
+    if (inflightCount > 0 && waitMs > MQTT_MANAGER_ACK_TIMEOUT_MS / 2) {
+        waitMs = MQTT_MANAGER_ACK_TIMEOUT_MS / 2;
+    }
+    return pdMS_TO_TICKS(waitMs);
+}
+
 void MQTTManager::mqttTask(void* parameter) {
     MQTTManager* mgr = (MQTTManager*)parameter;
     
     while (true) {
+        // Despertar con publish(), PUBACK, datos entrantes o por timeout
+        ulTaskNotifyTake(pdTRUE, mgr->idleWait());
+        JobMgr.start(mgr->loopJob);
         mgr->loop();
-        vTaskDelay(pdMS_TO_TICKS(10));  // 10ms
+        JobMgr.finish(mgr->loopJob);
+        
+        // Lo entrante ya se leyó: el vigilante puede volver a esperar datos
+        if (mgr->rxTaskHandle != NULL) {
+            xTaskNotifyGive(mgr->rxTaskHandle);
+        }
+    }
+}
+
+void MQTTManager::rxTask(void* parameter) {
+    MQTTManager* mgr = (MQTTManager*)parameter;
+    
+    while (true) {
+        int fd = mgr->socketFd;
+        if (fd < 0) {
+            // Sin sesión: esperar la próxima vuelta de la tarea MQTT
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(fd, &readSet);
+        struct timeval timeout;
+        timeout.tv_sec = MQTT_MANAGER_RX_POLL_MS / 1000;
+        timeout.tv_usec = (MQTT_MANAGER_RX_POLL_MS % 1000) * 1000;
+        
+        int ready = select(fd + 1, &readSet, NULL, NULL, &timeout);
+        if (ready == 0) continue;  // Sin datos: releer el socket por si reconectó
+        if (ready < 0) {
+            // Socket cerrado por la tarea MQTT: esperar a que publique el nuevo
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MQTT_MANAGER_RX_POLL_MS));
+            continue;
+        }
+        
+        // Datos (o cierre remoto): despertar a la tarea MQTT y no volver a
+        // select() hasta que los haya leído, si no el socket sigue legible
+        ulTaskNotifyTake(pdTRUE, 0);
+        xTaskNotifyGive(mgr->mqttTaskHandle);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
 }
@@ -10,19 +10,35 @@
 
 #include <Arduino.h>
 #include <PubSubClient.h>
+#include <ArduinoJson.h>
 #include <WiFiClient.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "freertos/queue.h"
+#include "MQTTPublishRing.h"
+#include "MQTTWireTap.h"
+#include <FlashQueueManager.h>
+#include <PeriodicJobManager.h>
 
 #define MQTT_MANAGER_VERSION "1.0.0"
-#define MQTT_MANAGER_TASK_STACK_SIZE 4096
+#define MQTT_MANAGER_TASK_STACK_SIZE 8192     // Los callbacks de mensajes corren en esta tarea
 #define MQTT_MANAGER_TASK_PRIORITY 3
+#define MQTT_MANAGER_RX_TASK_STACK_SIZE 2048  // Vigilante del socket (select)
+#define MQTT_MANAGER_RX_POLL_MS 1000          // select() máximo: vuelve a leer el socket tras reconectar
 #define MQTT_MANAGER_RECONNECT_INTERVAL 5000
+#define MQTT_MANAGER_LOOP_DEADLINE_MS 100     // Vuelta más larga atrasa keepalive y PUBACKs
 #define MQTT_MANAGER_KEEP_ALIVE 60
 #define MQTT_MANAGER_MAX_PACKET_SIZE 1024
-#define MQTT_MANAGER_QUEUE_SIZE 10
+#ifndef MQTT_MANAGER_QUEUE_BYTES
+#define MQTT_MANAGER_QUEUE_BYTES 4096        // Presupuesto de la cola RAM (bytes, potencia de 2)
+#endif
+#define MQTT_MANAGER_DRAIN_BUDGET_MS 50      // Tiempo máximo de drenado del backlog por vuelta
+#define MQTT_MANAGER_DRAIN_CHUNK_SIZE 128    // Tramo de lectura del payload desde flash
+#define MQTT_MANAGER_MAX_INFLIGHT 32         // Tope de la ventana QoS 1
+#define MQTT_MANAGER_DEFAULT_INFLIGHT 8      // Ventana QoS 1 por defecto
+#define MQTT_MANAGER_ACK_TIMEOUT_MS 10000    // PUBACK vencido: se asume TCP colgado y se reconecta
+#define MQTT_MANAGER_METRICS_PERIOD_MS 10000 // Período de cálculo de throughput y latencia
 
 // Estructuras
 struct MQTTConfig {
@@ -35,12 +51,6 @@ struct MQTTConfig {
     uint16_t maxPacketSize;
 };
 
-struct MQTTMessage {
-    char topic[128];
-    char payload[512];
-    bool retained;
-};
-
 struct MQTTStats {
     uint32_t totalPublished;
     uint32_t totalReceived;
@@ -50,6 +60,25 @@ struct MQTTStats {
     unsigned long lastReceiveTime;
 };
 
+/**
+ * @brief Métricas de publicación QoS 1
+ *
+ * Los campos de throughput y latencia corresponden al último período
+ * completo de MQTT_MANAGER_METRICS_PERIOD_MS.
+ */
+struct MQTTQoSStats {
+    uint8_t qos;                    ///< QoS de publicación configurado
+    uint8_t window;                 ///< Tamaño de la ventana en vuelo
+    uint8_t inflight;               ///< Mensajes enviados sin PUBACK
+    uint32_t acked;                 ///< PUBACK recibidos (total)
+    uint32_t retransmits;           ///< Reenvíos con DUP tras reconectar
+    uint32_t ackTimeouts;           ///< Reconexiones por PUBACK vencido
+    float messagesPerSecond;        ///< Mensajes confirmados por segundo
+    float bytesPerSecond;           ///< Bytes de payload confirmados por segundo
+    uint32_t ackLatencyAvgUs;       ///< Latencia media PUBLISH -> PUBACK
+    uint32_t ackLatencyMaxUs;       ///< Latencia máxima PUBLISH -> PUBACK
+};
+
 // Callbacks
 typedef std::function<void(char*, uint8_t*, unsigned int)> MQTTMessageCallback;
 typedef std::function<void(bool)> MQTTConnectionCallback;
@@ -70,11 +99,47 @@ public:
     bool isConnected();
     bool reconnect();
     
-    // Publish
+    /**
+     * @brief Intenta conectar en la próxima vuelta de la tarea, sin esperar
+     *        MQTT_MANAGER_RECONNECT_INTERVAL (p. ej. al obtener IP)
+     * @note Seguro desde callbacks de eventos WiFi
+     */
+    void requestReconnect();
+    
+    // Task
+    /**
+     * @brief Inicia la tarea MQTT dedicada
+     *
+     * La tarea es la única que toca el socket: drena la cola, escribe,
+     * atiende keepalive/mensajes entrantes y reconecta. Duerme en su
+     * notificación, que dan publish(), cada PUBACK capturado y una tarea
+     * chica que espera datos entrantes en el socket (select). Sin eventos
+     * despierta cada cuarto de keepalive (PINGREQ a tiempo).
+     */
+    bool startTask();
+    void stopTask();
+    bool isTaskRunning() const { return mqttTaskHandle != NULL; }
+    
+    // Publish (no bloqueante: encola en la arena lock-free y notifica a la tarea)
     bool publish(const char* topic, const char* payload, bool retained = false);
     bool publish(const char* topic, const uint8_t* payload, size_t length, bool retained = false);
     bool publishJSON(const char* topic, const char* json, bool retained = false);
     
+    /**
+     * @brief Serializa un documento JSON directo en la cola, sin String intermedio
+     *
+     * Pre-pasada con measureJson() para reservar el largo exacto y luego
+     * serializeJson() dentro de la reserva. La tarea lo transmite por tramos
+     * (beginPublish/write/endPublish), así que puede superar MQTT_MAX_PACKET_SIZE.
+     */
+    bool publishJSON(const char* topic, const JsonDocument& doc, bool retained = false);
+    
+    /**
+     * @brief Envía lo encolado en RAM de forma síncrona (p. ej. antes de reiniciar)
+     * @return true si la cola quedó vacía dentro del timeout
+     */
+    bool flush(uint32_t timeoutMs = 1000);
+    
     // Subscribe
     bool subscribe(const char* topic, uint8_t qos = 0);
     bool unsubscribe(const char* topic);
@@ -88,23 +153,55 @@ public:
     void setMaxPacketSize(uint16_t size);
     void setAutoReconnect(bool enable);
     
+    /**
+     * @brief QoS de las publicaciones encoladas desde ahora (0 o 1)
+     *
+     * Con QoS 1 los mensajes quedan en la cola hasta recibir su PUBACK y se
+     * reenvían (DUP) al reconectar. Se mantienen hasta `window` mensajes en
+     * vuelo a la vez, en orden, para no caer en stop-and-wait.
+     */
+    void setPublishQoS(uint8_t qos);
+    void setInflightWindow(uint8_t window);
+    MQTTQoSStats getQoSStats();
+    
+    /**
+     * @brief Asigna la cola persistente usada mientras no hay conexión
+     *
+     * Sin conexión, la tarea MQTT vuelca la cola RAM a flash; al reconectar
+     * drena primero flash (lo más antiguo) y luego la cola RAM.
+     */
+    void setOfflineStore(FlashQueueManager* store);
+    uint32_t getBacklog() const;
+    
+    /**
+     * @brief Presupuesto en bytes de la cola RAM (llamar antes de begin())
+     *
+     * Los mensajes se guardan con su largo real, sin slots fijos ni truncado.
+     */
+    void setQueueBudget(size_t bytes);
+    MQTTRingStats getQueueStats() const { return publishQueue.getStats(); }
+    
     // Info
     MQTTStats getStats() const { return stats; }
     void resetStats();
     void printStats();
     void printInfo();
     
-    // Loop (call in main loop if not using FreeRTOS task)
+    // Loop (lo ejecuta la tarea MQTT; llamar a mano sólo si no se usa startTask())
     void loop();
     
 private:
     bool initialized;
     WiFiClient wifiClient;
+    MQTTWireTap wireTap;        // Entre PubSubClient y el socket: captura PUBACK
     PubSubClient mqttClient;
     
     TaskHandle_t mqttTaskHandle;
+    TaskHandle_t rxTaskHandle;  // Vigilante del socket: notifica datos entrantes
+    volatile int socketFd;      // Socket de la sesión activa (-1 = sin conexión)
     SemaphoreHandle_t mutex;
-    QueueHandle_t publishQueue;
+    MQTTPublishRing publishQueue;
+    size_t queueBudget;
     
     MQTTConfig config;
     MQTTStats stats;
@@ -113,8 +210,48 @@ private:
     
     bool autoReconnectEnabled;
     unsigned long lastReconnectAttempt;
+    volatile bool reconnectNow;     // Próximo reconnect() sin esperar el intervalo
+    int8_t loopJob;             // Vuelta de la tarea, medida en JobMgr
+    int8_t reconnectJob;
+    
+    FlashQueueManager* offlineStore;
+    
+    // Ventana QoS 1: entradas en el mismo orden que los registros de la cola
+    // RAM o del backlog en flash (nunca mezclados: flash se drena primero)
+    struct InflightEntry {
+        uint16_t packetId;      // 0 = QoS 0 (no espera PUBACK)
+        bool acked;
+        bool fromFlash;         // Registro del backlog en flash
+        uint16_t segment;       // Posición en flash (sólo fromFlash)
+        uint16_t offset;
+        uint16_t topicLength;
+        uint32_t sentAt;        // micros()
+        uint32_t bytes;
+    };
+    uint8_t publishQoS;
+    uint8_t inflightWindow;
+    InflightEntry inflight[MQTT_MANAGER_MAX_INFLIGHT];
+    uint8_t inflightHead;
+    uint8_t inflightCount;
+    uint32_t sendIndex;         // Próximo registro de la cola sin enviar
+    uint16_t nextPacketId;
+    bool resendPending;
+    
+    // Último registro de flash enviado: el siguiente sale con peekNext()
+    FlashQueueRecord flashRecord;
+    
+    // Métricas QoS
+    MQTTQoSStats qosStats;
+    unsigned long periodStart;
+    uint32_t periodMessages;
+    uint32_t periodBytes;
+    uint64_t periodLatencySum;
+    uint32_t periodLatencyMax;
+    uint32_t periodAcks;
     
     static void mqttTask(void* parameter);
+    static void rxTask(void* parameter);
+    TickType_t idleWait();
     static void mqttCallback(char* topic, byte* payload, unsigned int length);
     static MQTTManager* instance;
     
@@ -122,6 +259,23 @@ private:
     void unlock();
     void handleReconnect();
     void processPublishQueue();
+    void processOfflineStore();
+    void spillToOfflineStore(bool all);
+    bool offlineStoreReady() const;
+    bool writeRecord(const MQTTRingRecord& record, uint16_t packetId, bool dup);
+    bool writePublishHeader(const char* topic, size_t payloadLength, bool retained, uint16_t packetId, bool dup);
+    void processAcks();
+    void releaseAcked();
+    void resendInflight();
+    void resetInflight();
+    bool windowFromFlash() const { return inflightCount > 0 && inflight[inflightHead].fromFlash; }
+    bool checkAckTimeout();
+    void recordAck(uint32_t sentAt);
+    void countDelivered(uint32_t bytes);
+    bool writeFlashRecord(const FlashQueueRecord& record, uint16_t packetId, bool dup);
+    void updateMetrics();
+    uint16_t allocatePacketId();
+    void notifyTask();
 };
 
 extern MQTTManager MqttMgr;
@@ -0,0 +1,246 @@
+/**
+ * @file MQTTPublishRing.cpp
+ * @brief Implementación de la arena circular de publicación (MPSC lock-free)
+ * @version 1.1.0
+ * @date 2026-10-18
+ */
+
+#include "MQTTPublishRing.h"
+
+#define RING_HEADER_SIZE sizeof(MQTTRingHeader)
+
+// ============================================================================
+// CONSTRUCTOR Y DESTRUCTOR
+// ============================================================================
+
+MQTTPublishRing::MQTTPublishRing() : head(0), tail(0), records(0) {
+    buffer = nullptr;
+    size = 0;
+    mask = 0;
+    memset(&stats, 0, sizeof(MQTTRingStats));
+}
+
+MQTTPublishRing::~MQTTPublishRing() {
+    end();
+}
+
+// ============================================================================
+// INICIALIZACIÓN
+// ============================================================================
+
+bool MQTTPublishRing::begin(size_t budgetBytes) {
+    if (buffer != nullptr) return true;
+
+    if (budgetBytes < MQTT_RING_MIN_CAPACITY) {
+        budgetBytes = MQTT_RING_MIN_CAPACITY;
+    }
+
+    // Mayor potencia de 2 que no supere el presupuesto
+    uint32_t capacity = MQTT_RING_MIN_CAPACITY;
+    while ((size_t)capacity * 2 <= budgetBytes) {
+        capacity *= 2;
+    }
+
+    // Arena a cero: una palabra `size` en 0 significa "no confirmado"
+    buffer = (uint8_t*)calloc(capacity, 1);
+    if (buffer == nullptr) {
+        return false;
+    }
+
+    size = capacity;
+    mask = capacity - 1;
+    head.store(0);
+    tail.store(0);
+    records.store(0);
+    return true;
+}
+
+void MQTTPublishRing::end() {
+    if (buffer != nullptr) {
+        free(buffer);
+        buffer = nullptr;
+    }
+    size = 0;
+    mask = 0;
+    head.store(0);
+    tail.store(0);
+    records.store(0);
+}
+
+// ============================================================================
+// PRODUCTORES
+// ============================================================================
+
+size_t MQTTPublishRing::recordSize(size_t topicLength, size_t payloadLength) {
+    return (RING_HEADER_SIZE + topicLength + payloadLength + 3) & ~(size_t)3;
+}
+
+bool MQTTPublishRing::push(const char* topic, const uint8_t* payload, size_t length, bool retained, uint8_t qos) {
+    if (payload == nullptr && length > 0) return false;
+
+    MQTTRingReservation reservation;
+    if (!reserve(topic, length, retained, qos, reservation)) {
+        return false;
+    }
+    write(reservation, 0, payload, length);
+    commit(reservation);
+    return true;
+}
+
+bool MQTTPublishRing::reserve(const char* topic, size_t payloadLength, bool retained, uint8_t qos, MQTTRingReservation& reservation) {
+    if (buffer == nullptr || topic == nullptr) return false;
+
+    size_t topicLength = strlen(topic);
+    if (topicLength == 0 || topicLength > MQTT_RING_MAX_TOPIC_LENGTH) return false;
+
+    size_t need = recordSize(topicLength, payloadLength);
+    if (need > size) {
+        __atomic_fetch_add(&stats.rejected, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    // Reserva por CAS sobre el índice de escritura
+    uint32_t start = head.load(std::memory_order_relaxed);
+    do {
+        uint32_t used = start - tail.load(std::memory_order_acquire);
+        if (used + need > size) {
+            __atomic_fetch_add(&stats.rejected, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    } while (!head.compare_exchange_weak(start, start + need,
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_relaxed));
+
+    uint32_t used = start + need - tail.load(std::memory_order_relaxed);
+    if (used > stats.highWater) {
+        stats.highWater = used;
+    }
+
+    // Cabecera sin `size` (se escribe al confirmar) + topic
+    MQTTRingHeader header;
+    header.size = 0;
+    header.topicLength = topicLength;
+    header.flags = (retained ? MQTT_RING_FLAG_RETAINED : 0) | (qos > 0 ? MQTT_RING_FLAG_QOS1 : 0);
+    header.reserved = 0;
+    header.payloadLength = payloadLength;
+    copyIn(start + sizeof(uint32_t), (const uint8_t*)&header + sizeof(uint32_t),
+           RING_HEADER_SIZE - sizeof(uint32_t));
+    copyIn(start + RING_HEADER_SIZE, topic, topicLength);
+
+    reservation.start = start;
+    reservation.size = need;
+    reservation.payloadStart = start + RING_HEADER_SIZE + topicLength;
+    reservation.payloadLength = payloadLength;
+    return true;
+}
+
+void MQTTPublishRing::write(const MQTTRingReservation& reservation, size_t offset, const uint8_t* data, size_t length) {
+    if (offset >= reservation.payloadLength) return;
+    if (length > reservation.payloadLength - offset) {
+        length = reservation.payloadLength - offset;
+    }
+    copyIn(reservation.payloadStart + offset, data, length);
+}
+
+void MQTTPublishRing::commit(const MQTTRingReservation& reservation) {
+    // La palabra `size` siempre queda alineada y contigua (registros alineados a 4)
+    sizeWord(reservation.start)->store(reservation.size, std::memory_order_release);
+    records.fetch_add(1, std::memory_order_relaxed);
+    __atomic_fetch_add(&stats.pushed, 1, __ATOMIC_RELAXED);
+}
+
+// ============================================================================
+// CONSUMIDOR
+// ============================================================================
+
+bool MQTTPublishRing::peek(MQTTRingRecord& record) {
+    return peekAt(tail.load(std::memory_order_relaxed), record);
+}
+
+bool MQTTPublishRing::peekAt(uint32_t index, MQTTRingRecord& record) {
+    if (buffer == nullptr) return false;
+
+    uint32_t start = tail.load(std::memory_order_relaxed);
+    if (index - start >= head.load(std::memory_order_acquire) - start) {
+        return false;  // Fuera del rango ocupado (o cola vacía)
+    }
+
+    // Registro reservado pero aún no confirmado: esperar (orden estricto)
+    if (sizeWord(index)->load(std::memory_order_acquire) == 0) return false;
+
+    MQTTRingHeader header;
+    copyOut(index, &header, RING_HEADER_SIZE);
+
+    copyOut(index + RING_HEADER_SIZE, record.topic, header.topicLength);
+    record.topic[header.topicLength] = '\0';
+
+    uint32_t payloadStart = index + RING_HEADER_SIZE + header.topicLength;
+    uint32_t pos = payloadStart & mask;
+    size_t first = size - pos;
+    if (first > header.payloadLength) first = header.payloadLength;
+
+    record.payload[0] = buffer + pos;
+    record.length[0] = first;
+    record.payload[1] = buffer;
+    record.length[1] = header.payloadLength - first;
+    record.payloadLength = header.payloadLength;
+    record.retained = (header.flags & MQTT_RING_FLAG_RETAINED) != 0;
+    record.qos = (header.flags & MQTT_RING_FLAG_QOS1) ? 1 : 0;
+    record.next = index + header.size;
+    return true;
+}
+
+void MQTTPublishRing::pop() {
+    if (buffer == nullptr) return;
+
+    uint32_t index = tail.load(std::memory_order_relaxed);
+    if (index == head.load(std::memory_order_acquire)) return;
+
+    uint32_t recordBytes = sizeWord(index)->load(std::memory_order_acquire);
+    if (recordBytes == 0) return;
+
+    // Poner a cero antes de liberar: ningún dato viejo puede parecer
+    // una cabecera confirmada en la siguiente vuelta
+    zero(index, recordBytes);
+    tail.store(index + recordBytes, std::memory_order_release);
+    records.fetch_sub(1, std::memory_order_relaxed);
+    stats.popped++;
+}
+
+// ============================================================================
+// MÉTODOS PRIVADOS
+// ============================================================================
+
+std::atomic<uint32_t>* MQTTPublishRing::sizeWord(uint32_t index) const {
+    return (std::atomic<uint32_t>*)(buffer + (index & mask));
+}
+
+void MQTTPublishRing::copyIn(uint32_t index, const void* data, size_t length) {
+    uint32_t pos = index & mask;
+    size_t first = size - pos;
+    if (first > length) first = length;
+    memcpy(buffer + pos, data, first);
+    if (length > first) {
+        memcpy(buffer, (const uint8_t*)data + first, length - first);
+    }
+}
+
+void MQTTPublishRing::copyOut(uint32_t index, void* data, size_t length) const {
+    uint32_t pos = index & mask;
+    size_t first = size - pos;
+    if (first > length) first = length;
+    memcpy(data, buffer + pos, first);
+    if (length > first) {
+        memcpy((uint8_t*)data + first, buffer, length - first);
+    }
+}
+
+void MQTTPublishRing::zero(uint32_t index, size_t length) {
+    uint32_t pos = index & mask;
+    size_t first = size - pos;
+    if (first > length) first = length;
+    memset(buffer + pos, 0, first);
+    if (length > first) {
+        memset(buffer, 0, length - first);
+    }
+}
@@ -0,0 +1,198 @@
+/**
+ * @file MQTTPublishRing.h
+ * @brief Cola de publicación lock-free en arena circular de bytes (MPSC)
+ * @version 1.1.0
+ * @date 2026-10-18
+ *
+ * @details
+ * Reemplaza la cola de slots fijos (topic[128] + payload[512] por mensaje).
+ * Cada registro ocupa sólo cabecera + topic + payload, alineado a 4 bytes,
+ * por lo que el mismo presupuesto de RAM admite muchos más mensajes cortos
+ * y los mensajes largos entran completos (sin truncar).
+ *
+ * Formato de registro (puede dar la vuelta al final del buffer):
+ * @code
+ * [size:4][topicLength:2][flags:1][reserved:1][payloadLength:4][topic...][payload...]
+ * @endcode
+ *
+ * Concurrencia: múltiples productores, un único consumidor (MPSC).
+ * - Productor: reserva espacio con CAS sobre el índice de escritura, copia
+ *   el registro y lo confirma escribiendo `size` al final (release).
+ * - Consumidor: lee en el índice de lectura sólo registros confirmados
+ *   (acquire) y al consumirlos los pone a cero antes de liberar el espacio.
+ * Ningún productor toma mutex ni espera: si no hay espacio, push() falla.
+ */
+
+#ifndef MQTT_PUBLISH_RING_H
+#define MQTT_PUBLISH_RING_H
+
+#include <Arduino.h>
+#include <atomic>
+
+#define MQTT_RING_MIN_CAPACITY 256
+#define MQTT_RING_MAX_TOPIC_LENGTH 128
+#define MQTT_RING_FLAG_RETAINED 0x01
+#define MQTT_RING_FLAG_QOS1 0x02
+
+/**
+ * @brief Cabecera de cada registro en la arena
+ */
+struct MQTTRingHeader {
+    uint32_t size;              ///< Bytes del registro (alineado); 0 = no confirmado
+    uint16_t topicLength;
+    uint8_t flags;              ///< MQTT_RING_FLAG_*
+    uint8_t reserved;
+    uint32_t payloadLength;
+};
+
+/**
+ * @brief Espacio reservado por un productor y aún no confirmado
+ */
+struct MQTTRingReservation {
+    uint32_t start;             ///< Índice monotónico del registro
+    uint32_t size;              ///< Bytes reservados
+    uint32_t payloadStart;      ///< Índice monotónico del primer byte de payload
+    uint32_t payloadLength;
+};
+
+/**
+ * @brief Registro devuelto por peek()
+ *
+ * El topic se copia (terminado en '\0'); el payload se expone como hasta dos
+ * tramos contiguos dentro de la arena (el segundo existe si dio la vuelta).
+ * `next` es el índice del registro siguiente, para recorrer la cola sin
+ * consumirla (ventana de mensajes en vuelo QoS 1).
+ */
+struct MQTTRingRecord {
+    char topic[MQTT_RING_MAX_TOPIC_LENGTH + 1];
+    const uint8_t* payload[2];
+    size_t length[2];
+    size_t payloadLength;
+    bool retained;
+    uint8_t qos;
+    uint32_t next;
+};
+
+/**
+ * @brief Estadísticas de la arena
+ */
+struct MQTTRingStats {
+    uint32_t pushed;            ///< Registros encolados
+    uint32_t popped;            ///< Registros consumidos
+    uint32_t rejected;          ///< Rechazados por falta de espacio
+    uint32_t highWater;         ///< Máximo de bytes ocupados (aproximado)
+};
+
+class MQTTPublishRing {
+public:
+    MQTTPublishRing();
+    ~MQTTPublishRing();
+
+    /**
+     * @brief Reserva la arena
+     * @param budgetBytes Presupuesto total. Se redondea hacia abajo a potencia
+     *        de 2 para que los índices monotónicos sigan siendo válidos al
+     *        desbordar 32 bits.
+     */
+    bool begin(size_t budgetBytes);
+    void end();
+    bool isReady() const { return buffer != nullptr; }
+
+    // ========================================================================
+    // PRODUCTORES (cualquier tarea, sin bloqueo)
+    // ========================================================================
+
+    /**
+     * @brief Encola un mensaje completo (topic + payload)
+     * @return false si no hay espacio o el mensaje excede la arena
+     */
+    bool push(const char* topic, const uint8_t* payload, size_t length, bool retained, uint8_t qos = 0);
+
+    /**
+     * @brief Reserva un registro y escribe su topic; el payload se completa
+     *        con write() y el registro se publica con commit()
+     */
+    bool reserve(const char* topic, size_t payloadLength, bool retained, uint8_t qos, MQTTRingReservation& reservation);
+    void write(const MQTTRingReservation& reservation, size_t offset, const uint8_t* data, size_t length);
+    void commit(const MQTTRingReservation& reservation);
+
+    // ========================================================================
+    // CONSUMIDOR (una sola tarea)
+    // ========================================================================
+
+    /**
+     * @brief Obtiene el registro confirmado más antiguo sin consumirlo
+     */
+    bool peek(MQTTRingRecord& record);
+
+    /**
+     * @brief Lee el registro confirmado en un índice sin consumirlo
+     * @param index readIndex() o el `next` de un registro anterior
+     * @return false si no hay registro confirmado en ese índice
+     */
+    bool peekAt(uint32_t index, MQTTRingRecord& record);
+    uint32_t readIndex() const { return tail.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Consume el registro devuelto por peek()
+     */
+    void pop();
+
+    // ========================================================================
+    // INFORMACIÓN
+    // ========================================================================
+
+    size_t count() const { return records.load(std::memory_order_relaxed); }
+    size_t used() const { return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed); }
+    size_t capacity() const { return size; }
+    MQTTRingStats getStats() const { return stats; }
+
+    /**
+     * @brief Bytes que ocupa en la arena un mensaje dado
+     */
+    static size_t recordSize(size_t topicLength, size_t payloadLength);
+
+private:
+    uint8_t* buffer;
+    uint32_t size;              // Potencia de 2
+    uint32_t mask;
+    std::atomic<uint32_t> head; // Índice monotónico de reserva (productores)
+    std::atomic<uint32_t> tail; // Índice monotónico de lectura (consumidor)
+    std::atomic<uint32_t> records;
+    MQTTRingStats stats;
+
+    void copyIn(uint32_t index, const void* data, size_t length);
+    void copyOut(uint32_t index, void* data, size_t length) const;
+    void zero(uint32_t index, size_t length);
+    std::atomic<uint32_t>* sizeWord(uint32_t index) const;
+};
+
+/**
+ * @brief Adaptador Print que escribe el payload de una reserva
+ *
+ * Permite serializar (p. ej. serializeJson) directo dentro de la arena,
+ * aunque el registro dé la vuelta al final del buffer.
+ */
+class MQTTRingWriter : public Print {
+public:
+    MQTTRingWriter(MQTTPublishRing& ring, const MQTTRingReservation& reservation)
+        : ring(ring), reservation(reservation), offset(0) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t length) override {
+        if (offset + length > reservation.payloadLength) {
+            length = reservation.payloadLength - offset;
+        }
+        ring.write(reservation, offset, data, length);
+        offset += length;
+        return length;
+    }
+    size_t written() const { return offset; }
+
+private:
+    MQTTPublishRing& ring;
+    const MQTTRingReservation& reservation;
+    size_t offset;
+};
+
+#endif // MQTT_PUBLISH_RING_H
@@ -0,0 +1,129 @@
+/**
+ * @file MQTTWireTap.cpp
+ * @brief Implementación del observador de flujo MQTT
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "MQTTWireTap.h"
+
+MQTTWireTap::MQTTWireTap(Client& client) : client(client) {
+    notifyTask = NULL;
+    ackHead = 0;
+    ackTail = 0;
+    dropped = 0;
+    reset();
+}
+
+// ============================================================================
+// CONEXIÓN
+// ============================================================================
+
+int MQTTWireTap::connect(IPAddress ip, uint16_t port) {
+    reset();
+    return client.connect(ip, port);
+}
+
+int MQTTWireTap::connect(const char* host, uint16_t port) {
+    reset();
+    return client.connect(host, port);
+}
+
+void MQTTWireTap::stop() {
+    client.stop();
+    reset();
+}
+
+// ============================================================================
+// LECTURA
+// ============================================================================
+
+int MQTTWireTap::read() {
+    int b = client.read();
+    if (b >= 0) {
+        feed((uint8_t)b);
+    }
+    return b;
+}
+
+int MQTTWireTap::read(uint8_t* buf, size_t size) {
+    int n = client.read(buf, size);
+    for (int i = 0; i < n; i++) {
+        feed(buf[i]);
+    }
+    return n;
+}
+
+bool MQTTWireTap::popAck(uint16_t& id) {
+    if (ackTail == ackHead) return false;
+    id = acks[ackTail & (MQTT_WIRE_TAP_ACK_QUEUE - 1)];
+    ackTail++;
+    return true;
+}
+
+// ============================================================================
+// MÉTODOS PRIVADOS
+// ============================================================================
+
+void MQTTWireTap::reset() {
+    // Cada conexión empieza en un límite de paquete; los PUBACK ya
+    // capturados se conservan (los resuelve MQTTManager)
+    state = PARSE_HEADER;
+    packetType = 0;
+    lengthShift = 0;
+    remaining = 0;
+    bodyIndex = 0;
+    packetId = 0;
+}
+
+void MQTTWireTap::feed(uint8_t b) {
+    switch (state) {
+        case PARSE_HEADER:
+            packetType = b >> 4;
+            remaining = 0;
+            lengthShift = 0;
+            bodyIndex = 0;
+            packetId = 0;
+            state = PARSE_LENGTH;
+            break;
+
+        case PARSE_LENGTH:
+            // Longitud restante: entero variable de hasta 4 bytes
+            remaining |= (uint32_t)(b & 0x7F) << lengthShift;
+            lengthShift += 7;
+            if ((b & 0x80) == 0) {
+                if (remaining == 0) {
+                    endPacket();
+                } else {
+                    state = PARSE_BODY;
+                }
+            } else if (lengthShift > 21) {
+                reset();  // Encuadre inválido: resincronizar en el próximo byte
+            }
+            break;
+
+        case PARSE_BODY:
+            if (packetType == MQTT_PACKET_PUBACK && bodyIndex < 2) {
+                packetId = (packetId << 8) | b;
+            }
+            if (++bodyIndex >= remaining) {
+                endPacket();
+            }
+            break;
+    }
+}
+
+void MQTTWireTap::endPacket() {
+    if (packetType == MQTT_PACKET_PUBACK && remaining >= 2) {
+        if ((uint8_t)(ackHead - ackTail) < MQTT_WIRE_TAP_ACK_QUEUE) {
+            acks[ackHead & (MQTT_WIRE_TAP_ACK_QUEUE - 1)] = packetId;
+            ackHead++;
+            if (notifyTask != NULL) {
+                xTaskNotifyGive(notifyTask);
+            }
+        } else {
+            dropped++;
+        }
+    }
+    state = PARSE_HEADER;
+}
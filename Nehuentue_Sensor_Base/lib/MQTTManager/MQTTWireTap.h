@@ -0,0 +1,92 @@
+/**
+ * @file MQTTWireTap.h
+ * @brief Client intermedio que observa el flujo MQTT entrante
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @details
+ * PubSubClient sólo publica con QoS 0 y descarta los PUBACK que recibe.
+ * MQTTWireTap se interpone entre PubSubClient y el WiFiClient: reenvía
+ * todas las llamadas sin modificar los datos y, al leer, sigue el
+ * encuadre de paquetes (cabecera fija + longitud restante) para capturar
+ * el packet ID de cada PUBACK.
+ *
+ * Los IDs capturados quedan en una cola corta que MQTTManager consume
+ * desde la misma tarea MQTT (no requiere sincronización). Cada PUBACK
+ * notifica además a esa tarea: PubSubClient lee un paquete por loop(), así
+ * que la tarea vuelve a correr enseguida para liberar la ventana.
+ */
+
+#ifndef MQTT_WIRE_TAP_H
+#define MQTT_WIRE_TAP_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define MQTT_WIRE_TAP_ACK_QUEUE 32        // Potencia de 2
+#define MQTT_PACKET_PUBACK 4
+
+class MQTTWireTap : public Client {
+public:
+    explicit MQTTWireTap(Client& client);
+
+    /**
+     * @brief Obtiene el siguiente PUBACK recibido
+     * @return false si no hay PUBACK pendientes
+     */
+    bool popAck(uint16_t& packetId);
+
+    /**
+     * @brief PUBACK perdidos porque la cola estaba llena
+     */
+    uint32_t droppedAcks() const { return dropped; }
+
+    /**
+     * @brief Tarea a notificar (xTaskNotifyGive) con cada PUBACK capturado
+     */
+    void setNotifyTask(TaskHandle_t task) { notifyTask = task; }
+
+    // Client
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    size_t write(uint8_t b) override { return client.write(b); }
+    size_t write(const uint8_t* buf, size_t size) override { return client.write(buf, size); }
+    int available() override { return client.available(); }
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override { return client.peek(); }
+    void flush() override { client.flush(); }
+    void stop() override;
+    uint8_t connected() override { return client.connected(); }
+    operator bool() override { return (bool)client; }
+
+private:
+    enum ParseState : uint8_t {
+        PARSE_HEADER,
+        PARSE_LENGTH,
+        PARSE_BODY
+    };
+
+    Client& client;
+    TaskHandle_t notifyTask;
+
+    ParseState state;
+    uint8_t packetType;
+    uint8_t lengthShift;
+    uint32_t remaining;
+    uint32_t bodyIndex;
+    uint16_t packetId;
+
+    uint16_t acks[MQTT_WIRE_TAP_ACK_QUEUE];
+    uint8_t ackHead;
+    uint8_t ackTail;
+    uint32_t dropped;
+
+    void reset();
+    void feed(uint8_t b);
+    void endPacket();
+};
+
+#endif // MQTT_WIRE_TAP_H
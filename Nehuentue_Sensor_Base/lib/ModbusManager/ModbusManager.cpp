@@ -19,7 +19,9 @@ ModbusManager::ModbusManager() {
     mutex = NULL;
     taskHandle = NULL;
     requestQueue = NULL;
+    rawQueue = NULL;
     responseCallback = nullptr;
+    rawCallback = nullptr;
     
     memset(&config, 0, sizeof(ModbusConfig));
     memset(&stats, 0, sizeof(ModbusStats));
@@ -58,6 +60,15 @@ bool ModbusManager::begin(HardwareSerial& serial, int rxPin, int txPin, unsigned
         return false;
     }
     
+    // Cola de tramas crudas (passthrough) y tarea que las atiende
+    rawQueue = xQueueCreate(MODBUS_MGR_RAW_QUEUE_SIZE, sizeof(ModbusRawRequest));
+    if (rawQueue == NULL) {
+        Serial.println("[MODBUS MGR] ERROR: No se pudo crear cola de tramas crudas");
+        vQueueDelete(requestQueue);
+        vSemaphoreDelete(mutex);
+        return false;
+    }
+    
     // Configurar puerto serial
     config.serial = &serial;
     config.rxPin = rxPin;
@@ -69,6 +80,12 @@ bool ModbusManager::begin(HardwareSerial& serial, int rxPin, int txPin, unsigned
     
     initialized = true;
     
+    if (xTaskCreate(modbusTask, "modbus_task", MODBUS_MGR_TASK_STACK, this,
+                    MODBUS_MGR_TASK_PRIORITY, &taskHandle) != pdPASS) {
+        taskHandle = NULL;
+        Serial.println("[MODBUS MGR] ERROR: No se pudo crear tarea (passthrough deshabilitado)");
+    }
+    
     Serial.printf("  Puerto: %s\n", "Serial1");
     Serial.printf("  RX Pin: GPIO %d\n", rxPin);
     Serial.printf("  TX Pin: GPIO %d\n", txPin);
@@ -100,6 +117,11 @@ void ModbusManager::end() {
         vQueueDelete(requestQueue);
         requestQueue = NULL;
     }
+    
+    if (rawQueue != NULL) {
+        vQueueDelete(rawQueue);
+        rawQueue = NULL;
+    }
 }
 
 // ============================================================================
@@ -204,6 +226,62 @@ ModbusResponse ModbusManager::writeMultipleRegisters(uint8_t slaveId, uint16_t s
     return sendRequest(request, 7 + byteCount);
 }
 
+size_t ModbusManager::executeBatch(const ModbusBatchOp* ops, size_t count, ModbusBatchCallback callback, void* context) {
+    if (!initialized || config.serial == NULL || ops == NULL) return 0;
+    if (count > MODBUS_MGR_MAX_BATCH) count = MODBUS_MGR_MAX_BATCH;
+    
+    uint8_t request[7 + 246];   // Máxima petición 0x10 sin CRC
+    size_t succeeded = 0;
+    
+    lock();
+    
+    for (size_t i = 0; i < count; i++) {
+        uint32_t start = micros();
+        ModbusResponse response;
+        
+        size_t length = buildRequest(ops[i], request, sizeof(request));
+        if (length > 0) {
+            response = transact(request, length);
+        } else {
+            memset(&response, 0, sizeof(ModbusResponse));
+            response.slaveId = ops[i].slaveId;
+            response.functionCode = ops[i].functionCode;
+        }
+        
+        if (response.success) succeeded++;
+        if (callback != nullptr) {
+            callback(i, response, micros() - start, context);
+        }
+    }
+    
+    unlock();
+    
+    return succeeded;
+}
+
+ModbusResponse ModbusManager::sendRaw(const uint8_t* frame, size_t length) {
+    if (!initialized || frame == NULL || length < 2 || length > MODBUS_MGR_MAX_RAW_FRAME) {
+        ModbusResponse empty;
+        memset(&empty, 0, sizeof(ModbusResponse));
+        return empty;
+    }
+    
+    return sendRequest((uint8_t*)frame, length);
+}
+
+bool ModbusManager::sendRawAsync(const uint8_t* frame, size_t length, const char* token) {
+    if (!initialized || rawQueue == NULL || taskHandle == NULL) return false;
+    if (frame == NULL || length < 2 || length > MODBUS_MGR_MAX_RAW_FRAME) return false;
+    
+    ModbusRawRequest request;
+    memcpy(request.frame, frame, length);
+    request.length = length;
+    strncpy(request.token, token != NULL ? token : "", MODBUS_MGR_MAX_TOKEN);
+    request.token[MODBUS_MGR_MAX_TOKEN] = '\0';
+    
+    return xQueueSend(rawQueue, &request, 0) == pdTRUE;
+}
+
 // ============================================================================
 // UTILIDADES
 // ============================================================================
@@ -278,12 +356,48 @@ void ModbusManager::onResponse(ModbusResponseCallback callback) {
 // CONFIGURACIÓN
 // ============================================================================
 
+void ModbusManager::onRawResponse(ModbusRawCallback callback) {
+    lock();
+    rawCallback = callback;
+    unlock();
+}
+
 void ModbusManager::setTimeout(uint32_t timeout) {
     lock();
     config.timeout = timeout;
     unlock();
 }
 
+bool ModbusManager::setSerialParams(unsigned long baudrate, int rxPin, int txPin) {
+    if (!initialized || config.serial == NULL) return false;
+    
+    lock();
+    
+    // Entre transacciones: no hay trama en vuelo
+    config.serial->flush();
+    
+    if (baudrate != config.baudrate) {
+        config.serial->updateBaudRate(baudrate);
+        config.baudrate = baudrate;
+    }
+    
+    if (rxPin != config.rxPin || txPin != config.txPin) {
+        config.serial->setPins(rxPin, txPin);
+        config.rxPin = rxPin;
+        config.txPin = txPin;
+    }
+    
+    // Descartar basura recibida durante el cambio
+    while (config.serial->available()) {
+        config.serial->read();
+    }
+    
+    unlock();
+    
+    Serial.printf("[MODBUS MGR] Puerto reconfigurado: %lu bps, RX=%d, TX=%d\n", baudrate, rxPin, txPin);
+    return true;
+}
+
 // ============================================================================
 // ESTADÍSTICAS
 // ============================================================================
@@ -294,6 +408,18 @@ void ModbusManager::resetStats() {
     unlock();
 }
 
+void ModbusManager::restoreStats(const ModbusStats& saved) {
+    lock();
+    stats.totalRequests = saved.totalRequests;
+    stats.successfulRequests = saved.successfulRequests;
+    stats.failedRequests = saved.failedRequests;
+    stats.timeouts = saved.timeouts;
+    stats.crcErrors = saved.crcErrors;
+    stats.exceptions = saved.exceptions;
+    stats.invalidReplies = saved.invalidReplies;
+    unlock();
+}
+
 void ModbusManager::printStats() {
     lock();
     
@@ -306,6 +432,7 @@ void ModbusManager::printStats() {
     Serial.printf("  Timeouts: %lu\n", stats.timeouts);
     Serial.printf("  Errores CRC: %lu\n", stats.crcErrors);
     Serial.printf("  Excepciones: %lu\n", stats.exceptions);
+    Serial.printf("  Respuestas no válidas: %lu\n", stats.invalidReplies);
     Serial.printf("  Última petición: %lu ms\n", stats.lastRequestTime);
     Serial.printf("  Última respuesta: %lu ms\n", stats.lastResponseTime);
     
@@ -348,15 +475,29 @@ void ModbusManager::unlock() {
 }
 
 ModbusResponse ModbusManager::sendRequest(uint8_t* request, size_t requestLength) {
-    ModbusResponse response;
-    memset(&response, 0, sizeof(ModbusResponse));
-    response.success = false;
-    
     if (!initialized || config.serial == NULL) {
-        return response;
+        ModbusResponse empty;
+        memset(&empty, 0, sizeof(ModbusResponse));
+        return empty;
     }
     
     lock();
+    ModbusResponse response = transact(request, requestLength);
+    unlock();
+    
+    // Callback
+    if (response.success && responseCallback != nullptr) {
+        responseCallback(response);
+    }
+    
+    return response;
+}
+
+ModbusResponse ModbusManager::transact(const uint8_t* request, size_t requestLength) {
+    // Llamar con el mutex tomado
+    ModbusResponse response;
+    memset(&response, 0, sizeof(ModbusResponse));
+    response.success = false;
     
     stats.totalRequests++;
     stats.lastRequestTime = millis();
@@ -381,10 +522,24 @@ ModbusResponse ModbusManager::sendRequest(uint8_t* request, size_t requestLength
     unsigned long startTime = millis();
     size_t bytesRead = 0;
     
+    // Tiempo de un carácter 8N1 (10 bits) en microsegundos
+    int64_t charTimeUs = 10000000LL / config.baudrate;
+    
     while (millis() - startTime < config.timeout && bytesRead < MODBUS_MGR_MAX_RESPONSE_SIZE) {
-        if (config.serial->available()) {
+        int available = config.serial->available();
+        if (available > 0) {
+            if (bytesRead == 0) {
+                // El UART entrega los bytes juntos tras su silencio de fin de
+                // bloque: el primero llegó antes, tantos caracteres como hay
+                // en espera más ese silencio
+                response.rxTimeUs = esp_timer_get_time() -
+                                    (available + MODBUS_MGR_RX_TIMEOUT_SYMBOLS) * charTimeUs;
+                response.timestamp = (uint32_t)(response.rxTimeUs / 1000);
+            }
             response.data[bytesRead++] = config.serial->read();
             startTime = millis();  // Reset timeout
+        } else if (bytesRead > 0 && millis() - startTime >= MODBUS_MGR_FRAME_GAP_MS) {
+            break;  // Silencio tras la trama: el esclavo terminó (funciones sin largo conocido)
         }
         
         // Verificar si respuesta completa
@@ -409,8 +564,9 @@ ModbusResponse ModbusManager::sendRequest(uint8_t* request, size_t requestLength
                     if (bytesRead >= (5 + byteCount)) break;
                 }
             }
-            // Función 0x06 o 0x10
-            else if (functionCode == 0x06 || functionCode == 0x10) {
+            // Funciones de escritura (eco de 8 bytes)
+            else if (functionCode == 0x05 || functionCode == 0x06 ||
+                     functionCode == 0x0F || functionCode == 0x10) {
                 if (bytesRead >= 8) break;
             }
         }
@@ -425,7 +581,6 @@ ModbusResponse ModbusManager::sendRequest(uint8_t* request, size_t requestLength
     if (bytesRead == 0) {
         stats.timeouts++;
         stats.failedRequests++;
-        unlock();
         return response;
     }
     
@@ -433,7 +588,14 @@ ModbusResponse ModbusManager::sendRequest(uint8_t* request, size_t requestLength
     if (!verifyCRC(response.data, bytesRead)) {
         stats.crcErrors++;
         stats.failedRequests++;
-        unlock();
+        return response;
+    }
+    
+    // Descartar respuestas que no son de esta petición (otro esclavo en el
+    // bus, función distinta o largo que no corresponde a la cantidad pedida)
+    if (!matchesRequest(request, requestLength, response.data, bytesRead)) {
+        stats.invalidReplies++;
+        stats.failedRequests++;
         return response;
     }
     
@@ -444,7 +606,6 @@ ModbusResponse ModbusManager::sendRequest(uint8_t* request, size_t requestLength
         response.functionCode = response.data[1] & 0x7F;
         stats.exceptions++;
         stats.failedRequests++;
-        unlock();
         return response;
     }
     
@@ -452,28 +613,127 @@ ModbusResponse ModbusManager::sendRequest(uint8_t* request, size_t requestLength
     response.success = true;
     response.slaveId = response.data[0];
     response.functionCode = response.data[1];
-    response.timestamp = millis();
     stats.successfulRequests++;
     
-    unlock();
+    return response;
+}
+
+bool ModbusManager::matchesRequest(const uint8_t* request, size_t requestLength,
+                                   const uint8_t* reply, size_t replyLength) {
+    if (requestLength < 2 || replyLength < 5) return false;
+    if (reply[0] != request[0]) return false;
+    if ((reply[1] & 0x7F) != request[1]) return false;
+    if ((reply[1] & 0x80) != 0) return replyLength == 5;
+    
+    // Tramas crudas de otras funciones: sólo esclavo y función
+    if (requestLength < 6) return true;
+    uint16_t quantity = ((uint16_t)request[4] << 8) | request[5];
+    
+    switch (request[1]) {
+        case MODBUS_READ_COILS:
+        case MODBUS_READ_DISCRETE_INPUTS: {
+            size_t expected = (quantity + 7) / 8;
+            return reply[2] == expected && replyLength == 5 + expected;
+        }
+        case MODBUS_READ_HOLDING_REGISTERS:
+        case MODBUS_READ_INPUT_REGISTERS: {
+            size_t expected = (size_t)quantity * 2;
+            return reply[2] == expected && replyLength == 5 + expected;
+        }
+        case MODBUS_WRITE_SINGLE_COIL:
+        case MODBUS_WRITE_SINGLE_REGISTER:
+        case MODBUS_WRITE_MULTIPLE_COILS:
+        case MODBUS_WRITE_MULTIPLE_REGISTERS:
+            // Eco de dirección y valor/cantidad
+            return replyLength == 8 && memcmp(reply + 2, request + 2, 4) == 0;
+        default:
+            return true;
+    }
+}
+
+size_t ModbusManager::buildRequest(const ModbusBatchOp& op, uint8_t* buffer, size_t size) {
+    if (size < 6) return 0;
     
-    // Callback
-    if (responseCallback != nullptr) {
-        responseCallback(response);
+    buffer[0] = op.slaveId;
+    buffer[1] = op.functionCode;
+    buffer[2] = (uint8_t)(op.address >> 8);
+    buffer[3] = (uint8_t)(op.address & 0xFF);
+    
+    switch (op.functionCode) {
+        case MODBUS_READ_COILS:
+        case MODBUS_READ_DISCRETE_INPUTS:
+            if (op.quantity == 0 || op.quantity > MODBUS_MAX_READ_BITS) return 0;
+            break;
+        
+        case MODBUS_READ_HOLDING_REGISTERS:
+        case MODBUS_READ_INPUT_REGISTERS:
+            if (op.quantity == 0 || op.quantity > MODBUS_MAX_READ_REGISTERS) return 0;
+            break;
+        
+        case MODBUS_WRITE_SINGLE_COIL:
+            if (op.values == NULL) return 0;
+            buffer[4] = op.values[0] ? 0xFF : 0x00;
+            buffer[5] = 0x00;
+            return 6;
+        
+        case MODBUS_WRITE_SINGLE_REGISTER:
+            if (op.values == NULL) return 0;
+            buffer[4] = (uint8_t)(op.values[0] >> 8);
+            buffer[5] = (uint8_t)(op.values[0] & 0xFF);
+            return 6;
+        
+        case MODBUS_WRITE_MULTIPLE_COILS: {
+            if (op.values == NULL || op.quantity == 0 || op.quantity > MODBUS_MAX_WRITE_COILS) return 0;
+            size_t byteCount = (op.quantity + 7) / 8;
+            if (7 + byteCount > size) return 0;
+            buffer[4] = (uint8_t)(op.quantity >> 8);
+            buffer[5] = (uint8_t)(op.quantity & 0xFF);
+            buffer[6] = (uint8_t)byteCount;
+            memset(buffer + 7, 0, byteCount);
+            for (uint16_t i = 0; i < op.quantity; i++) {
+                if (op.values[i]) buffer[7 + i / 8] |= (1 << (i % 8));
+            }
+            return 7 + byteCount;
+        }
+        
+        case MODBUS_WRITE_MULTIPLE_REGISTERS: {
+            if (op.values == NULL || op.quantity == 0 || op.quantity > MODBUS_MAX_WRITE_REGISTERS) return 0;
+            size_t byteCount = op.quantity * 2;
+            if (7 + byteCount > size) return 0;
+            buffer[4] = (uint8_t)(op.quantity >> 8);
+            buffer[5] = (uint8_t)(op.quantity & 0xFF);
+            buffer[6] = (uint8_t)byteCount;
+            for (uint16_t i = 0; i < op.quantity; i++) {
+                buffer[7 + i * 2] = (uint8_t)(op.values[i] >> 8);
+                buffer[7 + i * 2 + 1] = (uint8_t)(op.values[i] & 0xFF);
+            }
+            return 7 + byteCount;
+        }
+        
+        default:
+            return 0;
     }
     
-    return response;
+    // Lecturas: cantidad
+    buffer[4] = (uint8_t)(op.quantity >> 8);
+    buffer[5] = (uint8_t)(op.quantity & 0xFF);
+    return 6;
 }
 
 void ModbusManager::modbusTask(void* parameter) {
     ModbusManager* mgr = (ModbusManager*)parameter;
+    ModbusRawRequest raw;
     
     while (true) {
-        ModbusRequest req;
-        if (xQueueReceive(mgr->requestQueue, &req, pdMS_TO_TICKS(100)) == pdTRUE) {
-            mgr->processRequest(req);
+        // Tramas crudas (passthrough): despertar apenas llega una
+        if (xQueueReceive(mgr->rawQueue, &raw, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        
+        ModbusResponse response = mgr->sendRaw(raw.frame, raw.length);
+        if (mgr->rawCallback != nullptr) {
+            mgr->rawCallback(raw.token, response);
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
 }
 
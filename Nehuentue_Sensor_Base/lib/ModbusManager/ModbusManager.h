@@ -24,6 +24,7 @@
 #include <freertos/semphr.h>
 #include <freertos/queue.h>
 #include <HardwareSerial.h>
+#include <esp_timer.h>
 
 // ============================================================================
 // CONFIGURACIÓN
@@ -34,6 +35,18 @@
 #define MODBUS_MGR_QUEUE_SIZE         10      // Tamaño cola peticiones
 #define MODBUS_MGR_TASK_STACK         4096    // Stack tarea FreeRTOS
 #define MODBUS_MGR_TASK_PRIORITY      2       // Prioridad tarea
+#define MODBUS_MGR_MAX_BATCH          16      // Operaciones por lote
+#define MODBUS_MGR_FRAME_GAP_MS       20      // Silencio que cierra una trama de respuesta
+#define MODBUS_MGR_MAX_RAW_FRAME      254     // Dirección + PDU (sin CRC)
+#define MODBUS_MGR_RAW_QUEUE_SIZE     4       // Tramas crudas en espera
+#define MODBUS_MGR_MAX_TOKEN          32      // Token de correlación
+#define MODBUS_MGR_RX_TIMEOUT_SYMBOLS 2       // Silencio con que el UART entrega bytes (uart rx timeout)
+
+// Cantidades máximas por petición (especificación Modbus)
+#define MODBUS_MAX_READ_BITS          2000    // 0x01 / 0x02
+#define MODBUS_MAX_READ_REGISTERS     125     // 0x03 / 0x04
+#define MODBUS_MAX_WRITE_COILS        1968    // 0x0F
+#define MODBUS_MAX_WRITE_REGISTERS    123     // 0x10
 
 // ============================================================================
 // ESTRUCTURAS
@@ -49,7 +62,8 @@ struct ModbusResponse {
     uint8_t exceptionCode;                        ///< Código excepción (si aplica)
     uint8_t slaveId;                              ///< ID del esclavo
     uint8_t functionCode;                         ///< Código de función
-    uint32_t timestamp;                           ///< Timestamp de la respuesta
+    uint32_t timestamp;                           ///< millis() al llegar el primer byte
+    int64_t rxTimeUs;                             ///< esp_timer (us) al llegar el primer byte (0 = sin respuesta)
 };
 
 /**
@@ -73,6 +87,7 @@ struct ModbusStats {
     uint32_t timeouts;            ///< Timeouts
     uint32_t crcErrors;           ///< Errores de CRC
     uint32_t exceptions;          ///< Excepciones Modbus
+    uint32_t invalidReplies;      ///< Respuestas de otro esclavo/función o largo incorrecto
     uint32_t lastRequestTime;     ///< Timestamp última petición
     uint32_t lastResponseTime;    ///< Timestamp última respuesta
 };
@@ -103,6 +118,30 @@ struct ModbusRequest {
     size_t valueCount;
 };
 
+/**
+ * @brief Operación de un lote (executeBatch)
+ *
+ * Funciones soportadas: 0x01-0x04 (lectura, `quantity` elementos),
+ * 0x05/0x06 (escritura simple, valor en values[0]) y 0x0F/0x10
+ * (escritura múltiple, `quantity` valores; en 0x0F cada valor es un bit).
+ */
+struct ModbusBatchOp {
+    uint8_t slaveId;
+    uint8_t functionCode;
+    uint16_t address;
+    uint16_t quantity;
+    const uint16_t* values;     ///< Valores a escribir (sólo escrituras)
+};
+
+/**
+ * @brief Trama cruda encolada con sendRawAsync()
+ */
+struct ModbusRawRequest {
+    uint8_t frame[MODBUS_MGR_MAX_RAW_FRAME];
+    uint16_t length;
+    char token[MODBUS_MGR_MAX_TOKEN + 1];
+};
+
 // ============================================================================
 // CALLBACKS
 // ============================================================================
@@ -113,6 +152,22 @@ struct ModbusRequest {
  */
 typedef void (*ModbusResponseCallback)(const ModbusResponse& response);
 
+/**
+ * @brief Callback por operación de un lote
+ * @param index Índice de la operación
+ * @param response Respuesta (length == 0: timeout u operación inválida)
+ * @param elapsedUs Duración de la transacción en el bus
+ * @param context Puntero de usuario pasado a executeBatch()
+ */
+typedef void (*ModbusBatchCallback)(size_t index, const ModbusResponse& response, uint32_t elapsedUs, void* context);
+
+/**
+ * @brief Callback de una trama cruda (corre en la tarea Modbus)
+ * @param token Token de correlación pasado a sendRawAsync()
+ * @param response Respuesta; trama válida si success o exceptionCode != 0
+ */
+typedef void (*ModbusRawCallback)(const char* token, const ModbusResponse& response);
+
 // ============================================================================
 // CLASE MODBUSMANAGER
 // ============================================================================
@@ -192,6 +247,36 @@ public:
      */
     ModbusResponse writeMultipleRegisters(uint8_t slaveId, uint16_t startAddress, uint16_t quantity, uint16_t* values);
     
+    /**
+     * @brief Ejecutar un lote de operaciones seguidas en el bus
+     *
+     * Toma el bus una sola vez: ninguna otra petición se intercala entre
+     * las operaciones del lote. El callback se llama tras cada operación
+     * (dentro del lote, no debe usar ModbusMgr). No dispara onResponse().
+     * @param ops Operaciones (máx MODBUS_MGR_MAX_BATCH)
+     * @param count Cantidad de operaciones
+     * @param callback Resultado de cada operación
+     * @param context Puntero de usuario para el callback
+     * @return Cantidad de operaciones exitosas
+     */
+    size_t executeBatch(const ModbusBatchOp* ops, size_t count, ModbusBatchCallback callback, void* context = nullptr);
+    
+    /**
+     * @brief Enviar una trama cruda (dirección + PDU, el CRC se agrega)
+     * @param frame Trama sin CRC
+     * @param length Longitud (2 a MODBUS_MGR_MAX_RAW_FRAME)
+     * @return Respuesta completa (data incluye el CRC recibido)
+     */
+    ModbusResponse sendRaw(const uint8_t* frame, size_t length);
+    
+    /**
+     * @brief Encolar una trama cruda para la tarea Modbus (no bloquea)
+     *
+     * La respuesta llega por onRawResponse() con el mismo token.
+     * @return false si la cola está llena o la trama es inválida
+     */
+    bool sendRawAsync(const uint8_t* frame, size_t length, const char* token);
+    
     // ========================================================================
     // UTILIDADES
     // ========================================================================
@@ -212,6 +297,15 @@ public:
      */
     static bool verifyCRC(const uint8_t* buf, size_t len);
     
+    /**
+     * @brief Verificar que la respuesta corresponde a la petición
+     * @param request Petición sin CRC
+     * @param reply Respuesta con CRC
+     * @return true si esclavo, función y largo (o eco) coinciden
+     */
+    static bool matchesRequest(const uint8_t* request, size_t requestLength,
+                               const uint8_t* reply, size_t replyLength);
+    
     /**
      * @brief Extraer registros de una respuesta
      * @param response Respuesta Modbus
@@ -238,6 +332,11 @@ public:
      */
     void onResponse(ModbusResponseCallback callback);
     
+    /**
+     * @brief Registrar callback para respuestas de sendRawAsync()
+     */
+    void onRawResponse(ModbusRawCallback callback);
+    
     // ========================================================================
     // CONFIGURACIÓN
     // ========================================================================
@@ -254,6 +353,21 @@ public:
      */
     uint32_t getTimeout() const { return config.timeout; }
     
+    /**
+     * @brief Cambiar velocidad y pines del puerto sin reiniciar el bus
+     *
+     * Espera a que termine la transacción en curso (toma el mutex) y
+     * reconfigura el UART en el lugar: no hay end()/begin() ni pérdida de
+     * la tarea Modbus.
+     * @return false si no está inicializado
+     */
+    bool setSerialParams(unsigned long baudrate, int rxPin, int txPin);
+    
+    /**
+     * @brief Obtener configuración actual del puerto
+     */
+    const ModbusConfig& getConfig() const { return config; }
+    
     // ========================================================================
     // ESTADÍSTICAS
     // ========================================================================
@@ -269,6 +383,14 @@ public:
      */
     void resetStats();
     
+    /**
+     * @brief Restaurar contadores guardados (p. ej. del arranque anterior)
+     * 
+     * Copia los contadores; los timestamps de la última petición/respuesta
+     * se mantienen porque son de este arranque.
+     */
+    void restoreStats(const ModbusStats& saved);
+    
     /**
      * @brief Imprimir estadísticas
      */
@@ -298,17 +420,21 @@ private:
     SemaphoreHandle_t mutex;
     TaskHandle_t taskHandle;
     QueueHandle_t requestQueue;
+    QueueHandle_t rawQueue;
     
     // Estadísticas
     ModbusStats stats;
     
     // Callbacks
     ModbusResponseCallback responseCallback;
+    ModbusRawCallback rawCallback;
     
     // Métodos privados
     void lock();
     void unlock();
     ModbusResponse sendRequest(uint8_t* request, size_t length);
+    ModbusResponse transact(const uint8_t* request, size_t length);
+    static size_t buildRequest(const ModbusBatchOp& op, uint8_t* buffer, size_t size);
     void processRequest(const ModbusRequest& req);
     
     // Tarea FreeRTOS
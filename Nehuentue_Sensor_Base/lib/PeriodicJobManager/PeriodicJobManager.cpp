@@ -0,0 +1,251 @@
+/**
+ * @file PeriodicJobManager.cpp
+ * @brief Implementación del PeriodicJobManager
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "PeriodicJobManager.h"
+
+// Instancia global
+PeriodicJobManager JobMgr;
+
+// ============================================================================
+// HISTOGRAMA
+// ============================================================================
+
+void JobHistogram::add(uint32_t us) {
+    uint8_t bucket = 0;
+    if (us >= JOB_MGR_MIN_BUCKET_US) {
+        // [64,128) -> 1, [128,256) -> 2, ...
+        bucket = (31 - __builtin_clz(us)) - 5;
+        if (bucket >= JOB_MGR_BUCKETS) bucket = JOB_MGR_BUCKETS - 1;
+    }
+    counts[bucket]++;
+    if (us > maxUs) maxUs = us;
+}
+
+uint32_t JobHistogram::percentile(uint8_t percent) const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < JOB_MGR_BUCKETS; i++) {
+        total += counts[i];
+    }
+    if (total == 0) return 0;
+
+    uint32_t target = ((uint64_t)total * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < JOB_MGR_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= target) {
+            // El máximo acota mejor que el límite del bucket
+            uint32_t limit = bucketLimit(i);
+            return (limit < maxUs) ? limit : maxUs;
+        }
+    }
+    return maxUs;
+}
+
+uint32_t JobHistogram::bucketLimit(uint8_t bucket) {
+    if (bucket >= JOB_MGR_BUCKETS - 1) return UINT32_MAX;
+    return (uint32_t)JOB_MGR_MIN_BUCKET_US << bucket;
+}
+
+// ============================================================================
+// CONSTRUCTOR
+// ============================================================================
+
+PeriodicJobManager::PeriodicJobManager() {
+    memset(jobs, 0, sizeof(jobs));
+    jobCount = 0;
+    mutex = NULL;
+}
+
+// ============================================================================
+// REGISTRO
+// ============================================================================
+
+int8_t PeriodicJobManager::registerJob(const char* name, uint32_t periodMs, uint32_t deadlineMs,
+                                       JobCallback callback, uint8_t flags) {
+    if (mutex == NULL) {
+        mutex = xSemaphoreCreateMutex();
+        if (mutex == NULL) {
+            Serial.println("[JOBS] ERROR: No se pudo crear mutex");
+            return -1;
+        }
+    }
+
+    lock();
+
+    // Un manager que se reinicia (end/begin) recupera su trabajo
+    for (uint8_t i = 0; i < jobCount; i++) {
+        if (strcmp(jobs[i].stats.name, name) == 0) {
+            jobs[i].stats.periodMs = periodMs;
+            jobs[i].stats.deadlineMs = deadlineMs;
+            jobs[i].stats.flags = flags;
+            jobs[i].callback = callback;
+            jobs[i].lastStartUs = 0;
+            unlock();
+            return i;
+        }
+    }
+
+    if (jobCount >= JOB_MGR_MAX_JOBS) {
+        unlock();
+        Serial.printf("[JOBS] ERROR: Sin lugar para '%s'\n", name);
+        return -1;
+    }
+
+    int8_t id = jobCount++;
+    Job& job = jobs[id];
+    memset(&job, 0, sizeof(Job));
+    strncpy(job.stats.name, name, JOB_MGR_MAX_NAME);
+    job.stats.periodMs = periodMs;
+    job.stats.deadlineMs = deadlineMs;
+    job.stats.flags = flags;
+    job.callback = callback;
+
+    unlock();
+    return id;
+}
+
+// ============================================================================
+// MEDICIÓN
+// ============================================================================
+
+void PeriodicJobManager::start(int8_t id) {
+    if (id < 0 || id >= jobCount) return;
+
+    int64_t now = esp_timer_get_time();
+    Job& job = jobs[id];
+    int64_t periodUs = (int64_t)job.stats.periodMs * 1000;
+
+    lock();
+
+    if (job.lastStartUs == 0 || (job.stats.flags & JOB_FLAG_ON_DEMAND)) {
+        // Primera ejecución (o a pedido): no hay arranque esperado
+        job.expectedUs = now;
+    } else {
+        job.expectedUs = job.lastStartUs + periodUs;
+        int64_t late = now - job.expectedUs;
+
+        // Arrancar antes (p. ej. una tarea que despierta por notificación) no es jitter
+        if (late < 0) late = 0;
+        if (late >= periodUs && periodUs > 0) {
+            job.stats.skipped += late / periodUs;
+        }
+        job.stats.jitter.add(late > UINT32_MAX ? UINT32_MAX : (uint32_t)late);
+    }
+
+    job.startUs = now;
+    job.lastStartUs = now;
+
+    unlock();
+}
+
+void PeriodicJobManager::finish(int8_t id) {
+    if (id < 0 || id >= jobCount) return;
+
+    int64_t now = esp_timer_get_time();
+    Job& job = jobs[id];
+
+    lock();
+
+    int64_t runtime = now - job.startUs;
+    job.stats.runtime.add(runtime > UINT32_MAX ? UINT32_MAX : (uint32_t)runtime);
+    job.stats.runs++;
+
+    if (now - job.expectedUs > (int64_t)job.stats.deadlineMs * 1000) {
+        job.stats.misses++;
+    }
+
+    unlock();
+}
+
+void PeriodicJobManager::runDue() {
+    int64_t now = esp_timer_get_time();
+
+    for (uint8_t i = 0; i < jobCount; i++) {
+        Job& job = jobs[i];
+        if (job.callback == nullptr) continue;
+
+        // Primera vez: arranca un período después del registro, como los
+        // antiguos "if (millis() - last > período)"
+        if (job.lastStartUs == 0) {
+            job.lastStartUs = now;
+            continue;
+        }
+        if (now - job.lastStartUs < (int64_t)job.stats.periodMs * 1000) continue;
+
+        start(i);
+        job.callback();
+        finish(i);
+    }
+}
+
+// ============================================================================
+// INFORMACIÓN
+// ============================================================================
+
+bool PeriodicJobManager::getJob(uint8_t index, JobStats& out) {
+    if (index >= jobCount) return false;
+
+    lock();
+    out = jobs[index].stats;
+    unlock();
+    return true;
+}
+
+uint32_t PeriodicJobManager::getTotalMisses() {
+    uint32_t total = 0;
+    lock();
+    for (uint8_t i = 0; i < jobCount; i++) {
+        total += jobs[i].stats.misses;
+    }
+    unlock();
+    return total;
+}
+
+void PeriodicJobManager::resetStats() {
+    lock();
+    for (uint8_t i = 0; i < jobCount; i++) {
+        JobStats& stats = jobs[i].stats;
+        stats.runs = 0;
+        stats.misses = 0;
+        stats.skipped = 0;
+        memset(&stats.jitter, 0, sizeof(JobHistogram));
+        memset(&stats.runtime, 0, sizeof(JobHistogram));
+    }
+    unlock();
+}
+
+void PeriodicJobManager::printStatus() {
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   Periodic Jobs - Estado               ║");
+    Serial.println("╚════════════════════════════════════════╝");
+    Serial.println("  Trabajo          Período  Plazo   Ejec.    Vencidos  Jitter p99  Dur. p99   Dur. máx");
+
+    for (uint8_t i = 0; i < jobCount; i++) {
+        JobStats stats;
+        getJob(i, stats);
+        Serial.printf("  %-16s %6lu  %6lu  %8lu  %8lu  %8lu us  %8lu us  %8lu us\n",
+                      stats.name, stats.periodMs, stats.deadlineMs, stats.runs, stats.misses,
+                      stats.jitter.percentile(99), stats.runtime.percentile(99), stats.runtime.maxUs);
+    }
+    Serial.println("════════════════════════════════════════\n");
+}
+
+// ============================================================================
+// MÉTODOS PRIVADOS
+// ============================================================================
+
+void PeriodicJobManager::lock() {
+    if (mutex != NULL) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+    }
+}
+
+void PeriodicJobManager::unlock() {
+    if (mutex != NULL) {
+        xSemaphoreGive(mutex);
+    }
+}
@@ -0,0 +1,154 @@
+/**
+ * @file PeriodicJobManager.h
+ * @brief Registro de trabajos periódicos con jitter, duración y plazos vencidos
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @details
+ * Cada trabajo periódico del firmware (ciclo de polling, vuelta de la tarea
+ * MQTT, reconexión, NTP, chequeos de loop()) se registra con su período y
+ * su plazo. Al medir cada ejecución se acumulan:
+ *
+ * - Jitter de arranque: cuánto después de lo esperado empezó
+ *   (esperado = arranque anterior + período).
+ * - Duración: cuánto tardó.
+ * - Plazos vencidos: terminó más de deadline después de lo esperado.
+ * - Períodos saltados: arrancó tan tarde que no hubo ejecución en uno o
+ *   más períodos (informativo; un plazo mayor al período los tolera).
+ *
+ * Los histogramas son logarítmicos (64 us, 128 us, ... ~1 s), sin heap y de
+ * costo constante: sirven para ver p99 y colas sin guardar muestras.
+ *
+ * Dos formas de uso:
+ * @code
+ * // 1) Trabajos con su propia tarea: se marcan inicio y fin
+ * int8_t job = JobMgr.registerJob("poll_cycle", 10, 100);
+ * JobMgr.start(job);
+ * ...trabajo...
+ * JobMgr.finish(job);
+ *
+ * // 2) Trabajos de loop(): el registro los ejecuta al vencer
+ * JobMgr.registerJob("mem_check", 60000, 1000, checkMemory);
+ * void loop() { JobMgr.runDue(); }
+ * @endcode
+ */
+
+#ifndef PERIODIC_JOB_MANAGER_H
+#define PERIODIC_JOB_MANAGER_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// ============================================================================
+// CONSTANTES Y CONFIGURACIÓN
+// ============================================================================
+
+#define JOB_MGR_VERSION "1.0.0"
+#define JOB_MGR_MAX_JOBS 12
+#define JOB_MGR_MAX_NAME 15
+#define JOB_MGR_BUCKETS 16
+#define JOB_MGR_MIN_BUCKET_US 64              // Bucket 0: < 64 us; cada uno dobla el anterior
+
+// Flags de registro
+#define JOB_FLAG_NONE 0x00
+#define JOB_FLAG_ON_DEMAND 0x01               // Corre sólo cuando hace falta (p. ej. reconexión):
+                                              // sin jitter ni períodos saltados, sólo duración y plazo
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+typedef void (*JobCallback)();
+
+/**
+ * @brief Histograma logarítmico en microsegundos
+ */
+struct JobHistogram {
+    uint32_t counts[JOB_MGR_BUCKETS];
+    uint32_t maxUs;
+
+    void add(uint32_t us);
+
+    /**
+     * @brief Cota superior del bucket que contiene el percentil
+     * @param percent 1-100
+     */
+    uint32_t percentile(uint8_t percent) const;
+
+    static uint32_t bucketLimit(uint8_t bucket);
+};
+
+/**
+ * @brief Estado y estadísticas de un trabajo
+ */
+struct JobStats {
+    char name[JOB_MGR_MAX_NAME + 1];
+    uint32_t periodMs;
+    uint32_t deadlineMs;
+    uint8_t flags;
+    uint32_t runs;
+    uint32_t misses;            ///< Plazos vencidos
+    uint32_t skipped;           ///< Períodos enteros sin ejecución
+    JobHistogram jitter;        ///< Arranque - esperado
+    JobHistogram runtime;       ///< Duración
+};
+
+// ============================================================================
+// CLASE PRINCIPAL
+// ============================================================================
+
+class PeriodicJobManager {
+public:
+    PeriodicJobManager();
+
+    /**
+     * @brief Registra un trabajo (idempotente por nombre)
+     * @param deadlineMs Plazo desde el arranque esperado hasta terminar
+     * @param callback Opcional: lo ejecuta runDue() cuando vence
+     * @return Identificador, o -1 si no hay lugar
+     */
+    int8_t registerJob(const char* name, uint32_t periodMs, uint32_t deadlineMs,
+                       JobCallback callback = nullptr, uint8_t flags = JOB_FLAG_NONE);
+
+    /**
+     * @brief Marca inicio/fin de una ejecución (desde la tarea del trabajo)
+     */
+    void start(int8_t job);
+    void finish(int8_t job);
+
+    /**
+     * @brief Ejecuta los trabajos con callback cuyo período venció
+     */
+    void runDue();
+
+    uint8_t getJobCount() const { return jobCount; }
+    bool getJob(uint8_t index, JobStats& out);
+    uint32_t getTotalMisses();
+    void resetStats();
+    void printStatus();
+
+private:
+    struct Job {
+        JobStats stats;
+        JobCallback callback;
+        int64_t lastStartUs;    // 0 = nunca
+        int64_t expectedUs;     // Arranque esperado de la ejecución en curso
+        int64_t startUs;
+    };
+
+    Job jobs[JOB_MGR_MAX_JOBS];
+    uint8_t jobCount;
+    SemaphoreHandle_t mutex;
+
+    void lock();
+    void unlock();
+};
+
+// ============================================================================
+// INSTANCIA GLOBAL
+// ============================================================================
+extern PeriodicJobManager JobMgr;
+
+#endif // PERIODIC_JOB_MANAGER_H
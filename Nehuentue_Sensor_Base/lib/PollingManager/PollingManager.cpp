@@ -0,0 +1,442 @@
+/**
+ * @file PollingManager.cpp
+ * @brief Implementación del PollingManager
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "PollingManager.h"
+
+// Instancia global
+PollingManager PollMgr;
+
+// ============================================================================
+// CONSTRUCTOR
+// ============================================================================
+
+PollingManager::PollingManager() {
+    active = 0;
+    pending = false;
+    memset(slots, 0, sizeof(slots));
+    memset(state, 0, sizeof(state));
+    memset(batchIndex, 0, sizeof(batchIndex));
+    memset(&stats, 0, sizeof(PollingStats));
+    mutex = NULL;
+    taskHandle = NULL;
+    running = false;
+    cycleJob = -1;
+    sampleCallback = nullptr;
+}
+
+// ============================================================================
+// INICIALIZACIÓN
+// ============================================================================
+
+bool PollingManager::begin(const PollPlan& plan) {
+    if (taskHandle != NULL) {
+        Serial.println("[POLL MGR] Ya inicializado");
+        return true;
+    }
+
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   Polling Manager v1.0                 ║");
+    Serial.println("╚════════════════════════════════════════╝");
+
+    const char* reason = nullptr;
+    if (!validate(plan, &reason)) {
+        Serial.printf("[POLL MGR] ERROR: Plan inválido (%s)\n", reason);
+        return false;
+    }
+
+    if (!ModbusMgr.isInitialized()) {
+        Serial.println("[POLL MGR] ERROR: ModbusManager no inicializado");
+        return false;
+    }
+
+    if (mutex == NULL) {
+        mutex = xSemaphoreCreateMutex();
+        if (mutex == NULL) {
+            Serial.println("[POLL MGR] ERROR: No se pudo crear mutex");
+            return false;
+        }
+    }
+
+    // Plan inicial: todos los puntos arrancan ya
+    active = 0;
+    pending = false;
+    slots[0].plan = plan;
+    slots[0].generation = 1;
+    slots[0].serialChanged = false;
+    memset(slots[0].inherit, -1, sizeof(slots[0].inherit));
+
+    uint32_t now = millis();
+    memset(state, 0, sizeof(state));
+    for (uint8_t i = 0; i < plan.count; i++) {
+        state[i].nextDue = now;
+    }
+    stats.generation = 1;
+
+    // Alinear el puerto si el plan trae otros parámetros
+    const ModbusConfig& port = ModbusMgr.getConfig();
+    if (port.baudrate != plan.serial.baudrate || port.rxPin != plan.serial.rxPin ||
+        port.txPin != plan.serial.txPin) {
+        ModbusMgr.setSerialParams(plan.serial.baudrate, plan.serial.rxPin, plan.serial.txPin);
+    }
+
+    // Un ciclo que termina más de MIN_INTERVAL tarde atrasa las lecturas
+    cycleJob = JobMgr.registerJob("poll_cycle", POLLING_MGR_TICK_MS, POLLING_MGR_MIN_INTERVAL_MS);
+
+    running = true;
+    BaseType_t result = xTaskCreate(pollTask, "poll_task", POLLING_MGR_TASK_STACK_SIZE,
+                                    this, POLLING_MGR_TASK_PRIORITY, &taskHandle);
+    if (result != pdPASS) {
+        taskHandle = NULL;
+        running = false;
+        Serial.println("[POLL MGR] ERROR: No se pudo crear tarea");
+        return false;
+    }
+
+    Serial.printf("  Puntos: %u\n", plan.count);
+    Serial.printf("  Puerto: %lu bps (RX=%d, TX=%d)\n", plan.serial.baudrate,
+                  plan.serial.rxPin, plan.serial.txPin);
+    Serial.println("════════════════════════════════════════\n");
+    return true;
+}
+
+void PollingManager::end() {
+    if (taskHandle == NULL) return;
+
+    // La tarea termina el lote en curso y sale (no queda el bus tomado)
+    running = false;
+    while (taskHandle != NULL) {
+        vTaskDelay(pdMS_TO_TICKS(POLLING_MGR_TICK_MS));
+    }
+
+    adoptPending();
+    Serial.println("[POLL MGR] Finalizado");
+}
+
+// ============================================================================
+// RECONFIGURACIÓN
+// ============================================================================
+
+PollApplyStatus PollingManager::apply(const PollPlan& plan, PollDiff* diff, const char** reason) {
+    if (!validate(plan, reason)) {
+        return POLL_APPLY_INVALID;
+    }
+
+    if (mutex == NULL) {
+        mutex = xSemaphoreCreateMutex();
+        if (mutex == NULL) {
+            if (reason != nullptr) *reason = "no_memory";
+            return POLL_APPLY_INVALID;
+        }
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    // El slot libre nunca lo lee la tarea: se escribe sin apuro. Si ya había
+    // un pendiente sin adoptar, se reemplaza (se compara siempre contra el activo)
+    const PlanSlot& current = slots[active];
+    PlanSlot& next = slots[active ^ 1];
+    next.plan = plan;
+    next.generation = current.generation + 1;
+
+    PollDiff result;
+    diffPlans(current.plan, next, result);
+    pending = true;
+
+    xSemaphoreGive(mutex);
+
+    Serial.printf("[POLL MGR] Plan #%lu: +%u ~%u -%u =%u%s\n", result.generation,
+                  result.added, result.changed, result.removed, result.unchanged,
+                  result.serialChanged ? " (puerto)" : "");
+
+    // Sin tarea no hay ciclo en curso: adoptar ya
+    if (taskHandle == NULL) {
+        adoptPending();
+    }
+
+    if (diff != nullptr) {
+        *diff = result;
+    }
+    return POLL_APPLY_OK;
+}
+
+bool PollingManager::validate(const PollPlan& plan, const char** reason) {
+    const char* error = nullptr;
+
+    if (plan.count > POLLING_MGR_MAX_POINTS) {
+        error = "too_many_points";
+    } else if (plan.serial.baudrate < 1200 || plan.serial.baudrate > 921600) {
+        error = "invalid_baudrate";
+    } else if (plan.serial.rxPin < 0 || plan.serial.txPin < 0) {
+        error = "invalid_pins";
+    }
+
+    for (uint8_t i = 0; error == nullptr && i < plan.count; i++) {
+        const PollPoint& point = plan.points[i];
+        size_t nameLength = strnlen(point.name, sizeof(point.name));
+
+        if (nameLength == 0 || nameLength >= sizeof(point.name)) {
+            error = "invalid_name";
+        } else if (point.intervalMs < POLLING_MGR_MIN_INTERVAL_MS) {
+            error = "invalid_interval";
+        } else if (point.functionCode == MODBUS_READ_COILS ||
+                   point.functionCode == MODBUS_READ_DISCRETE_INPUTS) {
+            if (point.quantity == 0 || point.quantity > 2000) error = "invalid_count";
+        } else if (point.functionCode == MODBUS_READ_HOLDING_REGISTERS ||
+                   point.functionCode == MODBUS_READ_INPUT_REGISTERS) {
+            if (point.quantity == 0 || point.quantity > 125) error = "invalid_count";
+        } else {
+            error = "invalid_function";
+        }
+
+        for (uint8_t j = 0; error == nullptr && j < i; j++) {
+            if (strcmp(plan.points[j].name, point.name) == 0) {
+                error = "duplicate_name";
+            }
+        }
+    }
+
+    if (error != nullptr && reason != nullptr) {
+        *reason = error;
+    }
+    return error == nullptr;
+}
+
+void PollingManager::getPlan(PollPlan& plan) {
+    if (mutex == NULL) {
+        plan = slots[active].plan;
+        return;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    plan = slots[pending ? (active ^ 1) : active].plan;
+    xSemaphoreGive(mutex);
+}
+
+bool PollingManager::getPointState(const char* name, PollPointState& pointState) {
+    if (mutex == NULL || name == nullptr) return false;
+
+    bool found = false;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    const PollPlan& plan = slots[active].plan;
+    for (uint8_t i = 0; i < plan.count; i++) {
+        if (strcmp(plan.points[i].name, name) == 0) {
+            pointState = state[i];
+            found = true;
+            break;
+        }
+    }
+    xSemaphoreGive(mutex);
+    return found;
+}
+
+// ============================================================================
+// TAREA DE POLLING
+// ============================================================================
+
+void PollingManager::pollTask(void* parameter) {
+    PollingManager* mgr = (PollingManager*)parameter;
+
+    const TickType_t period = pdMS_TO_TICKS(POLLING_MGR_TICK_MS);
+    TickType_t lastWake = xTaskGetTickCount();
+
+    while (mgr->running) {
+        JobMgr.start(mgr->cycleJob);
+        // Punto de quiescencia: entre ciclos no hay lecturas del plan en curso
+        mgr->adoptPending();
+        mgr->pollDue();
+        JobMgr.finish(mgr->cycleJob);
+
+        // Período fijo; tras un lote largo se retoma desde ahora, sin
+        // ráfagas de ciclos para "recuperar" ticks
+        if (xTaskGetTickCount() - lastWake > period) {
+            lastWake = xTaskGetTickCount();
+        }
+        vTaskDelayUntil(&lastWake, period);
+    }
+
+    mgr->taskHandle = NULL;
+    vTaskDelete(NULL);
+}
+
+void PollingManager::adoptPending() {
+    if (!pending || mutex == NULL) return;
+
+    // Si un escritor está armando el plan, se adopta en el próximo ciclo
+    if (xSemaphoreTake(mutex, 0) != pdTRUE) return;
+    if (!pending) {
+        xSemaphoreGive(mutex);
+        return;
+    }
+
+    const PlanSlot& next = slots[active ^ 1];
+    uint32_t now = millis();
+
+    // Sólo los puntos nuevos o modificados arrancan de cero
+    PollPointState nextState[POLLING_MGR_MAX_POINTS];
+    for (uint8_t i = 0; i < next.plan.count; i++) {
+        if (next.inherit[i] >= 0) {
+            nextState[i] = state[next.inherit[i]];
+        } else {
+            memset(&nextState[i], 0, sizeof(PollPointState));
+            nextState[i].nextDue = now;
+        }
+    }
+    memcpy(state, nextState, sizeof(PollPointState) * next.plan.count);
+
+    if (next.serialChanged) {
+        if (!ModbusMgr.setSerialParams(next.plan.serial.baudrate, next.plan.serial.rxPin,
+                                       next.plan.serial.txPin)) {
+            Serial.println("[POLL MGR] ERROR: No se pudo reconfigurar el puerto");
+        }
+    }
+
+    active ^= 1;
+    pending = false;
+    stats.swaps++;
+    stats.generation = next.generation;
+
+    xSemaphoreGive(mutex);
+
+    Serial.printf("[POLL MGR] ✓ Plan #%lu activo (%u puntos)\n", stats.generation, next.plan.count);
+}
+
+void PollingManager::pollDue() {
+    const PollPlan& plan = slots[active].plan;
+    uint32_t now = millis();
+
+    ModbusBatchOp ops[POLLING_MGR_MAX_POINTS];
+    size_t count = 0;
+
+    for (uint8_t i = 0; i < plan.count; i++) {
+        PollPointState& pointState = state[i];
+        if ((int32_t)(now - pointState.nextDue) < 0) continue;
+
+        const PollPoint& point = plan.points[i];
+        ops[count].slaveId = point.slaveId;
+        ops[count].functionCode = point.functionCode;
+        ops[count].address = point.address;
+        ops[count].quantity = point.quantity;
+        ops[count].values = nullptr;
+        batchIndex[count] = i;
+        count++;
+
+        // Mantener la cadencia; si quedó atrás no acumular lecturas
+        pointState.nextDue += point.intervalMs;
+        if ((int32_t)(now - pointState.nextDue) >= 0) {
+            pointState.nextDue = now + point.intervalMs;
+        }
+    }
+
+    if (count == 0) return;
+
+    stats.cycles++;
+    ModbusMgr.executeBatch(ops, count, onBatchResult, this);
+}
+
+void PollingManager::onBatchResult(size_t index, const ModbusResponse& response, uint32_t elapsedUs, void* context) {
+    PollingManager* mgr = (PollingManager*)context;
+    uint8_t i = mgr->batchIndex[index];
+    PollPointState& pointState = mgr->state[i];
+
+    pointState.reads++;
+    mgr->stats.reads++;
+    if (response.success) {
+        pointState.lastRead = millis();
+    } else {
+        pointState.failures++;
+        mgr->stats.failures++;
+    }
+
+    if (mgr->sampleCallback != nullptr) {
+        mgr->sampleCallback(mgr->slots[mgr->active].plan.points[i], response);
+    }
+}
+
+// ============================================================================
+// INFORMACIÓN
+// ============================================================================
+
+void PollingManager::printStatus() {
+    PollPlan plan;
+    getPlan(plan);
+
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   Polling Manager - Estado             ║");
+    Serial.println("╚════════════════════════════════════════╝");
+    Serial.printf("  Plan: #%lu (%u puntos)%s\n", stats.generation, plan.count,
+                  pending ? " [cambio pendiente]" : "");
+    Serial.printf("  Ciclos: %lu, lecturas: %lu, fallos: %lu, cambios: %lu\n",
+                  stats.cycles, stats.reads, stats.failures, stats.swaps);
+    for (uint8_t i = 0; i < plan.count; i++) {
+        const PollPoint& point = plan.points[i];
+        PollPointState pointState;
+        bool hasState = getPointState(point.name, pointState);
+        Serial.printf("  %-16s slave %u fn %u @%u x%u cada %lu ms",
+                      point.name, point.slaveId, point.functionCode,
+                      point.address, point.quantity, point.intervalMs);
+        if (hasState) {
+            Serial.printf(" (%lu/%lu fallos)", pointState.failures, pointState.reads);
+        }
+        Serial.println();
+    }
+    Serial.println("════════════════════════════════════════\n");
+}
+
+// ============================================================================
+// MÉTODOS PRIVADOS
+// ============================================================================
+
+void PollingManager::diffPlans(const PollPlan& current, PlanSlot& next, PollDiff& diff) {
+    memset(&diff, 0, sizeof(PollDiff));
+    diff.generation = next.generation;
+
+    bool matched[POLLING_MGR_MAX_POINTS] = {false};
+
+    for (uint8_t i = 0; i < next.plan.count; i++) {
+        const PollPoint& point = next.plan.points[i];
+        bool found = false;
+        next.inherit[i] = -1;
+
+        for (uint8_t j = 0; j < current.count; j++) {
+            if (strcmp(current.points[j].name, point.name) != 0) continue;
+
+            found = true;
+            matched[j] = true;
+            if (samePoint(current.points[j], point)) {
+                next.inherit[i] = (int8_t)j;
+                diff.unchanged++;
+            } else {
+                diff.changed++;
+            }
+            break;
+        }
+
+        if (!found) {
+            diff.added++;
+        }
+    }
+
+    for (uint8_t j = 0; j < current.count; j++) {
+        if (!matched[j]) diff.removed++;
+    }
+
+    next.serialChanged = current.serial.baudrate != next.plan.serial.baudrate ||
+                         current.serial.rxPin != next.plan.serial.rxPin ||
+                         current.serial.txPin != next.plan.serial.txPin;
+    diff.serialChanged = next.serialChanged;
+}
+
+bool PollingManager::samePoint(const PollPoint& a, const PollPoint& b) {
+    // Campo a campo: memcmp incluiría el relleno de la estructura
+    return a.slaveId == b.slaveId &&
+           a.functionCode == b.functionCode &&
+           a.address == b.address &&
+           a.quantity == b.quantity &&
+           a.intervalMs == b.intervalMs &&
+           a.multiplier == b.multiplier &&
+           a.offset == b.offset;
+}
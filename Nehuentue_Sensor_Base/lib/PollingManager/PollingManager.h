@@ -0,0 +1,227 @@
+/**
+ * @file PollingManager.h
+ * @brief Polling periódico Modbus con plan reconfigurable en caliente
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @details
+ * Una tarea dedicada recorre el plan activo (lista de puntos Modbus con su
+ * intervalo) y lee los puntos vencidos en un solo lote de ModbusManager.
+ *
+ * Reconfiguración estilo RCU:
+ * - El plan activo es inmutable: la tarea lo lee sin locks durante todo
+ *   el ciclo.
+ * - apply() copia el plan nuevo en el buffer libre y lo deja pendiente
+ *   (varios apply() seguidos sobrescriben el mismo pendiente).
+ * - Entre ciclos la tarea adopta el pendiente con un intercambio de índice:
+ *   nunca se lee un plan a medio escribir y no hay ciclos perdidos.
+ *
+ * Los puntos se identifican por nombre. Un punto que no cambió conserva su
+ * estado (próxima lectura y contadores); sólo los agregados/modificados
+ * arrancan de cero. Si cambian velocidad o pines, el UART se reconfigura
+ * en el lugar (ModbusManager::setSerialParams), sin reiniciar el bus.
+ *
+ * Uso:
+ * @code
+ * PollPlan plan;
+ * plan.serial = {9600, 20, 21};
+ * plan.count = 1;
+ * strcpy(plan.points[0].name, "caudal");
+ * plan.points[0].slaveId = 1;
+ * plan.points[0].functionCode = MODBUS_READ_HOLDING_REGISTERS;
+ * plan.points[0].address = 0;
+ * plan.points[0].quantity = 2;
+ * plan.points[0].intervalMs = 1000;
+ *
+ * PollMgr.onSample(onSample);
+ * PollMgr.begin(plan);
+ * ...
+ * PollMgr.apply(nuevoPlan, &diff);   // desde cualquier tarea
+ * @endcode
+ */
+
+#ifndef POLLING_MANAGER_H
+#define POLLING_MANAGER_H
+
+#include <Arduino.h>
+#include <ModbusManager.h>
+#include <PeriodicJobManager.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+// ============================================================================
+// CONSTANTES Y CONFIGURACIÓN
+// ============================================================================
+
+#define POLLING_MGR_VERSION "1.0.0"
+#define POLLING_MGR_MAX_POINTS 16
+#define POLLING_MGR_MAX_NAME 23
+#define POLLING_MGR_MIN_INTERVAL_MS 100
+#define POLLING_MGR_TICK_MS 10                // Granularidad del ciclo
+#define POLLING_MGR_TASK_STACK_SIZE 6144       // Incluye el JSON de telemetría del callback
+#define POLLING_MGR_TASK_PRIORITY 2
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+/**
+ * @brief Punto Modbus a leer periódicamente
+ */
+struct PollPoint {
+    char name[POLLING_MGR_MAX_NAME + 1];  ///< Identificador único en el plan
+    uint8_t slaveId;
+    uint8_t functionCode;       ///< 0x01-0x04
+    uint16_t address;
+    uint16_t quantity;          ///< Registros (o bits para 0x01/0x02)
+    uint32_t intervalMs;
+    float multiplier;
+    float offset;
+};
+
+/**
+ * @brief Parámetros del puerto serie asociados al plan
+ */
+struct PollSerialParams {
+    uint32_t baudrate;
+    int8_t rxPin;
+    int8_t txPin;
+};
+
+/**
+ * @brief Conjunto completo de puntos + puerto
+ */
+struct PollPlan {
+    PollSerialParams serial;
+    uint8_t count;
+    PollPoint points[POLLING_MGR_MAX_POINTS];
+
+    PollPlan() {
+        memset(this, 0, sizeof(PollPlan));
+    }
+};
+
+/**
+ * @brief Diferencias entre el plan activo y el aplicado
+ */
+struct PollDiff {
+    uint8_t added;
+    uint8_t changed;
+    uint8_t removed;
+    uint8_t unchanged;
+    bool serialChanged;
+    uint32_t generation;        ///< Generación asignada al plan nuevo
+};
+
+/**
+ * @brief Estado de ejecución de un punto del plan activo
+ */
+struct PollPointState {
+    uint32_t nextDue;           ///< millis() de la próxima lectura
+    uint32_t reads;
+    uint32_t failures;
+    uint32_t lastRead;          ///< millis() de la última lectura exitosa
+};
+
+struct PollingStats {
+    uint32_t cycles;            ///< Ciclos con al menos una lectura
+    uint32_t reads;
+    uint32_t failures;
+    uint32_t swaps;             ///< Planes adoptados
+    uint32_t generation;        ///< Generación del plan activo
+};
+
+enum PollApplyStatus {
+    POLL_APPLY_OK = 0,
+    POLL_APPLY_INVALID          ///< Plan rechazado (ver reason)
+};
+
+/**
+ * @brief Callback por lectura (corre en la tarea de polling con el bus tomado:
+ *        debe ser breve y no llamar a ModbusMgr)
+ */
+typedef void (*PollSampleCallback)(const PollPoint& point, const ModbusResponse& response);
+
+// ============================================================================
+// CLASE PRINCIPAL
+// ============================================================================
+
+class PollingManager {
+public:
+    PollingManager();
+
+    /**
+     * @brief Adopta el plan inicial e inicia la tarea de polling
+     * @note Requiere ModbusMgr inicializado
+     */
+    bool begin(const PollPlan& plan);
+    void end();
+
+    /**
+     * @brief Publica un plan nuevo (se adopta al terminar el ciclo en curso)
+     * @param diff Opcional: diferencias contra el plan activo
+     * @param reason Opcional: motivo del rechazo si es inválido
+     */
+    PollApplyStatus apply(const PollPlan& plan, PollDiff* diff = nullptr, const char** reason = nullptr);
+
+    /**
+     * @brief Valida un plan sin aplicarlo
+     */
+    static bool validate(const PollPlan& plan, const char** reason = nullptr);
+
+    /**
+     * @brief Copia del plan vigente (el pendiente si hay uno sin adoptar)
+     */
+    void getPlan(PollPlan& plan);
+
+    /**
+     * @brief Estado de un punto del plan activo
+     */
+    bool getPointState(const char* name, PollPointState& state);
+
+    void onSample(PollSampleCallback callback) { sampleCallback = callback; }
+
+    PollingStats getStats() const { return stats; }
+    bool isRunning() const { return taskHandle != NULL; }
+    void printStatus();
+
+private:
+    /**
+     * @brief Buffer de plan con la correspondencia de estado al anterior
+     */
+    struct PlanSlot {
+        PollPlan plan;
+        int8_t inherit[POLLING_MGR_MAX_POINTS];  ///< Índice en el plan activo, -1 = nuevo
+        bool serialChanged;
+        uint32_t generation;
+    };
+
+    PlanSlot slots[2];
+    uint8_t active;             // Slot leído por la tarea
+    bool pending;               // slots[active ^ 1] espera ser adoptado
+
+    PollPointState state[POLLING_MGR_MAX_POINTS];
+    uint8_t batchIndex[POLLING_MGR_MAX_POINTS];  // Posición en el lote -> punto
+
+    SemaphoreHandle_t mutex;    // Escritores y el intercambio (no la lectura del plan)
+    TaskHandle_t taskHandle;
+    volatile bool running;      // La tarea sale sola al terminar el ciclo
+    int8_t cycleJob;            // Ciclo medido en JobMgr
+    PollSampleCallback sampleCallback;
+    PollingStats stats;
+
+    static void pollTask(void* parameter);
+    void adoptPending();
+    void pollDue();
+    void diffPlans(const PollPlan& current, PlanSlot& next, PollDiff& diff);
+    static bool samePoint(const PollPoint& a, const PollPoint& b);
+    static void onBatchResult(size_t index, const ModbusResponse& response, uint32_t elapsedUs, void* context);
+};
+
+// ============================================================================
+// INSTANCIA GLOBAL
+// ============================================================================
+extern PollingManager PollMgr;
+
+#endif // POLLING_MANAGER_H
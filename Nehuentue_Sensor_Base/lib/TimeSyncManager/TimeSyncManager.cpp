@@ -0,0 +1,363 @@
+/**
+ * @file TimeSyncManager.cpp
+ * @brief Implementación del TimeSyncManager
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "TimeSyncManager.h"
+#include <WiFi.h>
+#include <sys/time.h>
+
+// Instancia global
+TimeSyncManager TimeMgr;
+
+// Segundos entre 1900 (época NTP) y 1970 (época Unix)
+#define NTP_UNIX_OFFSET 2208988800LL
+#define NTP_PACKET_SIZE 48
+
+static int64_t ntpToUnixUs(const uint8_t* field) {
+    uint32_t seconds = ((uint32_t)field[0] << 24) | ((uint32_t)field[1] << 16) |
+                       ((uint32_t)field[2] << 8) | field[3];
+    uint32_t fraction = ((uint32_t)field[4] << 24) | ((uint32_t)field[5] << 16) |
+                        ((uint32_t)field[6] << 8) | field[7];
+
+    int64_t unixSeconds = (int64_t)seconds - NTP_UNIX_OFFSET;
+    // Era 1 (desde febrero de 2036): el contador de segundos dio la vuelta
+    if ((seconds & 0x80000000UL) == 0) {
+        unixSeconds += 0x100000000LL;
+    }
+    return unixSeconds * 1000000LL + (int64_t)(((uint64_t)fraction * 1000000ULL) >> 32);
+}
+
+// ============================================================================
+// CONSTRUCTOR
+// ============================================================================
+
+TimeSyncManager::TimeSyncManager() {
+    memset(server, 0, sizeof(server));
+    port = TIME_SYNC_DEFAULT_PORT;
+    intervalMs = 300000;
+    synced = false;
+    anchorUs = 0;
+    anchorOffsetUs = 0;
+    slewUs = 0;
+    slewDurationUs = 0;
+    driftPpm = 0.0;
+    lastMeasureUs = 0;
+    lastMeasureOffsetUs = 0;
+    memset(&stats, 0, sizeof(TimeSyncStats));
+    mutex = NULL;
+    taskHandle = NULL;
+    running = false;
+    roundJob = -1;
+}
+
+// ============================================================================
+// INICIALIZACIÓN
+// ============================================================================
+
+bool TimeSyncManager::begin(const char* server, uint16_t port, uint32_t intervalMs) {
+    if (taskHandle != NULL) return true;
+
+    if (mutex == NULL) {
+        mutex = xSemaphoreCreateMutex();
+        if (mutex == NULL) {
+            Serial.println("[TIME] ERROR: No se pudo crear mutex");
+            return false;
+        }
+    }
+
+    strncpy(this->server, server, TIME_SYNC_MAX_SERVER);
+    this->port = port;
+    this->intervalMs = intervalMs;
+
+    // Una ronda completa: todas las consultas con su espera máxima
+    roundJob = JobMgr.registerJob("ntp_sync", intervalMs,
+                                  TIME_SYNC_SAMPLES * (TIME_SYNC_REPLY_TIMEOUT_MS + 50));
+
+    running = true;
+    BaseType_t result = xTaskCreate(syncTask, "time_sync", TIME_SYNC_TASK_STACK_SIZE,
+                                    this, TIME_SYNC_TASK_PRIORITY, &taskHandle);
+    if (result != pdPASS) {
+        taskHandle = NULL;
+        running = false;
+        Serial.println("[TIME] ERROR: No se pudo crear tarea");
+        return false;
+    }
+
+    Serial.printf("[TIME] ✓ Sincronización NTP en segundo plano (%s:%u)\n", this->server, port);
+    return true;
+}
+
+void TimeSyncManager::end() {
+    if (taskHandle == NULL) return;
+
+    running = false;
+    xTaskNotifyGive(taskHandle);
+    while (taskHandle != NULL) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+bool TimeSyncManager::setServer(const char* server, uint16_t port) {
+    if (server == nullptr || strlen(server) == 0 || strlen(server) > TIME_SYNC_MAX_SERVER) {
+        return false;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    memset(this->server, 0, sizeof(this->server));
+    strncpy(this->server, server, TIME_SYNC_MAX_SERVER);
+    this->port = port;
+    xSemaphoreGive(mutex);
+
+    Serial.printf("[TIME] Servidor NTP: %s:%u\n", server, port);
+    syncNow();
+    return true;
+}
+
+void TimeSyncManager::syncNow() {
+    if (taskHandle != NULL) {
+        xTaskNotifyGive(taskHandle);
+    }
+}
+
+// ============================================================================
+// TRADUCCIÓN
+// ============================================================================
+
+int64_t TimeSyncManager::toUtcUs(int64_t localUs) {
+    if (!synced) return 0;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int64_t utcUs = localUs + offsetAt(localUs);
+    xSemaphoreGive(mutex);
+    return utcUs;
+}
+
+int64_t TimeSyncManager::offsetAt(int64_t localUs) const {
+    int64_t elapsed = localUs - anchorUs;
+    int64_t offset = anchorOffsetUs + (int64_t)(driftPpm * elapsed / 1000000.0);
+
+    // Corrección pendiente repartida linealmente desde el ancla
+    if (slewDurationUs > 0 && elapsed > 0) {
+        int64_t slewElapsed = (elapsed < slewDurationUs) ? elapsed : slewDurationUs;
+        offset += slewUs * slewElapsed / slewDurationUs;
+    }
+    return offset;
+}
+
+// ============================================================================
+// TAREA DE SINCRONIZACIÓN
+// ============================================================================
+
+void TimeSyncManager::syncTask(void* parameter) {
+    TimeSyncManager* mgr = (TimeSyncManager*)parameter;
+
+    while (mgr->running) {
+        uint32_t waitMs = TIME_SYNC_RETRY_MS;
+        if (WiFi.status() == WL_CONNECTED) {
+            JobMgr.start(mgr->roundJob);
+            bool synced = mgr->syncRound();
+            JobMgr.finish(mgr->roundJob);
+            if (synced) waitMs = mgr->intervalMs;
+        }
+
+        // syncNow()/setServer() despiertan antes de tiempo
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+    }
+
+    mgr->taskHandle = NULL;
+    vTaskDelete(NULL);
+}
+
+bool TimeSyncManager::syncRound() {
+    char host[TIME_SYNC_MAX_SERVER + 1];
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    memcpy(host, server, sizeof(host));
+    uint16_t hostPort = port;
+    xSemaphoreGive(mutex);
+
+    if (host[0] == '\0' || !udp.begin(TIME_SYNC_LOCAL_PORT)) {
+        stats.failures++;
+        return false;
+    }
+
+    // La de menor demora es la que menos error de asimetría arrastra
+    TimeSample best;
+    bool found = false;
+    for (uint8_t i = 0; i < TIME_SYNC_SAMPLES; i++) {
+        TimeSample sample;
+        if (query(host, hostPort, sample) && (!found || sample.delayUs < best.delayUs)) {
+            best = sample;
+            found = true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    udp.stop();
+
+    if (!found) {
+        stats.failures++;
+        Serial.printf("[TIME] ✗ Sin respuesta de %s:%u\n", host, hostPort);
+        return false;
+    }
+
+    discipline(best);
+    return true;
+}
+
+bool TimeSyncManager::query(const char* host, uint16_t hostPort, TimeSample& sample) {
+    uint8_t packet[NTP_PACKET_SIZE];
+    memset(packet, 0, sizeof(packet));
+    packet[0] = 0x23;  // LI=0, versión 4, modo 3 (cliente)
+
+    // Transmit timestamp propio como testigo: el servidor lo devuelve en
+    // originate, así se descartan respuestas atrasadas de otra consulta
+    int64_t cookie = esp_timer_get_time();
+    for (uint8_t i = 0; i < 8; i++) {
+        packet[40 + i] = (uint8_t)(cookie >> (56 - 8 * i));
+    }
+
+    // Descartar respuestas viejas que hayan quedado en el socket
+    while (udp.parsePacket() > 0) {
+        udp.flush();
+    }
+
+    if (!udp.beginPacket(host, hostPort)) return false;
+    udp.write(packet, sizeof(packet));
+    int64_t sent = esp_timer_get_time();
+    if (!udp.endPacket()) return false;
+
+    int64_t received = 0;
+    while (esp_timer_get_time() - sent < TIME_SYNC_REPLY_TIMEOUT_MS * 1000LL) {
+        int size = udp.parsePacket();
+        if (size >= NTP_PACKET_SIZE) {
+            received = esp_timer_get_time();
+            udp.read(packet, sizeof(packet));
+            break;
+        }
+        if (size > 0) udp.flush();
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    if (received == 0) return false;
+
+    // Respuesta válida: modo servidor, estrato 1-15, reloj sincronizado, nuestro testigo
+    uint8_t leap = packet[0] >> 6;
+    uint8_t mode = packet[0] & 0x07;
+    uint8_t stratum = packet[1];
+    if (mode != 4 || leap == 3 || stratum == 0 || stratum > 15) return false;
+    for (uint8_t i = 0; i < 8; i++) {
+        if (packet[24 + i] != (uint8_t)(cookie >> (56 - 8 * i))) return false;
+    }
+
+    int64_t serverReceive = ntpToUnixUs(packet + 32);
+    int64_t serverTransmit = ntpToUnixUs(packet + 40);
+
+    sample.offsetUs = ((serverReceive - sent) + (serverTransmit - received)) / 2;
+    sample.delayUs = (received - sent) - (serverTransmit - serverReceive);
+    if (sample.delayUs < 0) sample.delayUs = 0;
+    sample.localUs = received;
+    return true;
+}
+
+void TimeSyncManager::discipline(const TimeSample& sample) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    int64_t error = 0;
+    bool step = !synced;
+    if (!step) {
+        int64_t current = offsetAt(sample.localUs);
+        error = sample.offsetUs - current;
+        step = (error > TIME_SYNC_STEP_US || error < -TIME_SYNC_STEP_US);
+
+        if (!step) {
+            // Deriva del cristal: pendiente entre mediciones, suavizada
+            int64_t span = sample.localUs - lastMeasureUs;
+            if (lastMeasureUs != 0 && span >= TIME_SYNC_MIN_DRIFT_INTERVAL_US) {
+                double measured = (double)(sample.offsetUs - lastMeasureOffsetUs) * 1000000.0 / span;
+                if (measured > TIME_SYNC_MAX_DRIFT_PPM) measured = TIME_SYNC_MAX_DRIFT_PPM;
+                if (measured < -TIME_SYNC_MAX_DRIFT_PPM) measured = -TIME_SYNC_MAX_DRIFT_PPM;
+                driftPpm += (measured - driftPpm) / 4.0;
+            }
+
+            // Slew: el error se absorbe de a poco, sin saltos en la hora
+            anchorOffsetUs = current;
+            anchorUs = sample.localUs;
+            slewUs = error;
+            slewDurationUs = ((error < 0) ? -error : error) * 1000000LL / TIME_SYNC_MAX_SLEW_PPM;
+        }
+    }
+
+    if (step) {
+        anchorOffsetUs = sample.offsetUs;
+        anchorUs = sample.localUs;
+        slewUs = 0;
+        slewDurationUs = 0;
+        if (synced) stats.steps++;
+        synced = true;
+    }
+
+    lastMeasureUs = sample.localUs;
+    lastMeasureOffsetUs = sample.offsetUs;
+    stats.rounds++;
+    stats.lastErrorUs = error;
+    stats.lastDelayUs = sample.delayUs;
+    stats.lastSync = millis();
+
+    xSemaphoreGive(mutex);
+
+    if (step) {
+        setSystemClock(esp_timer_get_time() + sample.offsetUs);
+        time_t now = time(nullptr);
+        struct tm utc;
+        gmtime_r(&now, &utc);
+        Serial.printf("[TIME] ✓ Reloj ajustado: %04d-%02d-%02d %02d:%02d:%02d UTC (demora %ld us)\n",
+                      utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday,
+                      utc.tm_hour, utc.tm_min, utc.tm_sec, (long)sample.delayUs);
+    } else {
+        Serial.printf("[TIME] Error %ld us, demora %ld us, deriva %.2f ppm\n",
+                      (long)error, (long)sample.delayUs, driftPpm);
+    }
+}
+
+void TimeSyncManager::setSystemClock(int64_t utcUs) {
+    // time() queda en UTC para quien lo use (p. ej. FlashQueue)
+    struct timeval tv;
+    tv.tv_sec = utcUs / 1000000LL;
+    tv.tv_usec = utcUs % 1000000LL;
+    settimeofday(&tv, nullptr);
+}
+
+// ============================================================================
+// INFORMACIÓN
+// ============================================================================
+
+TimeSyncStats TimeSyncManager::getStats() {
+    if (mutex == NULL) return stats;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    stats.synced = synced;
+    stats.offsetUs = synced ? offsetAt(esp_timer_get_time()) : 0;
+    stats.driftPpm = (float)driftPpm;
+    TimeSyncStats snapshot = stats;
+    xSemaphoreGive(mutex);
+    return snapshot;
+}
+
+void TimeSyncManager::printStatus() {
+    TimeSyncStats current = getStats();
+
+    Serial.println("\n╔════════════════════════════════════════╗");
+    Serial.println("║   Time Sync Manager - Estado           ║");
+    Serial.println("╚════════════════════════════════════════╝");
+    Serial.printf("  Servidor: %s:%u\n", server, port);
+    Serial.printf("  Sincronizado: %s\n", current.synced ? "Sí" : "No");
+    if (current.synced) {
+        Serial.printf("  Última ronda: hace %lu s (error %ld us, demora %ld us)\n",
+                      (millis() - current.lastSync) / 1000, (long)current.lastErrorUs,
+                      (long)current.lastDelayUs);
+        Serial.printf("  Deriva: %.2f ppm, steps: %lu\n", current.driftPpm, current.steps);
+    }
+    Serial.printf("  Rondas: %lu, fallidas: %lu\n", current.rounds, current.failures);
+    Serial.println("════════════════════════════════════════\n");
+}
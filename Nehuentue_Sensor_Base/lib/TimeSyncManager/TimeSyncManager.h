@@ -0,0 +1,160 @@
+/**
+ * @file TimeSyncManager.h
+ * @brief Reloj UTC disciplinado por NTP sobre el esp_timer (microsegundos)
+ * @version 1.0.0
+ * @date 2026-10-18
+ *
+ * @details
+ * Las muestras se marcan con esp_timer_get_time() (monótono, en us desde el
+ * arranque) y se traducen a UTC con un offset que mantiene una tarea en
+ * segundo plano:
+ *
+ * - Cada ronda hace varias consultas SNTP y se queda con la de menor
+ *   demora de ida y vuelta (la menos afectada por colas en la red).
+ * - La primera sincronización, o un error mayor a TIME_SYNC_STEP_US, ajusta
+ *   el offset de golpe (step) y pone en hora el reloj del sistema.
+ * - Errores menores se reparten en el tiempo (slew) a TIME_SYNC_MAX_SLEW_PPM:
+ *   la hora traducida nunca retrocede ni salta entre dos muestras.
+ * - La deriva del cristal se estima entre rondas y se extrapola.
+ *
+ * Nada bloquea a quien consulta: toUtcUs() sólo evalúa el modelo.
+ *
+ * Uso:
+ * @code
+ * TimeMgr.begin("pool.ntp.org");
+ *
+ * int64_t rx = esp_timer_get_time();       // al llegar el dato
+ * ...
+ * if (TimeMgr.isSynced()) {
+ *     uint64_t utcMs = TimeMgr.toUtcUs(rx) / 1000;
+ * }
+ * @endcode
+ */
+
+#ifndef TIME_SYNC_MANAGER_H
+#define TIME_SYNC_MANAGER_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <WiFiUdp.h>
+#include <PeriodicJobManager.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+// ============================================================================
+// CONSTANTES Y CONFIGURACIÓN
+// ============================================================================
+
+#define TIME_SYNC_VERSION "1.0.0"
+#define TIME_SYNC_DEFAULT_PORT 123
+#define TIME_SYNC_LOCAL_PORT 4123
+#define TIME_SYNC_MAX_SERVER 63
+#define TIME_SYNC_SAMPLES 4                   // Consultas por ronda
+#define TIME_SYNC_REPLY_TIMEOUT_MS 500
+#define TIME_SYNC_RETRY_MS 16000              // Reintento sin sincronizar o tras fallo
+#define TIME_SYNC_STEP_US 128000              // Error que fuerza un step (128 ms)
+#define TIME_SYNC_MAX_SLEW_PPM 500            // 0.5 ms corregidos por segundo
+#define TIME_SYNC_MAX_DRIFT_PPM 500
+#define TIME_SYNC_MIN_DRIFT_INTERVAL_US 60000000LL  // Base mínima para estimar deriva
+#define TIME_SYNC_TASK_STACK_SIZE 4096
+#define TIME_SYNC_TASK_PRIORITY 1
+
+// ============================================================================
+// ESTRUCTURAS
+// ============================================================================
+
+/**
+ * @brief Una medición SNTP
+ */
+struct TimeSample {
+    int64_t offsetUs;           ///< UTC - esp_timer
+    int64_t delayUs;            ///< Ida y vuelta descontando el servidor
+    int64_t localUs;            ///< esp_timer al recibir
+};
+
+struct TimeSyncStats {
+    bool synced;
+    uint32_t rounds;            ///< Rondas exitosas
+    uint32_t failures;          ///< Rondas sin respuesta válida
+    uint32_t steps;
+    int64_t offsetUs;           ///< Offset aplicado ahora
+    int64_t lastErrorUs;        ///< Medido - modelo en la última ronda
+    int64_t lastDelayUs;
+    float driftPpm;
+    uint32_t lastSync;          ///< millis() de la última ronda exitosa
+};
+
+// ============================================================================
+// CLASE PRINCIPAL
+// ============================================================================
+
+class TimeSyncManager {
+public:
+    TimeSyncManager();
+
+    /**
+     * @brief Inicia la tarea de sincronización
+     * @param intervalMs Período entre rondas una vez sincronizado
+     */
+    bool begin(const char* server, uint16_t port = TIME_SYNC_DEFAULT_PORT, uint32_t intervalMs = 300000);
+    void end();
+
+    /**
+     * @brief Cambia el servidor y fuerza una ronda (p. ej. un NTP local de prueba)
+     */
+    bool setServer(const char* server, uint16_t port = TIME_SYNC_DEFAULT_PORT);
+
+    /**
+     * @brief Despierta la tarea para una ronda inmediata
+     */
+    void syncNow();
+
+    bool isSynced() const { return synced; }
+
+    /**
+     * @brief Traduce un instante de esp_timer a UTC
+     * @return Microsegundos desde 1970 (0 si aún no hay sincronización)
+     */
+    int64_t toUtcUs(int64_t localUs);
+    int64_t nowUtcUs() { return toUtcUs(esp_timer_get_time()); }
+
+    TimeSyncStats getStats();
+    void printStatus();
+
+private:
+    char server[TIME_SYNC_MAX_SERVER + 1];
+    uint16_t port;
+    uint32_t intervalMs;
+
+    // Modelo: offset(t) = anchorOffset + deriva*(t - anchor) + slew repartido
+    volatile bool synced;
+    int64_t anchorUs;
+    int64_t anchorOffsetUs;
+    int64_t slewUs;
+    int64_t slewDurationUs;
+    double driftPpm;
+    int64_t lastMeasureUs;
+    int64_t lastMeasureOffsetUs;
+
+    TimeSyncStats stats;
+    SemaphoreHandle_t mutex;
+    TaskHandle_t taskHandle;
+    volatile bool running;
+    int8_t roundJob;            // Ronda NTP medida en JobMgr
+    WiFiUDP udp;
+
+    static void syncTask(void* parameter);
+    bool syncRound();
+    bool query(const char* host, uint16_t hostPort, TimeSample& sample);
+    void discipline(const TimeSample& sample);
+    int64_t offsetAt(int64_t localUs) const;
+    void setSystemClock(int64_t utcUs);
+};
+
+// ============================================================================
+// INSTANCIA GLOBAL
+// ============================================================================
+extern TimeSyncManager TimeMgr;
+
+#endif // TIME_SYNC_MANAGER_H
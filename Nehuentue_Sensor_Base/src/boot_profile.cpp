@@ -0,0 +1,170 @@
+/**
+ * @file boot_profile.cpp
+ * @brief Perfil de tiempos del arranque en RTC memory
+ *
+ * El registro vive en RTC_NOINIT: no lo borra el arranque, así que tras un
+ * reinicio por software/watchdog/panic todavía tiene el perfil anterior. Si
+ * ese arranque no llegó a publicarlo (se colgó conectando, por ejemplo) se
+ * copia a RAM y sale como "prev" en el primer estado de este arranque.
+ */
+
+#include "boot_profile.h"
+#include "config.h"
+#include <esp_attr.h>
+#include <esp_crc.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+
+RTC_NOINIT_ATTR static BootProfileRecord record;
+
+static BootProfileRecord previous;
+static bool hasPrevious = false;
+static portMUX_TYPE profileMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char* const PHASE_NAMES[BOOT_PHASE_COUNT] = {
+  "system", "storage", "local", "mqtt_setup", "modbus", "polling",
+  "wifi_start", "wifi_assoc", "wifi_dhcp", "mqtt_connect"
+};
+
+static uint32_t recordCrc(const BootProfileRecord& profile) {
+  return esp_crc32_le(0, (const uint8_t*)&profile, offsetof(BootProfileRecord, crc));
+}
+
+static uint32_t nowUs() {
+  // 0 marca "no empezó": el primer microsegundo cuenta como 1
+  uint32_t now = (uint32_t)esp_timer_get_time();
+  return now > 0 ? now : 1;
+}
+
+// ============================================================================
+// MEDICIÓN
+// ============================================================================
+
+void bootProfileBegin() {
+  if (record.magic == BOOT_PROFILE_MAGIC && recordCrc(record) == record.crc && !record.published) {
+    previous = record;
+    previous.firmware[sizeof(previous.firmware) - 1] = '\0';
+    hasPrevious = true;
+  }
+
+  memset(&record, 0, sizeof(record));
+  record.magic = BOOT_PROFILE_MAGIC;
+  strncpy(record.firmware, FIRMWARE_VERSION, sizeof(record.firmware) - 1);
+  record.resetReason = (uint8_t)esp_reset_reason();
+  record.crc = recordCrc(record);
+}
+
+void bootPhaseBegin(BootPhase phase) {
+  if (phase >= BOOT_PHASE_COUNT) return;
+  uint32_t now = nowUs();
+
+  portENTER_CRITICAL(&profileMux);
+  if (record.phaseStartUs[phase] == 0) {
+    record.phaseStartUs[phase] = now;
+    record.crc = recordCrc(record);
+  }
+  portEXIT_CRITICAL(&profileMux);
+}
+
+void bootPhaseEnd(BootPhase phase) {
+  if (phase >= BOOT_PHASE_COUNT) return;
+  uint32_t now = nowUs();
+
+  portENTER_CRITICAL(&profileMux);
+  if (record.phaseStartUs[phase] != 0 && record.phaseUs[phase] == 0) {
+    uint32_t elapsed = now - record.phaseStartUs[phase];
+    record.phaseUs[phase] = elapsed > 0 ? elapsed : 1;
+    if (phase == BOOT_PHASE_MQTT_CONNECT) {
+      record.readyUs = now;
+    }
+    record.crc = recordCrc(record);
+  }
+  portEXIT_CRITICAL(&profileMux);
+}
+
+void bootProfileSetupDone() {
+  uint32_t now = nowUs();
+
+  portENTER_CRITICAL(&profileMux);
+  record.setupUs = now;
+  record.crc = recordCrc(record);
+  portEXIT_CRITICAL(&profileMux);
+}
+
+// ============================================================================
+// REPORTE
+// ============================================================================
+
+static void profileToJson(const BootProfileRecord& profile, JsonObject out) {
+  out["firmware"] = String(profile.firmware);   // Copia: profile puede ser una copia local
+  out["reset"] = profile.resetReason;
+  if (profile.setupUs != 0) out["setup_us"] = profile.setupUs;
+  if (profile.readyUs != 0) out["ready_us"] = profile.readyUs;
+
+  // Fase sin "us": empezó y no terminó (donde quedó un arranque colgado)
+  JsonObject phases = out.createNestedObject("phases");
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    if (profile.phaseStartUs[i] == 0) continue;
+    JsonObject phase = phases.createNestedObject(PHASE_NAMES[i]);
+    phase["at"] = profile.phaseStartUs[i];
+    if (profile.phaseUs[i] != 0) phase["us"] = profile.phaseUs[i];
+  }
+}
+
+bool bootProfilePending() {
+  return !record.published;
+}
+
+void bootProfileToJson(JsonObject boot) {
+  BootProfileRecord current;
+  portENTER_CRITICAL(&profileMux);
+  current = record;
+  portEXIT_CRITICAL(&profileMux);
+
+  profileToJson(current, boot);
+  if (hasPrevious) {
+    profileToJson(previous, boot.createNestedObject("prev"));
+  }
+}
+
+void bootProfileMarkPublished() {
+  portENTER_CRITICAL(&profileMux);
+  record.published = 1;
+  record.crc = recordCrc(record);
+  portEXIT_CRITICAL(&profileMux);
+  hasPrevious = false;
+}
+
+void bootProfilePrint() {
+  BootProfileRecord current;
+  portENTER_CRITICAL(&profileMux);
+  current = record;
+  portEXIT_CRITICAL(&profileMux);
+
+  Serial.println("\n╔════════════════════════════════════════╗");
+  Serial.println("║   Perfil de Arranque                   ║");
+  Serial.println("╚════════════════════════════════════════╝");
+  Serial.printf("  Firmware: %s (reset %u)\n", current.firmware, current.resetReason);
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    if (current.phaseStartUs[i] == 0) {
+      Serial.printf("  %-13s -\n", PHASE_NAMES[i]);
+    } else if (current.phaseUs[i] == 0) {
+      Serial.printf("  %-13s @%8lu us  (en curso)\n", PHASE_NAMES[i], current.phaseStartUs[i]);
+    } else {
+      Serial.printf("  %-13s @%8lu us  %8lu us\n", PHASE_NAMES[i],
+                    current.phaseStartUs[i], current.phaseUs[i]);
+    }
+  }
+  if (current.setupUs != 0) {
+    Serial.printf("  Fin de setup(): %lu ms\n", current.setupUs / 1000);
+  }
+  if (current.readyUs != 0) {
+    Serial.printf("  Broker conectado: %lu ms\n", current.readyUs / 1000);
+  }
+  if (hasPrevious) {
+    Serial.printf("  Arranque anterior sin publicar (%s, reset %u)\n",
+                  previous.firmware, previous.resetReason);
+  }
+  Serial.println("════════════════════════════════════════\n");
+}
@@ -0,0 +1,238 @@
+/**
+ * @file config_image.cpp
+ * @brief Imagen de configuración versionada: carga, validación y migración
+ *
+ * Hasta CONFIG_VERSION 1 cada ajuste era una clave de NVS (wifi_ssid,
+ * mqtt_server, mqtt_port, ...) más el blob "sensor_config": el arranque hacía
+ * unas diez lecturas. Desde la versión 2 todo vive en "cfg_image":
+ *
+ *   [magic | versión | tamaño | CRC32] [SensorConfig] [WiFi] [MQTT] [NTP]
+ *
+ * La imagen se lee de una vez y se valida con el CRC. Una imagen de otra
+ * versión o corrupta no se pisa: se arranca con los valores por defecto y
+ * el próximo set_* la reemplaza.
+ */
+
+#include "config_image.h"
+#include <FlashStorageManager.h>
+#include <esp_crc.h>
+
+extern WiFiConfig wifiConfig;
+extern MQTTConfig mqttConfig;
+extern NtpConfig ntpConfig;
+extern SensorConfig sensorConfig;
+
+// ============================================================================
+// VERSIÓN 1 (sólo para migrar)
+// ============================================================================
+
+// SensorConfig tal como se guardaba en "sensor_config", con sus alias
+struct SensorConfigV1 {
+  char name[32];
+  char type[32];
+  char unit[16];
+  bool enabled;
+  uint8_t slaveId;
+  uint8_t modbusAddress;      // = slaveId
+  uint8_t modbusFunction;
+  uint16_t startAddress;
+  uint16_t registerStart;     // = startAddress
+  uint16_t quantity;
+  uint16_t registerCount;     // = quantity
+  uint32_t pollInterval;
+  int32_t rxPin;
+  int32_t txPin;
+  uint32_t baudrate;
+  float multiplier;
+  float offset;
+  uint8_t decimals;
+  uint8_t version;
+};
+
+static const char* const legacyKeys[] = {
+  "wifi_ssid", "wifi_password",
+  "mqtt_server", "mqtt_port", "mqtt_user", "mqtt_password",
+  "ntp_server", "ntp_port",
+  "sensor_config",
+};
+
+/**
+ * @brief Aplica sobre los globales las claves de la versión 1 que existan
+ * @return true si había alguna
+ */
+static bool migrateFromV1() {
+  bool found = false;
+
+  SensorConfigV1 legacy;
+  if (FlashStorage.load("sensor_config", legacy) == FLASH_STORAGE_OK) {
+    SensorConfig sensor;
+    memcpy(sensor.name, legacy.name, sizeof(sensor.name));
+    memcpy(sensor.type, legacy.type, sizeof(sensor.type));
+    memcpy(sensor.unit, legacy.unit, sizeof(sensor.unit));
+    sensor.pollInterval = legacy.pollInterval;
+    sensor.baudrate = legacy.baudrate;
+    sensor.rxPin = legacy.rxPin;
+    sensor.txPin = legacy.txPin;
+    sensor.multiplier = legacy.multiplier;
+    sensor.offset = legacy.offset;
+    sensor.startAddress = legacy.startAddress;
+    sensor.quantity = legacy.quantity;
+    sensor.slaveId = legacy.slaveId;
+    sensor.modbusFunction = legacy.modbusFunction;
+    sensor.decimals = legacy.decimals;
+    sensor.enabled = legacy.enabled;
+    sensorConfig = sensor;
+    found = true;
+  }
+
+  // Mismas reglas que el arranque v1: un servidor/SSID vacío no sobrescribe
+  String ssid = FlashStorage.loadString("wifi_ssid", "");
+  if (ssid.length() > 0) {
+    strncpy(wifiConfig.ssid, ssid.c_str(), sizeof(wifiConfig.ssid) - 1);
+    String password = FlashStorage.loadString("wifi_password", "");
+    strncpy(wifiConfig.password, password.c_str(), sizeof(wifiConfig.password) - 1);
+    found = true;
+  }
+
+  String mqttServer = FlashStorage.loadString("mqtt_server", "");
+  if (mqttServer.length() > 0) {
+    strncpy(mqttConfig.server, mqttServer.c_str(), sizeof(mqttConfig.server) - 1);
+    mqttConfig.port = FlashStorage.loadInt("mqtt_port", (int32_t)DEFAULT_MQTT_PORT);
+    String mqttUser = FlashStorage.loadString("mqtt_user", "");
+    String mqttPassword = FlashStorage.loadString("mqtt_password", "");
+    if (mqttUser.length() > 0) strncpy(mqttConfig.user, mqttUser.c_str(), sizeof(mqttConfig.user) - 1);
+    if (mqttPassword.length() > 0) strncpy(mqttConfig.password, mqttPassword.c_str(), sizeof(mqttConfig.password) - 1);
+    found = true;
+  }
+
+  String ntpServer = FlashStorage.loadString("ntp_server", "");
+  if (ntpServer.length() > 0) {
+    strncpy(ntpConfig.server, ntpServer.c_str(), sizeof(ntpConfig.server) - 1);
+    ntpConfig.port = FlashStorage.loadInt("ntp_port", (int32_t)ntpConfig.port);
+    found = true;
+  }
+
+  return found;
+}
+
+// ============================================================================
+// IMAGEN
+// ============================================================================
+
+static uint32_t imageCrc(const ConfigImage& image) {
+  const uint8_t* body = (const uint8_t*)&image + sizeof(ConfigImageHeader);
+  return esp_crc32_le(0, body, image.header.size - sizeof(ConfigImageHeader));
+}
+
+static void packImage(ConfigImage& image) {
+  memset(&image, 0, sizeof(ConfigImage));
+  image.sensor = sensorConfig;
+  strncpy(image.wifiSsid, wifiConfig.ssid, sizeof(image.wifiSsid) - 1);
+  strncpy(image.wifiPassword, wifiConfig.password, sizeof(image.wifiPassword) - 1);
+  strncpy(image.mqttServer, mqttConfig.server, sizeof(image.mqttServer) - 1);
+  strncpy(image.mqttUser, mqttConfig.user, sizeof(image.mqttUser) - 1);
+  strncpy(image.mqttPassword, mqttConfig.password, sizeof(image.mqttPassword) - 1);
+  strncpy(image.ntpServer, ntpConfig.server, sizeof(image.ntpServer) - 1);
+  image.mqttPort = mqttConfig.port;
+  image.ntpPort = ntpConfig.port;
+
+  image.header.magic = CONFIG_IMAGE_MAGIC;
+  image.header.version = CONFIG_VERSION;
+  image.header.size = sizeof(ConfigImage);
+  image.header.crc = imageCrc(image);
+}
+
+static void unpackImage(const ConfigImage& image) {
+  sensorConfig = image.sensor;
+  strncpy(wifiConfig.ssid, image.wifiSsid, sizeof(wifiConfig.ssid) - 1);
+  strncpy(wifiConfig.password, image.wifiPassword, sizeof(wifiConfig.password) - 1);
+  strncpy(mqttConfig.server, image.mqttServer, sizeof(mqttConfig.server) - 1);
+  strncpy(mqttConfig.user, image.mqttUser, sizeof(mqttConfig.user) - 1);
+  strncpy(mqttConfig.password, image.mqttPassword, sizeof(mqttConfig.password) - 1);
+  strncpy(ntpConfig.server, image.ntpServer, sizeof(ntpConfig.server) - 1);
+  mqttConfig.port = image.mqttPort;
+  ntpConfig.port = image.ntpPort;
+}
+
+/**
+ * @return nullptr si la imagen es válida, o el motivo
+ */
+static const char* validateImage(const ConfigImage& image, size_t length) {
+  if (length < sizeof(ConfigImageHeader) || image.header.magic != CONFIG_IMAGE_MAGIC) {
+    return "encabezado inválido";
+  }
+  if (image.header.size != length) {
+    return "tamaño no coincide";
+  }
+  // Versiones posteriores a la 2 migran acá, campo a campo, antes del CRC
+  if (image.header.version != CONFIG_VERSION || length != sizeof(ConfigImage)) {
+    return "versión no soportada";
+  }
+  if (imageCrc(image) != image.header.crc) {
+    return "CRC no coincide";
+  }
+  return nullptr;
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+ConfigImageResult loadConfigImage() {
+  ConfigImage image;
+  size_t length = 0;
+  unsigned long start = micros();
+
+  FlashStorageStatus status = FlashStorage.loadRawBytes(CONFIG_IMAGE_KEY, &image, sizeof(image), length);
+  if (status == FLASH_STORAGE_OK) {
+    const char* reason = validateImage(image, length);
+    if (reason != nullptr) {
+      Serial.printf("[CONFIG] ERROR: Imagen descartada (%s), usando valores por defecto\n", reason);
+      return CONFIG_IMAGE_INVALID;
+    }
+    unpackImage(image);
+    Serial.printf("[CONFIG] ✓ Imagen v%u cargada: %u bytes en %lu us\n",
+                  image.header.version, (unsigned)length, micros() - start);
+    return CONFIG_IMAGE_LOADED;
+  }
+
+  if (status != FLASH_STORAGE_ERROR_KEY_NOT_FOUND) {
+    // Imagen más grande que la de este firmware (versión posterior)
+    Serial.printf("[CONFIG] ERROR: Imagen ilegible (%d), usando valores por defecto\n", status);
+    return CONFIG_IMAGE_INVALID;
+  }
+
+  // Sin imagen: primer arranque o firmware anterior (CONFIG_VERSION 1).
+  // Imagen y borrado de las claves viejas en un lote: un corte a mitad deja
+  // la configuración v1 intacta y la migración se repite en el próximo arranque
+  bool migrated = migrateFromV1();
+  packImage(image);
+
+  FlashStorageBatch batch;
+  batch.putBytes(CONFIG_IMAGE_KEY, &image, sizeof(image), false);
+  if (migrated) {
+    for (size_t i = 0; i < sizeof(legacyKeys) / sizeof(legacyKeys[0]); i++) {
+      batch.remove(legacyKeys[i]);
+    }
+  }
+
+  if (FlashStorage.commitBatch(batch) != FLASH_STORAGE_OK) {
+    Serial.println("[CONFIG] ERROR: No se pudo escribir la imagen");
+    return migrated ? CONFIG_IMAGE_MIGRATED : CONFIG_IMAGE_CREATED;
+  }
+
+  if (migrated) {
+    Serial.printf("[CONFIG] ✓ Configuración v1 migrada a imagen v%u (%u bytes)\n",
+                  CONFIG_VERSION, (unsigned)sizeof(image));
+    return CONFIG_IMAGE_MIGRATED;
+  }
+
+  Serial.printf("[CONFIG] Imagen v%u creada con valores por defecto\n", CONFIG_VERSION);
+  return CONFIG_IMAGE_CREATED;
+}
+
+ConfigStageResult saveConfigImage() {
+  ConfigImage image;
+  packImage(image);
+  return ConfigMgr.stageRaw(CONFIG_IMAGE_KEY, &image, sizeof(image));
+}
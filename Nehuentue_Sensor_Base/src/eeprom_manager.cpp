@@ -15,6 +15,24 @@ EEPROMManager::EEPROMManager() {
     sclPin = -1;
     frequency = I2C_MASTER_FREQ_HZ;
     eepromSize = EEPROM_SIZE;  // Valor por defecto (24LC128)
+    writeCyclePending = false;
+    writeCycleStartUs = 0;
+    writeQueue = NULL;
+    writerHandle = NULL;
+    pendingItems = 0;
+    writeFailed = false;
+    memset(&stats, 0, sizeof(stats));
+    portMUX_INITIALIZE(&statsMux);
+    barrierMutex = NULL;
+    barrierDone = NULL;
+    barrierSeq = 0;
+    barrierDoneSeq = 0;
+    shadow = NULL;
+    dirtyPages = NULL;
+    shadowStart = 0;
+    shadowLength = 0;
+    shadowMutex = NULL;
+    memset(&shadowStats, 0, sizeof(shadowStats));
 }
 
 EEPROMManager::~EEPROMManager() {
@@ -88,6 +106,7 @@ EEPROMStatus EEPROMManager::begin(int sda, int scl, uint16_t size, uint32_t freq
     Serial.printf("  Frecuencia: %lu Hz\n", freq);
     Serial.printf("  Tamaño: %d bytes\n", eepromSize);
     Serial.printf("  Página: %d bytes\n", EEPROM_PAGE_SIZE);
+    Serial.printf("  Ciclo de escritura: ACK polling (máx %d ms)\n", EEPROM_WRITE_CYCLE_MAX_MS);
     Serial.printf("  Thread-safe: ✓\n");
     Serial.printf("  CRC16: ✓\n");
     Serial.println("════════════════════════════════════════\n");
@@ -97,6 +116,10 @@ EEPROMStatus EEPROMManager::begin(int sda, int scl, uint16_t size, uint32_t freq
 
 // Finaliza y libera recursos
 void EEPROMManager::end() {
+    // Las páginas sucias pasan a la cola y la cola se vacía antes de cerrar
+    disableShadow();
+    disableWriteBehind();
+    
     if (initialized) {
         i2c_driver_delete(I2C_MASTER_NUM);
         initialized = false;
@@ -136,7 +159,47 @@ bool EEPROMManager::verifyDevice() {
 // Verifica si la EEPROM está lista
 bool EEPROMManager::isReady() {
     if (!initialized) return false;
-    return verifyDevice();
+    
+    // Durante un ciclo de grabación la EEPROM no responde: se espera que termine
+    if (xSemaphoreTake(i2cMutex, pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS * 2)) != pdTRUE) {
+        return false;
+    }
+    bool ready = (waitWriteCycle() == ESP_OK) && verifyDevice();
+    xSemaphoreGive(i2cMutex);
+    
+    return ready;
+}
+
+// ACK polling (con el mutex tomado): mientras graba una página la EEPROM no
+// reconoce su dirección. Se sondea sólo antes de la próxima transacción, así
+// la escritura vuelve enseguida y la siguiente página sale apenas termina el ciclo
+esp_err_t EEPROMManager::waitWriteCycle() {
+    if (!writeCyclePending) return ESP_OK;
+    
+    uint32_t polls = 0;
+    bool ready;
+    while (!(ready = verifyDevice())) {
+        polls++;
+        if (micros() - writeCycleStartUs > EEPROM_WRITE_CYCLE_MAX_MS * 1000UL) break;
+        taskYIELD();
+    }
+    writeCyclePending = false;
+    
+    // Si respondió al primer sondeo el ciclo terminó antes y no hay nada que medir
+    if (polls > 0) {
+        uint32_t cycleUs = micros() - writeCycleStartUs;
+        portENTER_CRITICAL(&statsMux);
+        stats.ackPolls += polls;
+        stats.lastCycleUs = cycleUs;
+        if (cycleUs > stats.maxCycleUs) stats.maxCycleUs = cycleUs;
+        portEXIT_CRITICAL(&statsMux);
+    }
+    
+    if (!ready) {
+        Serial.printf("[EEPROM] ERROR: Sin ACK tras %d ms de ciclo de escritura\n", EEPROM_WRITE_CYCLE_MAX_MS);
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
 }
 
 // Escritura raw (bajo nivel) - Thread-safe
@@ -159,6 +222,13 @@ esp_err_t EEPROMManager::writeRaw(uint16_t address, const uint8_t* data, size_t
         size_t pageRemaining = EEPROM_PAGE_SIZE - (currentAddress % EEPROM_PAGE_SIZE);
         size_t toWrite = (pageRemaining < (length - written)) ? pageRemaining : (length - written);
         
+        // La página anterior (de ésta u otra escritura) tiene que haber terminado
+        esp_err_t ret = waitWriteCycle();
+        if (ret != ESP_OK) {
+            result = ret;
+            break;
+        }
+        
         i2c_cmd_handle_t cmd = i2c_cmd_link_create();
         i2c_master_start(cmd);
         i2c_master_write_byte(cmd, (deviceAddress << 1) | I2C_MASTER_WRITE, I2C_ACK_CHECK_EN);
@@ -171,7 +241,7 @@ esp_err_t EEPROMManager::writeRaw(uint16_t address, const uint8_t* data, size_t
         
         i2c_master_stop(cmd);
         
-        esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS));
+        ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS));
         i2c_cmd_link_delete(cmd);
         
         if (ret != ESP_OK) {
@@ -179,13 +249,26 @@ esp_err_t EEPROMManager::writeRaw(uint16_t address, const uint8_t* data, size_t
             break;
         }
         
+        // Arranca el ciclo interno; no se espera acá sino en la próxima transacción
+        writeCyclePending = true;
+        writeCycleStartUs = micros();
         written += toWrite;
-        vTaskDelay(pdMS_TO_TICKS(EEPROM_WRITE_CYCLE_TIME_MS));
+        
+        portENTER_CRITICAL(&statsMux);
+        stats.pagesWritten++;
+        stats.bytesWritten += toWrite;
+        portEXIT_CRITICAL(&statsMux);
     }
     
     // Libera mutex
     xSemaphoreGive(i2cMutex);
     
+    if (result != ESP_OK) {
+        portENTER_CRITICAL(&statsMux);
+        stats.writeErrors++;
+        portEXIT_CRITICAL(&statsMux);
+    }
+    
     return result;
 }
 
@@ -195,11 +278,22 @@ esp_err_t EEPROMManager::readRaw(uint16_t address, uint8_t* buffer, size_t lengt
     if (address + length > eepromSize) return ESP_ERR_INVALID_ARG;
     if (buffer == NULL) return ESP_ERR_INVALID_ARG;
     
+    // Lo encolado se graba antes de leer (una lectura ve las escrituras previas)
+    if (!waitPending(EEPROM_FLUSH_TIMEOUT_MS)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
     // Toma mutex
     if (xSemaphoreTake(i2cMutex, pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS * 2)) != pdTRUE) {
         return ESP_ERR_TIMEOUT;
     }
     
+    esp_err_t ret = waitWriteCycle();
+    if (ret != ESP_OK) {
+        xSemaphoreGive(i2cMutex);
+        return ret;
+    }
+    
     // Escribe dirección
     i2c_cmd_handle_t cmd = i2c_cmd_link_create();
     i2c_master_start(cmd);
@@ -208,7 +302,7 @@ esp_err_t EEPROMManager::readRaw(uint16_t address, uint8_t* buffer, size_t lengt
     i2c_master_write_byte(cmd, (uint8_t)(address & 0xFF), I2C_ACK_CHECK_EN);
     i2c_master_stop(cmd);
     
-    esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS));
+    ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS));
     i2c_cmd_link_delete(cmd);
     
     if (ret != ESP_OK) {
@@ -216,7 +310,8 @@ esp_err_t EEPROMManager::readRaw(uint16_t address, uint8_t* buffer, size_t lengt
         return ret;
     }
     
-    // Lee datos
+    // Lee datos (el timeout crece con el largo: 9 bits por byte)
+    TickType_t timeout = pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS + (length * 9 * 1000UL) / frequency);
     cmd = i2c_cmd_link_create();
     i2c_master_start(cmd);
     i2c_master_write_byte(cmd, (deviceAddress << 1) | I2C_MASTER_READ, I2C_ACK_CHECK_EN);
@@ -227,7 +322,7 @@ esp_err_t EEPROMManager::readRaw(uint16_t address, uint8_t* buffer, size_t lengt
     i2c_master_read_byte(cmd, &buffer[length - 1], I2C_MASTER_NACK);
     i2c_master_stop(cmd);
     
-    ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS));
+    ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, timeout);
     i2c_cmd_link_delete(cmd);
     
     // Libera mutex
@@ -257,26 +352,501 @@ uint16_t EEPROMManager::calculateCRC16(const uint8_t* data, size_t length) {
 // ============================================================================
 
 EEPROMStatus EEPROMManager::writeByte(uint16_t address, uint8_t data) {
-    esp_err_t err = writeRaw(address, &data, 1);
-    return (err == ESP_OK) ? EEPROM_OK : EEPROM_ERROR_WRITE_FAILED;
+    return writeBytes(address, &data, 1);
 }
 
 EEPROMStatus EEPROMManager::writeBytes(uint16_t address, const uint8_t* data, size_t length) {
     if (data == NULL) return EEPROM_ERROR_NULL_POINTER;
-    esp_err_t err = writeRaw(address, data, length);
-    return (err == ESP_OK) ? EEPROM_OK : EEPROM_ERROR_WRITE_FAILED;
+    if (shadow == NULL) return writeDevice(address, data, length);
+    if (address + length > eepromSize) return EEPROM_ERROR_ADDRESS_OUT_OF_RANGE;
+    
+    // Lo que cae fuera de la región va a la EEPROM; lo de adentro, a RAM
+    uint32_t end = (uint32_t)address + length;
+    uint32_t shadowEnd = (uint32_t)shadowStart + shadowLength;
+    uint32_t inStart = (address > shadowStart) ? address : shadowStart;
+    uint32_t inEnd = (end < shadowEnd) ? end : shadowEnd;
+    if (inStart >= inEnd) return writeDevice(address, data, length);
+    
+    EEPROMStatus status = EEPROM_OK;
+    if (address < inStart) {
+        status = writeDevice(address, data, inStart - address);
+    }
+    if (status == EEPROM_OK && end > inEnd) {
+        status = writeDevice(inEnd, data + (inEnd - address), end - inEnd);
+    }
+    if (status != EEPROM_OK) return status;
+    
+    writeShadow(inStart, data + (inStart - address), inEnd - inStart);
+    return EEPROM_OK;
 }
 
 EEPROMStatus EEPROMManager::readByte(uint16_t address, uint8_t* data) {
-    if (data == NULL) return EEPROM_ERROR_NULL_POINTER;
-    esp_err_t err = readRaw(address, data, 1);
-    return (err == ESP_OK) ? EEPROM_OK : EEPROM_ERROR_READ_FAILED;
+    return readBytes(address, data, 1);
 }
 
 EEPROMStatus EEPROMManager::readBytes(uint16_t address, uint8_t* buffer, size_t length) {
     if (buffer == NULL) return EEPROM_ERROR_NULL_POINTER;
+    
+    uint32_t end = (uint32_t)address + length;
+    uint32_t shadowEnd = (uint32_t)shadowStart + shadowLength;
+    
+    if (shadow != NULL && address >= shadowStart && end <= shadowEnd) {
+        xSemaphoreTake(shadowMutex, portMAX_DELAY);
+        memcpy(buffer, shadow + (address - shadowStart), length);
+        shadowStats.hits++;
+        xSemaphoreGive(shadowMutex);
+        return EEPROM_OK;
+    }
+    
     esp_err_t err = readRaw(address, buffer, length);
-    return (err == ESP_OK) ? EEPROM_OK : EEPROM_ERROR_READ_FAILED;
+    if (err != ESP_OK) return EEPROM_ERROR_READ_FAILED;
+    
+    // Parte dentro de la región: la RAM puede tener páginas sin grabar
+    if (shadow != NULL) {
+        uint32_t inStart = (address > shadowStart) ? address : shadowStart;
+        uint32_t inEnd = (end < shadowEnd) ? end : shadowEnd;
+        
+        xSemaphoreTake(shadowMutex, portMAX_DELAY);
+        if (inStart < inEnd) {
+            memcpy(buffer + (inStart - address), shadow + (inStart - shadowStart), inEnd - inStart);
+        }
+        shadowStats.misses++;
+        xSemaphoreGive(shadowMutex);
+    }
+    return EEPROM_OK;
+}
+
+// Escritura a la EEPROM (encolada si la escritura diferida está activa)
+EEPROMStatus EEPROMManager::writeDevice(uint16_t address, const uint8_t* data, size_t length) {
+    if (writeQueue != NULL) return enqueueWrite(address, data, length);
+    esp_err_t err = writeRaw(address, data, length);
+    return (err == ESP_OK) ? EEPROM_OK : EEPROM_ERROR_WRITE_FAILED;
+}
+
+// ============================================================================
+// ESCRITURA DIFERIDA
+// ============================================================================
+
+EEPROMStatus EEPROMManager::enableWriteBehind(uint8_t queueDepth) {
+    if (!initialized) return EEPROM_ERROR_NOT_INITIALIZED;
+    if (writeQueue != NULL) return EEPROM_OK;
+    if (queueDepth == 0) return EEPROM_ERROR_INVALID_SIZE;
+    
+    if (barrierMutex == NULL) {
+        barrierMutex = xSemaphoreCreateMutex();
+    }
+    if (barrierDone == NULL) {
+        barrierDone = xSemaphoreCreateBinary();
+    }
+    if (barrierMutex == NULL || barrierDone == NULL) {
+        Serial.println("[EEPROM] ERROR: No se pudieron crear los semáforos de barrera");
+        return EEPROM_ERROR_NOT_INITIALIZED;
+    }
+    
+    writeQueue = xQueueCreate(queueDepth, sizeof(WriteItem));
+    if (writeQueue == NULL) {
+        Serial.println("[EEPROM] ERROR: No se pudo crear la cola de escritura");
+        return EEPROM_ERROR_NOT_INITIALIZED;
+    }
+    
+    pendingItems = 0;
+    writeFailed = false;
+    
+    BaseType_t result = xTaskCreate(writerTask, "eeprom_writer", EEPROM_WRITER_TASK_STACK_SIZE,
+                                    this, EEPROM_WRITER_TASK_PRIORITY, &writerHandle);
+    if (result != pdPASS) {
+        Serial.println("[EEPROM] ERROR: No se pudo crear la tarea de escritura");
+        vQueueDelete(writeQueue);
+        writeQueue = NULL;
+        writerHandle = NULL;
+        return EEPROM_ERROR_NOT_INITIALIZED;
+    }
+    
+    Serial.printf("[EEPROM] ✓ Escritura diferida activa (cola de %u páginas, %u bytes)\n",
+                  queueDepth, (unsigned)(queueDepth * sizeof(WriteItem)));
+    return EEPROM_OK;
+}
+
+void EEPROMManager::disableWriteBehind() {
+    if (writeQueue == NULL) return;
+    
+    // STOP es una barrera más: la tarea graba lo anterior antes de terminar
+    waitBarrier(WRITE_ITEM_STOP, portMAX_DELAY);
+    
+    vQueueDelete(writeQueue);
+    writeQueue = NULL;
+    
+    if (writeFailed) {
+        Serial.println("[EEPROM] ADVERTENCIA: Hubo escrituras diferidas fallidas");
+    }
+    Serial.println("[EEPROM] Escritura diferida detenida");
+}
+
+EEPROMStatus EEPROMManager::flush(uint32_t timeoutMs) {
+    EEPROMStatus status = writeBackShadow();
+    if (status != EEPROM_OK) return status;
+    
+    if (!waitPending(timeoutMs)) {
+        return EEPROM_ERROR_TIMEOUT;
+    }
+    
+    if (writeFailed) {
+        writeFailed = false;
+        return EEPROM_ERROR_WRITE_FAILED;
+    }
+    return EEPROM_OK;
+}
+
+// Parte la escritura en ítems de una página y los encola
+EEPROMStatus EEPROMManager::enqueueWrite(uint16_t address, const uint8_t* data, size_t length) {
+    if (address + length > eepromSize) return EEPROM_ERROR_ADDRESS_OUT_OF_RANGE;
+    
+    WriteItem item;
+    item.type = WRITE_ITEM_DATA;
+    item.barrierSeq = 0;
+    
+    size_t queued = 0;
+    while (queued < length) {
+        item.address = address + queued;
+        size_t pageRemaining = EEPROM_PAGE_SIZE - (item.address % EEPROM_PAGE_SIZE);
+        item.length = (pageRemaining < (length - queued)) ? pageRemaining : (length - queued);
+        memcpy(item.data, data + queued, item.length);
+        item.queuedUs = micros();
+        
+        // Se cuenta antes de encolar: una lectura concurrente no puede saltearlo
+        portENTER_CRITICAL(&statsMux);
+        pendingItems++;
+        portEXIT_CRITICAL(&statsMux);
+        
+        if (xQueueSend(writeQueue, &item, 0) != pdTRUE) {
+            portENTER_CRITICAL(&statsMux);
+            stats.queueFullWaits++;
+            portEXIT_CRITICAL(&statsMux);
+            
+            if (xQueueSend(writeQueue, &item, pdMS_TO_TICKS(EEPROM_WRITE_QUEUE_WAIT_MS)) != pdTRUE) {
+                portENTER_CRITICAL(&statsMux);
+                pendingItems--;
+                portEXIT_CRITICAL(&statsMux);
+                Serial.println("[EEPROM] ERROR: Cola de escritura llena");
+                return EEPROM_ERROR_TIMEOUT;
+            }
+        }
+        
+        uint16_t depth = uxQueueMessagesWaiting(writeQueue);
+        portENTER_CRITICAL(&statsMux);
+        stats.requestsQueued++;
+        if (depth > stats.queueHighWater) stats.queueHighWater = depth;
+        portEXIT_CRITICAL(&statsMux);
+        
+        queued += item.length;
+    }
+    
+    return EEPROM_OK;
+}
+
+// Espera a que la tarea grabe todo lo encolado hasta ahora (barrera en la cola)
+bool EEPROMManager::waitPending(uint32_t timeoutMs) {
+    if (writeQueue == NULL || pendingItems == 0) return true;
+    return waitBarrier(WRITE_ITEM_FLUSH, timeoutMs);
+}
+
+// Encola una barrera y espera a que la tarea la alcance (timeoutMs en ms,
+// portMAX_DELAY sin límite). Un aviso de una barrera anterior que venció
+// tarde se reconoce por su número y no cuenta para ésta.
+bool EEPROMManager::waitBarrier(WriteItemType type, uint32_t timeoutMs) {
+    TickType_t timeout = (timeoutMs == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+    TickType_t start = xTaskGetTickCount();
+    
+    if (xSemaphoreTake(barrierMutex, timeout) != pdTRUE) return false;
+    
+    WriteItem barrier;
+    barrier.type = type;
+    barrier.length = 0;
+    barrier.barrierSeq = ++barrierSeq;
+    
+    bool reached = false;
+    if (xQueueSend(writeQueue, &barrier, timeout) == pdTRUE) {
+        while (true) {
+            if ((int32_t)(barrierDoneSeq - barrier.barrierSeq) >= 0) {
+                reached = true;
+                break;
+            }
+            TickType_t wait = portMAX_DELAY;
+            if (timeout != portMAX_DELAY) {
+                TickType_t elapsed = xTaskGetTickCount() - start;
+                if (elapsed >= timeout) break;
+                wait = timeout - elapsed;
+            }
+            xSemaphoreTake(barrierDone, wait);
+        }
+    }
+    
+    xSemaphoreGive(barrierMutex);
+    return reached;
+}
+
+// Fusiona item en la página armada si es de la misma página y contiguo o
+// solapado (una transacción escribe bytes seguidos). Lo más nuevo pisa.
+bool EEPROMManager::mergeWrite(WriteItem& burst, const WriteItem& item) {
+    if (burst.address / EEPROM_PAGE_SIZE != item.address / EEPROM_PAGE_SIZE) return false;
+    
+    uint32_t burstEnd = (uint32_t)burst.address + burst.length;
+    uint32_t itemEnd = (uint32_t)item.address + item.length;
+    if (item.address > burstEnd || itemEnd < burst.address) return false;
+    
+    uint16_t start = (item.address < burst.address) ? item.address : burst.address;
+    uint32_t end = (itemEnd > burstEnd) ? itemEnd : burstEnd;
+    
+    if (start < burst.address) {
+        memmove(burst.data + (burst.address - start), burst.data, burst.length);
+    }
+    memcpy(burst.data + (item.address - start), item.data, item.length);
+    
+    burst.address = start;
+    burst.length = end - start;
+    // queuedUs queda el del ítem más viejo: la latencia se mide desde ahí
+    return true;
+}
+
+void EEPROMManager::writeBurst(WriteItem& burst, uint32_t items) {
+    esp_err_t err = writeRaw(burst.address, burst.data, burst.length);
+    uint32_t latencyUs = micros() - burst.queuedUs;
+    
+    if (err != ESP_OK) {
+        writeFailed = true;
+        Serial.printf("[EEPROM] ERROR: Escritura diferida en 0x%04X falló (0x%x)\n", burst.address, err);
+    }
+    
+    portENTER_CRITICAL(&statsMux);
+    pendingItems -= items;
+    stats.requestsCoalesced += items - 1;
+    if (err == ESP_OK) {
+        stats.lastLatencyUs = latencyUs;
+        if (latencyUs > stats.maxLatencyUs) stats.maxLatencyUs = latencyUs;
+        stats.avgLatencyUs = (stats.avgLatencyUs == 0)
+            ? latencyUs
+            : (uint32_t)(((uint64_t)stats.avgLatencyUs * 7 + latencyUs) / 8);
+    }
+    portEXIT_CRITICAL(&statsMux);
+}
+
+void EEPROMManager::writerTask(void* parameter) {
+    EEPROMManager* self = (EEPROMManager*)parameter;
+    WriteItem item;
+    WriteItem burst;
+    uint32_t burstItems = 0;
+    bool cycleDone = false;
+    
+    Serial.println("[EEPROM] Tarea de escritura iniciada");
+    
+    while (true) {
+        // Con una página armada sólo se junta lo que ya está en cola
+        TickType_t wait = (burstItems > 0) ? 0 : portMAX_DELAY;
+        
+        if (xQueueReceive(self->writeQueue, &item, wait) != pdTRUE) {
+            // Cola vacía: primero se espera que la EEPROM termine la página
+            // anterior (ACK polling) y se vuelve a mirar la cola, porque lo que
+            // llegue mientras tanto todavía se puede fusionar
+            if (!cycleDone) {
+                if (xSemaphoreTake(self->i2cMutex, pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS * 2)) == pdTRUE) {
+                    self->waitWriteCycle();
+                    xSemaphoreGive(self->i2cMutex);
+                }
+                cycleDone = true;
+                continue;
+            }
+            self->writeBurst(burst, burstItems);
+            burstItems = 0;
+            continue;
+        }
+        
+        if (item.type == WRITE_ITEM_DATA) {
+            if (burstItems > 0 && self->mergeWrite(burst, item)) {
+                burstItems++;
+                continue;
+            }
+            if (burstItems > 0) {
+                self->writeBurst(burst, burstItems);
+            }
+            burst = item;
+            burstItems = 1;
+            cycleDone = false;
+            continue;
+        }
+        
+        // Barrera: lo anterior queda grabado antes de avisar
+        if (burstItems > 0) {
+            self->writeBurst(burst, burstItems);
+            burstItems = 0;
+        }
+        
+        self->barrierDoneSeq = item.barrierSeq;
+        if (item.type == WRITE_ITEM_FLUSH) {
+            xSemaphoreGive(self->barrierDone);
+            continue;
+        }
+        
+        // WRITE_ITEM_STOP
+        self->writerHandle = NULL;
+        xSemaphoreGive(self->barrierDone);
+        vTaskDelete(NULL);
+        return;
+    }
+}
+
+// ============================================================================
+// COPIA EN RAM
+// ============================================================================
+
+EEPROMStatus EEPROMManager::enableShadow(uint16_t start, uint16_t length) {
+    if (!initialized) return EEPROM_ERROR_NOT_INITIALIZED;
+    if (shadow != NULL) return EEPROM_OK;
+    if (start >= eepromSize) return EEPROM_ERROR_ADDRESS_OUT_OF_RANGE;
+    
+    // Región a páginas completas
+    uint32_t end = (length == 0) ? eepromSize : (uint32_t)start + length;
+    if (end > eepromSize) return EEPROM_ERROR_ADDRESS_OUT_OF_RANGE;
+    uint16_t alignedStart = start - (start % EEPROM_PAGE_SIZE);
+    end = ((end + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE) * EEPROM_PAGE_SIZE;
+    if (end > eepromSize) end = eepromSize;
+    uint16_t alignedLength = end - alignedStart;
+    
+    uint16_t pageCount = (alignedLength + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE;
+    uint8_t* buffer = (uint8_t*)malloc(alignedLength);
+    uint32_t* dirty = (uint32_t*)calloc((pageCount + 31) / 32, sizeof(uint32_t));
+    if (shadowMutex == NULL) {
+        shadowMutex = xSemaphoreCreateMutex();
+    }
+    if (buffer == NULL || dirty == NULL || shadowMutex == NULL) {
+        Serial.printf("[EEPROM] ERROR: Sin memoria para la copia en RAM (%u bytes)\n", alignedLength);
+        free(buffer);
+        free(dirty);
+        return EEPROM_ERROR_NOT_INITIALIZED;
+    }
+    
+    // Carga en lecturas secuenciales largas: dos transacciones por bloque
+    // en lugar de dos por cada readBytes()
+    unsigned long startUs = micros();
+    for (uint32_t offset = 0; offset < alignedLength; offset += EEPROM_SHADOW_LOAD_CHUNK) {
+        uint32_t chunk = alignedLength - offset;
+        if (chunk > EEPROM_SHADOW_LOAD_CHUNK) chunk = EEPROM_SHADOW_LOAD_CHUNK;
+        
+        esp_err_t err = readRaw(alignedStart + offset, buffer + offset, chunk);
+        if (err != ESP_OK) {
+            Serial.printf("[EEPROM] ERROR: Carga de la copia en RAM falló en 0x%04lX (0x%x)\n",
+                          (unsigned long)(alignedStart + offset), err);
+            free(buffer);
+            free(dirty);
+            return EEPROM_ERROR_READ_FAILED;
+        }
+    }
+    unsigned long loadUs = micros() - startUs;
+    
+    xSemaphoreTake(shadowMutex, portMAX_DELAY);
+    shadowStart = alignedStart;
+    shadowLength = alignedLength;
+    dirtyPages = dirty;
+    memset(&shadowStats, 0, sizeof(shadowStats));
+    shadowStats.start = alignedStart;
+    shadowStats.length = alignedLength;
+    shadowStats.loadUs = loadUs;
+    shadow = buffer;
+    xSemaphoreGive(shadowMutex);
+    
+    Serial.printf("[EEPROM] ✓ Copia en RAM: 0x%04X-0x%04X (%u bytes) cargada en %lu ms (%lu kB/s)\n",
+                  alignedStart, alignedStart + alignedLength - 1, alignedLength, loadUs / 1000,
+                  loadUs > 0 ? (unsigned long)((uint64_t)alignedLength * 1000 / loadUs) : 0UL);
+    return EEPROM_OK;
+}
+
+EEPROMStatus EEPROMManager::disableShadow() {
+    if (shadow == NULL) return EEPROM_OK;
+    
+    EEPROMStatus status = writeBackShadow();
+    if (status != EEPROM_OK) {
+        // Se conserva la copia: las páginas sucias no se pierden
+        Serial.println("[EEPROM] ERROR: No se pudieron grabar las páginas sucias");
+        return status;
+    }
+    
+    xSemaphoreTake(shadowMutex, portMAX_DELAY);
+    free(shadow);
+    free(dirtyPages);
+    shadow = NULL;
+    dirtyPages = NULL;
+    shadowStart = 0;
+    shadowLength = 0;
+    xSemaphoreGive(shadowMutex);
+    
+    Serial.println("[EEPROM] Copia en RAM liberada");
+    return EEPROM_OK;
+}
+
+// Copia a RAM y marca sucias sólo las páginas cuyo contenido cambia
+void EEPROMManager::writeShadow(uint16_t address, const uint8_t* data, size_t length) {
+    xSemaphoreTake(shadowMutex, portMAX_DELAY);
+    
+    size_t done = 0;
+    while (done < length) {
+        uint16_t current = address + done;
+        size_t pageRemaining = EEPROM_PAGE_SIZE - (current % EEPROM_PAGE_SIZE);
+        size_t chunk = (pageRemaining < (length - done)) ? pageRemaining : (length - done);
+        
+        uint8_t* target = shadow + (current - shadowStart);
+        if (memcmp(target, data + done, chunk) != 0) {
+            memcpy(target, data + done, chunk);
+            uint16_t page = (current - shadowStart) / EEPROM_PAGE_SIZE;
+            if (!(dirtyPages[page / 32] & (1UL << (page % 32)))) {
+                dirtyPages[page / 32] |= (1UL << (page % 32));
+                shadowStats.dirtyPages++;
+            }
+        }
+        done += chunk;
+    }
+    
+    xSemaphoreGive(shadowMutex);
+}
+
+// Graba las páginas sucias (encoladas si la escritura diferida está activa)
+EEPROMStatus EEPROMManager::writeBackShadow() {
+    if (shadow == NULL) return EEPROM_OK;
+    
+    xSemaphoreTake(shadowMutex, portMAX_DELAY);
+    
+    EEPROMStatus status = EEPROM_OK;
+    uint16_t pageCount = (shadowLength + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE;
+    for (uint16_t page = 0; page < pageCount && shadowStats.dirtyPages > 0; page++) {
+        if (!(dirtyPages[page / 32] & (1UL << (page % 32)))) continue;
+        
+        uint16_t offset = page * EEPROM_PAGE_SIZE;
+        uint16_t length = (shadowLength - offset < EEPROM_PAGE_SIZE) ? shadowLength - offset : EEPROM_PAGE_SIZE;
+        status = writeDevice(shadowStart + offset, shadow + offset, length);
+        if (status != EEPROM_OK) break;  // La página sigue sucia
+        
+        dirtyPages[page / 32] &= ~(1UL << (page % 32));
+        shadowStats.dirtyPages--;
+        shadowStats.pagesWrittenBack++;
+    }
+    
+    xSemaphoreGive(shadowMutex);
+    return status;
+}
+
+EEPROMShadowStats EEPROMManager::getShadowStats() {
+    if (shadowMutex == NULL) {
+        EEPROMShadowStats empty;
+        memset(&empty, 0, sizeof(empty));
+        return empty;
+    }
+    
+    xSemaphoreTake(shadowMutex, portMAX_DELAY);
+    EEPROMShadowStats copy = shadowStats;
+    if (shadow == NULL) {
+        copy.start = 0;
+        copy.length = 0;
+    }
+    xSemaphoreGive(shadowMutex);
+    return copy;
 }
 
 // ============================================================================
@@ -384,9 +954,9 @@ EEPROMStatus EEPROMManager::fill(uint16_t startAddress, uint16_t length, uint8_t
     while (remaining > 0) {
         uint16_t toWrite = (remaining > EEPROM_PAGE_SIZE) ? EEPROM_PAGE_SIZE : remaining;
         
-        esp_err_t err = writeRaw(address, fillBuffer, toWrite);
-        if (err != ESP_OK) {
-            return EEPROM_ERROR_WRITE_FAILED;
+        EEPROMStatus status = writeBytes(address, fillBuffer, toWrite);
+        if (status != EEPROM_OK) {
+            return status;
         }
         
         address += toWrite;
@@ -405,6 +975,25 @@ uint16_t EEPROMManager::getFreeSpace(uint16_t fromAddress) {
     return eepromSize - fromAddress;
 }
 
+EEPROMWriteStats EEPROMManager::getWriteStats() {
+    portENTER_CRITICAL(&statsMux);
+    EEPROMWriteStats copy = stats;
+    portEXIT_CRITICAL(&statsMux);
+    
+    copy.queueDepth = getQueueDepth();
+    return copy;
+}
+
+uint16_t EEPROMManager::getQueueDepth() {
+    return (writeQueue != NULL) ? uxQueueMessagesWaiting(writeQueue) : 0;
+}
+
+void EEPROMManager::resetWriteStats() {
+    portENTER_CRITICAL(&statsMux);
+    memset(&stats, 0, sizeof(stats));
+    portEXIT_CRITICAL(&statsMux);
+}
+
 void EEPROMManager::printStatus() {
     Serial.println("\n╔════════════════════════════════════════╗");
     Serial.println("║     EEPROM Manager - Estado            ║");
@@ -416,6 +1005,30 @@ void EEPROMManager::printStatus() {
     Serial.printf("  Tamaño de página: %d bytes\n", EEPROM_PAGE_SIZE);
     Serial.printf("  Pines I2C: SDA=%d, SCL=%d\n", sdaPin, sclPin);
     Serial.printf("  Frecuencia: %lu Hz\n", frequency);
+    
+    if (isShadowEnabled()) {
+        EEPROMShadowStats ss = getShadowStats();
+        Serial.printf("  Copia en RAM: 0x%04X-0x%04X (%u bytes, cargada en %lu us)\n",
+                      ss.start, ss.start + ss.length - 1, ss.length, ss.loadUs);
+        Serial.printf("  Lecturas: %lu desde RAM, %lu a la EEPROM\n", ss.hits, ss.misses);
+        Serial.printf("  Páginas sucias: %u (%lu grabadas)\n", ss.dirtyPages, ss.pagesWrittenBack);
+    } else {
+        Serial.println("  Copia en RAM: ✗ No");
+    }
+    
+    EEPROMWriteStats ws = getWriteStats();
+    Serial.printf("  Escritura diferida: %s\n", isWriteBehindEnabled() ? "✓ Activa" : "✗ No (síncrona)");
+    Serial.printf("  Páginas escritas: %lu (%lu bytes, %lu errores)\n",
+                  ws.pagesWritten, ws.bytesWritten, ws.writeErrors);
+    Serial.printf("  Ciclo de grabación: último %lu us, máx %lu us (%lu sondeos)\n",
+                  ws.lastCycleUs, ws.maxCycleUs, ws.ackPolls);
+    if (isWriteBehindEnabled()) {
+        Serial.printf("  Cola: %u ahora, máx %u, %lu esperas por cola llena\n",
+                      ws.queueDepth, ws.queueHighWater, ws.queueFullWaits);
+        Serial.printf("  Encoladas: %lu (%lu fusionadas)\n", ws.requestsQueued, ws.requestsCoalesced);
+        Serial.printf("  Latencia: última %lu us, prom %lu us, máx %lu us\n",
+                      ws.lastLatencyUs, ws.avgLatencyUs, ws.maxLatencyUs);
+    }
     Serial.println("════════════════════════════════════════\n");
 }
 
@@ -13,27 +13,58 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <esp_wifi.h>
 
 // Managers modulares
 #include <SystemManager.h>
 #include <FlashStorageManager.h>
+#include <FlashQueueManager.h>
 #include <WiFiManager.h>
 #include <MQTTManager.h>
 #include <ModbusManager.h>
+#include <CommandDispatcher.h>
+#include <AggregationManager.h>
+#include <HistoryManager.h>
+#include <TimeSyncManager.h>
+#include <PeriodicJobManager.h>
+#include <ConfigCommitManager.h>
+#include <DeviceProfileManager.h>
+#include <CounterLogManager.h>
 
 // Configuración
 #include "config.h"
 #include "tasks.h"
+#include "modbus_commands.h"
+#include "polling.h"
+#include "config_image.h"
+#include "boot_profile.h"
 
 // ============================================================================
 // CONFIGURACIÓN GLOBAL
 // ============================================================================
 SensorConfig sensorConfig;
 SystemStats systemStats;
+uint32_t bootCount = 0;     // Arranques totales (partición "statslog")
+
+// Enlace WiFi: la conexión sigue en segundo plano (ver checkNetwork)
+static volatile uint32_t wifiDownSince = 0;   // millis() sin IP desde (0 = con IP)
+static volatile bool wifiFailureLogged = false;
 
 // Configuración WiFi y MQTT (usando las estructuras de los managers)
 WiFiConfig wifiConfig;
 MQTTConfig mqttConfig;
+NtpConfig ntpConfig;
+
+// Tópicos MQTT precalculados (se arman una vez que se conoce el clientId)
+char cmdTopic[96];
+char statusTopic[96];
+char responseTopic[96];
+
+void buildMqttTopics() {
+  snprintf(cmdTopic, sizeof(cmdTopic), "%s/%s/%s", MQTT_TOPIC_BASE, mqttConfig.clientId, MQTT_TOPIC_CMD);
+  snprintf(statusTopic, sizeof(statusTopic), "%s/%s/%s", MQTT_TOPIC_BASE, mqttConfig.clientId, MQTT_TOPIC_STATUS);
+  snprintf(responseTopic, sizeof(responseTopic), "%s/%s/%s", MQTT_TOPIC_BASE, mqttConfig.clientId, MQTT_TOPIC_RESPONSE);
+}
 
 // Sistema de errores
 SystemError lastError;
@@ -82,18 +113,27 @@ void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
   switch (event) {
     case ARDUINO_EVENT_WIFI_STA_CONNECTED:
       Serial.println("[WiFi] ✓ Conectado a la red");
+      bootPhaseEnd(BOOT_PHASE_WIFI_ASSOC);
+      bootPhaseBegin(BOOT_PHASE_WIFI_DHCP);
       clearError();  // Limpiar errores de WiFi al conectar
       break;
       
     case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
       Serial.println("[WiFi] ✗ Desconectado de la red");
       systemStats.wifiReconnects++;
+      if (wifiDownSince == 0) {
+        wifiDownSince = millis();
+      }
       logError(ERROR_WIFI, ERR_WIFI_DISCONNECTED);
       break;
       
     case ARDUINO_EVENT_WIFI_STA_GOT_IP:
     {
       Serial.printf("[WiFi] ✓ IP obtenida: %s\n", WiFi.localIP().toString().c_str());
+      wifiDownSince = 0;
+      wifiFailureLogged = false;
+      bootPhaseEnd(BOOT_PHASE_WIFI_DHCP);
+      bootPhaseBegin(BOOT_PHASE_MQTT_CONNECT);
       
       // Verificar señal WiFi débil
       int8_t rssi = WiFi.RSSI();
@@ -102,17 +142,8 @@ void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
                  String("Señal débil: " + String(rssi) + " dBm").c_str());
       }
       
-      // Conectar MQTT cuando tengamos IP
-      if (strlen(mqttConfig.server) > 0 && !MqttMgr.isConnected()) {
-        Serial.println("[MQTT] Intentando conectar al broker...");
-        if (MqttMgr.connect()) {
-          Serial.println("[MQTT] ✓ Conectado al broker");
-          // Suscribirse a topics de comando
-          MqttMgr.subscribe("nehuentue/+/command");
-        } else {
-          logError(ERROR_MQTT, ERR_MQTT_CONNECTION_FAILED);
-        }
-      }
+      // Despertar la tarea MQTT: conecta al broker ya, sin esperar el intervalo de reintento
+      MqttMgr.requestReconnect();
       break;
     }
       
@@ -127,287 +158,791 @@ void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
 }
 
 /**
- * @brief Callback para mensajes MQTT recibidos con comandos JSON
- * 
- * Comandos soportados:
- * - {"cmd":"get_status"}
- * - {"cmd":"get_config"}
- * - {"cmd":"set_wifi","ssid":"...", "password":"..."}
- * - {"cmd":"set_mqtt","server":"...", "port":1883, "user":"...", "password":"..."}
- * - {"cmd":"set_sensor","name":"...", "address":1, "register":0, "count":2}
- * - {"cmd":"scan_wifi"}
- * - {"cmd":"restart"}
- * - {"cmd":"factory_reset"}
+ * @brief Compara un payload (sin terminador) con un comando de texto
  */
-void onMqttMessage(char* topic, byte* payload, unsigned int length) {
-  String topicStr = String(topic);
+static bool payloadEquals(const byte* payload, unsigned int length, const char* text) {
+  size_t textLength = strlen(text);
+  return length == textLength && memcmp(payload, text, textLength) == 0;
+}
+
+/**
+ * @brief Callback de conexión MQTT (corre en la tarea MQTT)
+ *
+ * Se ejecuta en cada (re)conexión: restablece suscripciones y anuncia
+ * el estado online.
+ */
+void onMqttConnection(bool connected) {
+  if (!connected) {
+    logError(ERROR_MQTT, ERR_MQTT_CONNECTION_FAILED);
+    return;
+  }
   
-  // Convertir payload a String
-  char buffer[length + 1];
-  memcpy(buffer, payload, length);
-  buffer[length] = '\0';
-  String payloadStr = String(buffer);
+  Serial.println("[MQTT] ✓ Conectado al broker");
+  bootPhaseEnd(BOOT_PHASE_MQTT_CONNECT);
   
-  Serial.printf("[MQTT] Mensaje [%s]: %s\n", topic, payloadStr.c_str());
+  // Suscribirse al tópico de comandos
+  MqttMgr.subscribe(cmdTopic);
+  MqttMgr.subscribe("nehuentue/+/command");
+  subscribeRawModbus();
   
-  // Intentar parsear como JSON
-  StaticJsonDocument<512> doc;
-  DeserializationError error = deserializeJson(doc, payloadStr);
+  // Publicar mensaje de inicio (el primero del arranque lleva el perfil de tiempos)
+  StaticJsonDocument<1536> doc;
+  doc["status"] = "online";
+  doc["firmware"] = FIRMWARE_VERSION;
+  bool withProfile = bootProfilePending();
+  if (withProfile) {
+    bootProfileToJson(doc.createNestedObject("boot"));
+  }
+  if (MqttMgr.publishJSON(statusTopic, doc) && withProfile) {
+    bootProfileMarkPublished();
+    bootProfilePrint();
+  }
+}
+
+// ============================================================================
+// COMANDOS MQTT
+// ============================================================================
+// Cada comando es un handler registrado en CmdDispatcher con su esquema de
+// parámetros; el despachador valida requeridos/tipos antes de llamarlo.
+// Otros módulos pueden registrar sus propios comandos de la misma forma.
+// Los marcados CMD_FLAG_ASYNC (esperas largas, reinicios) corren en la
+// tarea worker del despachador para no frenar la tarea MQTT.
+
+// ========== GET STATUS ==========
+static void cmdGetStatus(CommandContext& ctx) {
+  StaticJsonDocument<2048> response;  // Incluye errores y trabajos periódicos
+  response["cmd"] = "get_status";
+  response["status"] = "ok";
   
-  String responseTopic = String(MQTT_TOPIC_BASE) + "/" + String(mqttConfig.clientId) + "/" + String(MQTT_TOPIC_RESPONSE);
+  JsonObject system = response.createNestedObject("system");
+  system["uptime"] = millis() / 1000;
+  system["heap_free"] = ESP.getFreeHeap();
+  system["cpu_freq"] = ESP.getCpuFreqMHz();
+  system["boots"] = bootCount;
   
-  if (error) {
-    // No es JSON válido, intentar comandos simples (retrocompatibilidad)
-    if (payloadStr == "restart") {
-      Serial.println("[CMD] Reiniciando...");
-      MqttMgr.publish(responseTopic.c_str(), "{\"status\":\"restarting\"}");
-      delay(500);
-      SysMgr.restart(1000);
-      return;
-    }
-    else if (payloadStr == "status") {
-      SysMgr.printStatus();
-      ModbusMgr.printStats();
-      MqttMgr.printStats();
-      return;
-    }
-    
-    Serial.printf("[CMD] Error JSON: %s\n", error.c_str());
-    MqttMgr.publish(responseTopic.c_str(), "{\"error\":\"invalid_json\"}");
+  JsonObject wifi = response.createNestedObject("wifi");
+  wifi["connected"] = WifiMgr.isConnected();
+  
+  // SSID e IP sin String (sin heap en el camino de entrada)
+  wifi_ap_record_t apInfo;
+  if (esp_wifi_sta_get_ap_info(&apInfo) == ESP_OK) {
+    wifi["ssid"] = (char*)apInfo.ssid;
+  } else {
+    wifi["ssid"] = "";
+  }
+  wifi["rssi"] = WifiMgr.getRSSI();
+  IPAddress ip = WifiMgr.getIP();
+  char ipStr[16];
+  snprintf(ipStr, sizeof(ipStr), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  wifi["ip"] = ipStr;
+  
+  JsonObject mqtt = response.createNestedObject("mqtt");
+  mqtt["connected"] = MqttMgr.isConnected();
+  mqtt["server"] = mqttConfig.server;
+  mqtt["backlog"] = FlashQueue.pendingCount();
+  mqtt["backlog_bytes"] = FlashQueue.pendingBytes();
+  MQTTQoSStats qos = MqttMgr.getQoSStats();
+  mqtt["qos"] = qos.qos;
+  mqtt["inflight"] = qos.inflight;
+  mqtt["retransmits"] = qos.retransmits;
+  mqtt["msg_per_s"] = qos.messagesPerSecond;
+  mqtt["ack_latency_us"] = qos.ackLatencyAvgUs;
+  mqtt["ack_latency_max_us"] = qos.ackLatencyMaxUs;
+  
+  JsonObject modbus = response.createNestedObject("modbus");
+  PollingStats polling = PollMgr.getStats();
+  modbus["enabled"] = PollMgr.isRunning();
+  modbus["reads_ok"] = polling.reads - polling.failures;
+  modbus["reads_fail"] = polling.failures;
+  modbus["plan"] = polling.generation;
+  
+  JsonObject clock = response.createNestedObject("time");
+  TimeSyncStats timeStats = TimeMgr.getStats();
+  clock["synced"] = timeStats.synced;
+  if (timeStats.synced) {
+    clock["utc_ms"] = TimeMgr.nowUtcUs() / 1000;
+    clock["error_us"] = timeStats.lastErrorUs;
+    clock["delay_us"] = timeStats.lastDelayUs;
+    clock["drift_ppm"] = timeStats.driftPpm;
+    clock["age_s"] = (millis() - timeStats.lastSync) / 1000;
+  }
+  
+  // Trabajos periódicos: plazos vencidos y p99 de jitter/duración
+  JsonArray jobs = response.createNestedArray("jobs");
+  for (uint8_t i = 0; i < JobMgr.getJobCount(); i++) {
+    JobStats job;
+    if (!JobMgr.getJob(i, job)) continue;
+    JsonObject item = jobs.createNestedObject();
+    item["name"] = job.name;
+    item["misses"] = job.misses;
+    item["jitter_p99_us"] = job.jitter.percentile(99);
+    item["run_p99_us"] = job.runtime.percentile(99);
+  }
+  
+  // Commits de configuración a NVS
+  JsonObject config = response.createNestedObject("config");
+  ConfigCommitStats commitStats = ConfigMgr.getStats();
+  config["pending"] = commitStats.pending;
+  config["commits"] = commitStats.commits;
+  config["writes"] = commitStats.writes;
+  config["skipped"] = commitStats.skipped;
+  
+  // Información de errores
+  JsonObject error = response.createNestedObject("error");
+  error["code"] = lastError.code;
+  error["type"] = getErrorTypeName(lastError.type);
+  error["description"] = lastError.description;
+  error["active"] = lastError.active;
+  if (lastError.active) {
+    error["timestamp"] = lastError.timestamp;
+    error["age_seconds"] = (millis() - lastError.timestamp) / 1000;
+  }
+  
+  ctx.reply(response);
+}
+
+// ========== GET CONFIG ==========
+static void cmdGetConfig(CommandContext& ctx) {
+  StaticJsonDocument<512> response;
+  response["cmd"] = "get_config";
+  response["status"] = "ok";
+  
+  JsonObject wifi = response.createNestedObject("wifi");
+  wifi["ssid"] = wifiConfig.ssid;
+  wifi["hostname"] = wifiConfig.hostname;
+  
+  JsonObject mqtt = response.createNestedObject("mqtt");
+  mqtt["server"] = mqttConfig.server;
+  mqtt["port"] = mqttConfig.port;
+  mqtt["user"] = mqttConfig.user;
+  mqtt["client_id"] = mqttConfig.clientId;
+  
+  JsonObject sensor = response.createNestedObject("sensor");
+  sensor["name"] = sensorConfig.name;
+  sensor["address"] = sensorConfig.slaveId;
+  sensor["register"] = sensorConfig.startAddress;
+  sensor["count"] = sensorConfig.quantity;
+  sensor["function"] = sensorConfig.modbusFunction;
+  sensor["interval"] = sensorConfig.pollInterval;
+  sensor["baudrate"] = sensorConfig.baudrate;
+  
+  ctx.reply(response);
+}
+
+// ========== SET WIFI ==========
+static const CommandParam setWifiParams[] = {
+  {"ssid", CMD_PARAM_STRING, true},
+  {"password", CMD_PARAM_STRING, true},
+};
+
+static void cmdSetWifi(CommandContext& ctx) {
+  const char* ssid = ctx.request["ssid"];
+  const char* password = ctx.request["password"];
+  
+  strncpy(wifiConfig.ssid, ssid, sizeof(wifiConfig.ssid) - 1);
+  strncpy(wifiConfig.password, password, sizeof(wifiConfig.password) - 1);
+  
+  // Guardar en flash (commit diferido: una imagen igual no se reescribe)
+  saveConfigImage();
+  
+  ctx.reply("{\"status\":\"ok\",\"message\":\"WiFi guardado, reinicia para aplicar\"}");
+  Serial.printf("[CMD] WiFi configurado: %s\n", ssid);
+}
+
+// ========== SET MQTT ==========
+static const CommandParam setMqttParams[] = {
+  {"server", CMD_PARAM_STRING, true},
+  {"port", CMD_PARAM_INT, false},
+  {"user", CMD_PARAM_STRING, false},
+  {"password", CMD_PARAM_STRING, false},
+};
+
+static void cmdSetMqtt(CommandContext& ctx) {
+  const char* server = ctx.request["server"];
+  int port = ctx.request["port"] | 1883;
+  const char* user = ctx.request["user"];
+  const char* password = ctx.request["password"];
+  
+  strncpy(mqttConfig.server, server, sizeof(mqttConfig.server) - 1);
+  mqttConfig.port = port;
+  if (user) strncpy(mqttConfig.user, user, sizeof(mqttConfig.user) - 1);
+  if (password) strncpy(mqttConfig.password, password, sizeof(mqttConfig.password) - 1);
+  
+  // Guardar en flash (commit diferido: una sola escritura de la imagen)
+  saveConfigImage();
+  
+  ctx.reply("{\"status\":\"ok\",\"message\":\"MQTT guardado, reinicia para aplicar\"}");
+  Serial.printf("[CMD] MQTT configurado: %s:%d\n", server, port);
+}
+
+// ========== SET NTP ==========
+static const CommandParam setNtpParams[] = {
+  {"server", CMD_PARAM_STRING, true},
+  {"port", CMD_PARAM_INT, false},
+};
+
+static void cmdSetNtp(CommandContext& ctx) {
+  const char* server = ctx.request["server"];
+  int port = ctx.request["port"] | TIME_SYNC_DEFAULT_PORT;
+  
+  // Se aplica en caliente: la tarea de hora hace una ronda inmediata
+  if (port <= 0 || port > 65535 || !TimeMgr.setServer(server, port)) {
+    ctx.replyError("invalid_param", (port <= 0 || port > 65535) ? "port" : "server");
     return;
   }
   
-  // Procesar comando JSON
-  const char* cmd = doc["cmd"];
-  if (cmd == nullptr) {
-    MqttMgr.publish(responseTopic.c_str(), "{\"error\":\"missing_cmd\"}");
+  strncpy(ntpConfig.server, server, sizeof(ntpConfig.server) - 1);
+  ntpConfig.port = port;
+  saveConfigImage();
+  
+  ctx.reply("{\"status\":\"ok\",\"message\":\"Servidor NTP aplicado\"}");
+  Serial.printf("[CMD] NTP configurado: %s:%d\n", server, port);
+}
+
+// ========== SET SENSOR ==========
+static const CommandParam setSensorParams[] = {
+  {"name", CMD_PARAM_STRING, false},
+  {"address", CMD_PARAM_INT, false},
+  {"register", CMD_PARAM_INT, false},
+  {"count", CMD_PARAM_INT, false},
+  {"multiplier", CMD_PARAM_FLOAT, false},
+  {"offset", CMD_PARAM_FLOAT, false},
+  {"function", CMD_PARAM_INT, false},
+  {"interval", CMD_PARAM_INT, false},
+  {"baudrate", CMD_PARAM_INT, false},
+  {"rx", CMD_PARAM_INT, false},
+  {"tx", CMD_PARAM_INT, false},
+  {"enabled", CMD_PARAM_BOOL, false},
+};
+
+static void cmdSetSensor(CommandContext& ctx) {
+  JsonDocument& doc = ctx.request;
+  SensorConfig previous = sensorConfig;
+  
+  if (doc.containsKey("name")) strncpy(sensorConfig.name, doc["name"], sizeof(sensorConfig.name) - 1);
+  if (doc.containsKey("address")) sensorConfig.slaveId = doc["address"];
+  if (doc.containsKey("register")) sensorConfig.startAddress = doc["register"];
+  if (doc.containsKey("count")) sensorConfig.quantity = doc["count"];
+  if (doc.containsKey("multiplier")) sensorConfig.multiplier = doc["multiplier"];
+  if (doc.containsKey("offset")) sensorConfig.offset = doc["offset"];
+  if (doc.containsKey("function")) sensorConfig.modbusFunction = doc["function"];
+  if (doc.containsKey("interval")) sensorConfig.pollInterval = doc["interval"];
+  if (doc.containsKey("baudrate")) sensorConfig.baudrate = doc["baudrate"];
+  if (doc.containsKey("rx")) sensorConfig.rxPin = doc["rx"];
+  if (doc.containsKey("tx")) sensorConfig.txPin = doc["tx"];
+  if (doc.containsKey("enabled")) sensorConfig.enabled = doc["enabled"];
+  
+  // Aplicar en caliente (el plan se adopta al terminar el ciclo en curso);
+  // si el plan es inválido no se guarda nada
+  if (!applyPollingConfig(ctx)) {
+    sensorConfig = previous;
     return;
   }
   
-  Serial.printf("[CMD] Ejecutando: %s\n", cmd);
+  // Guardar en flash (commit diferido)
+  saveConfigImage();
+  Serial.println("[CMD] Sensor configurado");
+}
+
+// ========== SCAN WIFI ==========
+static void cmdScanWifi(CommandContext& ctx) {
+  Serial.println("[CMD] Escaneando redes WiFi...");
+  WifiMgr.startScan();
   
-  // ========== GET STATUS ==========
-  if (strcmp(cmd, "get_status") == 0) {
-    StaticJsonDocument<1024> response;  // Aumentado para incluir errores
-    response["cmd"] = "get_status";
+  // Esperar a que termine (máx 10 segundos)
+  int attempts = 0;
+  while (WiFi.scanComplete() == WIFI_SCAN_RUNNING && attempts < 20) {
+    delay(500);
+    attempts++;
+  }
+  
+  int n = WiFi.scanComplete();
+  if (n >= 0) {
+    StaticJsonDocument<1024> response;
+    response["cmd"] = "scan_wifi";
     response["status"] = "ok";
+    JsonArray networks = response.createNestedArray("networks");
     
-    JsonObject system = response.createNestedObject("system");
-    system["uptime"] = millis() / 1000;
-    system["heap_free"] = ESP.getFreeHeap();
-    system["cpu_freq"] = ESP.getCpuFreqMHz();
-    
-    JsonObject wifi = response.createNestedObject("wifi");
-    wifi["connected"] = WifiMgr.isConnected();
-    wifi["ssid"] = WifiMgr.getSSID();
-    wifi["rssi"] = WifiMgr.getRSSI();
-    wifi["ip"] = WifiMgr.getIP().toString();
-    
-    JsonObject mqtt = response.createNestedObject("mqtt");
-    mqtt["connected"] = MqttMgr.isConnected();
-    mqtt["server"] = mqttConfig.server;
-    
-    JsonObject modbus = response.createNestedObject("modbus");
-    modbus["enabled"] = true;
-    modbus["reads_ok"] = systemStats.successfulReads;
-    modbus["reads_fail"] = systemStats.failedReads;
-    
-    // Información de errores
-    JsonObject error = response.createNestedObject("error");
-    error["code"] = lastError.code;
-    error["type"] = getErrorTypeName(lastError.type);
-    error["description"] = lastError.description;
-    error["active"] = lastError.active;
-    if (lastError.active) {
-      error["timestamp"] = lastError.timestamp;
-      error["age_seconds"] = (millis() - lastError.timestamp) / 1000;
+    for (int i = 0; i < n && i < 10; i++) {  // Máximo 10 redes
+      wifi_ap_record_t* ap = (wifi_ap_record_t*)WiFi.getScanInfoByIndex(i);
+      if (ap == nullptr) continue;
+      JsonObject net = networks.createNestedObject();
+      net["ssid"] = (char*)ap->ssid;  // Copia al documento, sin String
+      net["rssi"] = ap->rssi;
+      net["channel"] = ap->primary;
+      net["encrypted"] = (ap->authmode != WIFI_AUTH_OPEN);
     }
     
-    String output;
-    serializeJson(response, output);
-    MqttMgr.publish(responseTopic.c_str(), output.c_str());
+    ctx.reply(response);
+    WiFi.scanDelete();
+  } else {
+    ctx.reply("{\"error\":\"scan_failed\"}");
   }
+}
+
+// ========== GET ERROR HISTORY ==========
+static void cmdGetErrors(CommandContext& ctx) {
+  StaticJsonDocument<1024> response;
+  response["cmd"] = "get_errors";
+  response["status"] = "ok";
+  response["total_errors"] = errorCount;
   
-  // ========== GET CONFIG ==========
-  else if (strcmp(cmd, "get_config") == 0) {
-    StaticJsonDocument<512> response;
-    response["cmd"] = "get_config";
-    response["status"] = "ok";
-    
-    JsonObject wifi = response.createNestedObject("wifi");
-    wifi["ssid"] = wifiConfig.ssid;
-    wifi["hostname"] = wifiConfig.hostname;
-    
-    JsonObject mqtt = response.createNestedObject("mqtt");
-    mqtt["server"] = mqttConfig.server;
-    mqtt["port"] = mqttConfig.port;
-    mqtt["user"] = mqttConfig.user;
-    mqtt["client_id"] = mqttConfig.clientId;
-    
-    JsonObject sensor = response.createNestedObject("sensor");
-    sensor["name"] = sensorConfig.name;
-    sensor["address"] = sensorConfig.modbusAddress;
-    sensor["register"] = sensorConfig.registerStart;
-    sensor["count"] = sensorConfig.registerCount;
-    
-    String output;
-    serializeJson(response, output);
-    MqttMgr.publish(responseTopic.c_str(), output.c_str());
+  JsonArray errorArray = response.createNestedArray("errors");
+  int start = (errorCount > 5) ? (errorCount - 5) : 0;
+  int count = min(errorCount, 5);
+  
+  // Recorrer el buffer circular del más antiguo al más reciente
+  for (int i = 0; i < count; i++) {
+    JsonObject err = errorArray.createNestedObject();
+    SystemError& e = errors[(start + i) % 5];
+    err["code"] = e.code;
+    err["type"] = getErrorTypeName(e.type);
+    err["description"] = e.description;
+    err["timestamp"] = e.timestamp;
+    err["age_seconds"] = (millis() - e.timestamp) / 1000;
   }
   
-  // ========== SET WIFI ==========
-  else if (strcmp(cmd, "set_wifi") == 0) {
-    const char* ssid = doc["ssid"];
-    const char* password = doc["password"];
-    
-    if (ssid != nullptr && password != nullptr) {
-      strncpy(wifiConfig.ssid, ssid, sizeof(wifiConfig.ssid) - 1);
-      strncpy(wifiConfig.password, password, sizeof(wifiConfig.password) - 1);
-      
-      // Guardar en flash (auto-commit)
-      FlashStorage.saveString("wifi_ssid", ssid);
-      FlashStorage.saveString("wifi_password", password);
-      
-      MqttMgr.publish(responseTopic.c_str(), "{\"status\":\"ok\",\"message\":\"WiFi guardado, reinicia para aplicar\"}");
-      Serial.printf("[CMD] WiFi configurado: %s\n", ssid);
-    } else {
-      MqttMgr.publish(responseTopic.c_str(), "{\"error\":\"missing_params\"}");
-    }
+  ctx.reply(response);
+}
+
+// ========== GET JOBS ==========
+static const CommandParam getJobsParams[] = {
+  {"reset", CMD_PARAM_BOOL, false},
+};
+
+static void addHistogram(JsonObject parent, const char* key, const JobHistogram& histogram) {
+  JsonObject out = parent.createNestedObject(key);
+  out["p50_us"] = histogram.percentile(50);
+  out["p99_us"] = histogram.percentile(99);
+  out["max_us"] = histogram.maxUs;
+  
+  // Buckets hasta el último con datos (límites: 64 us, 128 us, ...)
+  int8_t last = JOB_MGR_BUCKETS - 1;
+  while (last >= 0 && histogram.counts[last] == 0) last--;
+  JsonArray counts = out.createNestedArray("hist");
+  for (int8_t i = 0; i <= last; i++) {
+    counts.add(histogram.counts[i]);
+  }
+}
+
+static void cmdGetJobs(CommandContext& ctx) {
+  DynamicJsonDocument response(JSON_OBJECT_SIZE(3) + JSON_ARRAY_SIZE(JOB_MGR_MAX_JOBS) +
+                               JOB_MGR_MAX_JOBS * (JSON_OBJECT_SIZE(8) +
+                               2 * (JSON_OBJECT_SIZE(4) + JSON_ARRAY_SIZE(JOB_MGR_BUCKETS))));
+  if (response.capacity() == 0) {
+    ctx.replyError("no_memory");
+    return;
   }
   
-  // ========== SET MQTT ==========
-  else if (strcmp(cmd, "set_mqtt") == 0) {
-    const char* server = doc["server"];
-    int port = doc["port"] | 1883;
-    const char* user = doc["user"];
-    const char* password = doc["password"];
-    
-    if (server != nullptr) {
-      strncpy(mqttConfig.server, server, sizeof(mqttConfig.server) - 1);
-      mqttConfig.port = port;
-      if (user) strncpy(mqttConfig.user, user, sizeof(mqttConfig.user) - 1);
-      if (password) strncpy(mqttConfig.password, password, sizeof(mqttConfig.password) - 1);
-      
-      // Guardar en flash (auto-commit)
-      FlashStorage.saveString("mqtt_server", server);
-      FlashStorage.saveInt("mqtt_port", port);
-      if (user) FlashStorage.saveString("mqtt_user", user);
-      if (password) FlashStorage.saveString("mqtt_password", password);
-      
-      MqttMgr.publish(responseTopic.c_str(), "{\"status\":\"ok\",\"message\":\"MQTT guardado, reinicia para aplicar\"}");
-      Serial.printf("[CMD] MQTT configurado: %s:%d\n", server, port);
-    } else {
-      MqttMgr.publish(responseTopic.c_str(), "{\"error\":\"missing_server\"}");
-    }
+  response["cmd"] = "get_jobs";
+  response["bucket_us"] = JOB_MGR_MIN_BUCKET_US;
+  JsonArray jobs = response.createNestedArray("jobs");
+  
+  for (uint8_t i = 0; i < JobMgr.getJobCount(); i++) {
+    JobStats job;
+    if (!JobMgr.getJob(i, job)) continue;
+    JsonObject item = jobs.createNestedObject();
+    item["name"] = job.name;
+    item["period_ms"] = job.periodMs;
+    item["deadline_ms"] = job.deadlineMs;
+    item["runs"] = job.runs;
+    item["misses"] = job.misses;
+    item["skipped"] = job.skipped;
+    addHistogram(item, "jitter", job.jitter);
+    addHistogram(item, "run", job.runtime);
   }
   
-  // ========== SET SENSOR ==========
-  else if (strcmp(cmd, "set_sensor") == 0) {
-    if (doc.containsKey("name")) strncpy(sensorConfig.name, doc["name"], sizeof(sensorConfig.name) - 1);
-    if (doc.containsKey("address")) sensorConfig.modbusAddress = doc["address"];
-    if (doc.containsKey("register")) sensorConfig.registerStart = doc["register"];
-    if (doc.containsKey("count")) sensorConfig.registerCount = doc["count"];
-    if (doc.containsKey("multiplier")) sensorConfig.multiplier = doc["multiplier"];
-    
-    // Guardar en flash (auto-commit)
-    FlashStorage.save("sensor_config", sensorConfig);
-    
-    MqttMgr.publish(responseTopic.c_str(), "{\"status\":\"ok\",\"message\":\"Sensor configurado\"}");
-    Serial.println("[CMD] Sensor configurado");
+  ctx.reply(response);
+  
+  // Después de responder: la respuesta lleva lo acumulado hasta ahora
+  if (ctx.request["reset"] | false) {
+    JobMgr.resetStats();
+  }
+}
+
+// ========== GET NVS STATS ==========
+static void cmdGetNvsStats(CommandContext& ctx) {
+  DynamicJsonDocument response(JSON_OBJECT_SIZE(13) + JSON_OBJECT_SIZE(5) + JSON_ARRAY_SIZE(CONFIG_COMMIT_MAX_KEYS) +
+                               CONFIG_COMMIT_MAX_KEYS * JSON_OBJECT_SIZE(7));
+  if (response.capacity() == 0) {
+    ctx.replyError("no_memory");
+    return;
   }
   
-  // ========== SCAN WIFI ==========
-  else if (strcmp(cmd, "scan_wifi") == 0) {
-    Serial.println("[CMD] Escaneando redes WiFi...");
-    WifiMgr.startScan();
-    
-    // Esperar a que termine (máx 10 segundos)
-    int attempts = 0;
-    while (WiFi.scanComplete() == WIFI_SCAN_RUNNING && attempts < 20) {
-      delay(500);
-      attempts++;
-    }
-    
-    int n = WiFi.scanComplete();
-    if (n >= 0) {
-      StaticJsonDocument<1024> response;
-      response["cmd"] = "scan_wifi";
-      response["status"] = "ok";
-      JsonArray networks = response.createNestedArray("networks");
-      
-      for (int i = 0; i < n && i < 10; i++) {  // Máximo 10 redes
-        JsonObject net = networks.createNestedObject();
-        net["ssid"] = WiFi.SSID(i);
-        net["rssi"] = WiFi.RSSI(i);
-        net["channel"] = WiFi.channel(i);
-        net["encrypted"] = (WiFi.encryptionType(i) != WIFI_AUTH_OPEN);
-      }
-      
-      String output;
-      serializeJson(response, output);
-      MqttMgr.publish(responseTopic.c_str(), output.c_str());
-      WiFi.scanDelete();
-    } else {
-      MqttMgr.publish(responseTopic.c_str(), "{\"error\":\"scan_failed\"}");
+  ConfigCommitStats stats = ConfigMgr.getStats();
+  response["cmd"] = "get_nvs_stats";
+  response["debounce_ms"] = ConfigMgr.getDebounceMs();
+  response["commits"] = stats.commits;
+  response["writes"] = stats.writes;
+  response["skipped"] = stats.skipped;
+  response["coalesced"] = stats.coalesced;
+  response["failures"] = stats.failures;
+  response["entries"] = stats.entries;
+  response["free_entries"] = FlashStorage.getFreeEntries();
+  
+  // Caché de lectura de FlashStorage
+  FlashStorageStats storage = FlashStorage.getStats();
+  JsonObject cache = response.createNestedObject("cache");
+  cache["budget"] = FlashStorage.getCacheBudget();
+  cache["bytes"] = FlashStorage.getCacheBytes();
+  cache["keys"] = FlashStorage.getCacheEntries();
+  cache["hits"] = storage.cacheHits;
+  cache["misses"] = storage.cacheMisses;
+  
+  // Pronóstico al ritmo medido desde el arranque (null hasta tener 1 h)
+  float perDay = ConfigMgr.getEntriesPerDay();
+  float years = ConfigMgr.getForecastYears();
+  if (perDay >= 0.0f) response["entries_per_day"] = perDay;
+  else response["entries_per_day"] = nullptr;
+  if (years >= 0.0f) response["forecast_years"] = years;
+  else response["forecast_years"] = nullptr;
+  
+  JsonArray keys = response.createNestedArray("keys");
+  for (uint8_t i = 0; i < ConfigMgr.getKeyCount(); i++) {
+    ConfigKeyStats key;
+    if (!ConfigMgr.getKey(i, key)) continue;
+    JsonObject item = keys.createNestedObject();
+    item["key"] = key.key;
+    item["writes"] = key.writes;
+    item["skipped"] = key.skipped;
+    item["coalesced"] = key.coalesced;
+    item["failures"] = key.failures;
+    item["entries"] = key.entries;
+    item["pending"] = key.pending;
+  }
+  
+  ctx.reply(response);
+}
+
+// ========== CLEAR ERRORS ==========
+static void cmdClearErrors(CommandContext& ctx) {
+  clearError();
+  errorCount = 0;
+  memset(errors, 0, sizeof(errors));
+  ctx.reply("{\"status\":\"ok\",\"message\":\"Errores limpiados\"}");
+  Serial.println("[CMD] Errores limpiados");
+}
+
+// ========== RESTART ==========
+static void cmdRestart(CommandContext& ctx) {
+  Serial.println("[CMD] Reiniciando sistema...");
+  ctx.reply("{\"status\":\"restarting\"}");
+  ConfigMgr.flush();  // Lo configurado recién no espera la ventana
+  MqttMgr.flush();
+  SysMgr.restart(1000);
+}
+
+// ========== FACTORY RESET ==========
+static void cmdFactoryReset(CommandContext& ctx) {
+  Serial.println("[CMD] Factory reset...");
+  ctx.reply("{\"status\":\"factory_reset\"}");
+  ConfigMgr.discard();
+  MqttMgr.flush();
+  SysMgr.factoryReset();
+}
+
+// ========== GET COMMANDS ==========
+static void cmdGetCommands(CommandContext& ctx) {
+  // Un objeto por comando y por parámetro: con el tamaño fijo ArduinoJson
+  // descartaba en silencio los que no entraban
+  size_t capacity = JSON_OBJECT_SIZE(3) + JSON_ARRAY_SIZE(CmdDispatcher.count());
+  for (size_t i = 0; i < CmdDispatcher.count(); i++) {
+    const CommandSpec* spec = CmdDispatcher.at(i);
+    capacity += JSON_OBJECT_SIZE(3) + JSON_ARRAY_SIZE(spec->paramCount) +
+                spec->paramCount * JSON_OBJECT_SIZE(3);
+  }
+  
+  DynamicJsonDocument response(capacity);
+  if (response.capacity() == 0) {
+    ctx.replyError("no_memory");
+    return;
+  }
+  response["cmd"] = "get_commands";
+  response["status"] = "ok";
+  JsonArray commands = response.createNestedArray("commands");
+  
+  for (size_t i = 0; i < CmdDispatcher.count(); i++) {
+    const CommandSpec* spec = CmdDispatcher.at(i);
+    JsonObject command = commands.createNestedObject();
+    command["name"] = spec->name;
+    command["async"] = (spec->flags & CMD_FLAG_ASYNC) != 0;
+    JsonArray params = command.createNestedArray("params");
+    for (uint8_t p = 0; p < spec->paramCount; p++) {
+      JsonObject param = params.createNestedObject();
+      param["name"] = spec->params[p].name;
+      param["type"] = CommandDispatcher::paramTypeName(spec->params[p].type);
+      param["required"] = spec->params[p].required;
     }
   }
   
-  // ========== GET ERROR HISTORY ==========
-  else if (strcmp(cmd, "get_errors") == 0) {
-    StaticJsonDocument<1024> response;
-    response["cmd"] = "get_errors";
-    response["status"] = "ok";
-    response["total_errors"] = errorCount;
-    
-    JsonArray errorArray = response.createNestedArray("errors");
-    int start = (errorCount > 5) ? (errorCount - 5) : 0;
-    int count = min(errorCount, 5);
+  ctx.reply(response);
+}
+
+static const CommandSpec coreCommands[] = {
+  {"get_status",    cmdGetStatus,    CMD_NO_PARAMS,             CMD_FLAG_NONE, "Estado del sistema"},
+  {"get_config",    cmdGetConfig,    CMD_NO_PARAMS,             CMD_FLAG_NONE, "Configuración actual"},
+  {"set_wifi",      cmdSetWifi,      CMD_PARAMS(setWifiParams), CMD_FLAG_NONE, "Credenciales WiFi"},
+  {"set_mqtt",      cmdSetMqtt,      CMD_PARAMS(setMqttParams), CMD_FLAG_NONE, "Broker MQTT"},
+  {"set_sensor",    cmdSetSensor,    CMD_PARAMS(setSensorParams), CMD_FLAG_NONE, "Parámetros del sensor"},
+  {"set_ntp",       cmdSetNtp,       CMD_PARAMS(setNtpParams),  CMD_FLAG_NONE, "Servidor NTP"},
+  {"scan_wifi",     cmdScanWifi,     CMD_NO_PARAMS,             CMD_FLAG_ASYNC, "Escanea redes WiFi"},
+  {"get_errors",    cmdGetErrors,    CMD_NO_PARAMS,             CMD_FLAG_NONE, "Historial de errores"},
+  {"clear_errors",  cmdClearErrors,  CMD_NO_PARAMS,             CMD_FLAG_NONE, "Limpia errores"},
+  {"get_jobs",      cmdGetJobs,      CMD_PARAMS(getJobsParams), CMD_FLAG_NONE, "Jitter, duración y plazos de trabajos periódicos"},
+  {"get_nvs_stats", cmdGetNvsStats,  CMD_NO_PARAMS,             CMD_FLAG_NONE, "Escrituras NVS por clave y vida útil estimada"},
+  {"restart",       cmdRestart,      CMD_NO_PARAMS,             CMD_FLAG_ASYNC, "Reinicia el dispositivo"},
+  {"factory_reset", cmdFactoryReset, CMD_NO_PARAMS,             CMD_FLAG_ASYNC, "Borra la configuración"},
+  {"get_commands",  cmdGetCommands,  CMD_NO_PARAMS,             CMD_FLAG_NONE, "Lista comandos y parámetros"},
+};
+
+/**
+ * @brief Registra los comandos base del firmware (llamar antes de iniciar MQTT)
+ */
+void registerCoreCommands() {
+  for (size_t i = 0; i < sizeof(coreCommands) / sizeof(coreCommands[0]); i++) {
+    CmdDispatcher.registerCommand(coreCommands[i]);
+  }
+}
+
+/**
+ * @brief Callback para mensajes MQTT recibidos con comandos JSON
+ * 
+ * Formato: {"cmd":"<nombre>", ...parámetros}. Los comandos disponibles
+ * y su esquema se consultan con {"cmd":"get_commands"}.
+ */
+void onMqttMessage(char* topic, byte* payload, unsigned int length) {
+  // Passthrough binario: el payload no es texto, no se imprime
+  if (handleRawModbusMessage(topic, payload, length)) {
+    return;
+  }
+  
+  Serial.printf("[MQTT] Mensaje [%s]: %.*s\n", topic, (int)length, (const char*)payload);
+  
+  // Comandos simples en texto plano (retrocompatibilidad)
+  if (payloadEquals(payload, length, "restart")) {
+    StaticJsonDocument<64> doc;
+    doc["cmd"] = "restart";
+    CmdDispatcher.dispatch(doc, responseTopic);
+    return;
+  }
+  else if (payloadEquals(payload, length, "status")) {
+    SysMgr.printStatus();
+    ModbusMgr.printStats();
+    PollMgr.printStatus();
+    AggMgr.printStatus();
+    HistoryMgr.printStatus();
+    TimeMgr.printStatus();
+    JobMgr.printStatus();
+    ConfigMgr.printStatus();
+    ProfileMgr.printStatus();
+    CounterLog.printStats();
+    bootProfilePrint();
+    MqttMgr.printStats();
+    return;
+  }
+  
+  // Parseo in-place (zero-copy): los strings del documento apuntan al buffer
+  // de PubSubClient, válido durante todo el callback porque las respuestas
+  // se encolan y las escribe la tarea MQTT después
+  StaticJsonDocument<COMMAND_DISPATCHER_DOC_SIZE> doc;
+  DeserializationError error = deserializeJson(doc, (char*)payload, length);
+  
+  if (error) {
+    Serial.printf("[CMD] Error JSON: %s\n", error.c_str());
+    MqttMgr.publish(responseTopic, "{\"error\":\"invalid_json\"}");
+    return;
+  }
+  
+  CmdDispatcher.dispatch(doc, responseTopic);
+}
+
+// ============================================================================
+// CONTADORES PERSISTENTES
+// ============================================================================
+// Checkpoint de SystemStats y ModbusStats en el log circular de la partición
+// "statslog": al arrancar se retoman los totales del último registro válido.
+
+// Cambiar este struct = subir STATS_LOG_SCHEMA (un registro viejo se ignora)
+struct PersistedCounters {
+  uint32_t bootCount;
+  uint32_t successfulReads;
+  uint32_t failedReads;
+  uint32_t mqttPublished;
+  uint32_t wifiReconnects;
+  uint32_t modbusRequests;
+  uint32_t modbusSuccessful;
+  uint32_t modbusFailed;
+  uint32_t modbusTimeouts;
+  uint32_t modbusCrcErrors;
+  uint32_t modbusExceptions;
+};
+
+/**
+ * @brief Guarda los contadores actuales (trabajo periódico "stats_checkpoint")
+ * 
+ * Si nada cambió desde el último checkpoint CounterLog no escribe.
+ */
+static void checkpointCounters() {
+  const ModbusStats& modbus = ModbusMgr.getStats();
+  
+  PersistedCounters counters;
+  counters.bootCount = bootCount;
+  counters.successfulReads = systemStats.successfulReads;
+  counters.failedReads = systemStats.failedReads;
+  counters.mqttPublished = systemStats.mqttPublished;
+  counters.wifiReconnects = systemStats.wifiReconnects;
+  counters.modbusRequests = modbus.totalRequests;
+  counters.modbusSuccessful = modbus.successfulRequests;
+  counters.modbusFailed = modbus.failedRequests;
+  counters.modbusTimeouts = modbus.timeouts;
+  counters.modbusCrcErrors = modbus.crcErrors;
+  counters.modbusExceptions = modbus.exceptions;
+  
+  CounterLog.append(counters, STATS_LOG_SCHEMA);
+}
+
+/**
+ * @brief Retoma los contadores del último checkpoint y registra el arranque
+ */
+static void restoreCounters() {
+  PersistedCounters saved;
+  if (CounterLog.load(saved, STATS_LOG_SCHEMA)) {
+    bootCount = saved.bootCount;
+    systemStats.successfulReads = saved.successfulReads;
+    systemStats.failedReads = saved.failedReads;
+    systemStats.mqttPublished = saved.mqttPublished;
+    systemStats.wifiReconnects = saved.wifiReconnects;
     
-    for (int i = 0; i < count; i++) {
-      JsonObject err = errorArray.createNestedObject();
-      SystemError& e = errors[i];
-      err["code"] = e.code;
-      err["type"] = getErrorTypeName(e.type);
-      err["description"] = e.description;
-      err["timestamp"] = e.timestamp;
-      err["age_seconds"] = (millis() - e.timestamp) / 1000;
-    }
+    ModbusStats modbus;
+    memset(&modbus, 0, sizeof(modbus));
+    modbus.totalRequests = saved.modbusRequests;
+    modbus.successfulRequests = saved.modbusSuccessful;
+    modbus.failedRequests = saved.modbusFailed;
+    modbus.timeouts = saved.modbusTimeouts;
+    modbus.crcErrors = saved.modbusCrcErrors;
+    modbus.exceptions = saved.modbusExceptions;
+    ModbusMgr.restoreStats(modbus);
     
-    String output;
-    serializeJson(response, output);
-    MqttMgr.publish(responseTopic.c_str(), output.c_str());
+    Serial.printf("[STATS] ✓ Contadores retomados del registro #%lu\n", CounterLog.getSequence());
   }
   
-  // ========== CLEAR ERRORS ==========
-  else if (strcmp(cmd, "clear_errors") == 0) {
-    clearError();
-    errorCount = 0;
-    memset(errors, 0, sizeof(errors));
-    MqttMgr.publish(responseTopic.c_str(), "{\"status\":\"ok\",\"message\":\"Errores limpiados\"}");
-    Serial.println("[CMD] Errores limpiados");
+  bootCount++;
+  Serial.printf("[STATS] Arranque #%lu\n", bootCount);
+  checkpointCounters();
+}
+
+// ============================================================================
+// TRABAJOS PERIÓDICOS
+// ============================================================================
+
+/**
+ * @brief Detecta memoria baja o fragmentada (trabajo periódico "mem_check")
+ */
+static void checkMemory() {
+  uint32_t freeHeap = ESP.getFreeHeap();
+  uint32_t maxAlloc = ESP.getMaxAllocHeap();
+  
+  // Detectar memoria baja (menos de 50KB libres)
+  if (freeHeap < 50000) {
+    char desc[128];
+    snprintf(desc, sizeof(desc), "Heap libre: %lu bytes", freeHeap);
+    logError(ERROR_MEMORY, ERR_SYSTEM_LOW_MEMORY, desc);
+    Serial.printf("[MEMORY] ⚠️  Memoria baja: %lu bytes libres\n", freeHeap);
   }
   
-  // ========== RESTART ==========
-  else if (strcmp(cmd, "restart") == 0) {
-    Serial.println("[CMD] Reiniciando sistema...");
-    MqttMgr.publish(responseTopic.c_str(), "{\"status\":\"restarting\"}");
-    delay(500);
-    SysMgr.restart(1000);
+  // Detectar fragmentación (max alloc < 50% del heap libre)
+  if (maxAlloc < (freeHeap / 2)) {
+    char desc[128];
+    snprintf(desc, sizeof(desc), "Heap libre: %lu, Max alloc: %lu", freeHeap, maxAlloc);
+    logError(ERROR_MEMORY, ERR_SYSTEM_HEAP_FRAGMENTED, desc);
+    Serial.printf("[MEMORY] ⚠️  Heap fragmentado: libre=%lu, max_alloc=%lu\n", freeHeap, maxAlloc);
+  }
+}
+
+/**
+ * @brief Reporta la red caída por más de WIFI_CONNECT_TIMEOUT_MS (trabajo "net_check")
+ * 
+ * Reemplaza la espera bloqueante que había en setup(): el arranque no espera
+ * a la red, pero una red que no aparece se sigue informando (una vez por corte).
+ */
+static void checkNetwork() {
+  uint32_t since = wifiDownSince;
+  if (since == 0 || wifiFailureLogged || millis() - since < WIFI_CONNECT_TIMEOUT_MS) {
+    return;
   }
   
-  // ========== FACTORY RESET ==========
-  else if (strcmp(cmd, "factory_reset") == 0) {
-    Serial.println("[CMD] Factory reset...");
-    MqttMgr.publish(responseTopic.c_str(), "{\"status\":\"factory_reset\"}");
-    delay(500);
-    SysMgr.factoryReset();
+  wifiFailureLogged = true;
+  Serial.printf("[WiFi] ✗ Sin conexión a '%s' hace %lu s\n", wifiConfig.ssid, (millis() - since) / 1000);
+  Serial.println("[WiFi] Verifica las credenciales en config.h");
+  Serial.println("[WiFi] El sistema continuará intentando reconectar...");
+  logError(ERROR_WIFI, ERR_WIFI_CONNECTION_FAILED);
+}
+
+/**
+ * @brief Escribe la configuración pendiente cuando vence la ventana (trabajo "cfg_commit")
+ */
+static void commitConfig() {
+  ConfigMgr.loop();
+}
+
+/**
+ * @brief Imprime las estadísticas del sistema (trabajo periódico "stats_print")
+ */
+static void printSystemStats() {
+  Serial.println("\n╔════════════════════════════════════════════════╗");
+  Serial.println("║  📊 ESTADÍSTICAS DEL SISTEMA                   ║");
+  Serial.println("╚════════════════════════════════════════════════╝");
+  
+  // Estado del sistema
+  SystemStatus status = SysMgr.getStatus();
+  Serial.printf("  Uptime: %lu s\n", status.uptime / 1000);
+  Serial.printf("  Heap libre: %lu bytes\n", status.freeHeap);
+  Serial.printf("  WiFi: %s\n", status.wifiConnected ? "✓ Conectado" : "✗ Desconectado");
+  Serial.printf("  MQTT: %s\n", status.mqttConnected ? "✓ Conectado" : "✗ Desconectado");
+  
+  // Estadísticas Modbus
+  const ModbusStats& modbusStats = ModbusMgr.getStats();
+  Serial.printf("  Modbus peticiones: %lu (éxito: %lu, fallos: %lu)\n",
+                modbusStats.totalRequests,
+                modbusStats.successfulRequests,
+                modbusStats.failedRequests);
+  
+  // Estadísticas MQTT
+  if (strlen(mqttConfig.server) > 0) {
+    const MQTTStats& mqttStats = MqttMgr.getStats();
+    Serial.printf("  MQTT publicados: %lu, recibidos: %lu\n",
+                  mqttStats.totalPublished,
+                  mqttStats.totalReceived);
+    Serial.printf("  MQTT backlog: %lu mensajes\n", MqttMgr.getBacklog());
   }
   
-  // ========== COMANDO NO RECONOCIDO ==========
-  else {
-    Serial.printf("[CMD] Comando desconocido: %s\n", cmd);
-    MqttMgr.publish(responseTopic.c_str(), "{\"error\":\"unknown_command\"}");
+  // Trabajos periódicos que terminaron fuera de plazo
+  Serial.printf("  Plazos vencidos: %lu\n", JobMgr.getTotalMisses());
+  
+  // TODO: Implementar lectura de datos del sensor usando ModbusMgr
+  // (código legacy de tasks.cpp deshabilitado temporalmente)
+  /*
+  if (dataMutex != NULL && xSemaphoreTake(dataMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+    if (sensorData.valid && sensorData.registerCount > 0) {
+      Serial.println("  Últimos datos del sensor:");
+      Serial.printf("    Registros leídos: %d\n", sensorData.registerCount);
+      if (sensorData.registerCount > 0) {
+        Serial.printf("    Reg[0]: %d (0x%04X)\n", 
+                      sensorData.registers[0], sensorData.registers[0]);
+      }
+      if (sensorData.registerCount > 1) {
+        Serial.printf("    Reg[1]: %d (0x%04X)\n", 
+                      sensorData.registers[1], sensorData.registers[1]);
+      }
+      Serial.printf("    Timestamp: hace %lu ms\n", millis() - sensorData.timestamp);
+    } else {
+      Serial.println("  ⚠ No hay datos válidos del sensor");
+    }
+    xSemaphoreGive(dataMutex);
   }
+  */
+  
+  Serial.println("════════════════════════════════════════════════\n");
 }
 
 // ============================================================================
@@ -415,9 +950,11 @@ void onMqttMessage(char* topic, byte* payload, unsigned int length) {
 // ============================================================================
 
 void setup() {
-  // Inicializar serial
+  // Perfil de arranque: antes que nada, para medir desde el principio
+  bootProfileBegin();
+  
+  // Inicializar serial (sin espera: el arranque no se demora por el monitor)
   Serial.begin(115200);
-  delay(500);
   
   Serial.println("\n\n");
   Serial.println("╔══════════════════════════════════════════════╗");
@@ -437,13 +974,16 @@ void setup() {
   // 1. System Manager (información del sistema)
   // ========================================================================
   Serial.println("[INIT] Inicializando System Manager...");
+  bootPhaseBegin(BOOT_PHASE_SYSTEM);
   SysMgr.begin();
   SysMgr.printInfo();
+  bootPhaseEnd(BOOT_PHASE_SYSTEM);
   
   // ========================================================================
   // 2. Flash Storage Manager (persistencia)
   // ========================================================================
   Serial.println("[INIT] Inicializando Flash Storage Manager...");
+  bootPhaseBegin(BOOT_PHASE_STORAGE);
   
   // Aplicar valores preconfigurados por defecto
   strncpy(wifiConfig.ssid, DEFAULT_WIFI_SSID, sizeof(wifiConfig.ssid) - 1);
@@ -456,120 +996,135 @@ void setup() {
   strncpy(mqttConfig.password, DEFAULT_MQTT_PASSWORD, sizeof(mqttConfig.password) - 1);
   strncpy(mqttConfig.clientId, DEFAULT_MQTT_CLIENT_ID, sizeof(mqttConfig.clientId) - 1);
   
+  strncpy(ntpConfig.server, DEFAULT_NTP_SERVER, sizeof(ntpConfig.server) - 1);
+  ntpConfig.port = TIME_SYNC_DEFAULT_PORT;
+  
   Serial.println("[CONFIG] ✓ Credenciales preconfiguradas cargadas");
   Serial.printf("[CONFIG]   WiFi SSID: %s\n", wifiConfig.ssid);
   Serial.printf("[CONFIG]   MQTT Server: %s:%d\n", mqttConfig.server, mqttConfig.port);
   
-  if (!FlashStorage.begin("nehuentue")) {
+  if (FlashStorage.begin("nehuentue") != FLASH_STORAGE_OK) {
     Serial.println("[WARN] FlashStorage falló - usando solo valores preconfigurados");
     logError(ERROR_FLASH, ERR_EEPROM_INIT_FAILED);
   } else {
     Serial.println("[INIT] ✓ Flash Storage inicializado");
+    FlashStorage.enableCache(FLASH_CACHE_BUDGET_BYTES);
+    ConfigMgr.begin(FlashStorage, CONFIG_COMMIT_DEBOUNCE_MS);
     
-    // Intentar cargar sobrescrituras de la flash (si existen)
-    bool sensorLoaded = FlashStorage.load("sensor_config", sensorConfig);
-    
-    // WiFi Config (puede sobrescribir los valores por defecto)
-    String ssid = FlashStorage.loadString("wifi_ssid", "");
-    if (ssid.length() > 0) {
-      strncpy(wifiConfig.ssid, ssid.c_str(), sizeof(wifiConfig.ssid) - 1);
-      String password = FlashStorage.loadString("wifi_password", "");
-      strncpy(wifiConfig.password, password.c_str(), sizeof(wifiConfig.password) - 1);
-      Serial.printf("[CONFIG] WiFi sobrescrito desde Flash: %s\n", wifiConfig.ssid);
-    }
-    
-    // MQTT Config (puede sobrescribir los valores por defecto)
-    String mqttServer = FlashStorage.loadString("mqtt_server", "");
-    if (mqttServer.length() > 0) {
-      strncpy(mqttConfig.server, mqttServer.c_str(), sizeof(mqttConfig.server) - 1);
-      mqttConfig.port = FlashStorage.loadInt("mqtt_port", DEFAULT_MQTT_PORT);
-      String mqttUser = FlashStorage.loadString("mqtt_user", "");
-      String mqttPassword = FlashStorage.loadString("mqtt_password", "");
-      if (mqttUser.length() > 0) strncpy(mqttConfig.user, mqttUser.c_str(), sizeof(mqttConfig.user) - 1);
-      if (mqttPassword.length() > 0) strncpy(mqttConfig.password, mqttPassword.c_str(), sizeof(mqttConfig.password) - 1);
-      Serial.printf("[CONFIG] MQTT sobrescrito desde Flash: %s:%d\n", mqttConfig.server, mqttConfig.port);
-    }
-    
-    if (sensorLoaded) {
-      Serial.printf("[CONFIG] Sensor cargado: '%s' (Slave ID: %d)\n", 
-                    sensorConfig.name, sensorConfig.slaveId);
+    // Toda la configuración en una lectura (migra las claves de la v1)
+    if (loadConfigImage() == CONFIG_IMAGE_INVALID) {
+      logError(ERROR_FLASH, ERR_FLASH_CORRUPTED, "Imagen de configuración inválida");
     }
+    Serial.printf("[CONFIG] WiFi: %s, MQTT: %s:%d\n", wifiConfig.ssid, mqttConfig.server, mqttConfig.port);
+    Serial.printf("[CONFIG] Sensor: '%s' (Slave ID: %d)\n", sensorConfig.name, sensorConfig.slaveId);
   }
   
-  // ========================================================================
-  // 3. WiFi Manager (conectividad)
-  // ========================================================================
-  Serial.println("[INIT] Inicializando WiFi Manager...");
-  WifiMgr.begin(wifiConfig.hostname);
-  WifiMgr.onEvent(onWiFiEvent);
+  bootPhaseEnd(BOOT_PHASE_STORAGE);
   
-  Serial.printf("[WiFi] Conectando a '%s'...\n", wifiConfig.ssid);
-  WifiMgr.connectSTA(wifiConfig.ssid, wifiConfig.password);
+  // Cola persistente de publicaciones (store-and-forward)
+  bootPhaseBegin(BOOT_PHASE_LOCAL);
+  Serial.println("[INIT] Inicializando cola persistente MQTT...");
+  FlashQueue.setRetention(MQTT_OFFLINE_MAX_AGE_S, MQTT_OFFLINE_MAX_SEGMENTS);
+  if (!FlashQueue.begin()) {
+    Serial.println("[WARN] Cola persistente no disponible - se usará la cola en RAM");
+    logError(ERROR_FLASH, ERR_FLASH_CORRUPTED, "Partición mqttlog no disponible");
+  } else if (FlashQueue.pendingCount() > 0) {
+    Serial.printf("[INIT] Backlog pendiente: %lu mensajes\n", FlashQueue.pendingCount());
+  }
   
-  // Esperar 15 segundos para conexión
-  int attempts = 0;
-  while (!WifiMgr.isConnected() && attempts < 30) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
+  // Contadores persistentes (antes de Modbus/WiFi, que los incrementan)
+  if (!CounterLog.begin()) {
+    Serial.println("[WARN] Log de contadores no disponible - los contadores arrancan en cero");
+    logError(ERROR_FLASH, ERR_FLASH_CORRUPTED, "Partición statslog no disponible");
   }
-  Serial.println();
+  restoreCounters();
   
-  if (WifiMgr.isConnected()) {
-    Serial.printf("[WiFi] ✓ Conectado - IP: %s\n", WiFi.localIP().toString().c_str());
-    Serial.printf("[WiFi] ✓ RSSI: %d dBm\n", WifiMgr.getRSSI());
-  } else {
-    Serial.println("[WiFi] ✗ Error: No se pudo conectar a la red");
-    Serial.println("[WiFi] Verifica las credenciales en config.h");
-    Serial.println("[WiFi] El sistema continuará intentando reconectar...");
-    logError(ERROR_WIFI, ERR_WIFI_CONNECTION_FAILED);
+  // Biblioteca de perfiles de equipos (partición de sólo lectura, opcional)
+  if (!ProfileMgr.begin()) {
+    Serial.println("[INFO] Sin perfiles de equipos - list_profiles responde vacío");
   }
+  bootPhaseEnd(BOOT_PHASE_LOCAL);
   
   // ========================================================================
-  // 4. MQTT Manager
+  // 3. MQTT Manager (buffering: publicar funciona desde ya, sin red)
   // ========================================================================
+  // Lo publicado antes de tener red queda en la cola RAM y la tarea lo pasa
+  // a la cola persistente; al conectar se drena en orden.
   Serial.println("[INIT] Inicializando MQTT Manager...");
+  bootPhaseBegin(BOOT_PHASE_MQTT_SETUP);
+  buildMqttTopics();
+  registerCoreCommands();
+  registerModbusCommands();
+  registerPollingCommands();
+  beginRawModbus(mqttConfig.clientId);
+  if (!CmdDispatcher.startWorker()) {
+    logError(ERROR_SYSTEM, ERR_SYSTEM_TASK_FAILED, "No se pudo crear tarea de comandos");
+  }
+  MqttMgr.setPublishQoS(MQTT_PUBLISH_QOS);
+  MqttMgr.setInflightWindow(MQTT_INFLIGHT_WINDOW);
   MqttMgr.begin(mqttConfig.server, mqttConfig.port, 
                 mqttConfig.user, mqttConfig.password, mqttConfig.clientId);
   MqttMgr.onMessage(onMqttMessage);
   MqttMgr.setAutoReconnect(true);
+  MqttMgr.setOfflineStore(&FlashQueue);
   
-  if (WifiMgr.isConnected()) {
-    Serial.printf("[MQTT] Conectando a %s:%d...\n", mqttConfig.server, mqttConfig.port);
-    if (MqttMgr.connect()) {
-      Serial.println("[MQTT] ✓ Conectado al broker");
-      
-      // Suscribirse al tópico de comandos
-      String cmdTopic = String(MQTT_TOPIC_BASE) + "/" + String(mqttConfig.clientId) + "/" + String(MQTT_TOPIC_CMD);
-      MqttMgr.subscribe(cmdTopic.c_str());
-      Serial.printf("[MQTT] ✓ Suscrito a: %s\n", cmdTopic.c_str());
-      
-      // Publicar mensaje de inicio
-      String statusTopic = String(MQTT_TOPIC_BASE) + "/" + String(mqttConfig.clientId) + "/" + String(MQTT_TOPIC_STATUS);
-      MqttMgr.publish(statusTopic.c_str(), "{\"status\":\"online\",\"firmware\":\"v2.1\"}");
-    } else {
-      Serial.println("[MQTT] ✗ Error al conectar al broker");
-    }
-  } else {
-    Serial.println("[MQTT] Esperando conexión WiFi...");
+  MqttMgr.onConnectionChange(onMqttConnection);
+  
+  // Tarea dedicada: conecta cuando hay red, drena la cola y atiende keepalive/entrantes
+  if (!MqttMgr.startTask()) {
+    logError(ERROR_SYSTEM, ERR_SYSTEM_TASK_FAILED, "No se pudo crear tarea MQTT");
   }
+  bootPhaseEnd(BOOT_PHASE_MQTT_SETUP);
   
   // ========================================================================
-  // 5. Modbus Manager
+  // 4. Modbus Manager (adquisición desde el arranque, no espera a la red)
   // ========================================================================
   Serial.println("[INIT] Inicializando Modbus Manager...");
+  bootPhaseBegin(BOOT_PHASE_MODBUS);
   ModbusMgr.begin(Serial1, sensorConfig.rxPin, sensorConfig.txPin, 
                   sensorConfig.baudrate);
   ModbusMgr.setTimeout(1000);
+  bootPhaseEnd(BOOT_PHASE_MODBUS);
   Serial.println("[INIT] ✓ Modbus RTU Master inicializado");
   
   // ========================================================================
-  // 6. Inicializar tareas FreeRTOS (legacy - DESHABILITADO TEMPORALMENTE)
+  // 5. Polling Modbus (reemplaza las tareas legacy de tasks.cpp)
   // ========================================================================
-  // TODO: Migrar tasks.cpp para usar los managers
-  // Serial.println("[INIT] Inicializando tareas FreeRTOS...");
-  // initTasks();
-  // vTaskDelay(pdMS_TO_TICKS(300));
+  Serial.println("[INIT] Inicializando polling...");
+  bootPhaseBegin(BOOT_PHASE_POLLING);
+  if (!beginPolling(mqttConfig.clientId)) {
+    logError(ERROR_SYSTEM, ERR_SYSTEM_TASK_FAILED, "No se pudo iniciar el polling");
+  }
+  bootPhaseEnd(BOOT_PHASE_POLLING);
+  
+  // ========================================================================
+  // 6. WiFi Manager (conectividad, en segundo plano)
+  // ========================================================================
+  // Sin espera: asociación y DHCP corren en paralelo con el polling; la
+  // tarea MQTT conecta al broker cuando llega la IP y checkNetwork avisa
+  // si la red no aparece.
+  Serial.println("[INIT] Inicializando WiFi Manager...");
+  bootPhaseBegin(BOOT_PHASE_WIFI_START);
+  WifiMgr.begin(wifiConfig.hostname);
+  WifiMgr.onEvent(onWiFiEvent);
+  
+  Serial.printf("[WiFi] Conectando a '%s' (en segundo plano)...\n", wifiConfig.ssid);
+  wifiDownSince = millis();
+  bootPhaseBegin(BOOT_PHASE_WIFI_ASSOC);
+  WifiMgr.connectSTA(wifiConfig.ssid, wifiConfig.password);
+  
+  // Hora UTC: sincroniza en segundo plano, sin esperar a la red
+  if (!TimeMgr.begin(ntpConfig.server, ntpConfig.port, NTP_SYNC_INTERVAL_MS)) {
+    logError(ERROR_SYSTEM, ERR_SYSTEM_TASK_FAILED, "No se pudo crear tarea NTP");
+  }
+  bootPhaseEnd(BOOT_PHASE_WIFI_START);
+  
+  // Chequeos de loop(): mismo período que antes, medidos en JobMgr
+  JobMgr.registerJob("mem_check", 60000, 1000, checkMemory);
+  JobMgr.registerJob("stats_print", 60000, 1000, printSystemStats);
+  JobMgr.registerJob("cfg_commit", CONFIG_COMMIT_CHECK_MS, 1000, commitConfig);
+  JobMgr.registerJob("stats_checkpoint", STATS_CHECKPOINT_INTERVAL_MS, 1000, checkpointCounters);
+  JobMgr.registerJob("net_check", 1000, 1000, checkNetwork);
   
   // ========================================================================
   // INICIO COMPLETADO
@@ -581,6 +1136,7 @@ void setup() {
   Serial.println("╚══════════════════════════════════════════════╝");
   
   SysMgr.printStatus();
+  bootProfileSetupDone();
   
   Serial.println("\n[READY] Sistema operativo - Tareas ejecutándose");
   Serial.println("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
@@ -591,95 +1147,11 @@ void setup() {
 // ============================================================================
 
 void loop() {
-  // Monitoreo de memoria cada 60 segundos
-  static unsigned long lastMemCheck = 0;
-  if (millis() - lastMemCheck > 60000) {
-    lastMemCheck = millis();
-    
-    uint32_t freeHeap = ESP.getFreeHeap();
-    uint32_t maxAlloc = ESP.getMaxAllocHeap();
-    
-    // Detectar memoria baja (menos de 50KB libres)
-    if (freeHeap < 50000) {
-      char desc[128];
-      snprintf(desc, sizeof(desc), "Heap libre: %lu bytes", freeHeap);
-      logError(ERROR_MEMORY, ERR_SYSTEM_LOW_MEMORY, desc);
-      Serial.printf("[MEMORY] ⚠️  Memoria baja: %lu bytes libres\n", freeHeap);
-    }
-    
-    // Detectar fragmentación (max alloc < 50% del heap libre)
-    if (maxAlloc < (freeHeap / 2)) {
-      char desc[128];
-      snprintf(desc, sizeof(desc), "Heap libre: %lu, Max alloc: %lu", freeHeap, maxAlloc);
-      logError(ERROR_MEMORY, ERR_SYSTEM_HEAP_FRAGMENTED, desc);
-      Serial.printf("[MEMORY] ⚠️  Heap fragmentado: libre=%lu, max_alloc=%lu\n", freeHeap, maxAlloc);
-    }
-  }
+  // Chequeos periódicos registrados en JobMgr (ver setup)
+  JobMgr.runDue();
   
   // Loop del sistema
   SysMgr.loop();
   
-  // Loop de MQTT Manager (mantiene conexión y procesa cola)
-  if (WifiMgr.isConnected()) {
-    MqttMgr.loop();
-  }
-  
-  // Estadísticas periódicas
-  static unsigned long lastStats = 0;
-  if (millis() - lastStats > 60000) {  // Cada 60 segundos
-    lastStats = millis();
-    
-    Serial.println("\n╔════════════════════════════════════════════════╗");
-    Serial.println("║  📊 ESTADÍSTICAS DEL SISTEMA                   ║");
-    Serial.println("╚════════════════════════════════════════════════╝");
-    
-    // Estado del sistema
-    SystemStatus status = SysMgr.getStatus();
-    Serial.printf("  Uptime: %lu s\n", status.uptime / 1000);
-    Serial.printf("  Heap libre: %lu bytes\n", status.freeHeap);
-    Serial.printf("  WiFi: %s\n", status.wifiConnected ? "✓ Conectado" : "✗ Desconectado");
-    Serial.printf("  MQTT: %s\n", status.mqttConnected ? "✓ Conectado" : "✗ Desconectado");
-    
-    // Estadísticas Modbus
-    const ModbusStats& modbusStats = ModbusMgr.getStats();
-    Serial.printf("  Modbus peticiones: %lu (éxito: %lu, fallos: %lu)\n",
-                  modbusStats.totalRequests,
-                  modbusStats.successfulRequests,
-                  modbusStats.failedRequests);
-    
-    // Estadísticas MQTT
-    if (strlen(mqttConfig.server) > 0) {
-      const MQTTStats& mqttStats = MqttMgr.getStats();
-      Serial.printf("  MQTT publicados: %lu, recibidos: %lu\n",
-                    mqttStats.totalPublished,
-                    mqttStats.totalReceived);
-    }
-    
-    // TODO: Implementar lectura de datos del sensor usando ModbusMgr
-    // (código legacy de tasks.cpp deshabilitado temporalmente)
-    /*
-    if (dataMutex != NULL && xSemaphoreTake(dataMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-      if (sensorData.valid && sensorData.registerCount > 0) {
-        Serial.println("  Últimos datos del sensor:");
-        Serial.printf("    Registros leídos: %d\n", sensorData.registerCount);
-        if (sensorData.registerCount > 0) {
-          Serial.printf("    Reg[0]: %d (0x%04X)\n", 
-                        sensorData.registers[0], sensorData.registers[0]);
-        }
-        if (sensorData.registerCount > 1) {
-          Serial.printf("    Reg[1]: %d (0x%04X)\n", 
-                        sensorData.registers[1], sensorData.registers[1]);
-        }
-        Serial.printf("    Timestamp: hace %lu ms\n", millis() - sensorData.timestamp);
-      } else {
-        Serial.println("  ⚠ No hay datos válidos del sensor");
-      }
-      xSemaphoreGive(dataMutex);
-    }
-    */
-    
-    Serial.println("════════════════════════════════════════════════\n");
-  }
-  
   delay(100);
 }
@@ -0,0 +1,273 @@
+/**
+ * @file modbus_commands.cpp
+ * @brief Comandos MQTT de acceso directo al bus Modbus
+ *
+ * modbus_batch ejecuta una lista de lecturas/escrituras seguidas en el bus
+ * (un solo turno de ModbusManager) y responde todos los resultados juntos,
+ * con estado y duración por operación.
+ *
+ * El passthrough binario reenvía tramas crudas sin JSON ni hex: el payload
+ * de <base>/<id>/raw/req/<token> es [esclavo][PDU] (sin CRC) y la trama de
+ * respuesta, sin CRC, se publica en <base>/<id>/raw/resp/<token>.
+ */
+
+#include "modbus_commands.h"
+#include "config.h"
+#include <ArduinoJson.h>
+#include <CommandDispatcher.h>
+#include <ModbusManager.h>
+#include <MQTTManager.h>
+
+// ============================================================================
+// MODBUS BATCH
+// ============================================================================
+// {"cmd":"modbus_batch","ops":[
+//   {"fn":3,"slave":1,"addr":0,"count":2},
+//   {"fn":6,"slave":1,"addr":10,"value":123},
+//   {"fn":16,"slave":1,"addr":20,"values":[1,2,3]}
+// ]}
+
+static const CommandParam modbusBatchParams[] = {
+  {"ops", CMD_PARAM_ARRAY, true},
+};
+
+/**
+ * @brief Convierte una operación JSON en ModbusBatchOp
+ * @return false si falta un campo o la función no está soportada
+ */
+static bool parseBatchOp(JsonObject item, ModbusBatchOp& op, uint16_t* pool, size_t& poolUsed) {
+  if (!item["fn"].is<int>() || !item["addr"].is<int>()) return false;
+  if (!item["count"].isNull() && !item["count"].is<int>()) return false;
+  
+  // Rango antes de convertir: un count fuera de uint16_t no debe dar la vuelta
+  long quantity = item["count"] | 1L;
+  op.functionCode = item["fn"];
+  op.slaveId = item["slave"] | 1;
+  op.address = item["addr"];
+  op.quantity = 0;
+  op.values = nullptr;
+  
+  switch (op.functionCode) {
+    case MODBUS_READ_COILS:
+    case MODBUS_READ_DISCRETE_INPUTS:
+      if (quantity < 1 || quantity > MODBUS_MAX_READ_BITS) return false;
+      op.quantity = quantity;
+      return true;
+    
+    case MODBUS_READ_HOLDING_REGISTERS:
+    case MODBUS_READ_INPUT_REGISTERS:
+      if (quantity < 1 || quantity > MODBUS_MAX_READ_REGISTERS) return false;
+      op.quantity = quantity;
+      return true;
+    
+    case MODBUS_WRITE_SINGLE_COIL:
+    case MODBUS_WRITE_SINGLE_REGISTER:
+      if (!item["value"].is<int>() || poolUsed >= MODBUS_BATCH_MAX_VALUES) return false;
+      pool[poolUsed] = item["value"].as<uint16_t>();
+      op.values = &pool[poolUsed++];
+      op.quantity = 1;
+      return true;
+    
+    case MODBUS_WRITE_MULTIPLE_COILS:
+    case MODBUS_WRITE_MULTIPLE_REGISTERS: {
+      JsonArray values = item["values"];
+      size_t limit = (op.functionCode == MODBUS_WRITE_MULTIPLE_COILS) ? MODBUS_MAX_WRITE_COILS
+                                                                      : MODBUS_MAX_WRITE_REGISTERS;
+      if (values.isNull() || values.size() == 0 || values.size() > limit ||
+          poolUsed + values.size() > MODBUS_BATCH_MAX_VALUES) {
+        return false;
+      }
+      op.values = &pool[poolUsed];
+      op.quantity = values.size();
+      for (JsonVariant value : values) {
+        pool[poolUsed++] = value.as<uint16_t>();
+      }
+      return true;
+    }
+    
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief Resultado de cada operación (lo llama ModbusManager durante el lote)
+ */
+static void onBatchResult(size_t index, const ModbusResponse& response, uint32_t elapsedUs, void* context) {
+  JsonArray results = *(JsonArray*)context;
+  JsonObject result = results.createNestedObject();
+  result["us"] = elapsedUs;
+  
+  if (response.success) {
+    result["status"] = "ok";
+    uint8_t fn = response.functionCode;
+    if (fn == MODBUS_READ_HOLDING_REGISTERS || fn == MODBUS_READ_INPUT_REGISTERS) {
+      JsonArray data = result.createNestedArray("data");
+      uint8_t count = response.data[2] / 2;
+      for (uint8_t i = 0; i < count; i++) {
+        data.add((uint16_t)((response.data[3 + i * 2] << 8) | response.data[4 + i * 2]));
+      }
+    } else if (fn == MODBUS_READ_COILS || fn == MODBUS_READ_DISCRETE_INPUTS) {
+      // Bits empaquetados tal como vienen del esclavo (LSB = primera dirección)
+      JsonArray data = result.createNestedArray("bytes");
+      for (uint8_t i = 0; i < response.data[2]; i++) {
+        data.add(response.data[3 + i]);
+      }
+    }
+  } else if (response.exceptionCode != 0) {
+    result["status"] = "exception";
+    result["exception"] = response.exceptionCode;
+    result["description"] = ModbusManager::getExceptionDescription(response.exceptionCode);
+  } else if (response.length == 0) {
+    result["status"] = "timeout";
+  } else {
+    result["status"] = "crc_error";
+  }
+}
+
+static void cmdModbusBatch(CommandContext& ctx) {
+  if (!ModbusMgr.isInitialized()) {
+    ctx.replyError("modbus_not_ready");
+    return;
+  }
+  
+  JsonArray items = ctx.request["ops"];
+  size_t count = items.size();
+  
+  if (count == 0 || count > MODBUS_MGR_MAX_BATCH) {
+    ctx.replyError("invalid_param", "ops");
+    return;
+  }
+  
+  ModbusBatchOp ops[MODBUS_MGR_MAX_BATCH];
+  uint16_t pool[MODBUS_BATCH_MAX_VALUES];
+  size_t poolUsed = 0;
+  size_t readItems = 0;
+  
+  // Validar todo el lote antes de tocar el bus
+  for (size_t i = 0; i < count; i++) {
+    JsonObject item = items[i];
+    if (item.isNull() || !parseBatchOp(item, ops[i], pool, poolUsed)) {
+      StaticJsonDocument<128> error;
+      error["cmd"] = "modbus_batch";
+      error["error"] = "invalid_op";
+      error["index"] = i;
+      ctx.reply(error);
+      return;
+    }
+    if (ops[i].values == nullptr) {
+      readItems += ops[i].quantity;
+    }
+  }
+  
+  // Documento dimensionado según lo pedido (registros/bytes leídos)
+  size_t capacity = JSON_OBJECT_SIZE(6) + JSON_ARRAY_SIZE(count) +
+                    count * (JSON_OBJECT_SIZE(4) + JSON_ARRAY_SIZE(0)) +
+                    JSON_ARRAY_SIZE(readItems) + 128;
+  DynamicJsonDocument response(capacity);
+  if (response.capacity() == 0) {
+    ctx.replyError("no_memory");
+    return;
+  }
+  
+  response["cmd"] = "modbus_batch";
+  JsonArray results = response.createNestedArray("results");
+  
+  uint32_t start = micros();
+  size_t succeeded = ModbusMgr.executeBatch(ops, count, onBatchResult, &results);
+  uint32_t elapsed = micros() - start;
+  
+  response["status"] = (succeeded == count) ? "ok" : "partial";
+  response["succeeded"] = succeeded;
+  response["elapsed_us"] = elapsed;
+  
+  ctx.reply(response);
+  Serial.printf("[CMD] modbus_batch: %u/%u ops OK en %lu us\n",
+                (unsigned)succeeded, (unsigned)count, elapsed);
+}
+
+// ============================================================================
+// PASSTHROUGH BINARIO
+// ============================================================================
+// Request:  nehuentue/<id>/raw/req/<token>   payload = [esclavo][PDU]
+// Response: nehuentue/<id>/raw/resp/<token>  payload = [esclavo][PDU] de la
+//           respuesta (excepciones incluidas), vacío si no hubo respuesta
+//           válida (timeout, CRC o cola llena)
+
+static char rawReqPrefix[96];      // ".../raw/req/"
+static char rawRespPrefix[96];     // ".../raw/resp/"
+static size_t rawReqPrefixLength = 0;
+
+static void publishRawResponse(const char* token, const uint8_t* frame, size_t length) {
+  char topic[sizeof(rawRespPrefix) + MODBUS_MGR_MAX_TOKEN];
+  snprintf(topic, sizeof(topic), "%s%s", rawRespPrefix, token);
+  MqttMgr.publish(topic, frame, length);
+}
+
+/**
+ * @brief Respuesta de una trama cruda (corre en la tarea Modbus)
+ */
+static void onRawResult(const char* token, const ModbusResponse& response) {
+  if (response.success || response.exceptionCode != 0) {
+    // Trama recibida sin los 2 bytes de CRC
+    publishRawResponse(token, response.data, response.length - 2);
+  } else {
+    Serial.printf("[MODBUS RAW] %s: %s\n", token, response.length == 0 ? "timeout" : "error CRC");
+    publishRawResponse(token, nullptr, 0);
+  }
+}
+
+void beginRawModbus(const char* clientId) {
+  snprintf(rawReqPrefix, sizeof(rawReqPrefix), "%s/%s/%s/", MQTT_TOPIC_BASE, clientId, MQTT_TOPIC_RAW_REQ);
+  snprintf(rawRespPrefix, sizeof(rawRespPrefix), "%s/%s/%s/", MQTT_TOPIC_BASE, clientId, MQTT_TOPIC_RAW_RESP);
+  rawReqPrefixLength = strlen(rawReqPrefix);
+  ModbusMgr.onRawResponse(onRawResult);
+}
+
+void subscribeRawModbus() {
+  if (rawReqPrefixLength == 0) return;
+  
+  char filter[sizeof(rawReqPrefix) + 1];
+  snprintf(filter, sizeof(filter), "%s+", rawReqPrefix);
+  MqttMgr.subscribe(filter);
+}
+
+bool handleRawModbusMessage(const char* topic, const uint8_t* payload, size_t length) {
+  if (rawReqPrefixLength == 0 || strncmp(topic, rawReqPrefix, rawReqPrefixLength) != 0) {
+    return false;
+  }
+  
+  const char* token = topic + rawReqPrefixLength;
+  size_t tokenLength = strlen(token);
+  if (tokenLength == 0 || tokenLength > MODBUS_MGR_MAX_TOKEN) {
+    Serial.println("[MODBUS RAW] Token inválido, trama descartada");
+    return true;
+  }
+  
+  if (length < 2 || length > MODBUS_MGR_MAX_RAW_FRAME) {
+    Serial.printf("[MODBUS RAW] %s: longitud inválida (%u bytes)\n", token, (unsigned)length);
+    publishRawResponse(token, nullptr, 0);
+    return true;
+  }
+  
+  // La transacción la hace la tarea Modbus; el callback MQTT no se bloquea
+  if (!ModbusMgr.sendRawAsync(payload, length, token)) {
+    Serial.printf("[MODBUS RAW] %s: rechazada (bus ocupado o no inicializado)\n", token);
+    publishRawResponse(token, nullptr, 0);
+  }
+  return true;
+}
+
+// ============================================================================
+// REGISTRO
+// ============================================================================
+
+static const CommandSpec modbusCommands[] = {
+  {"modbus_batch", cmdModbusBatch, CMD_PARAMS(modbusBatchParams), CMD_FLAG_ASYNC, "Lote de operaciones Modbus"},
+};
+
+void registerModbusCommands() {
+  for (size_t i = 0; i < sizeof(modbusCommands) / sizeof(modbusCommands[0]); i++) {
+    CmdDispatcher.registerCommand(modbusCommands[i]);
+  }
+}
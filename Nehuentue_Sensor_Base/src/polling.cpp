@@ -0,0 +1,735 @@
+/**
+ * @file polling.cpp
+ * @brief Plan de polling del firmware y su reconfiguración por MQTT
+ *
+ * El plan se arma con el sensor principal (SensorConfig, set_sensor) más
+ * los puntos extra (set_points). Cualquier cambio se aplica en caliente con
+ * PollMgr.apply(): sin reinicio y sin cortar el bus.
+ *
+ * Cada lectura pasa por AggMgr: por defecto sólo se publica el resumen de
+ * cada ventana (min/max/media/desvío) en .../telemetry; los puntos con
+ * "raw" publican además cada muestra en .../telemetry/raw.
+ *
+ * Las lecturas también quedan en HistoryMgr (comprimidas en RAM) para que
+ * el backend recupere con get_history los huecos de una desconexión.
+ *
+ * Los puntos extra también se pueden cargar desde la biblioteca de perfiles
+ * de equipos (ProfileMgr, partición "profiles") con apply_profile.
+ */
+
+#include "polling.h"
+#include "config.h"
+#include <ArduinoJson.h>
+#include <FlashStorageManager.h>
+#include <ConfigCommitManager.h>
+#include <MQTTManager.h>
+#include <AggregationManager.h>
+#include <HistoryManager.h>
+#include <TimeSyncManager.h>
+#include <DeviceProfileManager.h>
+#include <PeriodicJobManager.h>
+
+extern SensorConfig sensorConfig;
+
+static PollPointList extraPoints;
+static char telemetryTopic[96];
+static char rawTopic[96];
+
+// ============================================================================
+// PLAN
+// ============================================================================
+
+static void buildPlan(const PollPointList& extras, PollPlan& plan) {
+  plan = PollPlan();
+  plan.serial.baudrate = sensorConfig.baudrate;
+  plan.serial.rxPin = sensorConfig.rxPin;
+  plan.serial.txPin = sensorConfig.txPin;
+
+  if (sensorConfig.enabled) {
+    PollPoint& point = plan.points[plan.count++];
+    strncpy(point.name, sensorConfig.name, POLLING_MGR_MAX_NAME);
+    point.slaveId = sensorConfig.slaveId;
+    point.functionCode = sensorConfig.modbusFunction;
+    point.address = sensorConfig.startAddress;
+    point.quantity = sensorConfig.quantity;
+    point.intervalMs = sensorConfig.pollInterval;
+    point.multiplier = sensorConfig.multiplier;
+    point.offset = sensorConfig.offset;
+  }
+
+  for (uint8_t i = 0; i < extras.count && plan.count < POLLING_MGR_MAX_POINTS; i++) {
+    plan.points[plan.count++] = extras.points[i];
+  }
+}
+
+/**
+ * @brief Decodifica una respuesta en valores escalados
+ * @return Cantidad de valores (registros, o bits como 0/1)
+ */
+static uint8_t decodeSample(const PollPoint& point, const ModbusResponse& response, float* values) {
+  uint8_t count = 0;
+
+  if (point.functionCode == MODBUS_READ_HOLDING_REGISTERS ||
+      point.functionCode == MODBUS_READ_INPUT_REGISTERS) {
+    // transact() ya exige byte count == 2 * quantity; el tope protege values[]
+    uint16_t registers = response.data[2] / 2;
+    if (registers > point.quantity) registers = point.quantity;
+    count = registers < 125 ? registers : 125;
+    for (uint8_t i = 0; i < count; i++) {
+      uint16_t raw = (response.data[3 + i * 2] << 8) | response.data[4 + i * 2];
+      values[i] = raw * point.multiplier + point.offset;
+    }
+  } else {
+    // Sólo los bits que se agregan (AGGREGATION_MGR_MAX_CHANNELS)
+    uint16_t bits = point.quantity < AGGREGATION_MGR_MAX_CHANNELS ? point.quantity : AGGREGATION_MGR_MAX_CHANNELS;
+    for (uint16_t i = 0; i < bits; i++) {
+      values[count++] = (response.data[3 + i / 8] >> (i % 8)) & 0x01;
+    }
+  }
+  return count;
+}
+
+static void publishRawSample(const PollPoint& point, const ModbusResponse& response, const float* values, uint8_t count) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(4) + JSON_ARRAY_SIZE(125)> doc;
+  doc["point"] = point.name;
+  doc["ts"] = response.timestamp;
+  if (TimeMgr.isSynced()) {
+    // Hora del primer byte de la respuesta, no la de publicación
+    doc["utc"] = TimeMgr.toUtcUs(response.rxTimeUs) / 1000;
+  }
+
+  if (point.functionCode == MODBUS_READ_HOLDING_REGISTERS ||
+      point.functionCode == MODBUS_READ_INPUT_REGISTERS) {
+    JsonArray array = doc.createNestedArray("values");
+    for (uint8_t i = 0; i < count; i++) {
+      array.add(values[i]);
+    }
+  } else {
+    // Bits empaquetados tal como vienen del esclavo (LSB = primera dirección)
+    JsonArray bits = doc.createNestedArray("bits");
+    for (uint8_t i = 0; i < response.data[2]; i++) {
+      bits.add(response.data[3 + i]);
+    }
+  }
+
+  MqttMgr.publishJSON(rawTopic, doc);
+}
+
+static void publishAggregate(const AggregateWindow& window) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(10) + 4 * JSON_ARRAY_SIZE(AGGREGATION_MGR_MAX_CHANNELS)> doc;
+  doc["point"] = window.name;
+  doc["start"] = window.start;
+  if (TimeMgr.isSynced()) {
+    doc["start_utc"] = TimeMgr.toUtcUs((int64_t)window.start * 1000) / 1000;
+  }
+  doc["window_ms"] = window.windowMs;
+  doc["samples"] = window.samples;
+  doc["missed"] = window.missed;
+
+  JsonArray min = doc.createNestedArray("min");
+  JsonArray max = doc.createNestedArray("max");
+  JsonArray mean = doc.createNestedArray("mean");
+  JsonArray stddev = doc.createNestedArray("stddev");
+  for (uint8_t i = 0; i < window.channels; i++) {
+    const RunningStats& stats = window.stats[i];
+    min.add(stats.min);
+    max.add(stats.max);
+    mean.add((float)stats.mean);
+    stddev.add(stats.stddev());
+  }
+
+  MqttMgr.publishJSON(telemetryTopic, doc);
+}
+
+/**
+ * @brief Agrega cada lectura y publica ventanas cerradas (corre en la tarea de polling)
+ */
+static void onPollSample(const PollPoint& point, const ModbusResponse& response) {
+  float values[125];
+  uint8_t count = response.success ? decodeSample(point, response, values) : 0;
+
+  if (response.success && count > 0) {
+    HistoryMgr.append(point.name, response.timestamp, values, count);
+  }
+
+  AggregateWindow closed;
+  uint8_t result = AggMgr.add(point.name, response.success ? values : nullptr, count, millis(), closed);
+
+  if ((result & AGG_EMIT_RAW) && response.success) {
+    publishRawSample(point, response, values, count);
+  }
+  if (result & AGG_WINDOW_CLOSED) {
+    publishAggregate(closed);
+  }
+}
+
+/**
+ * @brief Cierre por timer de las ventanas vencidas (trabajo agg_close)
+ */
+static void closeAggregates() {
+  AggMgr.closeExpired();
+}
+
+bool beginPolling(const char* clientId) {
+  snprintf(telemetryTopic, sizeof(telemetryTopic), "%s/%s/%s", MQTT_TOPIC_BASE, clientId, MQTT_TOPIC_TELEMETRY);
+  snprintf(rawTopic, sizeof(rawTopic), "%s/%s/%s", MQTT_TOPIC_BASE, clientId, MQTT_TOPIC_TELEMETRY_RAW);
+
+  AggregationConfig aggregation;
+  if (FlashStorage.load("agg_config", aggregation) != FLASH_STORAGE_OK) {
+    aggregation = AggregationConfig();
+    aggregation.defaultWindowMs = DEFAULT_AGGREGATION_WINDOW_MS;
+  }
+  AggMgr.begin();
+  AggMgr.onWindowClosed(publishAggregate);
+  AggMgr.setConfig(aggregation);
+
+  // Ventanas de puntos que dejaron de leerse (o con intervalo mayor que la
+  // ventana): no esperan a la próxima lectura
+  JobMgr.registerJob("agg_close", AGGREGATION_CLOSE_CHECK_MS, 1000, closeAggregates);
+
+  // Sin historial el polling sigue: get_history responde vacío
+  HistoryMgr.begin(HISTORY_RAM_BUDGET);
+
+  if (FlashStorage.load("poll_points", extraPoints) != FLASH_STORAGE_OK) {
+    extraPoints = PollPointList();
+  }
+
+  PollPlan plan;
+  buildPlan(extraPoints, plan);
+
+  PollMgr.onSample(onPollSample);
+  return PollMgr.begin(plan);
+}
+
+/**
+ * @brief Mismos datos de lectura: los valores siguen siendo comparables
+ */
+static bool sameReading(const PollPoint& a, const PollPoint& b) {
+  return a.slaveId == b.slaveId && a.functionCode == b.functionCode &&
+         a.address == b.address && a.quantity == b.quantity &&
+         a.multiplier == b.multiplier && a.offset == b.offset;
+}
+
+/**
+ * @brief Cierra la ventana de los puntos quitados o que ahora leen otra cosa
+ */
+static void closeRemovedSeries(const PollPlan& previous, const PollPlan& plan) {
+  for (uint8_t i = 0; i < previous.count; i++) {
+    const PollPoint& old = previous.points[i];
+    bool kept = false;
+    for (uint8_t j = 0; j < plan.count; j++) {
+      if (strcmp(old.name, plan.points[j].name) == 0) {
+        kept = sameReading(old, plan.points[j]);
+        break;
+      }
+    }
+    if (!kept) {
+      AggMgr.closeSeries(old.name);
+    }
+  }
+}
+
+static bool applyPlan(CommandContext& ctx, const PollPointList& extras) {
+  PollPlan plan;
+  buildPlan(extras, plan);
+
+  PollPlan previous;
+  PollMgr.getPlan(previous);
+
+  PollDiff diff;
+  const char* reason = nullptr;
+  if (PollMgr.apply(plan, &diff, &reason) != POLL_APPLY_OK) {
+    ctx.replyError(reason);
+    return false;
+  }
+  closeRemovedSeries(previous, plan);
+
+  StaticJsonDocument<256> response;
+  response["cmd"] = ctx.spec.name;
+  response["status"] = "ok";
+  response["generation"] = diff.generation;
+  response["added"] = diff.added;
+  response["changed"] = diff.changed;
+  response["removed"] = diff.removed;
+  response["unchanged"] = diff.unchanged;
+  response["serial_changed"] = diff.serialChanged;
+  ctx.reply(response);
+  return true;
+}
+
+bool applyPollingConfig(CommandContext& ctx) {
+  return applyPlan(ctx, extraPoints);
+}
+
+// ============================================================================
+// SET POINTS
+// ============================================================================
+// {"cmd":"set_points","points":[
+//   {"name":"presion","slave":2,"fn":4,"addr":0,"count":2,"interval":500},
+//   {"name":"bomba","slave":3,"fn":1,"addr":16,"count":8}
+// ]}
+
+static const CommandParam setPointsParams[] = {
+  {"points", CMD_PARAM_ARRAY, true},
+};
+
+static bool parsePoint(JsonObject item, PollPoint& point) {
+  const char* name = item["name"];
+  if (name == nullptr || !item["addr"].is<int>()) return false;
+
+  memset(&point, 0, sizeof(PollPoint));
+  strncpy(point.name, name, POLLING_MGR_MAX_NAME);
+  point.slaveId = item["slave"] | 1;
+  point.functionCode = item["fn"] | MODBUS_READ_HOLDING_REGISTERS;
+  point.address = item["addr"];
+  point.quantity = item["count"] | 1;
+  point.intervalMs = item["interval"] | 1000;
+  point.multiplier = item["multiplier"] | 1.0f;
+  point.offset = item["offset"] | 0.0f;
+  return true;
+}
+
+/**
+ * @brief Valida, persiste y aplica un nuevo conjunto de puntos extra
+ */
+static bool commitExtras(CommandContext& ctx, const PollPointList& extras) {
+  // Validar antes de persistir: un plan rechazado no toca la flash
+  PollPlan plan;
+  buildPlan(extras, plan);
+  const char* reason = nullptr;
+  if (!PollingManager::validate(plan, &reason)) {
+    ctx.replyError(reason);
+    return false;
+  }
+
+  extraPoints = extras;
+  ConfigMgr.stage("poll_points", extraPoints);
+  return applyPlan(ctx, extraPoints);
+}
+
+static void cmdSetPoints(CommandContext& ctx) {
+  JsonArray items = ctx.request["points"];
+  if (items.size() > POLL_EXTRA_POINTS) {
+    ctx.replyError("too_many_points");
+    return;
+  }
+
+  PollPointList extras;
+  for (JsonVariant item : items) {
+    if (!item.is<JsonObject>() || !parsePoint(item.as<JsonObject>(), extras.points[extras.count])) {
+      StaticJsonDocument<128> error;
+      error["cmd"] = "set_points";
+      error["error"] = "invalid_point";
+      error["index"] = extras.count;
+      ctx.reply(error);
+      return;
+    }
+    extras.count++;
+  }
+
+  if (commitExtras(ctx, extras)) {
+    Serial.printf("[CMD] Puntos de polling: %u extra\n", extraPoints.count);
+  }
+}
+
+// ============================================================================
+// GET POINTS
+// ============================================================================
+
+static void cmdGetPoints(CommandContext& ctx) {
+  PollPlan plan;
+  PollMgr.getPlan(plan);
+  PollingStats stats = PollMgr.getStats();
+
+  DynamicJsonDocument response(JSON_OBJECT_SIZE(4) + JSON_OBJECT_SIZE(3) + JSON_ARRAY_SIZE(POLLING_MGR_MAX_POINTS) +
+                               POLLING_MGR_MAX_POINTS * JSON_OBJECT_SIZE(11));
+  if (response.capacity() == 0) {
+    ctx.replyError("no_memory");
+    return;
+  }
+
+  response["cmd"] = "get_points";
+  response["generation"] = stats.generation;
+
+  JsonObject serial = response.createNestedObject("serial");
+  serial["baudrate"] = plan.serial.baudrate;
+  serial["rx"] = plan.serial.rxPin;
+  serial["tx"] = plan.serial.txPin;
+
+  uint32_t now = millis();
+  JsonArray points = response.createNestedArray("points");
+  for (uint8_t i = 0; i < plan.count; i++) {
+    const PollPoint& point = plan.points[i];
+    JsonObject item = points.createNestedObject();
+    item["name"] = point.name;
+    item["slave"] = point.slaveId;
+    item["fn"] = point.functionCode;
+    item["addr"] = point.address;
+    item["count"] = point.quantity;
+    item["interval"] = point.intervalMs;
+    item["multiplier"] = point.multiplier;
+    item["offset"] = point.offset;
+
+    PollPointState state;
+    if (PollMgr.getPointState(point.name, state)) {
+      item["reads"] = state.reads;
+      item["failures"] = state.failures;
+      if (state.lastRead != 0) item["age_ms"] = now - state.lastRead;
+    }
+  }
+
+  ctx.reply(response);
+}
+
+// ============================================================================
+// PERFILES DE EQUIPOS
+// ============================================================================
+// {"cmd":"list_profiles","offset":0,"limit":20}
+// {"cmd":"get_profile","model":"SDM120"}
+// {"cmd":"apply_profile","model":"SDM120","slave":3,"interval":2000}
+// Los perfiles se leen directo de la partición mapeada: nada se copia a RAM
+// salvo los puntos que apply_profile pasa al plan.
+
+static const CommandParam listProfilesParams[] = {
+  {"offset", CMD_PARAM_INT, false},
+  {"limit", CMD_PARAM_INT, false},
+};
+
+static const CommandParam getProfileParams[] = {
+  {"model", CMD_PARAM_STRING, true},
+};
+
+static const CommandParam applyProfileParams[] = {
+  {"model", CMD_PARAM_STRING, true},
+  {"slave", CMD_PARAM_INT, false},
+  {"interval", CMD_PARAM_INT, false},
+};
+
+static void cmdListProfiles(CommandContext& ctx) {
+  long offset = ctx.request["offset"] | 0;
+  long limit = ctx.request["limit"] | PROFILE_LIST_DEFAULT_LIMIT;
+  if (offset < 0) {
+    ctx.replyError("invalid_param", "offset");
+    return;
+  }
+  if (limit <= 0 || limit > PROFILE_LIST_MAX_LIMIT) {
+    ctx.replyError("invalid_param", "limit");
+    return;
+  }
+
+  uint16_t total = ProfileMgr.getProfileCount();
+  uint16_t count = (offset < total) ? ((total - offset < limit) ? total - offset : limit) : 0;
+
+  // Los strings son punteros a flash: ArduinoJson no los copia
+  DynamicJsonDocument response(JSON_OBJECT_SIZE(5) + JSON_ARRAY_SIZE(count) + count * JSON_OBJECT_SIZE(5));
+  if (response.capacity() == 0) {
+    ctx.replyError("no_memory");
+    return;
+  }
+
+  response["cmd"] = "list_profiles";
+  response["total"] = total;
+  response["crc"] = ProfileMgr.getImageCrc();
+
+  JsonArray profiles = response.createNestedArray("profiles");
+  for (uint16_t i = 0; i < count; i++) {
+    const ProfileRecord* profile = ProfileMgr.getProfile(offset + i);
+    JsonObject item = profiles.createNestedObject();
+    item["model"] = ProfileMgr.getName(*profile);
+    item["vendor"] = ProfileMgr.getVendor(*profile);
+    item["points"] = profile->pointCount;
+    item["baudrate"] = profile->baudrate;
+    item["slave"] = profile->defaultSlave;
+  }
+  if (offset + count < total) {
+    response["next"] = offset + count;
+  }
+
+  ctx.reply(response);
+}
+
+static void cmdGetProfile(CommandContext& ctx) {
+  const ProfileRecord* profile = ProfileMgr.find(ctx.request["model"]);
+  if (profile == nullptr) {
+    ctx.replyError("unknown_profile");
+    return;
+  }
+
+  DynamicJsonDocument response(JSON_OBJECT_SIZE(6) + JSON_ARRAY_SIZE(profile->pointCount) +
+                               profile->pointCount * JSON_OBJECT_SIZE(7));
+  if (response.capacity() == 0) {
+    ctx.replyError("no_memory");
+    return;
+  }
+
+  response["cmd"] = "get_profile";
+  response["model"] = ProfileMgr.getName(*profile);
+  response["vendor"] = ProfileMgr.getVendor(*profile);
+  response["baudrate"] = profile->baudrate;
+  response["slave"] = profile->defaultSlave;
+
+  const ProfilePointRecord* records = ProfileMgr.getPoints(*profile);
+  JsonArray points = response.createNestedArray("points");
+  for (uint16_t i = 0; i < profile->pointCount; i++) {
+    const ProfilePointRecord& record = records[i];
+    JsonObject item = points.createNestedObject();
+    item["name"] = ProfileMgr.getString(record.nameOffset);
+    item["fn"] = record.functionCode;
+    item["addr"] = record.address;
+    item["count"] = record.quantity;
+    item["multiplier"] = record.multiplier;
+    item["offset"] = record.offset;
+    item["unit"] = ProfileMgr.getString(record.unitOffset);
+  }
+
+  ctx.reply(response);
+}
+
+static void cmdApplyProfile(CommandContext& ctx) {
+  const ProfileRecord* profile = ProfileMgr.find(ctx.request["model"]);
+  if (profile == nullptr) {
+    ctx.replyError("unknown_profile");
+    return;
+  }
+  if (profile->pointCount > POLL_EXTRA_POINTS) {
+    ctx.replyError("too_many_points");
+    return;
+  }
+
+  uint8_t slaveId = ctx.request["slave"] | profile->defaultSlave;
+  uint32_t interval = ctx.request["interval"] | 1000UL;
+
+  // Los puntos del perfil reemplazan a los extra (el sensor principal queda)
+  PollPointList extras;
+  const ProfilePointRecord* records = ProfileMgr.getPoints(*profile);
+  for (uint16_t i = 0; i < profile->pointCount; i++) {
+    const ProfilePointRecord& record = records[i];
+    PollPoint& point = extras.points[extras.count++];
+    strncpy(point.name, ProfileMgr.getString(record.nameOffset), POLLING_MGR_MAX_NAME);
+    point.slaveId = slaveId;
+    point.functionCode = record.functionCode;
+    point.address = record.address;
+    point.quantity = record.quantity;
+    point.intervalMs = interval;
+    point.multiplier = record.multiplier;
+    point.offset = record.offset;
+  }
+
+  if (profile->baudrate != sensorConfig.baudrate) {
+    Serial.printf("[CMD] ⚠️  '%s' sale de fábrica a %lu baudios; el bus está a %lu (set_sensor)\n",
+                  ProfileMgr.getName(*profile), (unsigned long)profile->baudrate,
+                  (unsigned long)sensorConfig.baudrate);
+  }
+
+  if (commitExtras(ctx, extras)) {
+    Serial.printf("[CMD] Perfil '%s' aplicado: %u puntos (esclavo %u)\n",
+                  ProfileMgr.getName(*profile), extras.count, slaveId);
+  }
+}
+
+// ============================================================================
+// AGREGACIÓN
+// ============================================================================
+// {"cmd":"set_aggregation","window":60000}                       ventana por defecto
+// {"cmd":"set_aggregation","point":"presion","window":10000,"raw":true}
+// {"cmd":"set_aggregation","point":"presion","remove":true}
+
+static const CommandParam setAggregationParams[] = {
+  {"point", CMD_PARAM_STRING, false},
+  {"window", CMD_PARAM_INT, false},
+  {"raw", CMD_PARAM_BOOL, false},
+  {"remove", CMD_PARAM_BOOL, false},
+};
+
+static void replyAggregation(CommandContext& ctx) {
+  AggregationConfig config;
+  AggMgr.getConfig(config);
+  AggregationStats stats = AggMgr.getStats();
+
+  DynamicJsonDocument response(JSON_OBJECT_SIZE(5) + JSON_ARRAY_SIZE(AGGREGATION_MGR_MAX_RULES) +
+                               AGGREGATION_MGR_MAX_RULES * JSON_OBJECT_SIZE(3));
+  if (response.capacity() == 0) {
+    ctx.replyError("no_memory");
+    return;
+  }
+
+  response["cmd"] = ctx.spec.name;
+  response["default_window"] = config.defaultWindowMs;
+  response["samples"] = stats.samples;
+  response["windows"] = stats.windowsClosed;
+
+  JsonArray rules = response.createNestedArray("rules");
+  for (uint8_t i = 0; i < config.count; i++) {
+    JsonObject rule = rules.createNestedObject();
+    rule["point"] = config.rules[i].name;
+    rule["window"] = config.rules[i].windowMs;
+    rule["raw"] = config.rules[i].raw;
+  }
+
+  ctx.reply(response);
+}
+
+static void cmdSetAggregation(CommandContext& ctx) {
+  JsonDocument& doc = ctx.request;
+  const char* point = doc["point"];
+  bool ok;
+
+  if (point == nullptr) {
+    if (!doc["window"].is<long>()) {
+      ctx.replyError("missing_param", "window");
+      return;
+    }
+    ok = AggMgr.setDefaultWindow(doc["window"]);
+  } else if (doc["remove"] | false) {
+    ok = AggMgr.removeRule(point);
+  } else {
+    uint32_t window = doc["window"] | AggMgr.windowFor(point);
+    ok = AggMgr.setRule(point, window, doc["raw"] | false);
+  }
+
+  if (!ok) {
+    ctx.replyError("invalid_param", (point == nullptr || doc.containsKey("window")) ? "window" : "point");
+    return;
+  }
+
+  AggregationConfig config;
+  AggMgr.getConfig(config);
+  ConfigMgr.stage("agg_config", config);
+
+  replyAggregation(ctx);
+  Serial.println("[CMD] Agregación configurada");
+}
+
+static void cmdGetAggregation(CommandContext& ctx) {
+  replyAggregation(ctx);
+}
+
+// ============================================================================
+// HISTORIAL
+// ============================================================================
+// {"cmd":"get_history","point":"presion","from":120000,"to":180000,"limit":300}
+// Tiempos en ms desde el arranque (como "ts" en telemetry/raw). Si la
+// respuesta trae "next", pedir de nuevo con "from":next. Una página termina
+// en "limit" muestras o en HISTORY_REPLY_MAX_BYTES de JSON, lo que llegue antes.
+
+static const CommandParam getHistoryParams[] = {
+  {"point", CMD_PARAM_STRING, true},
+  {"from", CMD_PARAM_INT, false},
+  {"to", CMD_PARAM_INT, false},
+  {"limit", CMD_PARAM_INT, false},
+};
+
+struct HistoryReply {
+  JsonArray times;
+  JsonArray values;
+  uint8_t channels;
+  size_t bytes;               // JSON serializado hasta ahora
+};
+
+/**
+ * @brief Agrega una muestra si la respuesta sigue entrando en HISTORY_REPLY_MAX_BYTES
+ *
+ * La cola de publicación descarta mensajes más grandes que su presupuesto:
+ * en lugar de perder la página entera se corta acá y se responde "next".
+ */
+static bool onHistorySample(uint32_t timestamp, const float* values, uint8_t channels, void* context) {
+  HistoryReply* reply = (HistoryReply*)context;
+
+  StaticJsonDocument<JSON_ARRAY_SIZE(HISTORY_MGR_MAX_CHANNELS)> row;
+  JsonArray array = row.to<JsonArray>();
+  uint8_t count = (channels < reply->channels) ? channels : reply->channels;
+  for (uint8_t i = 0; i < count; i++) {
+    array.add(values[i]);
+  }
+
+  // Fila + tiempo + dos comas
+  char time[12];
+  size_t added = measureJson(row) + snprintf(time, sizeof(time), "%lu", (unsigned long)timestamp) + 2;
+  if (reply->bytes + added > HISTORY_REPLY_MAX_BYTES) {
+    return false;
+  }
+
+  reply->bytes += added;
+  reply->times.add(timestamp);
+  reply->values.add(array);
+  return true;
+}
+
+static void cmdGetHistory(CommandContext& ctx) {
+  const char* point = ctx.request["point"];
+  uint32_t from = ctx.request["from"] | 0UL;
+  uint32_t to = ctx.request["to"] | (unsigned long)UINT32_MAX;
+  long limit = ctx.request["limit"] | HISTORY_QUERY_DEFAULT_LIMIT;
+
+  if (limit <= 0 || limit > HISTORY_QUERY_MAX_LIMIT) {
+    ctx.replyError("invalid_param", "limit");
+    return;
+  }
+
+  HistorySeriesInfo info;
+  if (!HistoryMgr.getSeriesInfo(point, info)) {
+    ctx.replyError("unknown_point");
+    return;
+  }
+
+  // La página se corta en HISTORY_REPLY_MAX_BYTES (onHistorySample): no caben
+  // más filas que las que entran en ese JSON con la muestra más corta posible
+  // ("0,[0,...,0],": 2 bytes por canal + 4), aunque limit sea mayor
+  size_t rows = HISTORY_REPLY_MAX_BYTES / (2 * info.channels + 4);
+  if (rows > (size_t)limit) {
+    rows = limit;
+  }
+  DynamicJsonDocument response(JSON_OBJECT_SIZE(10) + 2 * JSON_ARRAY_SIZE(rows) +
+                               rows * JSON_ARRAY_SIZE(info.channels));
+  if (response.capacity() == 0) {
+    ctx.replyError("no_memory");
+    return;
+  }
+
+  response["cmd"] = "get_history";
+  response["point"] = point;
+  response["now"] = millis();
+  if (TimeMgr.isSynced()) {
+    // utc = t + utc_offset_ms
+    int64_t nowUs = esp_timer_get_time();
+    response["utc_offset_ms"] = (TimeMgr.toUtcUs(nowUs) - nowUs) / 1000;
+  }
+  response["oldest"] = info.oldest;
+
+  HistoryReply reply;
+  reply.times = response.createNestedArray("t");
+  reply.values = response.createNestedArray("v");
+  reply.channels = info.channels;
+  // Lo fijo de la respuesta, con margen para count/truncated/next
+  reply.bytes = measureJson(response) + 64;
+
+  HistoryQueryResult result = HistoryMgr.query(point, from, to, limit, onHistorySample, &reply);
+  response["count"] = result.count;
+  response["truncated"] = result.truncated;
+  if (result.truncated) {
+    response["next"] = result.nextTime;
+  }
+
+  ctx.reply(response);
+}
+
+// ============================================================================
+// REGISTRO
+// ============================================================================
+
+static const CommandSpec pollingCommands[] = {
+  {"set_points", cmdSetPoints, CMD_PARAMS(setPointsParams), CMD_FLAG_NONE, "Define los puntos de polling extra"},
+  {"get_points", cmdGetPoints, CMD_NO_PARAMS, CMD_FLAG_NONE, "Plan de polling activo"},
+  {"list_profiles", cmdListProfiles, CMD_PARAMS(listProfilesParams), CMD_FLAG_NONE, "Perfiles de equipos disponibles"},
+  {"get_profile", cmdGetProfile, CMD_PARAMS(getProfileParams), CMD_FLAG_NONE, "Registros de un perfil de equipo"},
+  {"apply_profile", cmdApplyProfile, CMD_PARAMS(applyProfileParams), CMD_FLAG_NONE, "Carga los puntos de un perfil en el plan"},
+  {"set_aggregation", cmdSetAggregation, CMD_PARAMS(setAggregationParams), CMD_FLAG_NONE, "Ventanas de agregación"},
+  {"get_aggregation", cmdGetAggregation, CMD_NO_PARAMS, CMD_FLAG_NONE, "Reglas de agregación"},
+  {"get_history", cmdGetHistory, CMD_PARAMS(getHistoryParams), CMD_FLAG_ASYNC, "Historial de un punto por rango de tiempo"},
+};
+
+void registerPollingCommands() {
+  for (size_t i = 0; i < sizeof(pollingCommands) / sizeof(pollingCommands[0]); i++) {
+    CmdDispatcher.registerCommand(pollingCommands[i]);
+  }
+}
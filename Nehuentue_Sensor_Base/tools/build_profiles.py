@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""
+Arma la imagen de la partición "profiles" (DeviceProfileManager).
+
+Lee uno o más JSON con perfiles de equipos y escribe el binario indexado que
+el firmware mapea con esp_partition_mmap(). Ver el formato en
+lib/DeviceProfileManager/DeviceProfileManager.h; este script y ese header
+tienen que cambiar juntos.
+
+Formato de entrada (un archivo puede tener varios perfiles; un directorio se
+lee completo, *.json):
+
+    {"profiles": [
+      {"model": "SDM120", "vendor": "Eastron", "baudrate": 2400, "slave": 1,
+       "points": [
+         {"name": "voltaje", "fn": 4, "addr": 0, "count": 2, "unit": "V"},
+         {"name": "corriente", "fn": 4, "addr": 6, "count": 2, "unit": "A"}
+       ]}
+    ]}
+
+Los puntos usan las mismas claves que set_points (name, fn, addr, count,
+multiplier, offset) más "unit".
+
+Uso:
+    python3 tools/build_profiles.py tools/profiles -o profiles.bin
+    esptool.py --chip esp32c3 write_flash 0x390000 profiles.bin
+
+    # Sólo validar y listar
+    python3 tools/build_profiles.py tools/profiles --list
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = 0x4652504E            # "NPRF"
+FORMAT_VERSION = 1
+
+HEADER = struct.Struct("<IHHIIIIII")     # ProfileImageHeader (32 bytes)
+PROFILE = struct.Struct("<IIIIHBBI")     # ProfileRecord (24 bytes)
+POINT = struct.Struct("<IIHHB3xff")      # ProfilePointRecord (24 bytes)
+
+PARTITION_OFFSET = 0x390000   # partitions.csv
+PARTITION_SIZE = 0x50000
+
+MAX_POINT_NAME = 23           # POLLING_MGR_MAX_NAME
+MAX_POINTS = 15               # POLL_EXTRA_POINTS: apply_profile no acepta más
+MAX_QUANTITY = {1: 2000, 2: 2000, 3: 125, 4: 125}
+
+
+def fnv1a(text):
+    value = 2166136261
+    for byte in text.encode("utf-8"):
+        value ^= byte
+        value = (value * 16777619) & 0xFFFFFFFF
+    return value
+
+
+class Strings:
+    """Tabla de strings sin repetidos; el offset 0 es "" """
+
+    def __init__(self):
+        self.data = bytearray(b"\0")
+        self.offsets = {"": 0}
+
+    def add(self, text):
+        if text not in self.offsets:
+            self.offsets[text] = len(self.data)
+            self.data += text.encode("utf-8") + b"\0"
+        return self.offsets[text]
+
+
+def load_profiles(paths):
+    files = []
+    for path in paths:
+        if os.path.isdir(path):
+            files += sorted(os.path.join(path, name) for name in os.listdir(path) if name.endswith(".json"))
+        else:
+            files.append(path)
+
+    profiles = []
+    for path in files:
+        with open(path, encoding="utf-8") as source:
+            document = json.load(source)
+        for profile in document.get("profiles", []):
+            profile["_source"] = path
+            profiles.append(profile)
+    return profiles
+
+
+def check(profile):
+    where = f"{profile.get('model', '?')} ({profile['_source']})"
+    if not profile.get("model"):
+        raise ValueError(f"{where}: falta 'model'")
+
+    points = profile.get("points", [])
+    if not points:
+        raise ValueError(f"{where}: sin puntos")
+    if len(points) > MAX_POINTS:
+        raise ValueError(f"{where}: {len(points)} puntos (máximo {MAX_POINTS})")
+    if not 1 <= profile.get("slave", 1) <= 247:
+        raise ValueError(f"{where}: esclavo fuera de rango")
+
+    names = set()
+    for point in points:
+        name = point.get("name", "")
+        if not name or len(name.encode("utf-8")) > MAX_POINT_NAME:
+            raise ValueError(f"{where}: nombre de punto inválido '{name}' (1-{MAX_POINT_NAME} bytes)")
+        if name in names:
+            raise ValueError(f"{where}: punto repetido '{name}'")
+        names.add(name)
+
+        fn = point.get("fn", 3)
+        if fn not in MAX_QUANTITY:
+            raise ValueError(f"{where}/{name}: función {fn} no soportada (1-4)")
+        if not 1 <= point.get("count", 1) <= MAX_QUANTITY[fn]:
+            raise ValueError(f"{where}/{name}: 'count' fuera de rango")
+        if not 0 <= point.get("addr", -1) <= 0xFFFF:
+            raise ValueError(f"{where}/{name}: 'addr' fuera de rango")
+
+
+def build(profiles):
+    models = {}
+    for profile in profiles:
+        check(profile)
+        model = profile["model"]
+        if model in models:
+            raise ValueError(f"modelo repetido '{model}' ({models[model]['_source']}, {profile['_source']})")
+        models[model] = profile
+
+    # Orden del índice: hash y luego nombre (find() hace búsqueda binaria por hash)
+    ordered = sorted(profiles, key=lambda p: (fnv1a(p["model"]), p["model"]))
+
+    strings = Strings()
+    profile_table = bytearray()
+    point_table = bytearray()
+    point_count = 0
+
+    for profile in ordered:
+        points = profile["points"]
+        profile_table += PROFILE.pack(
+            fnv1a(profile["model"]),
+            strings.add(profile["model"]),
+            strings.add(profile.get("vendor", "")),
+            point_count,
+            len(points),
+            profile.get("slave", 1),
+            0,
+            profile.get("baudrate", 9600),
+        )
+        for point in points:
+            point_table += POINT.pack(
+                strings.add(point["name"]),
+                strings.add(point.get("unit", "")),
+                point["addr"],
+                point.get("count", 1),
+                point.get("fn", 3),
+                float(point.get("multiplier", 1.0)),
+                float(point.get("offset", 0.0)),
+            )
+            point_count += 1
+
+    profiles_offset = HEADER.size
+    points_offset = profiles_offset + len(profile_table)
+    strings_offset = points_offset + len(point_table)
+    body = bytes(profile_table + point_table + strings.data)
+    image_size = HEADER.size + len(body)
+
+    header = HEADER.pack(MAGIC, FORMAT_VERSION, len(ordered), image_size,
+                         zlib.crc32(body) & 0xFFFFFFFF,
+                         profiles_offset, points_offset, strings_offset, point_count)
+    return header + body, ordered
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Imagen de perfiles de equipos para la partición 'profiles'")
+    parser.add_argument("sources", nargs="+", help="Archivos JSON o directorios con *.json")
+    parser.add_argument("-o", "--output", default="profiles.bin")
+    parser.add_argument("--partition-size", type=lambda v: int(v, 0), default=PARTITION_SIZE)
+    parser.add_argument("--list", action="store_true", help="Validar y listar sin escribir")
+    args = parser.parse_args()
+
+    try:
+        image, ordered = build(load_profiles(args.sources))
+    except (ValueError, KeyError, json.JSONDecodeError) as error:
+        print(f"[PROFILES] ERROR: {error}", file=sys.stderr)
+        return 1
+
+    if len(image) > args.partition_size:
+        print(f"[PROFILES] ERROR: La imagen ocupa {len(image)} bytes y la partición {args.partition_size}",
+              file=sys.stderr)
+        return 1
+
+    for profile in sorted(ordered, key=lambda p: p["model"]):
+        print(f"  {profile['model']:<20} {profile.get('vendor', ''):<16} {len(profile['points']):>2} registros")
+    print(f"[PROFILES] {len(ordered)} perfiles, {len(image)} bytes "
+          f"({100.0 * len(image) / args.partition_size:.1f}% de la partición)")
+
+    if args.list:
+        return 0
+
+    with open(args.output, "wb") as output:
+        output.write(image)
+    print(f"[PROFILES] ✓ {args.output}")
+    print(f"  esptool.py --chip esp32c3 write_flash 0x{PARTITION_OFFSET:X} {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""
+Servidor NTP mínimo para probar TimeSyncManager en la red local.
+
+Responde consultas SNTP con la hora de esta máquina más un desfase fijo y
+una deriva opcional, y puede demorar la respuesta para simular una red
+asimétrica. Con un desfase conocido se verifica en get_status ("time") que
+el dispositivo lo sigue: primero con un step y luego por slew.
+
+Uso:
+    python3 tools/ntp_standin.py --port 12300 --offset-ms 250
+    # en el dispositivo: {"cmd":"set_ntp","server":"192.168.1.10","port":12300}
+
+    # Deriva de 50 ppm y 20 ms extra sólo en la vuelta
+    python3 tools/ntp_standin.py --port 12300 --drift-ppm 50 --reply-delay-ms 20
+"""
+
+import argparse
+import socket
+import struct
+import time
+
+NTP_UNIX_OFFSET = 2208988800
+
+
+def to_ntp(unix_seconds):
+    seconds = int(unix_seconds)
+    fraction = int((unix_seconds - seconds) * (1 << 32)) & 0xFFFFFFFF
+    return struct.pack("!II", (seconds + NTP_UNIX_OFFSET) & 0xFFFFFFFF, fraction)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="NTP de prueba para TimeSyncManager")
+    parser.add_argument("--bind", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=123)
+    parser.add_argument("--offset-ms", type=float, default=0.0, help="Desfase respecto de esta máquina")
+    parser.add_argument("--drift-ppm", type=float, default=0.0, help="Deriva del reloj servido")
+    parser.add_argument("--reply-delay-ms", type=float, default=0.0, help="Espera antes de responder (asimetría)")
+    parser.add_argument("--stratum", type=int, default=2, help="0 simula un kiss-of-death")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((args.bind, args.port))
+    start = time.time()
+    print(f"[NTP] Escuchando en {args.bind}:{args.port} "
+          f"(desfase {args.offset_ms} ms, deriva {args.drift_ppm} ppm)")
+
+    def served_time():
+        now = time.time()
+        return now + args.offset_ms / 1000.0 + (now - start) * args.drift_ppm / 1e6
+
+    while True:
+        request, address = sock.recvfrom(512)
+        receive = served_time()
+        if len(request) < 48:
+            continue
+
+        if args.reply_delay_ms > 0:
+            time.sleep(args.reply_delay_ms / 1000.0)
+
+        version = (request[0] >> 3) & 0x07
+        header = struct.pack("!BBbb", (version << 3) | 4, args.stratum, 6, -20)
+        root = struct.pack("!II", 0, 0) + b"LOCL"
+        reference = to_ntp(receive)
+        originate = request[40:48]  # el testigo del cliente, tal cual
+
+        transmit = served_time()
+        reply = header + root + reference + originate + to_ntp(receive) + to_ntp(transmit)
+        sock.sendto(reply, address)
+        print(f"[NTP] {address[0]}:{address[1]} -> {time.strftime('%H:%M:%S', time.gmtime(transmit))}"
+              f".{int((transmit % 1) * 1000):03d} UTC")
+
+
+if __name__ == "__main__":
+    main()